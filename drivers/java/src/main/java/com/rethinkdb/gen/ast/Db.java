@@ -61,6 +61,10 @@ public class Db extends ReqlAst {
         Arguments arguments = new Arguments(this);
         return new Rebalance(arguments);
     }
+    public Compact compact() {
+        Arguments arguments = new Arguments(this);
+        return new Compact(arguments);
+    }
     public Grant grant(Object expr, Object exprA) {
         Arguments arguments = new Arguments(this);
         arguments.coerceAndAdd(expr);
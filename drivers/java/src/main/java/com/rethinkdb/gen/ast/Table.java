@@ -85,6 +85,10 @@ public class Table extends ReqlExpr {
         Arguments arguments = new Arguments(this);
         return new Rebalance(arguments);
     }
+    public Compact compact() {
+        Arguments arguments = new Arguments(this);
+        return new Compact(arguments);
+    }
     public Sync sync() {
         Arguments arguments = new Arguments(this);
         return new Sync(arguments);
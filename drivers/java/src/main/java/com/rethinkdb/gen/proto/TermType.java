@@ -98,6 +98,7 @@ public enum TermType {
     WAIT(177),
     RECONFIGURE(176),
     REBALANCE(179),
+    COMPACT(197),
     SYNC(138),
     GRANT(188),
     INDEX_CREATE(75),
@@ -293,6 +294,7 @@ public enum TermType {
             case 177: return TermType.WAIT;
             case 176: return TermType.RECONFIGURE;
             case 179: return TermType.REBALANCE;
+            case 197: return TermType.COMPACT;
             case 138: return TermType.SYNC;
             case 188: return TermType.GRANT;
             case 75: return TermType.INDEX_CREATE;
@@ -1155,6 +1155,9 @@ class DB(RqlTopLevelQuery):
     def rebalance(self, *args, **kwargs):
         return Rebalance(self, *args, **kwargs)
 
+    def compact(self, *args, **kwargs):
+        return Compact(self, *args, **kwargs)
+
     def grant(self, *args, **kwargs):
         return Grant(self, *args, **kwargs)
 
@@ -1247,6 +1250,9 @@ class Table(RqlQuery):
     def rebalance(self, *args, **kwargs):
         return Rebalance(self, *args, **kwargs)
 
+    def compact(self, *args, **kwargs):
+        return Compact(self, *args, **kwargs)
+
     def sync(self, *args):
         return Sync(self, *args)
 
@@ -1565,6 +1571,11 @@ class Rebalance(RqlMethodQuery):
     st = 'rebalance'
 
 
+class Compact(RqlMethodQuery):
+    tt = pTerm.COMPACT
+    st = 'compact'
+
+
 class Sync(RqlMethodQuery):
     tt = pTerm.SYNC
     st = 'sync'
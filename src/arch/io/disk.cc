@@ -25,6 +25,8 @@
 #include "arch/io/disk/conflict_resolving.hpp"
 #include "arch/io/disk/stats.hpp"
 #include "arch/io/disk/accounting.hpp"
+#include "arch/io/disk/merging.hpp"
+#include "arch/io/disk/uring.hpp"
 #include "backtrace.hpp"
 #include "config/args.hpp"
 #include "do_on_thread.hpp"
@@ -50,14 +52,47 @@ public:
     linux_disk_manager_t(linux_event_queue_t *queue,
                          int batch_factor,
                          int max_concurrent_io_requests,
+                         file_io_backend_t io_backend,
                          perfmon_collection_t *stats) :
         stack_stats(stats, "stack"),
         conflict_resolver(stats),
-        accounter(batch_factor),
+        accounter(stats, batch_factor),
         backend_stats(stats, "backend", accounter.producer),
-        backend(queue, backend_stats.producer, max_concurrent_io_requests),
+        merger(stats, "backend", backend_stats.producer),
         outstanding_txn(0)
     {
+        /* Pick the backend. The backends pull their operations from the queue as
+        soon as they are constructed, so we have to set their `done_fun` right
+        away. */
+        auto backend_done_fun = std::bind(&merging_diskmgr_t::done, &merger, ph::_1);
+        merger.dispatch_fun = [this](pool_diskmgr_t::action_t *a) {
+            accounter.dispatched(static_cast<stats_diskmgr_2_t::action_t *>(a));
+        };
+        bool use_pool = true;
+#if RDB_HAS_IO_URING
+        if (io_backend == file_io_backend_t::io_uring) {
+            if (uring_diskmgr_t::is_supported()) {
+                uring_backend.init(new uring_diskmgr_t(
+                    queue, merger.producer, max_concurrent_io_requests));
+                uring_backend->done_fun = backend_done_fun;
+                use_pool = false;
+            } else {
+                logWRN("The io_uring disk backend is not supported by this kernel. "
+                       "Falling back to the thread pool disk backend.");
+            }
+        }
+#else
+        if (io_backend == file_io_backend_t::io_uring) {
+            logWRN("This build of RethinkDB does not support the io_uring disk "
+                   "backend. Falling back to the thread pool disk backend.");
+        }
+#endif
+        if (use_pool) {
+            pool_backend.init(new pool_diskmgr_t(
+                queue, merger.producer, max_concurrent_io_requests));
+            pool_backend->done_fun = backend_done_fun;
+        }
+
         /* Hook up the `submit_fun`s of the parts of the IO stack that are above the
         queue. (The parts below the queue use the `passive_producer_t` interface instead
         of a callback function.) */
@@ -67,7 +102,7 @@ public:
                                                  &accounter, ph::_1);
 
         /* Hook up everything's `done_fun`. */
-        backend.done_fun = std::bind(&stats_diskmgr_2_t::done, &backend_stats, ph::_1);
+        merger.done_fun = std::bind(&stats_diskmgr_2_t::done, &backend_stats, ph::_1);
         backend_stats.done_fun = std::bind(&accounting_diskmgr_t::done, &accounter, ph::_1);
         accounter.done_fun = std::bind(&conflict_resolving_diskmgr_t::done,
                                        &conflict_resolver, ph::_1);
@@ -81,8 +116,10 @@ public:
                 outstanding_txn);
     }
 
-    void *create_account(int pri, int outstanding_requests_limit) {
-        return new accounting_diskmgr_t::account_t(&accounter, pri, outstanding_requests_limit);
+    void *create_account(int pri, int outstanding_requests_limit,
+                         file_io_class_t io_class) {
+        return new accounting_diskmgr_t::account_t(&accounter, pri,
+                                                   outstanding_requests_limit, io_class);
     }
 
     void destroy_account(void *account) {
@@ -126,6 +163,19 @@ public:
                                a));
     }
 
+    void submit_punch_hole(fd_t fd, int64_t offset, size_t count,
+                           void *account, linux_iocallback_t *cb) {
+        threadnum_t calling_thread = get_thread_id();
+
+        action_t *a = new action_t(calling_thread, cb);
+        a->make_punch_hole(fd, offset, count);
+        a->account = static_cast<accounting_diskmgr_t::account_t *>(account);
+
+        do_on_thread(home_thread(),
+                     std::bind(&linux_disk_manager_t::submit_action_to_stack_stats, this,
+                               a));
+    }
+
 #ifndef USE_WRITEV
 #error "USE_WRITEV not defined.  Did you include pool.hpp?"
 #elif USE_WRITEV
@@ -179,8 +229,11 @@ private:
     the conflict resolver, which enforces ordering constraints between IO operations by
     holding back operations that must be run after other, currently-running, operations.
     Then it goes to the account manager, which queues up running IO operations according
-    to which account they are part of. Finally the "backend" pops the IO operations
-    from the queue.
+    to which account they are part of. Right before the backend pops the IO
+    operations from the queue, the merger combines adjacent reads or writes that are
+    queued up into single vectored operations. The backend is either a thread pool
+    that runs blocking system calls, or an io_uring; exactly one of `pool_backend`
+    and `uring_backend` is set.
 
     At two points in the process--once as soon as it is submitted, and again right
     as the backend pops it off the queue--its statistics are recorded. The "stack stats"
@@ -193,7 +246,11 @@ private:
     conflict_resolving_diskmgr_t conflict_resolver;
     accounting_diskmgr_t accounter;
     stats_diskmgr_2_t backend_stats;
-    pool_diskmgr_t backend;
+    merging_diskmgr_t merger;
+    scoped_ptr_t<pool_diskmgr_t> pool_backend;
+#if RDB_HAS_IO_URING
+    scoped_ptr_t<uring_diskmgr_t> uring_backend;
+#endif
 
 
     intptr_t outstanding_txn;
@@ -202,11 +259,14 @@ private:
 };
 
 io_backender_t::io_backender_t(file_direct_io_mode_t _direct_io_mode,
-                               int max_concurrent_io_requests)
+                               int max_concurrent_io_requests,
+                               file_io_backend_t io_backend)
     : direct_io_mode(_direct_io_mode),
+      stats_membership(&get_global_perfmon_collection(), &stats, "disk"),
       diskmgr(new linux_disk_manager_t(&linux_thread_pool_t::get_thread()->queue,
                                        DEFAULT_IO_BATCH_FACTOR,
                                        max_concurrent_io_requests,
+                                       io_backend,
                                        &stats)) { }
 
 io_backender_t::~io_backender_t() { }
@@ -356,6 +416,21 @@ void linux_file_t::writev_async(int64_t offset, size_t length,
 
 }
 
+void linux_file_t::punch_hole_async(int64_t offset, size_t length,
+                                    file_account_t *account,
+                                    linux_iocallback_t *callback) {
+    rassert(diskmgr != nullptr,
+            "No diskmgr has been constructed (are we running without an event queue?)");
+    rassert(divides(DEVICE_BLOCK_SIZE, offset));
+    rassert(divides(DEVICE_BLOCK_SIZE, length));
+    rassert(offset >= 0 && offset + static_cast<int64_t>(length) <= file_size);
+    diskmgr->submit_punch_hole(fd.get(), offset, length,
+                               account == DEFAULT_DISK_ACCOUNT
+                               ? default_account->get_account()
+                               : account->get_account(),
+                               callback);
+}
+
 bool linux_file_t::coop_lock_and_check() {
 #ifdef _WIN32
     // TODO WINDOWS
@@ -369,9 +444,10 @@ bool linux_file_t::coop_lock_and_check() {
 #endif
 }
 
-void *linux_file_t::create_account(int priority, int outstanding_requests_limit) {
+void *linux_file_t::create_account(int priority, int outstanding_requests_limit,
+                                    file_io_class_t io_class) {
     assert_thread();
-    return diskmgr->create_account(priority, outstanding_requests_limit);
+    return diskmgr->create_account(priority, outstanding_requests_limit, io_class);
 }
 
 void linux_file_t::destroy_account(void *account) {
@@ -11,9 +11,11 @@ struct accounting_diskmgr_eager_account_t : public semaphore_available_callback_
 
     accounting_diskmgr_eager_account_t(accounting_diskmgr_t *par,
                                        int pri,
-                                       int outstanding_requests_limit) :
+                                       int outstanding_requests_limit,
+                                       file_io_class_t io_class) :
+        class_queue(par->get_class_queue(io_class)),
         outstanding_requests_limiter(outstanding_requests_limit == UNLIMITED_OUTSTANDING_REQUESTS ? SEMAPHORE_NO_LIMIT : outstanding_requests_limit),
-        account(&par->queue, &queue, pri),
+        account(&class_queue->queue, &queue, pri),
         accounter_lock(par->get_auto_drainer()) {
         rassert(outstanding_requests_limit == UNLIMITED_OUTSTANDING_REQUESTS || outstanding_requests_limit > 0);
     }
@@ -25,6 +27,7 @@ struct accounting_diskmgr_eager_account_t : public semaphore_available_callback_
     void on_semaphore_available() {
         action_t *action = throttled_queue.head();
         throttled_queue.pop_front();
+        class_queue->on_enqueue(action);
         queue.push(action);
     }
     co_semaphore_t *get_outstanding_requests_limiter() {
@@ -38,6 +41,7 @@ private:
     // we have to implement that functionality manually.
     // throttled_queue contains requests which can not be put on queue right now,
     // because the number of outstanding requests has been exceeded
+    accounting_diskmgr_t::io_class_queue_t *class_queue;
     intrusive_list_t<action_t> throttled_queue;
     unlimited_fifo_queue_t<action_t *, intrusive_list_t<action_t> > queue;
     static_semaphore_t outstanding_requests_limiter;
@@ -49,9 +53,11 @@ private:
 
 accounting_diskmgr_account_t::accounting_diskmgr_account_t(accounting_diskmgr_t *_par,
                                                            int _pri,
-                                                           int _outstanding_requests_limit)
+                                                           int _outstanding_requests_limit,
+                                                           file_io_class_t _io_class)
         : par(_par), pri(_pri),
-          outstanding_requests_limit(_outstanding_requests_limit) { }
+          outstanding_requests_limit(_outstanding_requests_limit),
+          io_class(_io_class) { }
 
 accounting_diskmgr_account_t::~accounting_diskmgr_account_t() {
     par->assert_thread();
@@ -83,7 +89,8 @@ co_semaphore_t *accounting_diskmgr_account_t::get_outstanding_requests_limiter()
 void accounting_diskmgr_account_t::maybe_init(){
     if (!eager_account.has()) {
         par->assert_thread();
-        eager_account.init(new eager_account_t(par, pri, outstanding_requests_limit));
+        eager_account.init(new eager_account_t(par, pri, outstanding_requests_limit,
+                                               io_class));
     }
 }
 
@@ -99,17 +106,167 @@ void debug_print(printf_buffer_t *buf,
 }
 
 
+accounting_diskmgr_t::io_class_queue_t::io_class_queue_t(
+        accounting_diskmgr_t *_parent, int batch_factor, ticks_t _latency_target,
+        perfmon_collection_t *stats, perfmon_collection_t *latency_stats,
+        const std::string &name) :
+    queue(batch_factor),
+    parent(_parent),
+    latency_target(_latency_target),
+    wait_sampler(secs_to_ticks(1), false),
+    stats_membership(stats,
+                     &queue_depth, (name + "_queued").c_str(),
+                     &wait_sampler, (name + "_wait_ms").c_str(),
+                     &deadline_misses, (name + "_deadline_misses").c_str()),
+    latency_membership(latency_stats, &latency_collection, name),
+    read_wait(secs_to_ticks(DISK_LATENCY_HISTOGRAM_INTERVAL_SECS)),
+    read_device(secs_to_ticks(DISK_LATENCY_HISTOGRAM_INTERVAL_SECS)),
+    write_wait(secs_to_ticks(DISK_LATENCY_HISTOGRAM_INTERVAL_SECS)),
+    write_device(secs_to_ticks(DISK_LATENCY_HISTOGRAM_INTERVAL_SECS)),
+    latency_stats_membership(&latency_collection,
+                             &read_wait, "read_queue_wait",
+                             &read_device, "read_device_time",
+                             &write_wait, "write_queue_wait",
+                             &write_device, "write_device_time") {
+    queue.available->set_callback(this);
+}
+
+accounting_diskmgr_t::io_class_queue_t::~io_class_queue_t() {
+    queue.available->unset_callback();
+}
+
+void accounting_diskmgr_t::io_class_queue_t::on_source_availability_changed() {
+    parent->update_availability();
+}
+
+void accounting_diskmgr_t::io_class_queue_t::on_enqueue(action_t *action) {
+    action->enqueue_time = get_ticks();
+    enqueue_times.insert(action->enqueue_time.nanos);
+    ++queue_depth;
+}
+
+accounting_diskmgr_t::action_t *accounting_diskmgr_t::io_class_queue_t::pop(
+        ticks_t now) {
+    action_t *action = queue.pop();
+    auto it = enqueue_times.find(action->enqueue_time.nanos);
+    rassert(it != enqueue_times.end());
+    enqueue_times.erase(it);
+    --queue_depth;
+
+    const int64_t waited = now.nanos - action->enqueue_time.nanos;
+    wait_sampler.record(static_cast<double>(waited) / MILLION);
+    if (waited > latency_target.nanos) {
+        ++deadline_misses;
+    }
+    if (action->get_is_read() || action->get_is_write()) {
+        (action->get_is_read() ? &read_wait : &write_wait)->record(ticks_t{waited});
+    }
+    return action;
+}
+
+void accounting_diskmgr_t::io_class_queue_t::on_done(action_t *action, ticks_t now) {
+    if (action->get_is_read() || action->get_is_write()) {
+        (action->get_is_read() ? &read_device : &write_device)->record(
+            ticks_t{now.nanos - action->dispatch_time.nanos});
+    }
+}
+
+ticks_t accounting_diskmgr_t::io_class_queue_t::get_deadline() const {
+    rassert(!enqueue_times.empty());
+    ticks_t deadline;
+    deadline.nanos = *enqueue_times.begin() + latency_target.nanos;
+    return deadline;
+}
+
+static ticks_t ms_to_ticks(int64_t ms) {
+    return ticks_t{ms * MILLION};
+}
+
+accounting_diskmgr_t::accounting_diskmgr_t(perfmon_collection_t *stats,
+                                           int batch_factor)
+    : passive_producer_t<accounting_payload_t *>(&availability),
+      producer(this),
+      latency_membership(stats, &latency_collection, "latency"),
+      interactive_queue(this, batch_factor,
+                        ms_to_ticks(INTERACTIVE_IO_LATENCY_TARGET_MS),
+                        stats, &latency_collection, "interactive"),
+      normal_queue(this, batch_factor,
+                   ms_to_ticks(NORMAL_IO_LATENCY_TARGET_MS),
+                   stats, &latency_collection, "normal"),
+      background_queue(this, batch_factor,
+                       ms_to_ticks(BACKGROUND_IO_LATENCY_TARGET_MS),
+                       stats, &latency_collection, "background"),
+      auto_drainer(new auto_drainer_t()) { }
+
 accounting_diskmgr_t::~accounting_diskmgr_t() {
     auto_drainer.reset();  // Make absolutely sure this happens first.
 }
 
+accounting_diskmgr_t::io_class_queue_t *accounting_diskmgr_t::get_class_queue(
+        file_io_class_t io_class) {
+    switch (io_class) {
+    case file_io_class_t::interactive: return &interactive_queue;
+    case file_io_class_t::normal: return &normal_queue;
+    case file_io_class_t::background: return &background_queue;
+    default: unreachable();
+    }
+}
+
+void accounting_diskmgr_t::update_availability() {
+    availability.set_available(interactive_queue.queue.available->get()
+                               || normal_queue.queue.available->get()
+                               || background_queue.queue.available->get());
+}
+
+accounting_payload_t *accounting_diskmgr_t::produce_next_value() {
+    return pop_next(get_ticks());
+}
+
+accounting_payload_t *accounting_diskmgr_t::pop_next(ticks_t now) {
+    assert_thread();
+
+    // In order of priority.
+    io_class_queue_t *const class_queues[] = {
+        &interactive_queue, &normal_queue, &background_queue };
+
+    // Serve the class with the earliest missed deadline, if there is one.
+    // Otherwise serve the highest class that has something for us.
+    io_class_queue_t *chosen = nullptr;
+    io_class_queue_t *highest = nullptr;
+    for (io_class_queue_t *class_queue : class_queues) {
+        if (!class_queue->queue.available->get()) {
+            continue;
+        }
+        if (highest == nullptr) {
+            highest = class_queue;
+        }
+        const ticks_t deadline = class_queue->get_deadline();
+        if (deadline.nanos < now.nanos
+            && (chosen == nullptr || deadline.nanos < chosen->get_deadline().nanos)) {
+            chosen = class_queue;
+        }
+    }
+    if (chosen == nullptr) {
+        chosen = highest;
+    }
+    rassert(chosen != nullptr);
+
+    /* Implicit cast from `action_t *` to `accounting_payload_t *` in return */
+    return chosen->pop(now);
+}
+
 void accounting_diskmgr_t::submit(action_t *a) {
     a->account->push(a);
 }
 
+void accounting_diskmgr_t::dispatched(accounting_payload_t *p) {
+    static_cast<action_t *>(p)->dispatch_time = get_ticks();
+}
+
 void accounting_diskmgr_t::done(accounting_payload_t *p) {
     // p really is an action_t...
     action_t *a = static_cast<action_t *>(p);
+    get_class_queue(a->account->get_io_class())->on_done(a, get_ticks());
     a->account->get_outstanding_requests_limiter()->unlock(1);
     a->account_acq.reset();
     done_fun(static_cast<action_t *>(p));
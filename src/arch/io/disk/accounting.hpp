@@ -3,6 +3,8 @@
 #define ARCH_IO_DISK_ACCOUNTING_HPP_
 
 #include <functional>
+#include <set>
+#include <string>
 
 #include "containers/intrusive_list.hpp"
 #include "containers/scoped.hpp"
@@ -12,27 +14,25 @@
 #include "concurrency/semaphore.hpp"
 #include "arch/io/disk.hpp"
 #include "arch/io/disk/stats_2.hpp"
-
-/* `casting_passive_producer_t` is useful when you have a
-`passive_producer_t<X>` but you need a `passive_producer_t<Y>`, where `X` can
-be cast to `Y`. */
-
-template <class input_t, class output_t>
-struct casting_passive_producer_t : public passive_producer_t<output_t> {
-    explicit casting_passive_producer_t(passive_producer_t<input_t> *_source) :
-        passive_producer_t<output_t>(_source->available), source(_source) { }
-
-    output_t produce_next_value() {
-        /* Implicit cast from `input_t` to `output_t` in return */
-        return source->pop();
-    }
-
-private:
-    passive_producer_t<input_t> *source;
-};
+#include "perfmon/perfmon.hpp"
 
 /* `accounting_diskmgr_t` shares disk throughput proportionally between a
-number of different "accounts". */
+number of different "accounts".
+
+Every account belongs to a latency class (see `file_io_class_t`), and each class
+has its own `accounting_queue_t` that shares the disk between the accounts in that
+class by weight. Between classes, the `accounting_diskmgr_t` schedules by
+deadline: every class has a latency target, and if the oldest operation waiting
+in some class has been waiting for longer than that, the class with the earliest
+missed deadline gets served. Otherwise the highest class that has operations
+waiting gets served. That way cache-miss reads can pass GC, backfill and flush
+writes that are queued up, while lower classes are still guaranteed to make
+progress.
+
+For every class, the `accounting_diskmgr_t` also keeps latency histograms of reads
+and writes, split into the time that an operation waited on its class's queue
+and the time that the backend took to run it, from when it was handed to the
+backend. Those show up under "latency" in the stats. */
 
 typedef stats_diskmgr_2_t::action_t accounting_payload_t;
 
@@ -42,18 +42,24 @@ struct accounting_diskmgr_action_t;
 
 struct accounting_diskmgr_eager_account_t;
 
+namespace unittest {
+struct accounting_test_driver_t;
+}
+
 struct accounting_diskmgr_account_t {
     typedef accounting_diskmgr_action_t action_t;
 
     accounting_diskmgr_account_t(accounting_diskmgr_t *_par,
                                  int _pri,
-                                 int _outstanding_requests_limit);
+                                 int _outstanding_requests_limit,
+                                 file_io_class_t _io_class);
 
     ~accounting_diskmgr_account_t();
 
     void push(action_t *action);
     void on_semaphore_available();
     co_semaphore_t *get_outstanding_requests_limiter();
+    file_io_class_t get_io_class() const { return io_class; }
 
 private:
     typedef accounting_diskmgr_eager_account_t eager_account_t;
@@ -63,6 +69,7 @@ private:
     accounting_diskmgr_t *par;
     int pri;
     int outstanding_requests_limit;
+    file_io_class_t io_class;
     scoped_ptr_t<eager_account_t> eager_account;
     // A scoped pointer because we create the drainer lazily on first use.
     scoped_ptr_t<auto_drainer_t> requests_drainer;
@@ -75,18 +82,20 @@ struct accounting_diskmgr_action_t
       public accounting_payload_t {
     accounting_diskmgr_account_t *account;
     auto_drainer_t::lock_t account_acq;
+    // When the action was put on its class's queue.
+    ticks_t enqueue_time;
+    // When the action was handed to the backend (see `accounting_diskmgr_t::
+    // dispatched()`).
+    ticks_t dispatch_time;
 };
 
 void debug_print(printf_buffer_t *buf,
                  const accounting_diskmgr_action_t &action);
 
-class accounting_diskmgr_t : public home_thread_mixin_t {
+class accounting_diskmgr_t : private passive_producer_t<accounting_payload_t *>,
+                             public home_thread_mixin_t {
 public:
-    explicit accounting_diskmgr_t(int batch_factor)
-        : producer(&caster),
-          queue(batch_factor),
-          caster(&queue),
-          auto_drainer(new auto_drainer_t()) { }
+    accounting_diskmgr_t(perfmon_collection_t *stats, int batch_factor);
 
     ~accounting_diskmgr_t();
 
@@ -101,15 +110,69 @@ public:
     passive_producer_t<accounting_payload_t *> * const producer;
     void done(accounting_payload_t *p);
 
+    /* Should be called when an action that came from `producer` goes to the
+    backend. The device time of the action is measured from then, so that it
+    doesn't include the time that it spent further down the IO stack. */
+    void dispatched(accounting_payload_t *p);
+
     auto_drainer_t *get_auto_drainer() {
         return auto_drainer.get();
     }
 
 private:
     friend struct accounting_diskmgr_eager_account_t;
-
-    accounting_queue_t<action_t *> queue;
-    casting_passive_producer_t<action_t *, accounting_payload_t *> caster;
+    friend struct unittest::accounting_test_driver_t;
+
+    /* The queue and the statistics for one latency class. */
+    class io_class_queue_t : private availability_callback_t {
+    public:
+        io_class_queue_t(accounting_diskmgr_t *parent, int batch_factor,
+                         ticks_t latency_target, perfmon_collection_t *stats,
+                         perfmon_collection_t *latency_stats,
+                         const std::string &name);
+        ~io_class_queue_t();
+
+        // Called by the eager accounts when they put an action on `queue`.
+        void on_enqueue(action_t *action);
+        action_t *pop(ticks_t now);
+        // Called when the backend is done with an action from `queue`.
+        void on_done(action_t *action, ticks_t now);
+        // Returns the time by which the oldest queued action should be served.
+        ticks_t get_deadline() const;
+
+        accounting_queue_t<action_t *> queue;
+
+    private:
+        void on_source_availability_changed();
+
+        accounting_diskmgr_t *parent;
+        const ticks_t latency_target;
+        // The enqueue times of the actions that are on `queue`.
+        std::multiset<int64_t> enqueue_times;
+
+        perfmon_counter_t queue_depth;
+        perfmon_sampler_t wait_sampler;
+        perfmon_counter_t deadline_misses;
+        perfmon_multi_membership_t stats_membership;
+
+        perfmon_collection_t latency_collection;
+        perfmon_membership_t latency_membership;
+        perfmon_latency_histogram_t read_wait, read_device, write_wait, write_device;
+        perfmon_multi_membership_t latency_stats_membership;
+
+        DISABLE_COPYING(io_class_queue_t);
+    };
+
+    accounting_payload_t *produce_next_value();
+    // Picks the class to serve as of `now`, and pops the next action from it.
+    accounting_payload_t *pop_next(ticks_t now);
+    void update_availability();
+    io_class_queue_t *get_class_queue(file_io_class_t io_class);
+
+    availability_control_t availability;
+    perfmon_collection_t latency_collection;
+    perfmon_membership_t latency_membership;
+    io_class_queue_t interactive_queue, normal_queue, background_queue;
     scoped_ptr_t<auto_drainer_t> auto_drainer;
 
     DISABLE_COPYING(accounting_diskmgr_t);
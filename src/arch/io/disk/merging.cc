@@ -0,0 +1,205 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/io/disk/merging.hpp"
+
+#include <sys/uio.h>
+
+#include <algorithm>
+
+#include "config/args.hpp"
+
+merging_diskmgr_t::merging_diskmgr_t(perfmon_collection_t *stats,
+                                     const std::string &name,
+                                     passive_producer_t<action_t *> *_source) :
+    passive_producer_t<action_t *>(&availability),
+    producer(this),
+    source(_source),
+    filling_pending(false),
+    held(nullptr),
+    merge_size_sampler(secs_to_ticks(1), true),
+    stats_membership(stats,
+                     &merged_counter, (name + "_merged").c_str(),
+                     &merge_size_sampler, (name + "_merge_size").c_str()) {
+    update_availability();
+    source->available->set_callback(this);
+}
+
+merging_diskmgr_t::~merging_diskmgr_t() {
+    rassert(held == nullptr);
+    rassert(merged_actions.empty());
+    source->available->unset_callback();
+}
+
+void merging_diskmgr_t::on_source_availability_changed() {
+    // While we are pulling operations from `source` ourselves, we update our
+    // availability once we are done.
+    if (!filling_pending) {
+        update_availability();
+    }
+}
+
+void merging_diskmgr_t::update_availability() {
+    availability.set_available(held != nullptr || source->available->get());
+}
+
+bool merging_diskmgr_t::is_mergeable(const action_t *action) {
+    return (action->get_is_read() || action->get_is_write())
+        && action->get_ds_op() == datasync_op::no_datasyncs;
+}
+
+bool merging_diskmgr_t::try_extend(const action_t *first, const action_t *action,
+                                   int64_t *begin, int64_t *end) {
+    const bool is_read = first->get_is_read();
+    const int64_t max_gap = is_read ? DISK_MERGE_MAX_READ_GAP : 0;
+    const int64_t a_begin = action->get_offset();
+    const int64_t a_end = a_begin + action->get_count();
+    const bool joins = is_mergeable(action)
+        && action->get_fd() == first->get_fd()
+        && action->get_is_read() == is_read
+        && std::max(a_end, *end) - std::min(a_begin, *begin) <= DISK_MERGE_MAX_SIZE
+        && ((a_begin >= *end && a_begin - *end <= max_gap)
+            || (a_end <= *begin && *begin - a_end <= max_gap));
+    if (joins) {
+        *begin = std::min(*begin, a_begin);
+        *end = std::max(*end, a_end);
+    }
+    return joins;
+}
+
+merging_diskmgr_t::action_t *merging_diskmgr_t::produce_next_value() {
+    action_t *first;
+    if (held != nullptr) {
+        first = held;
+        held = nullptr;
+    } else {
+        first = source->pop();
+    }
+
+#ifndef USE_WRITEV
+#error "USE_WRITEV not defined.  Did you include pool.hpp?"
+#elif USE_WRITEV
+    if (is_mergeable(first)) {
+        int64_t begin = first->get_offset();
+        int64_t end = begin + first->get_count();
+        std::vector<action_t *> parts(1, first);
+
+        // Keep taking operations for as long as they extend the range [begin, end)
+        // on either side.
+        filling_pending = true;
+        while (parts.size() < DISK_MERGE_MAX_OPS && source->available->get()) {
+            action_t *a = source->pop();
+            if (try_extend(first, a, &begin, &end)) {
+                parts.push_back(a);
+            } else {
+                held = a;
+                break;
+            }
+        }
+        filling_pending = false;
+
+        if (parts.size() > 1) {
+            for (action_t *part : parts) {
+                dispatch_fun(part);
+            }
+            update_availability();
+            return make_merged_action(std::move(parts));
+        }
+    }
+#endif  // USE_WRITEV
+
+    dispatch_fun(first);
+    update_availability();
+    return first;
+}
+
+merging_diskmgr_action_t *merging_diskmgr_t::make_merged_action(
+        std::vector<action_t *> &&parts) {
+#ifndef USE_WRITEV
+#error "USE_WRITEV not defined.  Did you include pool.hpp?"
+#elif USE_WRITEV
+    std::sort(parts.begin(), parts.end(), [](action_t *x, action_t *y) {
+        return x->get_offset() < y->get_offset();
+    });
+
+    merging_diskmgr_action_t *merged = new merging_diskmgr_action_t;
+
+    // Count the io vectors we need, and find out how large the gaps are.
+    size_t num_vecs = 0;
+    int64_t max_gap = 0;
+    for (size_t i = 0; i < parts.size(); ++i) {
+        iovec *vecs;
+        size_t vecs_len;
+        parts[i]->get_bufs(&vecs, &vecs_len);
+        num_vecs += vecs_len;
+        if (i > 0) {
+            int64_t gap = parts[i]->get_offset()
+                - (parts[i - 1]->get_offset() + parts[i - 1]->get_count());
+            rassert(gap >= 0);
+            if (gap > 0) {
+                ++num_vecs;
+                max_gap = std::max(max_gap, gap);
+            }
+        }
+    }
+    if (max_gap > 0) {
+        // All the gaps can share the same scratch buffer.
+        merged->gap_buf = scoped_device_block_aligned_ptr_t<char>(max_gap);
+    }
+
+    scoped_array_t<iovec> merged_vecs(num_vecs);
+    size_t vec_ix = 0;
+    for (size_t i = 0; i < parts.size(); ++i) {
+        if (i > 0) {
+            int64_t gap = parts[i]->get_offset()
+                - (parts[i - 1]->get_offset() + parts[i - 1]->get_count());
+            if (gap > 0) {
+                merged_vecs[vec_ix].iov_base = merged->gap_buf.get();
+                merged_vecs[vec_ix].iov_len = gap;
+                ++vec_ix;
+            }
+        }
+        iovec *vecs;
+        size_t vecs_len;
+        parts[i]->get_bufs(&vecs, &vecs_len);
+        std::copy(vecs, vecs + vecs_len, merged_vecs.data() + vec_ix);
+        vec_ix += vecs_len;
+    }
+    rassert(vec_ix == num_vecs);
+
+    const fd_t fd = parts.front()->get_fd();
+    const int64_t begin = parts.front()->get_offset();
+    const int64_t end = parts.back()->get_offset() + parts.back()->get_count();
+    if (parts.front()->get_is_read()) {
+        merged->make_readv(fd, std::move(merged_vecs), end - begin, begin);
+    } else {
+        merged->make_writev(fd, std::move(merged_vecs), end - begin, begin);
+    }
+
+    merged_counter += parts.size();
+    merge_size_sampler.record(parts.size());
+    merged->parts = std::move(parts);
+    merged_actions.insert(merged);
+    return merged;
+#else
+    unreachable();
+#endif  // USE_WRITEV
+}
+
+void merging_diskmgr_t::done(action_t *action) {
+    auto it = merged_actions.find(action);
+    if (it == merged_actions.end()) {
+        done_fun(action);
+        return;
+    }
+    merged_actions.erase(it);
+
+    scoped_ptr_t<merging_diskmgr_action_t> merged(
+        static_cast<merging_diskmgr_action_t *>(action));
+    for (action_t *part : merged->parts) {
+        if (merged->get_succeeded()) {
+            part->io_result = part->get_count();
+        } else {
+            part->io_result = merged->io_result;
+        }
+        done_fun(part);
+    }
+}
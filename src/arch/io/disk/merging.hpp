@@ -0,0 +1,100 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef ARCH_IO_DISK_MERGING_HPP_
+#define ARCH_IO_DISK_MERGING_HPP_
+
+#include <functional>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "arch/io/disk/pool.hpp"
+#include "concurrency/queue/passive_producer.hpp"
+#include "containers/scoped.hpp"
+#include "perfmon/perfmon.hpp"
+
+/* The merging disk manager sits right above the backend. When the backend asks
+for the next disk operation, it takes the next operation from the accounting disk
+manager, and then keeps taking operations for as long as they are reads or writes
+on the same file that are adjacent to the ones it has, and combines them into a
+single vectored read or write. This saves system calls and gives the device larger
+requests during range scans and garbage collection, whose operations come out of
+their account one after the other.
+
+Reads that are separated by a small gap (at most `DISK_MERGE_MAX_READ_GAP` bytes)
+are merged as well; the data in the gap is read into a scratch buffer and thrown
+away. Writes are only merged if they are exactly adjacent. Resizes and operations
+that involve a datasync are never merged.
+
+The merging disk manager only takes operations in the order that the accounting
+disk manager releases them, and only while they can be merged. The first one that
+can't be merged is held back and passed on next, so at most one operation that the
+accounting disk manager has already released waits here; operations of a higher
+latency class that come in meanwhile aren't stuck behind a queue of lower class
+operations. The merging disk manager never waits for a merge partner. Operations
+that come out of the accounting disk manager one after the other can only be
+merged if they don't conflict with each other, which the conflict resolving disk
+manager guarantees. */
+
+struct merging_diskmgr_action_t : public pool_diskmgr_t::action_t {
+    // The operations that were combined into this one.
+    std::vector<pool_diskmgr_t::action_t *> parts;
+    // Scratch space that the gaps between merged reads are read into.
+    scoped_device_block_aligned_ptr_t<char> gap_buf;
+};
+
+class merging_diskmgr_t : private passive_producer_t<pool_diskmgr_t::action_t *>,
+                          private availability_callback_t {
+public:
+    typedef pool_diskmgr_t::action_t action_t;
+
+    /* Give the `merging_diskmgr_t` constructor a `passive_producer_t<action_t *>`;
+    it will get its operations from there. It will call `done_fun` on each one
+    when it's done. */
+    merging_diskmgr_t(perfmon_collection_t *stats, const std::string &name,
+                      passive_producer_t<action_t *> *source);
+    ~merging_diskmgr_t();
+
+    std::function<void(action_t *)> done_fun;
+
+    /* Called on each operation when it goes to the backend, on its own or as part
+    of a merged operation. */
+    std::function<void(action_t *)> dispatch_fun;
+
+    passive_producer_t<action_t *> *const producer;
+    void done(action_t *action);
+
+private:
+    action_t *produce_next_value();
+    void on_source_availability_changed();
+    void update_availability();
+
+    // Returns true if `action` is a read or write that we may merge with others.
+    static bool is_mergeable(const action_t *action);
+    // Returns true if `action` can be merged with `first`, whose merged operation
+    // currently covers [*begin, *end), and extends the range if so.
+    static bool try_extend(const action_t *first, const action_t *action,
+                           int64_t *begin, int64_t *end);
+    // Creates a merged action for the given operations, sorted by offset.
+    merging_diskmgr_action_t *make_merged_action(std::vector<action_t *> &&parts);
+
+    passive_producer_t<action_t *> *const source;
+    availability_control_t availability;
+    bool filling_pending;
+
+    // The operation that we have taken from `source` but couldn't merge with the
+    // previous ones, or null.  We pass it on next.
+    action_t *held;
+
+    // The merged actions that are currently being run by the backend.
+    std::set<action_t *> merged_actions;
+
+    // Counts the operations that were merged into a larger one.
+    perfmon_counter_t merged_counter;
+    // Records the number of operations that went into each merged operation.
+    perfmon_sampler_t merge_size_sampler;
+    perfmon_multi_membership_t stats_membership;
+
+    DISABLE_COPYING(merging_diskmgr_t);
+};
+
+#endif  // ARCH_IO_DISK_MERGING_HPP_
@@ -181,6 +181,24 @@ void pool_diskmgr_t::action_t::run() {
             io_result = -get_errno();
             return;
         }
+#endif
+    } break;
+    case ACTION_PUNCH_HOLE: {
+#if defined(__linux__) && defined(FALLOC_FL_PUNCH_HOLE)
+        int res;
+        do {
+            res = fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                            offset, get_count());
+        } while (res == -1 && get_errno() == EINTR);
+        if (res == 0) {
+            io_result = get_count();
+        } else {
+            io_result = -get_errno();
+            return;
+        }
+#else
+        io_result = -EOPNOTSUPP;
+        return;
 #endif
     } break;
     case ACTION_READ:
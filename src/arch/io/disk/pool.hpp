@@ -52,6 +52,18 @@ struct pool_diskmgr_action_t
         size_change = _new_size - _old_size;
     }
 
+    // Frees the disk space of [_offset, _offset + _count), which reads as zeros
+    // afterwards.  The file size stays the same.
+    void make_punch_hole(fd_t _fd, int64_t _offset, size_t _count) {
+        type = ACTION_PUNCH_HOLE;
+        ds_op = datasync_op::no_datasyncs;
+        fd = _fd;
+        buf_and_count.iov_base = nullptr;
+        buf_and_count.iov_len = _count;
+        offset = _offset;
+        size_change = 0;
+    }
+
 #ifndef USE_WRITEV
 #error "USE_WRITEV not defined... but we are in pool.hpp.  Where is it?"
 #elif USE_WRITEV
@@ -65,6 +77,17 @@ struct pool_diskmgr_action_t
         offset = _offset;
         size_change = 0;
     }
+
+    void make_readv(fd_t _fd, scoped_array_t<iovec> &&_bufs, size_t _count, int64_t _offset) {
+        type = ACTION_READ;
+        ds_op = datasync_op::no_datasyncs;
+        fd = _fd;
+        iovecs = std::move(_bufs);
+        buf_and_count.iov_base = nullptr;
+        buf_and_count.iov_len = _count;
+        offset = _offset;
+        size_change = 0;
+    }
 #endif
 
     void make_read(fd_t _fd, void *_buf, size_t _count, int64_t _offset) {
@@ -80,6 +103,7 @@ struct pool_diskmgr_action_t
     bool get_is_write() const { return type == ACTION_WRITE; }
     bool get_is_resize() const { return type == ACTION_RESIZE; }
     bool get_is_read() const { return type == ACTION_READ; }
+    bool get_is_punch_hole() const { return type == ACTION_PUNCH_HOLE; }
     fd_t get_fd() const { return fd; }
     void get_bufs(iovec **iovecs_out, size_t *iovecs_len_out) {
         if (buf_and_count.iov_base != nullptr) {
@@ -93,6 +117,7 @@ struct pool_diskmgr_action_t
     size_t get_count() const { return buf_and_count.iov_len; }
     int64_t get_offset() const { return offset; }
     int64_t get_size_change() const { return size_change; }
+    datasync_op get_ds_op() const { return ds_op; }
 
     void set_successful_due_to_conflict() { io_result = get_count(); }
     bool get_succeeded() const { return io_result == static_cast<int64_t>(get_count()); }
@@ -103,17 +128,18 @@ struct pool_diskmgr_action_t
 
 private:
     friend class pool_diskmgr_t;
+    friend class uring_diskmgr_t;
+    friend class merging_diskmgr_t;
     pool_diskmgr_t *parent;
 
-    enum action_type_t {ACTION_READ, ACTION_WRITE, ACTION_RESIZE};
+    enum action_type_t {ACTION_READ, ACTION_WRITE, ACTION_RESIZE, ACTION_PUNCH_HOLE};
     action_type_t type;
     datasync_op ds_op;
     fd_t fd;
 
-    // Either type is ACTION_RESIZE, or buf_and_count.iov_base is used, or iovecs
-    // is used (for writev).  If iovecs is used, then buf_and_count.iov_len is the
-    // sum of the iovecs' iov_len fields.  Currently readv is not supported, but if
-    // you need it, it should be easy to add.
+    // Either type is ACTION_RESIZE or ACTION_PUNCH_HOLE, or buf_and_count.iov_base
+    // is used, or iovecs is used (for writev and readv).  If iovecs is used, then buf_and_count.iov_len
+    // is the sum of the iovecs' iov_len fields.
     scoped_array_t<iovec> iovecs;
     iovec buf_and_count;
     int64_t offset;
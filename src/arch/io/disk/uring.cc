@@ -0,0 +1,232 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/io/disk/uring.hpp"
+
+#if RDB_HAS_IO_URING
+
+#include <limits.h>
+#include <linux/io_uring.h>
+
+#include <algorithm>
+
+#include "arch/io/disk.hpp"
+#include "config/args.hpp"
+#include "logger.hpp"
+
+// We don't want to put more than this many entries into a single ring, no matter
+// how many concurrent IO requests the user asked for.
+const unsigned MAX_IO_URING_ENTRIES = 4096;
+
+/* A `request_t` tracks a read or write while it is in the ring. A request goes
+through up to three stages, each of which is a separate submission: an optional
+datasync before the operation, the read or write itself (which is resubmitted
+if the kernel only transfers part of the data), and an optional datasync after
+it. */
+struct uring_diskmgr_t::request_t {
+    enum class stage_t { datasync_before, read_write, datasync_after };
+
+    action_t *action;
+    stage_t stage;
+
+    // A copy of the action's io vectors. It gets advanced as data is transferred.
+    scoped_array_t<iovec> vecs;
+    iovec *remaining_vecs;
+    size_t remaining_vecs_len;
+    int64_t bytes_done;
+};
+
+/* Resize and punch hole operations are run on the `resize_pool` using the same code
+that the pool disk manager uses. */
+class uring_diskmgr_t::resize_job_t : public blocker_pool_t::job_t {
+public:
+    resize_job_t(uring_diskmgr_t *_parent, action_t *_action)
+        : parent(_parent), action(_action) { }
+
+    void run() {
+        action->run();
+    }
+
+    void done() {
+        uring_diskmgr_t *local_parent = parent;
+        action_t *local_action = action;
+        delete this;
+        local_parent->on_resize_done(local_action);
+    }
+
+private:
+    uring_diskmgr_t *parent;
+    action_t *action;
+
+    DISABLE_COPYING(resize_job_t);
+};
+
+bool uring_diskmgr_t::is_supported() {
+    return io_uring_ring_t::is_supported();
+}
+
+uring_diskmgr_t::uring_diskmgr_t(linux_event_queue_t *_queue,
+                                 passive_producer_t<action_t *> *_source,
+                                 int max_concurrent_io_requests)
+    : queue(_queue),
+      source(_source),
+      queue_depth(std::min<unsigned>(max_concurrent_io_requests, MAX_IO_URING_ENTRIES)),
+      ring(new io_uring_ring_t(queue_depth)),
+      resize_pool(1, _queue),
+      n_pending(0) {
+    guarantee(max_concurrent_io_requests > 0);
+    guarantee(ring->get_sq_entries() >= static_cast<unsigned>(queue_depth));
+    ring->register_eventfd(completion_event.get_notify_fd());
+    queue->watch_event(&completion_event, this);
+
+    if (source->available->get()) { pump(); }
+    source->available->set_callback(this);
+}
+
+uring_diskmgr_t::~uring_diskmgr_t() {
+    assert_thread();
+    rassert(n_pending == 0, "Destroying the io_uring disk manager with %d "
+            "outstanding requests", n_pending);
+    source->available->unset_callback();
+    queue->forget_event(&completion_event, this);
+}
+
+void uring_diskmgr_t::on_source_availability_changed() {
+    assert_thread();
+    if (source->available->get()) pump();
+}
+
+void uring_diskmgr_t::pump() {
+    assert_thread();
+    while (source->available->get() && n_pending < queue_depth) {
+        action_t *a = source->pop();
+        n_pending++;
+        start_request(a);
+    }
+    ring->flush();
+}
+
+void uring_diskmgr_t::start_request(action_t *action) {
+    if (action->get_is_resize() || action->get_is_punch_hole()) {
+        resize_pool.do_job(new resize_job_t(this, action));
+        return;
+    }
+
+    request_t *request = new request_t;
+    request->action = action;
+    request->stage = action->ds_op == datasync_op::wrap_in_datasyncs
+        ? request_t::stage_t::datasync_before
+        : request_t::stage_t::read_write;
+    action->copy_vectors(&request->vecs);
+    request->remaining_vecs = request->vecs.data();
+    request->remaining_vecs_len = request->vecs.size();
+    request->bytes_done = 0;
+    submit_stage(request);
+}
+
+void uring_diskmgr_t::submit_stage(request_t *request) {
+    action_t *action = request->action;
+    io_uring_sqe *sqe = ring->next_sqe();
+    sqe->fd = action->fd;
+    sqe->user_data = reinterpret_cast<uintptr_t>(request);
+    switch (request->stage) {
+    case request_t::stage_t::datasync_before:
+    case request_t::stage_t::datasync_after:
+        sqe->opcode = IORING_OP_FSYNC;
+        sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+        break;
+    case request_t::stage_t::read_write:
+        sqe->opcode = action->type == action_t::ACTION_READ
+            ? IORING_OP_READV
+            : IORING_OP_WRITEV;
+        sqe->addr = reinterpret_cast<uintptr_t>(request->remaining_vecs);
+        sqe->len = std::min<size_t>(request->remaining_vecs_len, IOV_MAX);
+        sqe->off = action->offset + request->bytes_done;
+        break;
+    default:
+        unreachable();
+    }
+}
+
+void uring_diskmgr_t::on_event(DEBUG_VAR int events) {
+    assert_thread();
+    rassert(events == poll_event_in);
+    completion_event.consume_wakey_wakeys();
+
+    std::vector<io_uring_completion_t> completions;
+    ring->reap(&completions);
+    for (const auto &completion : completions) {
+        on_completion(reinterpret_cast<request_t *>(completion.user_data),
+                      completion.res);
+    }
+    ring->flush();
+}
+
+void uring_diskmgr_t::on_completion(request_t *request, int32_t res) {
+    action_t *action = request->action;
+    if (res == -EINTR || res == -EAGAIN) {
+        submit_stage(request);
+        return;
+    } else if (res < 0) {
+        finish_request(request, res);
+        return;
+    }
+
+    switch (request->stage) {
+    case request_t::stage_t::datasync_before:
+        request->stage = request_t::stage_t::read_write;
+        submit_stage(request);
+        break;
+    case request_t::stage_t::read_write: {
+        const int64_t total_bytes = action->get_count();
+        if (res == 0 && action->type == action_t::ACTION_WRITE) {
+            // See `pool_diskmgr_t::action_t::perform_read_write` for why we
+            // treat this as running out of disk space.
+            logERR("Failed I/O: vectored write of %" PRIi64 " bytes stopped after "
+                   "%" PRIi64 " bytes. Assuming we ran out of disk space.",
+                   total_bytes, request->bytes_done);
+            finish_request(request, -ENOSPC);
+            return;
+        } else if (res == 0) {
+            logERR("Failed I/O: we tried to read from behind the end of the file. "
+                   "Either the file got truncated, or there is a bug in RethinkDB.");
+            finish_request(request, -EINVAL);
+            return;
+        }
+
+        request->bytes_done += action_t::advance_vector(&request->remaining_vecs,
+                                                        &request->remaining_vecs_len,
+                                                        res);
+        if (request->bytes_done < total_bytes) {
+            submit_stage(request);
+        } else if (action->ds_op == datasync_op::wrap_in_datasyncs
+                   || action->ds_op == datasync_op::datasync_after) {
+            request->stage = request_t::stage_t::datasync_after;
+            submit_stage(request);
+        } else {
+            finish_request(request, total_bytes);
+        }
+    } break;
+    case request_t::stage_t::datasync_after:
+        finish_request(request, action->get_count());
+        break;
+    default:
+        unreachable();
+    }
+}
+
+void uring_diskmgr_t::finish_request(request_t *request, int64_t io_result) {
+    action_t *action = request->action;
+    action->io_result = io_result;
+    delete request;
+    n_pending--;
+    pump();
+    done_fun(action);
+}
+
+void uring_diskmgr_t::on_resize_done(action_t *action) {
+    assert_thread();
+    n_pending--;
+    pump();
+    done_fun(action);
+}
+
+#endif  // RDB_HAS_IO_URING
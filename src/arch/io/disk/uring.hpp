@@ -0,0 +1,85 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef ARCH_IO_DISK_URING_HPP_
+#define ARCH_IO_DISK_URING_HPP_
+
+#include "arch/io/io_uring.hpp"
+
+#if RDB_HAS_IO_URING
+
+#include <sys/uio.h>
+
+#include <functional>
+#include <vector>
+
+#include "arch/io/blocker_pool.hpp"
+#include "arch/io/disk/pool.hpp"
+#include "arch/runtime/event_queue.hpp"
+#include "arch/runtime/system_event.hpp"
+#include "concurrency/queue/passive_producer.hpp"
+#include "containers/scoped.hpp"
+
+/* The io_uring disk manager is an alternative to the pool disk manager. Instead
+of handing blocking `preadv`/`pwritev` calls to a pool of blocker threads, it
+puts the requests on the submission queue of an io_uring directly from the event
+queue thread, and reaps their results from the completion queue when the ring's
+eventfd fires. That saves a thread context switch per request and lets us keep
+many more requests in flight.
+
+It consumes the same `pool_diskmgr_t::action_t`s as the pool disk manager, so it
+can be swapped in below the accounting and stats layers without them noticing.
+Resize operations (which io_uring can't do on the kernels we care about) are
+still run on a small blocker pool.
+
+Use `uring_diskmgr_t::is_supported()` to check whether the running kernel has
+io_uring before constructing one. */
+
+class uring_diskmgr_t : private availability_callback_t,
+                        private linux_event_callback_t,
+                        public home_thread_mixin_debug_only_t {
+public:
+    typedef pool_diskmgr_action_t action_t;
+
+    /* Returns true if the running kernel lets us set up an io_uring with the
+    features we rely on. */
+    static bool is_supported();
+
+    /* Like the `pool_diskmgr_t`, the `uring_diskmgr_t` draws actions to run from
+    `source` and calls `done_fun` on each one when it's done. */
+    uring_diskmgr_t(linux_event_queue_t *queue, passive_producer_t<action_t *> *source,
+                    int max_concurrent_io_requests);
+    std::function<void(action_t *)> done_fun;
+    ~uring_diskmgr_t();
+
+private:
+    struct request_t;
+    class resize_job_t;
+
+    void on_source_availability_changed();
+    void on_event(int events);
+
+    void pump();
+    void start_request(action_t *action);
+    // Puts the next stage of `request` on the submission queue.
+    void submit_stage(request_t *request);
+    void on_completion(request_t *request, int32_t res);
+    void finish_request(request_t *request, int64_t io_result);
+    void on_resize_done(action_t *action);
+
+    linux_event_queue_t *const queue;
+    passive_producer_t<action_t *> *const source;
+    const int queue_depth;
+
+    scoped_ptr_t<io_uring_ring_t> ring;
+    system_event_t completion_event;
+
+    // Resizes are run synchronously on this pool.
+    blocker_pool_t resize_pool;
+
+    int n_pending;
+
+    DISABLE_COPYING(uring_diskmgr_t);
+};
+
+#endif  // RDB_HAS_IO_URING
+
+#endif  // ARCH_IO_DISK_URING_HPP_
@@ -0,0 +1,157 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/io/io_uring.hpp"
+
+#if RDB_HAS_IO_URING
+
+#include <linux/io_uring.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+namespace {
+
+int sys_io_uring_setup(unsigned entries, io_uring_params *params) {
+    return syscall(__NR_io_uring_setup, entries, params);
+}
+
+int sys_io_uring_enter(int ring_fd, unsigned to_submit, unsigned flags = 0) {
+    return syscall(__NR_io_uring_enter, ring_fd, to_submit, 0, flags, nullptr, 0);
+}
+
+int sys_io_uring_register(int ring_fd, unsigned opcode, const void *arg,
+                          unsigned nr_args) {
+    return syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args);
+}
+
+}  // namespace
+
+bool io_uring_ring_t::is_supported(uint32_t extra_features) {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int ring_fd = sys_io_uring_setup(1, &params);
+    if (ring_fd < 0) {
+        return false;
+    }
+    int res = close(ring_fd);
+    guarantee_err(res == 0 || get_errno() == EINTR, "Could not close io_uring");
+    const uint32_t required = IORING_FEAT_SINGLE_MMAP | extra_features;
+    return (params.features & required) == required;
+}
+
+io_uring_ring_t::io_uring_ring_t(unsigned entries, unsigned cq_entries)
+    : n_unsubmitted(0) {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    if (cq_entries != 0) {
+        params.flags |= IORING_SETUP_CQSIZE;
+        params.cq_entries = cq_entries;
+    }
+    ring_fd = sys_io_uring_setup(entries, &params);
+    guarantee_err(ring_fd >= 0, "Could not set up io_uring");
+    guarantee((params.features & IORING_FEAT_SINGLE_MMAP) != 0,
+              "io_uring does not support IORING_FEAT_SINGLE_MMAP");
+
+    sq_entries = params.sq_entries;
+    ring_size = std::max<size_t>(
+        params.sq_off.array + params.sq_entries * sizeof(unsigned),
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+    ring_ptr = mmap(nullptr, ring_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+    guarantee_err(ring_ptr != MAP_FAILED, "Could not map io_uring rings");
+    sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    void *sqes_ptr = mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+    guarantee_err(sqes_ptr != MAP_FAILED, "Could not map io_uring submission entries");
+    sqes = static_cast<io_uring_sqe *>(sqes_ptr);
+
+    char *base = static_cast<char *>(ring_ptr);
+    sq_head = reinterpret_cast<unsigned *>(base + params.sq_off.head);
+    sq_tail = reinterpret_cast<unsigned *>(base + params.sq_off.tail);
+    sq_flags = reinterpret_cast<unsigned *>(base + params.sq_off.flags);
+    sq_mask = *reinterpret_cast<unsigned *>(base + params.sq_off.ring_mask);
+    sq_array = reinterpret_cast<unsigned *>(base + params.sq_off.array);
+    cq_head = reinterpret_cast<unsigned *>(base + params.cq_off.head);
+    cq_tail = reinterpret_cast<unsigned *>(base + params.cq_off.tail);
+    cq_mask = *reinterpret_cast<unsigned *>(base + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe *>(base + params.cq_off.cqes);
+}
+
+io_uring_ring_t::~io_uring_ring_t() {
+    rassert(n_unsubmitted == 0);
+    int res = munmap(sqes, sqes_size);
+    guarantee_err(res == 0, "Could not unmap io_uring submission entries");
+    res = munmap(ring_ptr, ring_size);
+    guarantee_err(res == 0, "Could not unmap io_uring rings");
+    res = close(ring_fd);
+    guarantee_err(res == 0 || get_errno() == EINTR, "Could not close io_uring");
+}
+
+void io_uring_ring_t::register_eventfd(int event_fd) {
+    int res = sys_io_uring_register(ring_fd, IORING_REGISTER_EVENTFD, &event_fd, 1);
+    guarantee_err(res == 0, "Could not register eventfd with io_uring");
+}
+
+io_uring_sqe *io_uring_ring_t::next_sqe() {
+    if (*sq_tail + n_unsubmitted - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE)
+        >= sq_entries) {
+        flush();
+    }
+    unsigned tail = *sq_tail + n_unsubmitted;
+    guarantee(tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) < sq_entries,
+              "io_uring submission queue overflow");
+    unsigned index = tail & sq_mask;
+    sq_array[index] = index;
+    ++n_unsubmitted;
+    io_uring_sqe *sqe = &sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+void io_uring_ring_t::flush() {
+    if (n_unsubmitted == 0) {
+        return;
+    }
+    __atomic_store_n(sq_tail, *sq_tail + n_unsubmitted, __ATOMIC_RELEASE);
+    unsigned to_submit = n_unsubmitted;
+    n_unsubmitted = 0;
+    while (to_submit > 0) {
+        int res = sys_io_uring_enter(ring_fd, to_submit);
+        if (res == -1 && get_errno() == EINTR) {
+            continue;
+        }
+        guarantee_err(res >= 0, "Could not submit requests to io_uring");
+        to_submit -= res;
+    }
+}
+
+void io_uring_ring_t::reap(std::vector<io_uring_completion_t> *out) {
+    while (true) {
+        unsigned head = *cq_head;
+        unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head) {
+            const io_uring_cqe *cqe = &cqes[head & cq_mask];
+            io_uring_completion_t completion;
+            completion.user_data = cqe->user_data;
+            completion.res = cqe->res;
+            completion.flags = cqe->flags;
+            out->push_back(completion);
+        }
+        __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+
+#ifdef IORING_SQ_CQ_OVERFLOW
+        // If the completion queue was full, the kernel holds on to the
+        // completions that didn't fit until we ask for them.
+        if ((__atomic_load_n(sq_flags, __ATOMIC_ACQUIRE) & IORING_SQ_CQ_OVERFLOW) != 0) {
+            int res = sys_io_uring_enter(ring_fd, 0, IORING_ENTER_GETEVENTS);
+            guarantee_err(res >= 0 || get_errno() == EINTR,
+                          "Could not get completions from io_uring");
+            continue;
+        }
+#endif
+        break;
+    }
+}
+
+#endif  // RDB_HAS_IO_URING
@@ -0,0 +1,95 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef ARCH_IO_IO_URING_HPP_
+#define ARCH_IO_IO_URING_HPP_
+
+#ifdef __linux
+#include <sys/syscall.h>
+#endif
+
+// io_uring is only available on reasonably recent Linux kernels. We also need a
+// real eventfd to get completion notifications into the event queue.
+#if defined(__linux) && !defined(LEGACY_LINUX) && !defined(NO_EVENTFD) \
+    && !defined(NO_IO_URING) && defined(__NR_io_uring_setup)
+#define RDB_HAS_IO_URING 1
+#else
+#define RDB_HAS_IO_URING 0
+#endif
+
+#if RDB_HAS_IO_URING
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "errors.hpp"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+struct io_uring_completion_t {
+    uint64_t user_data;
+    int32_t res;
+    uint32_t flags;
+};
+
+/* `io_uring_ring_t` owns an io_uring file descriptor and the shared submission
+and completion rings. It talks to the kernel through raw system calls, so we
+don't depend on liburing.
+
+A ring must only be used from a single thread, so the only synchronization we
+need is with the kernel. */
+class io_uring_ring_t {
+public:
+    /* Returns true if the running kernel lets us set up an io_uring with the
+    features we rely on, plus the `IORING_FEAT_*` flags in `extra_features`. */
+    static bool is_supported(uint32_t extra_features = 0);
+
+    /* `cq_entries` can be used to ask for a completion queue that is larger
+    than the submission queue. If it is zero, the kernel's default is used. */
+    explicit io_uring_ring_t(unsigned entries, unsigned cq_entries = 0);
+    ~io_uring_ring_t();
+
+    unsigned get_sq_entries() const { return sq_entries; }
+
+    void register_eventfd(int event_fd);
+
+    /* Returns a zeroed submission queue entry. It gets handed to the kernel on
+    the next call to `flush()`. If the submission queue is full, the entries
+    that are already on it are flushed first. */
+    io_uring_sqe *next_sqe();
+
+    /* Hands all entries obtained through `next_sqe()` to the kernel with a single
+    system call. */
+    void flush();
+
+    /* Pops all available completions and appends them to `out`. */
+    void reap(std::vector<io_uring_completion_t> *out);
+
+private:
+    int ring_fd;
+    unsigned sq_entries;
+
+    void *ring_ptr;
+    size_t ring_size;
+    io_uring_sqe *sqes;
+    size_t sqes_size;
+
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_flags;
+    unsigned sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned cq_mask;
+    io_uring_cqe *cqes;
+
+    // The number of entries we've filled in but haven't told the kernel about yet.
+    unsigned n_unsubmitted;
+
+    DISABLE_COPYING(io_uring_ring_t);
+};
+
+#endif  // RDB_HAS_IO_URING
+
+#endif  // ARCH_IO_IO_URING_HPP_
@@ -18,8 +18,11 @@
 #include <netinet/tcp.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <limits.h>
 #endif
 
+#include "arch/io/network_uring.hpp"
 #include "arch/runtime/runtime.hpp"
 #include "arch/runtime/thread_pool.hpp"
 #include "arch/timing.hpp"
@@ -343,10 +346,24 @@ size_t linux_tcp_conn_t::read_internal(void *buffer, size_t size) THROWS_ONLY(tc
         return op.nb_bytes;
     }
 #else
+#if RDB_HAS_IO_URING
+    linux_network_uring_t *uring = linux_network_uring_t::get();
+#endif
     while (true) {
+#if RDB_HAS_IO_URING
+        ssize_t res = uring != nullptr
+            ? uring->recv(sock.get(), buffer, size, &read_closed)
+            : ::read(sock.get(), buffer, size);
+#else
         ssize_t res = ::read(sock.get(), buffer, size);
+#endif
+
+        if (read_closed.is_pulsed()) {
+            /* We were closed while the read was in the io_uring. Something else
+               has already called on_shutdown_read(). */
+            throw tcp_conn_read_closed_exc_t();
 
-        if (res == -1 && (get_errno() == EAGAIN || get_errno() == EWOULDBLOCK)) {
+        } else if (res == -1 && (get_errno() == EAGAIN || get_errno() == EWOULDBLOCK)) {
             /* There's no data available right now, so we must wait for a notification from the
                epoll queue, or for an order to shut down. */
 
@@ -521,13 +538,47 @@ linux_tcp_conn_t::write_handler_t::write_handler_t(linux_tcp_conn_t *_parent) :
 { }
 
 void linux_tcp_conn_t::write_handler_t::coro_pool_callback(write_queue_op_t *operation, UNUSED signal_t *interruptor) {
-    if (operation->buffer != nullptr) {
-        parent->perform_write(operation->buffer, operation->size);
-        if (operation->dealloc != nullptr) {
-            parent->release_write_buffer(operation->dealloc);
-            parent->write_queue_limiter.unlock(operation->size);
+    /* Take everything else that is queued up as well, so that we can hand it
+       all to the socket at once. We are the only coroutine in the pool, so
+       nobody else is going to pop operations off the queue in the meantime. */
+    write_queue_op_t *batch[WRITE_BATCH_MAX_OPS];
+    size_t batch_size = 0;
+    batch[batch_size++] = operation;
+    while (batch_size < WRITE_BATCH_MAX_OPS && parent->write_queue.size() > 0) {
+        batch[batch_size++] = parent->write_queue.pop();
+    }
+
+#ifdef _WIN32
+    for (size_t i = 0; i < batch_size; ++i) {
+        if (batch[i]->buffer != nullptr) {
+            parent->perform_write(batch[i]->buffer, batch[i]->size);
         }
     }
+#else
+    iovec vecs[WRITE_BATCH_MAX_OPS];
+    size_t num_vecs = 0;
+    for (size_t i = 0; i < batch_size; ++i) {
+        if (batch[i]->buffer != nullptr && batch[i]->size > 0) {
+            vecs[num_vecs].iov_base = const_cast<void *>(batch[i]->buffer);
+            vecs[num_vecs].iov_len = batch[i]->size;
+            ++num_vecs;
+        }
+    }
+    if (num_vecs > 0) {
+        parent->perform_writev(vecs, num_vecs);
+    }
+#endif
+
+    for (size_t i = 0; i < batch_size; ++i) {
+        finish_operation(batch[i]);
+    }
+}
+
+void linux_tcp_conn_t::write_handler_t::finish_operation(write_queue_op_t *operation) {
+    if (operation->buffer != nullptr && operation->dealloc != nullptr) {
+        parent->release_write_buffer(operation->dealloc);
+        parent->write_queue_limiter.unlock(operation->size);
+    }
 
     if (operation->cond != nullptr) {
         operation->cond->pulse();
@@ -598,10 +649,46 @@ void linux_tcp_conn_t::perform_write(const void *buf, size_t size) {
         rassert(op.nb_bytes == size);  // TODO WINDOWS: does windows guarantee this?
     }
 #else
-    while (size > 0) {
-        ssize_t res = ::write(sock.get(), buf, size);
+    iovec vec;
+    vec.iov_base = const_cast<void *>(buf);
+    vec.iov_len = size;
+    perform_writev(&vec, 1);
+#endif
+}
+
+#ifndef _WIN32
+void linux_tcp_conn_t::perform_writev(iovec *vecs, size_t count) {
+    assert_thread();
+
+    if (write_closed.is_pulsed()) {
+        /* See `perform_write()`. */
+        return;
+    }
+
+#if RDB_HAS_IO_URING
+    linux_network_uring_t *uring = linux_network_uring_t::get();
+#endif
+    while (count > 0) {
+        if (vecs->iov_len == 0) {
+            ++vecs;
+            --count;
+            continue;
+        }
+        const size_t batch_count = std::min<size_t>(count, IOV_MAX);
+#if RDB_HAS_IO_URING
+        ssize_t res = uring != nullptr
+            ? uring->sendv(sock.get(), vecs, batch_count, &write_closed)
+            : ::writev(sock.get(), vecs, batch_count);
+#else
+        ssize_t res = ::writev(sock.get(), vecs, batch_count);
+#endif
 
-        if (res == -1 && (get_errno() == EAGAIN || get_errno() == EWOULDBLOCK)) {
+        if (write_closed.is_pulsed()) {
+            /* We were closed while the write was in the io_uring. Whatever
+               signalled us has already called on_shutdown_write(). */
+            break;
+
+        } else if (res == -1 && (get_errno() == EAGAIN || get_errno() == EWOULDBLOCK)) {
             /* Wait for a notification from the event queue, or for an order to
                shut down */
             linux_event_watcher_t::watch_t watch(event_watcher.get(), poll_event_out);
@@ -637,24 +724,33 @@ void linux_tcp_conn_t::perform_write(const void *buf, size_t size) {
             break;
 
         } else {
-            rassert(res <= static_cast<ssize_t>(size));
-            buf = reinterpret_cast<const void *>(reinterpret_cast<const char *>(buf) + res);
-            size -= res;
             if (write_perfmon) {
                 write_perfmon->record(res);
             }
+            /* Skip over the buffers that were written completely, and the part of
+               the next one that was written. */
+            size_t written = res;
+            while (count > 0 && written >= vecs->iov_len) {
+                written -= vecs->iov_len;
+                ++vecs;
+                --count;
+            }
+            rassert(written == 0 || count > 0);
+            if (written > 0) {
+                vecs->iov_base = static_cast<char *>(vecs->iov_base) + written;
+                vecs->iov_len -= written;
+            }
         }
     }
-#endif
 }
+#endif
 
-void linux_tcp_conn_t::write(const void *buf, size_t size, signal_t *closer) THROWS_ONLY(tcp_conn_write_closed_exc_t) {
-    write_op_wrapper_t sentry(this, closer);
-
+void linux_tcp_conn_t::internal_write_and_wait(const void *buf, size_t size) {
     write_queue_op_t op;
     cond_t to_signal_when_done;
 
-    /* Flush out any data that's been buffered, so that things don't get out of order */
+    /* Flush out any data that's been buffered, so that things don't get out of
+       order. The write handler will send it together with `buf`. */
     if (current_write_buffer->size > 0) {
         internal_flush_write_buffer();
     }
@@ -673,6 +769,12 @@ void linux_tcp_conn_t::write(const void *buf, size_t size, signal_t *closer) THR
        is closed before or during our write, then `perform_write()` will turn into a
        no-op, so the cond will still get pulsed. */
     to_signal_when_done.wait();
+}
+
+void linux_tcp_conn_t::write(const void *buf, size_t size, signal_t *closer) THROWS_ONLY(tcp_conn_write_closed_exc_t) {
+    write_op_wrapper_t sentry(this, closer);
+
+    internal_write_and_wait(buf, size);
 
     if (write_closed.is_pulsed()) {
         throw tcp_conn_write_closed_exc_t();
@@ -682,6 +784,17 @@ void linux_tcp_conn_t::write(const void *buf, size_t size, signal_t *closer) THR
 void linux_tcp_conn_t::write_buffered(const void *vbuf, size_t size, signal_t *closer) THROWS_ONLY(tcp_conn_write_closed_exc_t) {
     write_op_wrapper_t sentry(this, closer);
 
+    /* Large payloads would take many chunks to copy. Reference them directly
+       instead; since the caller may reuse the memory once we return, we have
+       to wait until it has been written. */
+    if (size >= WRITE_ZERO_COPY_THRESHOLD) {
+        internal_write_and_wait(vbuf, size);
+        if (write_closed.is_pulsed()) {
+            throw tcp_conn_write_closed_exc_t();
+        }
+        return;
+    }
+
     /* Convert to `char` for ease of pointer arithmetic */
     const char *buf = reinterpret_cast<const char *>(vbuf);
 
@@ -908,7 +1021,8 @@ linux_secure_tcp_conn_t::linux_secure_tcp_conn_t(
         signal_t *interruptor, int local_port)
         THROWS_ONLY(connect_failed_exc_t, crypto::openssl_error_t, interrupted_exc_t) :
     linux_tcp_conn_t(host, port, interruptor, local_port),
-    conn(tls_ctx) {
+    conn(tls_ctx),
+    ktls_send(false) {
 
     conn.set_fd(sock.get());
     SSL_set_connect_state(conn.get());
@@ -920,7 +1034,8 @@ linux_secure_tcp_conn_t::linux_secure_tcp_conn_t(
         SSL_CTX *tls_ctx, fd_t _sock, signal_t *interruptor)
         THROWS_ONLY(crypto::openssl_error_t, interrupted_exc_t) :
     linux_tcp_conn_t(_sock),
-    conn(tls_ctx) {
+    conn(tls_ctx),
+    ktls_send(false) {
 
     conn.set_fd(sock.get());
     SSL_set_accept_state(conn.get());
@@ -947,7 +1062,11 @@ void linux_secure_tcp_conn_t::perform_handshake(signal_t *interruptor)
         int ret = SSL_do_handshake(conn.get());
 
         if (ret > 0) {
-            return; // Successful TLS handshake.
+            // Successful TLS handshake.
+#if defined(BIO_get_ktls_send) && !defined(_WIN32)
+            ktls_send = BIO_get_ktls_send(SSL_get_wbio(conn.get()));
+#endif
+            return;
         }
 
         if (ret == 0) {
@@ -1044,6 +1163,93 @@ size_t linux_secure_tcp_conn_t::read_internal(void *buffer, size_t size)
     }
 }
 
+#ifndef _WIN32
+bool linux_secure_tcp_conn_t::tls_has_pending_writes() {
+#if defined(BIO_get_ktls_send)
+    SSL *ssl = conn.get();
+    return SSL_in_init(ssl)
+        || SSL_get_key_update_type(ssl) != SSL_KEY_UPDATE_NONE
+        || BIO_wpending(SSL_get_wbio(ssl)) > 0;
+#else
+    // Without kTLS, everything goes through `SSL_write()` anyway.
+    return false;
+#endif
+}
+
+void linux_secure_tcp_conn_t::perform_writev(iovec *vecs, size_t count) {
+    assert_thread();
+
+    if (!ktls_send || tls_has_pending_writes()) {
+        for (size_t i = 0; i < count && is_open(); ++i) {
+            perform_write(vecs[i].iov_base, vecs[i].iov_len);
+        }
+        return;
+    }
+
+    if (closed.is_pulsed()) {
+        /* See `perform_write()`. */
+        return;
+    }
+
+#if RDB_HAS_IO_URING
+    linux_network_uring_t *uring = linux_network_uring_t::get();
+#endif
+    while (count > 0) {
+        if (vecs->iov_len == 0) {
+            ++vecs;
+            --count;
+            continue;
+        }
+        if (tls_has_pending_writes()) {
+            // `SSL_read()` may have queued up something of OpenSSL's own while we
+            // were waiting for the socket.
+            for (size_t i = 0; i < count && is_open(); ++i) {
+                perform_write(vecs[i].iov_base, vecs[i].iov_len);
+            }
+            return;
+        }
+        const size_t batch_count = std::min<size_t>(count, IOV_MAX);
+#if RDB_HAS_IO_URING
+        ssize_t res = uring != nullptr
+            ? uring->sendv(sock.get(), vecs, batch_count, &closed)
+            : ::writev(sock.get(), vecs, batch_count);
+#else
+        ssize_t res = ::writev(sock.get(), vecs, batch_count);
+#endif
+
+        if (closed.is_pulsed()) {
+            /* We were closed while the write was in the io_uring. Whatever
+            signalled us has already called shutdown_socket(). */
+            return;
+        } else if (res == -1 && (get_errno() == EAGAIN || get_errno() == EWOULDBLOCK)) {
+            linux_event_watcher_t::watch_t watch(get_event_watcher(), poll_event_out);
+            wait_any_t waiter(&watch, &closed);
+            waiter.wait_lazily_unordered();
+            if (closed.is_pulsed()) {
+                return;
+            }
+        } else if (res <= 0) {
+            // Assume that the connection is unusable, like `perform_write()`
+            // does when `SSL_write()` fails.
+            shutdown_socket();
+            return;
+        } else {
+            if (write_perfmon) write_perfmon->record(res);
+            size_t written = res;
+            while (count > 0 && written >= vecs->iov_len) {
+                written -= vecs->iov_len;
+                ++vecs;
+                --count;
+            }
+            if (written > 0) {
+                vecs->iov_base = static_cast<char *>(vecs->iov_base) + written;
+                vecs->iov_len -= written;
+            }
+        }
+    }
+}
+#endif
+
 void linux_secure_tcp_conn_t::perform_write(const void *buffer, size_t size) {
     assert_thread();
 
@@ -1600,6 +1806,127 @@ fd_t linux_nonthrowing_tcp_listener_t::wait_for_any_socket(const auto_drainer_t:
 }
 #endif
 
+#if RDB_HAS_IO_URING
+/* Collects the connections that a multishot accept produces. They are handed to
+`handle()` by `accept_loop_uring()`, so that the listener can't go away while
+`handle()` gets started. */
+class linux_nonthrowing_tcp_listener_t::uring_acceptor_t
+    : public linux_network_uring_t::op_callback_t {
+public:
+    uring_acceptor_t(fd_t _sock, cond_t *_wakeup)
+        : sock(_sock), wakeup(_wakeup), armed(false), accepted_any(false),
+          result(0) { }
+
+    void on_uring_completion(int32_t res, bool more) {
+        if (res >= 0) {
+            accepted.push_back(res);
+            accepted_any = true;
+        }
+        if (!more) {
+            armed = false;
+            result = res;
+        }
+        wakeup->pulse_if_not_already_pulsed();
+    }
+
+    const fd_t sock;
+    cond_t *const wakeup;
+    // True while the multishot accept is running.
+    bool armed;
+    bool accepted_any;
+    // The result of the completion that stopped the multishot accept.
+    int32_t result;
+    std::vector<fd_t> accepted;
+};
+
+bool linux_nonthrowing_tcp_listener_t::accept_loop_uring(
+        const auto_drainer_t::lock_t &lock, exponential_backoff_t *backoff) {
+    linux_network_uring_t *uring = linux_network_uring_t::get();
+    if (uring == nullptr) {
+        return false;
+    }
+
+    cond_t wakeup;
+    scoped_array_t<scoped_ptr_t<uring_acceptor_t> > acceptors(socks.size());
+    for (size_t i = 0; i < socks.size(); ++i) {
+        acceptors[i].init(new uring_acceptor_t(socks[i].get(), &wakeup));
+        acceptors[i]->armed = true;
+        uring->accept_multishot(socks[i].get(), acceptors[i].get());
+    }
+
+    bool supported = true;
+    while (supported && !lock.get_drain_signal()->is_pulsed()) {
+        {
+            wait_any_t waiter(&wakeup, lock.get_drain_signal());
+            waiter.wait_lazily_unordered();
+        }
+        wakeup.reset();
+
+        for (size_t i = 0; i < acceptors.size(); ++i) {
+            uring_acceptor_t *acceptor = acceptors[i].get();
+            std::vector<fd_t> new_socks;
+            new_socks.swap(acceptor->accepted);
+            for (fd_t new_sock : new_socks) {
+                coro_t::spawn_now_dangerously(std::bind(
+                    &linux_nonthrowing_tcp_listener_t::handle, this, new_sock));
+                backoff->success();
+                log_next_error = true;
+            }
+
+            if (acceptor->armed || lock.get_drain_signal()->is_pulsed()) {
+                continue;
+            }
+            const int32_t res = acceptor->result;
+            if (res == -EINVAL && !acceptor->accepted_any) {
+                /* The kernel doesn't know about multishot accepts. */
+                supported = false;
+                break;
+            } else if (res == -EAGAIN || res == -EWOULDBLOCK) {
+                /* Older kernels don't wait for non-blocking sockets to become
+                   readable, so we do that for them. */
+                linux_event_watcher_t::watch_t watch(event_watchers[i].get(),
+                                                     poll_event_in);
+                wait_any_t waiter(&watch, lock.get_drain_signal());
+                waiter.wait_lazily_unordered();
+            } else if (res < 0 && res != -EINTR) {
+                /* Unexpected error. Log it unless it's a repeat error. */
+                if (log_next_error) {
+                    logERR("accept() failed: %s.", errno_string(-res).c_str());
+                    log_next_error = false;
+                }
+                try {
+                    backoff->failure(lock.get_drain_signal());
+                } catch (const interrupted_exc_t &) {
+                    break;
+                }
+            }
+            if (!lock.get_drain_signal()->is_pulsed()) {
+                acceptor->armed = true;
+                uring->accept_multishot(acceptor->sock, acceptor);
+            }
+        }
+    }
+
+    /* Stop the remaining multishot accepts. We have to wait for their final
+    completions before the acceptors can go away. */
+    for (size_t i = 0; i < acceptors.size(); ++i) {
+        if (acceptors[i]->armed) {
+            uring->cancel(acceptors[i].get());
+        }
+    }
+    for (size_t i = 0; i < acceptors.size(); ++i) {
+        while (acceptors[i]->armed) {
+            wakeup.wait_lazily_unordered();
+            wakeup.reset();
+        }
+        for (fd_t new_sock : acceptors[i]->accepted) {
+            scoped_fd_t closer(new_sock);
+        }
+    }
+    return supported;
+}
+#endif  // RDB_HAS_IO_URING
+
 void linux_nonthrowing_tcp_listener_t::accept_loop(auto_drainer_t::lock_t lock) {
     exponential_backoff_t backoff(10, 160, 2.0, 0.5);
 
@@ -1610,6 +1937,12 @@ void linux_nonthrowing_tcp_listener_t::accept_loop(auto_drainer_t::lock_t lock)
     });
 
 #else
+#if RDB_HAS_IO_URING
+    if (accept_loop_uring(lock, &backoff)) {
+        return;
+    }
+#endif
+
     fd_t active_fd = socks[0].get();
     while(!lock.get_drain_signal()->is_pulsed()) {
         fd_t new_sock = accept(active_fd, nullptr, nullptr);
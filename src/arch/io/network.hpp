@@ -138,7 +138,10 @@ public:
 
     /* write_buffered() is like write(), but it might not send the data until
     flush_buffer*() or write() is called. Internally, it bundles together the
-    buffered writes; this may improve performance. */
+    buffered writes; this may improve performance. Payloads of at least
+    `WRITE_ZERO_COPY_THRESHOLD` bytes aren't copied into the buffer; instead,
+    write_buffered() sends them along with the buffered data and blocks until
+    they are written, like write() does. */
     void write_buffered(const void *buf, size_t size, signal_t *closer)
         THROWS_ONLY(tcp_conn_write_closed_exc_t);
 
@@ -268,6 +271,10 @@ private:
 
     static const size_t WRITE_QUEUE_MAX_SIZE = 128 * KILOBYTE;
     static const size_t WRITE_CHUNK_SIZE = 8 * KILOBYTE;
+    static const size_t WRITE_ZERO_COPY_THRESHOLD = 4 * WRITE_CHUNK_SIZE;
+    /* The most operations that `write_handler_t` takes off the write queue to
+    hand to the socket in a single vectored write. */
+    static const size_t WRITE_BATCH_MAX_OPS = 64;
 
     /* Structs to avoid over-using dynamic allocation */
     struct write_buffer_t : public intrusive_list_node_t<write_buffer_t> {
@@ -289,6 +296,9 @@ private:
     private:
         linux_tcp_conn_t *parent;
         void coro_pool_callback(write_queue_op_t *operation, signal_t *interruptor);
+        /* Releases the buffer of `operation` and notifies whoever is waiting on
+        it, once its data has been written. */
+        void finish_operation(write_queue_op_t *operation);
     } write_handler;
 
     template <class T>
@@ -318,6 +328,10 @@ private:
     data to be completely written. */
     void internal_flush_write_buffer();
 
+    /* Puts `size` bytes from `buf` on the write queue and blocks until they have
+    been written, or until the write half of the connection has been closed. */
+    void internal_write_and_wait(const void *buf, size_t size);
+
     /* Used to queue up buffers to write. The functions in `write_queue` will all be
     `std::bind()`s of the `perform_write()` function below. */
     unlimited_fifo_queue_t<write_queue_op_t*, intrusive_list_t<write_queue_op_t> > write_queue;
@@ -345,6 +359,12 @@ private:
     /* Used to actually perform a write. If the write end of the connection is open, then
     writes `size` bytes from `buffer` to the socket. */
     virtual void perform_write(const void *buffer, size_t size);
+
+#ifndef _WIN32
+    /* Like `perform_write()`, but writes the `count` buffers in `vecs` one after
+    the other, with as few system calls as possible. Modifies `vecs`. */
+    virtual void perform_writev(iovec *vecs, size_t count);
+#endif
 };
 
 #ifdef ENABLE_TLS
@@ -389,6 +409,9 @@ public:
 
     virtual void rethread(threadnum_t thread);
 
+    /* True if the kernel encrypts what we send (see `ktls_send`). */
+    bool is_kernel_tls_send() const { return ktls_send; }
+
 private:
 
     // Server connection constructor.
@@ -409,6 +432,20 @@ private:
     writes `size` bytes from `buffer` to the socket. */
     virtual void perform_write(const void *buffer, size_t size);
 
+#ifndef _WIN32
+    /* If the kernel does the encryption for us (see `ktls_send`), this writes
+    all the buffers to the socket at once. Otherwise OpenSSL has to encrypt them,
+    and it doesn't have a vectored write, so this calls `perform_write()` on each
+    buffer in turn. */
+    virtual void perform_writev(iovec *vecs, size_t count);
+
+    /* True if OpenSSL has something of its own to send before more application
+    data can go out, like the response to a key update, or the rest of a record
+    it couldn't write. Then we write through `SSL_write()` even with `ktls_send`,
+    so that OpenSSL sends that first. */
+    bool tls_has_pending_writes();
+#endif
+
     void shutdown();
     void shutdown_socket();
 
@@ -416,6 +453,15 @@ private:
 
     tls_conn_wrapper_t conn;
 
+    /* True if OpenSSL handed the session keys to the kernel after the handshake
+    (because the context has `SSL_OP_ENABLE_KTLS` set, and the kernel supports
+    the negotiated cipher). Then the kernel encrypts whatever we write to the
+    socket, so we can bypass OpenSSL for sending application data, unless
+    `tls_has_pending_writes()`. Receiving
+    still goes through `SSL_read()`, which uses kTLS by itself if it can and
+    takes care of the non-data records that the peer might send. */
+    bool ktls_send;
+
     cond_t closed;
 };
 
@@ -485,6 +531,14 @@ private:
                             windows_event_watcher_t *event_watcher);
 #else
     fd_t wait_for_any_socket(const auto_drainer_t::lock_t &lock);
+
+    /* With the io_uring network backend, we keep a multishot accept running on
+    each socket instead. Returns false (without having accepted anything) if the
+    kernel doesn't support multishot accepts, in which case we fall back to
+    `accept()`. */
+    class uring_acceptor_t;
+    bool accept_loop_uring(const auto_drainer_t::lock_t &lock,
+                           exponential_backoff_t *backoff);
 #endif
     scoped_ptr_t<auto_drainer_t> accept_loop_drainer;
 
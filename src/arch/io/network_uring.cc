@@ -0,0 +1,196 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/io/network_uring.hpp"
+
+#include "logger.hpp"
+
+static network_io_backend_t global_network_io_backend = network_io_backend_t::epoll;
+
+void set_network_io_backend(network_io_backend_t backend) {
+    if (backend == network_io_backend_t::io_uring) {
+#if RDB_HAS_IO_URING
+        if (!linux_network_uring_t::is_supported()) {
+            logWRN("The io_uring network backend is not supported by this kernel. "
+                   "Falling back to the epoll network backend.");
+            backend = network_io_backend_t::epoll;
+        }
+#else
+        logWRN("This build of RethinkDB does not support the io_uring network "
+               "backend. Falling back to the epoll network backend.");
+        backend = network_io_backend_t::epoll;
+#endif
+    }
+    global_network_io_backend = backend;
+}
+
+network_io_backend_t get_network_io_backend() {
+    return global_network_io_backend;
+}
+
+#if RDB_HAS_IO_URING
+
+#include <linux/io_uring.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "arch/runtime/runtime.hpp"
+#include "arch/runtime/thread_pool.hpp"
+#include "concurrency/cond_var.hpp"
+#include "concurrency/wait_any.hpp"
+
+// The size of the submission queue. Submissions beyond this in a single pass
+// through the event loop cause an extra system call, but are otherwise fine.
+const unsigned NETWORK_IO_URING_SQ_ENTRIES = 1024;
+// The size of the completion queue. If more operations complete at once, the
+// kernel holds on to the excess until we reap them.
+const unsigned NETWORK_IO_URING_CQ_ENTRIES = 16 * NETWORK_IO_URING_SQ_ENTRIES;
+
+class linux_network_uring_t::blocking_op_t : public op_callback_t {
+public:
+    blocking_op_t() : res(0) { }
+
+    void on_uring_completion(int32_t _res, DEBUG_VAR bool more) {
+        rassert(!more);
+        res = _res;
+        done.pulse();
+    }
+
+    cond_t done;
+    int32_t res;
+};
+
+bool linux_network_uring_t::is_supported() {
+    // Without `IORING_FEAT_NODROP`, completions might get lost when lots of
+    // connections become ready at once. `IORING_FEAT_FAST_POLL` makes sure that
+    // the kernel waits for readiness itself instead of handing each operation to
+    // a worker thread.
+    return io_uring_ring_t::is_supported(IORING_FEAT_NODROP | IORING_FEAT_FAST_POLL);
+}
+
+linux_network_uring_t::linux_network_uring_t(linux_event_queue_t *_queue)
+    : queue(_queue),
+      ring(new io_uring_ring_t(NETWORK_IO_URING_SQ_ENTRIES,
+                               NETWORK_IO_URING_CQ_ENTRIES)),
+      flush_scheduled(false) {
+    ring->register_eventfd(completion_event.get_notify_fd());
+    queue->watch_event(&completion_event, this);
+}
+
+linux_network_uring_t::~linux_network_uring_t() {
+    assert_thread();
+    rassert(!flush_scheduled);
+    queue->forget_event(&completion_event, this);
+}
+
+linux_network_uring_t *linux_network_uring_t::get() {
+    linux_thread_t *thread = linux_thread_pool_t::get_thread();
+    return thread == nullptr ? nullptr : thread->network_uring.get();
+}
+
+ssize_t linux_network_uring_t::recv(fd_t fd, void *buf, size_t size,
+                                    const signal_t *abort) {
+    blocking_op_t op;
+    io_uring_sqe *sqe = next_sqe(&op);
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uintptr_t>(buf);
+    sqe->len = std::min<size_t>(size, std::numeric_limits<int32_t>::max());
+    return run_blocking(&op, abort);
+}
+
+ssize_t linux_network_uring_t::sendv(fd_t fd, const iovec *vecs, size_t count,
+                                     const signal_t *abort) {
+    // The kernel reads `msg` when it starts the operation, which might be after
+    // we submit it, but `run_blocking()` keeps it alive until we're done.
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = const_cast<iovec *>(vecs);
+    msg.msg_iovlen = count;
+
+    blocking_op_t op;
+    io_uring_sqe *sqe = next_sqe(&op);
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uintptr_t>(&msg);
+    sqe->len = 1;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    return run_blocking(&op, abort);
+}
+
+void linux_network_uring_t::accept_multishot(fd_t fd, op_callback_t *callback) {
+    io_uring_sqe *sqe = next_sqe(callback);
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    schedule_flush();
+}
+
+void linux_network_uring_t::cancel(op_callback_t *callback) {
+    // The cancellation request itself reports to nobody.
+    io_uring_sqe *sqe = next_sqe(nullptr);
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->addr = reinterpret_cast<uintptr_t>(callback);
+    schedule_flush();
+}
+
+io_uring_sqe *linux_network_uring_t::next_sqe(op_callback_t *callback) {
+    assert_thread();
+    io_uring_sqe *sqe = ring->next_sqe();
+    sqe->user_data = reinterpret_cast<uintptr_t>(callback);
+    return sqe;
+}
+
+ssize_t linux_network_uring_t::run_blocking(blocking_op_t *op, const signal_t *abort) {
+    schedule_flush();
+    {
+        wait_any_t waiter(&op->done, abort);
+        waiter.wait_lazily_unordered();
+    }
+    if (!op->done.is_pulsed()) {
+        // The kernel might still be using the buffer, so we have to wait for the
+        // operation to complete even though we're cancelling it.
+        cancel(op);
+        op->done.wait_lazily_unordered();
+    }
+    if (op->res < 0) {
+        set_errno(-op->res);
+        return -1;
+    }
+    return op->res;
+}
+
+void linux_network_uring_t::schedule_flush() {
+    if (!flush_scheduled) {
+        flush_scheduled = true;
+        call_later_on_this_thread(this);
+    }
+}
+
+void linux_network_uring_t::on_thread_switch() {
+    assert_thread();
+    flush_scheduled = false;
+    ring->flush();
+}
+
+void linux_network_uring_t::on_event(DEBUG_VAR int events) {
+    assert_thread();
+    rassert(events == poll_event_in);
+    completion_event.consume_wakey_wakeys();
+
+    std::vector<io_uring_completion_t> completions;
+    ring->reap(&completions);
+    for (const auto &completion : completions) {
+        op_callback_t *callback =
+            reinterpret_cast<op_callback_t *>(completion.user_data);
+        if (callback != nullptr) {
+            callback->on_uring_completion(
+                completion.res, (completion.flags & IORING_CQE_F_MORE) != 0);
+        }
+    }
+}
+
+#endif  // RDB_HAS_IO_URING
@@ -0,0 +1,97 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef ARCH_IO_NETWORK_URING_HPP_
+#define ARCH_IO_NETWORK_URING_HPP_
+
+#include <sys/types.h>
+
+#include "arch/io/io_uring.hpp"
+#include "arch/types.hpp"
+
+/* Selects the network backend for threads that are started from now on. Must be
+called before the thread pool is started. Falls back to `epoll` (with a warning)
+if io_uring isn't available. */
+void set_network_io_backend(network_io_backend_t backend);
+network_io_backend_t get_network_io_backend();
+
+#if RDB_HAS_IO_URING
+
+#include "arch/runtime/event_queue.hpp"
+#include "arch/runtime/runtime_utils.hpp"
+#include "arch/runtime/system_event.hpp"
+#include "containers/scoped.hpp"
+#include "threading.hpp"
+
+class signal_t;
+
+/* When the io_uring network backend is enabled, every thread in the thread pool
+has a `linux_network_uring_t`. `linux_tcp_conn_t` sends and receives through it
+instead of calling `read` and `write` itself, and the TCP listeners use it for
+multishot accepts, which keep producing new connections from a single submission.
+
+Submissions aren't handed to the kernel right away. Instead, the ring flushes
+once per pass through the event loop, so all the sends and receives that the
+coroutines on a thread start in the meantime cost a single system call. The
+same goes for the operations that are started in response to completions. */
+class linux_network_uring_t : private linux_event_callback_t,
+                              private linux_thread_message_t,
+                              public home_thread_mixin_debug_only_t {
+public:
+    /* Gets notified about the completions of an operation. `more` is true if
+    the operation is going to produce more completions, which only multishot
+    accepts do. */
+    class op_callback_t {
+    public:
+        virtual void on_uring_completion(int32_t res, bool more) = 0;
+    protected:
+        virtual ~op_callback_t() { }
+    };
+
+    /* Returns true if the running kernel lets us set up an io_uring with the
+    features we rely on. */
+    static bool is_supported();
+
+    explicit linux_network_uring_t(linux_event_queue_t *queue);
+    ~linux_network_uring_t();
+
+    /* Returns the current thread's ring, or `nullptr` if the io_uring network
+    backend isn't enabled. */
+    static linux_network_uring_t *get();
+
+    /* `recv()` and `sendv()` block the current coroutine until the operation is
+    done. They behave like `::read()` and `::writev()` do on a socket: they
+    return the number of bytes transferred, or -1 and set errno. If `abort` is
+    pulsed first, they cancel the operation and fail with `ECANCELED`. `sendv()`
+    gathers the data from `count` buffers. */
+    ssize_t recv(fd_t fd, void *buf, size_t size, const signal_t *abort);
+    ssize_t sendv(fd_t fd, const iovec *vecs, size_t count, const signal_t *abort);
+
+    /* Starts accepting connections on the listening socket `fd`. Every accepted
+    socket (or error) is passed to `callback` until it gets a completion with
+    `more` set to false, which happens on errors or after `cancel()`. */
+    void accept_multishot(fd_t fd, op_callback_t *callback);
+
+    /* Asks the kernel to cancel the operation that reports to `callback`. The
+    callback still gets a final completion. */
+    void cancel(op_callback_t *callback);
+
+private:
+    class blocking_op_t;
+
+    io_uring_sqe *next_sqe(op_callback_t *callback);
+    ssize_t run_blocking(blocking_op_t *op, const signal_t *abort);
+    void schedule_flush();
+
+    void on_thread_switch();
+    void on_event(int events);
+
+    linux_event_queue_t *const queue;
+    scoped_ptr_t<io_uring_ring_t> ring;
+    system_event_t completion_event;
+    bool flush_scheduled;
+
+    DISABLE_COPYING(linux_network_uring_t);
+};
+
+#endif  // RDB_HAS_IO_URING
+
+#endif  // ARCH_IO_NETWORK_URING_HPP_
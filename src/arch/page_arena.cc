@@ -0,0 +1,482 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/page_arena.hpp"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#include <atomic>
+
+#include "arch/runtime/runtime.hpp"
+#include "config/args.hpp"
+#include "containers/scoped.hpp"
+#include "errors.hpp"
+#include "logger.hpp"
+#include "memory_utils.hpp"
+#include "perfmon/perfmon.hpp"
+#include "rdb_protocol/datum.hpp"
+#include "utils.hpp"
+
+#ifdef __linux__
+#include "arch/io/concurrency.hpp"
+#include "containers/intrusive_list.hpp"
+#endif
+
+static const char *page_arena_mode_name(page_arena_mode_t mode) {
+    switch (mode) {
+    case page_arena_mode_t::off: return "off";
+    case page_arena_mode_t::transparent: return "transparent";
+    case page_arena_mode_t::hugetlb: return "hugetlb";
+    default: unreachable();
+    }
+}
+
+static std::atomic<int64_t> fallback_allocations(0);
+
+#ifdef __linux__
+
+namespace {
+
+const size_t NUM_SIZE_CLASSES = PAGE_ARENA_MAX_BUFFER_SIZE / DEVICE_BLOCK_SIZE;
+
+// Buffers are handed out and taken back in batches of this many between the
+// thread caches and the arena.
+const size_t TRANSFER_BATCH_SIZE = PAGE_ARENA_THREAD_CACHE_SIZE / 2;
+
+inline size_t size_class_of(size_t size) {
+    return (size - 1) / DEVICE_BLOCK_SIZE;
+}
+
+inline size_t class_buffer_size(size_t size_class) {
+    return (size_class + 1) * DEVICE_BLOCK_SIZE;
+}
+
+inline size_t buffers_per_slab(size_t size_class) {
+    return PAGE_ARENA_SLAB_SIZE / class_buffer_size(size_class);
+}
+
+// A free buffer holds the link to the next free buffer of its list.
+struct free_buffer_t {
+    free_buffer_t *next;
+};
+
+struct slab_t : public intrusive_list_node_t<slab_t> {
+    slab_t()
+        : size_class(-1), mapped(false), hugetlb(false),
+          num_allocated(0), num_carved(0), free_list(nullptr) { }
+
+    // -1 while the slab doesn't hold any buffers.
+    int size_class;
+    // Whether the slab is backed by memory, or is just reserved address space.
+    bool mapped;
+    bool hugetlb;
+    // Buffers that are in use or in a thread cache.
+    size_t num_allocated;
+    // The buffers after the first `num_carved` have never been handed out, so we
+    // don't have to touch the slab's memory to put them on the free list.
+    size_t num_carved;
+    free_buffer_t *free_list;
+};
+
+struct thread_cache_t {
+    thread_cache_t() : bytes_allocated(0), bytes_freed(0) {
+        for (size_t i = 0; i < NUM_SIZE_CLASSES; ++i) {
+            heads[i] = nullptr;
+            counts[i] = 0;
+        }
+    }
+    free_buffer_t *heads[NUM_SIZE_CLASSES];
+    size_t counts[NUM_SIZE_CLASSES];
+    // Only written by the thread itself, but read by `get_stats()`.
+    std::atomic<int64_t> bytes_allocated;
+    std::atomic<int64_t> bytes_freed;
+};
+
+class page_arena_t {
+public:
+    page_arena_t(page_arena_mode_t _mode, char *_region, size_t _num_slabs)
+        : mode(_mode), region(_region), num_slabs(_num_slabs), slabs(_num_slabs),
+          next_unused_slab(0), num_empty_slabs(0), num_hugetlb_slabs(0),
+          num_mapped_slabs(0), hugetlb_fallbacks(0),
+          external_bytes_allocated(0), external_bytes_freed(0) { }
+
+    bool owns(const void *ptr) const {
+        return ptr >= region && ptr < region + num_slabs * PAGE_ARENA_SLAB_SIZE;
+    }
+
+    // Returns `nullptr` if the arena is out of address space or memory.
+    void *alloc(size_t size) {
+        const size_t size_class = size_class_of(size);
+        const int thread = get_thread_id().threadnum;
+        if (thread < 0) {
+            system_mutex_t::lock_t lock(&mutex);
+            free_buffer_t *buffer = take_buffer(size_class);
+            if (buffer != nullptr) {
+                external_bytes_allocated += class_buffer_size(size_class);
+            }
+            return buffer;
+        }
+
+        thread_cache_t *cache = &thread_caches[thread];
+        if (cache->heads[size_class] == nullptr) {
+            system_mutex_t::lock_t lock(&mutex);
+            while (cache->counts[size_class] < TRANSFER_BATCH_SIZE) {
+                free_buffer_t *buffer = take_buffer(size_class);
+                if (buffer == nullptr) {
+                    break;
+                }
+                buffer->next = cache->heads[size_class];
+                cache->heads[size_class] = buffer;
+                ++cache->counts[size_class];
+            }
+            if (cache->heads[size_class] == nullptr) {
+                return nullptr;
+            }
+        }
+        free_buffer_t *buffer = cache->heads[size_class];
+        cache->heads[size_class] = buffer->next;
+        --cache->counts[size_class];
+        cache->bytes_allocated.store(
+            cache->bytes_allocated.load(std::memory_order_relaxed)
+                + class_buffer_size(size_class),
+            std::memory_order_relaxed);
+        return buffer;
+    }
+
+    void free(void *ptr) {
+        // The buffer is allocated, so nobody changes the slab's size class.
+        const size_t size_class = slab_of(ptr)->size_class;
+        free_buffer_t *buffer = static_cast<free_buffer_t *>(ptr);
+        const int thread = get_thread_id().threadnum;
+        if (thread < 0) {
+            system_mutex_t::lock_t lock(&mutex);
+            return_buffer(buffer);
+            external_bytes_freed += class_buffer_size(size_class);
+            return;
+        }
+
+        thread_cache_t *cache = &thread_caches[thread];
+        buffer->next = cache->heads[size_class];
+        cache->heads[size_class] = buffer;
+        ++cache->counts[size_class];
+        cache->bytes_freed.store(
+            cache->bytes_freed.load(std::memory_order_relaxed)
+                + class_buffer_size(size_class),
+            std::memory_order_relaxed);
+        if (cache->counts[size_class] > PAGE_ARENA_THREAD_CACHE_SIZE) {
+            system_mutex_t::lock_t lock(&mutex);
+            while (cache->counts[size_class] > PAGE_ARENA_THREAD_CACHE_SIZE
+                                               - TRANSFER_BATCH_SIZE) {
+                free_buffer_t *b = cache->heads[size_class];
+                cache->heads[size_class] = b->next;
+                --cache->counts[size_class];
+                return_buffer(b);
+            }
+        }
+    }
+
+    ql::datum_t get_stats() {
+        system_mutex_t::lock_t lock(&mutex);
+        int64_t bytes_in_use = external_bytes_allocated - external_bytes_freed;
+        for (int i = 0; i < MAX_THREADS; ++i) {
+            bytes_in_use +=
+                thread_caches[i].bytes_allocated.load(std::memory_order_relaxed)
+                - thread_caches[i].bytes_freed.load(std::memory_order_relaxed);
+        }
+
+        ql::datum_object_builder_t builder;
+        builder.overwrite("mode", ql::datum_t(page_arena_mode_name(mode)));
+        builder.overwrite("slabs",
+            ql::datum_t(static_cast<double>(num_mapped_slabs)));
+        builder.overwrite("hugetlb_slabs",
+            ql::datum_t(static_cast<double>(num_hugetlb_slabs)));
+        builder.overwrite("empty_slabs",
+            ql::datum_t(static_cast<double>(num_empty_slabs)));
+        builder.overwrite("hugetlb_fallbacks",
+            ql::datum_t(static_cast<double>(hugetlb_fallbacks)));
+        builder.overwrite("bytes_mapped", ql::datum_t(
+            static_cast<double>(num_mapped_slabs * PAGE_ARENA_SLAB_SIZE)));
+        builder.overwrite("bytes_in_use",
+            ql::datum_t(static_cast<double>(bytes_in_use)));
+        lock.unlock();
+        return std::move(builder).to_datum();
+    }
+
+private:
+    slab_t *slab_of(const void *ptr) {
+        return &slabs[(static_cast<const char *>(ptr) - region) / PAGE_ARENA_SLAB_SIZE];
+    }
+
+    char *slab_address(slab_t *slab) {
+        return region + (slab - slabs.data()) * PAGE_ARENA_SLAB_SIZE;
+    }
+
+    // The functions below must be called with `mutex` held.
+
+    free_buffer_t *take_buffer(size_t size_class) {
+        slab_t *slab = partial_slabs[size_class].head();
+        if (slab == nullptr) {
+            slab = new_slab(size_class);
+            if (slab == nullptr) {
+                return nullptr;
+            }
+            partial_slabs[size_class].push_back(slab);
+        }
+
+        free_buffer_t *buffer;
+        if (slab->free_list != nullptr) {
+            buffer = slab->free_list;
+            slab->free_list = buffer->next;
+        } else {
+            rassert(slab->num_carved < buffers_per_slab(size_class));
+            buffer = reinterpret_cast<free_buffer_t *>(
+                slab_address(slab) + slab->num_carved * class_buffer_size(size_class));
+            ++slab->num_carved;
+        }
+        ++slab->num_allocated;
+        if (slab->num_allocated == buffers_per_slab(size_class)) {
+            partial_slabs[size_class].remove(slab);
+        }
+        return buffer;
+    }
+
+    void return_buffer(free_buffer_t *buffer) {
+        slab_t *slab = slab_of(buffer);
+        const size_t size_class = slab->size_class;
+        if (slab->num_allocated == buffers_per_slab(size_class)) {
+            partial_slabs[size_class].push_back(slab);
+        }
+        buffer->next = slab->free_list;
+        slab->free_list = buffer;
+        --slab->num_allocated;
+
+        if (slab->num_allocated == 0) {
+            partial_slabs[size_class].remove(slab);
+            slab->size_class = -1;
+            slab->num_carved = 0;
+            slab->free_list = nullptr;
+            if (num_empty_slabs < PAGE_ARENA_EMPTY_SLABS_KEPT) {
+                empty_slabs.push_back(slab);
+                ++num_empty_slabs;
+            } else {
+                unmap_slab(slab);
+                released_slabs.push_back(slab);
+            }
+        }
+    }
+
+    slab_t *new_slab(size_t size_class) {
+        slab_t *slab = empty_slabs.head();
+        if (slab != nullptr) {
+            empty_slabs.remove(slab);
+            --num_empty_slabs;
+        } else {
+            slab = released_slabs.head();
+            if (slab != nullptr) {
+                released_slabs.remove(slab);
+            } else if (next_unused_slab < num_slabs) {
+                slab = &slabs[next_unused_slab];
+                ++next_unused_slab;
+            } else {
+                return nullptr;
+            }
+            if (!map_slab(slab)) {
+                released_slabs.push_back(slab);
+                return nullptr;
+            }
+        }
+        slab->size_class = size_class;
+        return slab;
+    }
+
+    bool map_slab(slab_t *slab) {
+        char *address = slab_address(slab);
+        if (mode == page_arena_mode_t::hugetlb) {
+            void *res = mmap(address, PAGE_ARENA_SLAB_SIZE, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_HUGETLB,
+                             -1, 0);
+            if (res != MAP_FAILED) {
+                slab->mapped = true;
+                slab->hugetlb = true;
+                ++num_mapped_slabs;
+                ++num_hugetlb_slabs;
+                return true;
+            }
+            // The hugetlbfs pool is exhausted (or there is none).
+            ++hugetlb_fallbacks;
+        }
+        if (mprotect(address, PAGE_ARENA_SLAB_SIZE, PROT_READ | PROT_WRITE) != 0) {
+            return false;
+        }
+#ifdef MADV_HUGEPAGE
+        // This is only a hint, so failures don't matter.
+        madvise(address, PAGE_ARENA_SLAB_SIZE, MADV_HUGEPAGE);
+#endif
+        slab->mapped = true;
+        slab->hugetlb = false;
+        ++num_mapped_slabs;
+        return true;
+    }
+
+    void unmap_slab(slab_t *slab) {
+        // Mapping fresh reserved address space over the slab gives its memory back
+        // to the kernel, whether it came from the hugetlbfs pool or not.
+        void *res = mmap(slab_address(slab), PAGE_ARENA_SLAB_SIZE, PROT_NONE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_NORESERVE,
+                         -1, 0);
+        guarantee_err(res != MAP_FAILED, "Could not release a page arena slab");
+        --num_mapped_slabs;
+        if (slab->hugetlb) {
+            --num_hugetlb_slabs;
+        }
+        slab->mapped = false;
+        slab->hugetlb = false;
+    }
+
+    const page_arena_mode_t mode;
+    char *const region;
+    const size_t num_slabs;
+
+    system_mutex_t mutex;
+    scoped_array_t<slab_t> slabs;
+    size_t next_unused_slab;
+    intrusive_list_t<slab_t> partial_slabs[NUM_SIZE_CLASSES];
+    // Empty slabs that are still backed by memory.
+    intrusive_list_t<slab_t> empty_slabs;
+    size_t num_empty_slabs;
+    // Slabs that have been used before, but whose memory has been returned.
+    intrusive_list_t<slab_t> released_slabs;
+
+    size_t num_hugetlb_slabs;
+    size_t num_mapped_slabs;
+    int64_t hugetlb_fallbacks;
+    int64_t external_bytes_allocated;
+    int64_t external_bytes_freed;
+
+    thread_cache_t thread_caches[MAX_THREADS];
+
+    DISABLE_COPYING(page_arena_t);
+};
+
+// Once set, the arena is never destroyed, because buffers may be freed at any
+// time until the process exits.
+std::atomic<page_arena_t *> global_page_arena(nullptr);
+
+}  // namespace
+
+bool set_page_arena_mode(page_arena_mode_t mode) {
+    guarantee(global_page_arena.load() == nullptr);
+    if (mode == page_arena_mode_t::off) {
+        return true;
+    }
+
+    // Reserve one extra slab, so that we can align the region to the slab size.
+    const size_t reserved_size = PAGE_ARENA_REGION_SIZE + PAGE_ARENA_SLAB_SIZE;
+    void *res = mmap(nullptr, reserved_size, PROT_NONE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (res == MAP_FAILED) {
+        logWRN("Could not reserve address space for the page arena: %s. "
+               "Huge pages will not be used for the cache.", errno_string(get_errno()).c_str());
+        return false;
+    }
+    char *reserved = static_cast<char *>(res);
+    const uintptr_t misalignment =
+        reinterpret_cast<uintptr_t>(reserved) % PAGE_ARENA_SLAB_SIZE;
+    char *region = reserved + (misalignment == 0 ? 0 : PAGE_ARENA_SLAB_SIZE - misalignment);
+    if (region != reserved) {
+        munmap(reserved, region - reserved);
+    }
+    if (region + PAGE_ARENA_REGION_SIZE != reserved + reserved_size) {
+        munmap(region + PAGE_ARENA_REGION_SIZE,
+               reserved + reserved_size - (region + PAGE_ARENA_REGION_SIZE));
+    }
+
+    global_page_arena.store(new page_arena_t(
+        mode, region, PAGE_ARENA_REGION_SIZE / PAGE_ARENA_SLAB_SIZE));
+    return true;
+}
+
+void *page_arena_alloc(size_t size) {
+    page_arena_t *arena = global_page_arena.load(std::memory_order_acquire);
+    if (arena != nullptr && size > 0 && size <= PAGE_ARENA_MAX_BUFFER_SIZE) {
+        void *ptr = arena->alloc(size);
+        if (ptr != nullptr) {
+            return ptr;
+        }
+        fallback_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    return raw_malloc_aligned(size, DEVICE_BLOCK_SIZE);
+}
+
+void page_arena_free(void *ptr) {
+    page_arena_t *arena = global_page_arena.load(std::memory_order_acquire);
+    if (arena != nullptr && arena->owns(ptr)) {
+        arena->free(ptr);
+    } else {
+        raw_free_aligned(ptr);
+    }
+}
+
+static ql::datum_t get_arena_stats() {
+    page_arena_t *arena = global_page_arena.load(std::memory_order_acquire);
+    if (arena == nullptr) {
+        return ql::datum_t();
+    }
+    return arena->get_stats();
+}
+
+#else  // __linux__
+
+bool set_page_arena_mode(page_arena_mode_t mode) {
+    if (mode == page_arena_mode_t::off) {
+        return true;
+    }
+    logWRN("Huge pages for the cache are only supported on Linux.");
+    return false;
+}
+
+void *page_arena_alloc(size_t size) {
+    return raw_malloc_aligned(size, DEVICE_BLOCK_SIZE);
+}
+
+void page_arena_free(void *ptr) {
+    raw_free_aligned(ptr);
+}
+
+static ql::datum_t get_arena_stats() {
+    return ql::datum_t();
+}
+
+#endif  // __linux__
+
+/* `fallback_allocations` counts the buffers that came from `raw_malloc_aligned()`
+because the arena was full. */
+ql::datum_t get_page_arena_stats() {
+    ql::datum_t stats = get_arena_stats();
+    if (!stats.has()) {
+        ql::datum_object_builder_t builder;
+        builder.overwrite("mode",
+            ql::datum_t(page_arena_mode_name(page_arena_mode_t::off)));
+        return std::move(builder).to_datum();
+    }
+    ql::datum_object_builder_t builder(stats);
+    builder.overwrite("fallback_allocations", ql::datum_t(static_cast<double>(
+        fallback_allocations.load(std::memory_order_relaxed))));
+    return std::move(builder).to_datum();
+}
+
+/* Reports the arena's slabs and the memory in them as "page_arena" in the stats. */
+class page_arena_stats_t : public perfmon_t {
+public:
+    void *begin_stats() {
+        return nullptr;
+    }
+    void visit_stats(void *) { }
+    ql::datum_t end_stats(void *) {
+        return get_page_arena_stats();
+    }
+};
+
+static page_arena_stats_t pm_page_arena;
+static perfmon_membership_t pm_page_arena_membership(
+    &get_global_perfmon_collection(), &pm_page_arena, "page_arena");
@@ -0,0 +1,54 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef ARCH_PAGE_ARENA_HPP_
+#define ARCH_PAGE_ARENA_HPP_
+
+#include <stddef.h>
+
+namespace ql { class datum_t; }
+
+/* The page arena hands out the DEVICE_BLOCK_SIZE-aligned buffers that hold the
+blocks of the buffer cache and the serializer (everything that goes through
+`scoped_device_block_aligned_ptr_t`). It carves them out of 2MB slabs that are
+backed by huge pages, so that a big cache needs far fewer TLB entries, and so
+that the cache's memory is allocated in predictable 2MB steps instead of
+fragmenting the heap.
+
+Every slab holds buffers of a single size class (a multiple of
+DEVICE_BLOCK_SIZE, up to PAGE_ARENA_MAX_BUFFER_SIZE). Every thread keeps a few
+free buffers of each size class for itself, so most allocations and frees don't
+take the arena's lock. When all buffers of a slab are free again, the slab goes
+back to the arena; beyond PAGE_ARENA_EMPTY_SLABS_KEPT empty slabs, their memory
+is returned to the kernel.
+
+The arena is off unless `set_page_arena_mode()` turns it on. Buffers that are
+too large for it, and buffers that are allocated while it's off or full, come
+from `raw_malloc_aligned()` instead; `page_arena_free()` tells them apart by
+their address. Its usage is reported as "page_arena" in the stats. */
+
+enum class page_arena_mode_t {
+    // Buffers come from `raw_malloc_aligned()`.
+    off,
+    // Slabs are regular anonymous memory, with `madvise(MADV_HUGEPAGE)` asking the
+    // kernel to back them with transparent huge pages.
+    transparent,
+    // Slabs come from the hugetlbfs pool (`MAP_HUGETLB`), which the administrator
+    // has to reserve (e.g. through `vm.nr_hugepages`). If the pool runs dry, slabs
+    // fall back to transparent huge pages.
+    hugetlb
+};
+
+/* Turns the page arena on. Can only be called once, and only turns it on on Linux.
+Returns false (and leaves the arena off) if that's not possible. */
+bool set_page_arena_mode(page_arena_mode_t mode);
+
+/* Allocate and free a DEVICE_BLOCK_SIZE-aligned buffer. They are safe to call on
+any thread, and a buffer may be freed on a different thread than the one that
+allocated it. */
+void *page_arena_alloc(size_t size);
+void page_arena_free(void *ptr);
+
+/* The stats that are reported as "page_arena": the mode, the slabs and the bytes
+in them, and how many buffers didn't come from the arena because it was full. */
+ql::datum_t get_page_arena_stats();
+
+#endif  // ARCH_PAGE_ARENA_HPP_
@@ -207,18 +207,29 @@ bool artificial_stack_context_ref_t::is_nil() {
 }
 
 artificial_stack_t::artificial_stack_t(void (*initial_fun)(void), size_t _stack_size)
-    : stack(_stack_size), stack_size(_stack_size), overflow_protection_enabled(false) {
+    : stack(nullptr), stack_size(_stack_size), overflow_protection_enabled(false) {
 
-    // Tell the operating system that it can unmap the stack space
-    // (except for the first page, which we are definitely going to need).
-    // This is an optimization to keep memory consumption in check.
+    // We map the stack ourselves rather than getting it from the allocator. The
+    // pages don't take up any memory until they are touched, and with
+    // `MAP_NORESERVE` they don't count against the overcommit limit either, so
+    // only the part of the stack that the coroutine actually uses costs anything.
     guarantee(stack_size >= static_cast<size_t>(getpagesize()));
-    madvise(stack.get(), stack_size - getpagesize(), MADV_DONTNEED);
+    guarantee(divides(getpagesize(), stack_size));
+    int map_flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_NORESERVE
+    map_flags |= MAP_NORESERVE;
+#endif
+    void *mapping = mmap(nullptr, stack_size, PROT_READ | PROT_WRITE, map_flags, -1, 0);
+    if (mapping == MAP_FAILED) {
+        crash("Failed to allocate a coroutine stack. `mmap` failed with error code %d.",
+              get_errno());
+    }
+    stack = static_cast<char *>(mapping);
 
     // Register our stack with Valgrind so that it understands what's going on
     // and doesn't create spurious errors.
 #ifdef VALGRIND
-    valgrind_stack_id = VALGRIND_STACK_REGISTER(stack.get(), (intptr_t)stack.get() + stack_size);
+    valgrind_stack_id = VALGRIND_STACK_REGISTER(stack, (intptr_t)stack + stack_size);
 #endif
 
     // Setup the new stack (grows downwards).
@@ -241,7 +252,7 @@ artificial_stack_t::artificial_stack_t(void (*initial_fun)(void), size_t _stack_
     uintptr_t *sp;
 
     // (1) initialize sp to point at the top of the stack.
-    sp = reinterpret_cast<uintptr_t *>(uintptr_t(stack.get()) + stack_size);
+    sp = reinterpret_cast<uintptr_t *>(uintptr_t(stack) + stack_size);
 
     // (2) align sp to meet platform ABI requirements.
     // Note: not all platforms require 16-byte alignment, but it is easier to do it
@@ -340,16 +351,20 @@ artificial_stack_t::~artificial_stack_t() {
     /* Undo protections changes */
     disable_overflow_protection();
 
-    /* Return the memory to the operating system right away. This makes
-    sense because we keep our own cache of coroutine stacks around and
-    don't need to rely on the allocator to optimize for the case of
-    us quickly re-allocating an object of the same size.
-    On OS X we use MADV_FREE. On Linux MADV_FREE is not available,
-    and we use MADV_DONTNEED instead. */
+    /* Return the memory to the operating system right away. We keep our own
+    cache of coroutine stacks around, so there's no point in holding on to it. */
+    guarantee_err(munmap(stack, stack_size) == 0, "Failed to unmap a coroutine stack");
+}
+
+void artificial_stack_t::release_unused_memory() {
+    /* The topmost page holds the stack's initial frame, and we are going to need
+    it again as soon as the stack gets reused.
+    On OS X we use MADV_FREE. On Linux MADV_FREE is only available on newer
+    kernels, and we use MADV_DONTNEED instead. */
 #ifdef __MACH__
-    madvise(stack.get(), stack_size, MADV_FREE);
+    madvise(stack, stack_size - getpagesize(), MADV_FREE);
 #else
-    madvise(stack.get(), stack_size, MADV_DONTNEED);
+    madvise(stack, stack_size - getpagesize(), MADV_DONTNEED);
 #endif
 }
 
@@ -377,7 +392,7 @@ void artificial_stack_t::enable_overflow_protection() {
     /* OS X Instruments hangs when running with mprotect and having object identification
     enabled. We don't need it for THREADED_COROUTINES anyway, so don't use it then. */
 #ifndef THREADED_COROUTINES
-    checked_mprotect_page(stack.get(), PROT_NONE);
+    checked_mprotect_page(stack, PROT_NONE);
     overflow_protection_enabled = true;
 #endif
 }
@@ -387,7 +402,7 @@ void artificial_stack_t::disable_overflow_protection() {
         return;
     }
 #ifndef THREADED_COROUTINES
-    checked_mprotect_page(stack.get(), PROT_READ | PROT_WRITE);
+    checked_mprotect_page(stack, PROT_READ | PROT_WRITE);
     overflow_protection_enabled = false;
 #endif
 }
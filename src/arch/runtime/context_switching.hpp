@@ -28,6 +28,9 @@ public:
     I think fibers always have some overflow protection though? */
     void enable_overflow_protection() {}
     void disable_overflow_protection() {}
+
+    /* Not implemented for fiber stacks either. */
+    void release_unused_memory() {}
 };
 
 void context_switch(fiber_context_ref_t *current_context_out, fiber_context_ref_t *dest_context_in);
@@ -95,10 +98,10 @@ public:
     bool address_is_stack_overflow(const void *addr) const;
 
     /* Returns the base of the stack */
-    void *get_stack_base() const { return stack.get() + stack_size; }
+    void *get_stack_base() const { return stack + stack_size; }
 
     /* Returns the end of the stack */
-    void *get_stack_bound() const { return stack.get(); }
+    void *get_stack_bound() const { return stack; }
 
     /* Returns how many more bytes below the given address can be used */
     size_t free_space_below(const void *addr) const;
@@ -108,8 +111,14 @@ public:
     /* Disables stack-smashing protection for this stack, if currently enabled */
     void disable_overflow_protection();
 
+    /* Gives the memory of all but the topmost page of the stack back to the
+    operating system. The stack must not be in use. */
+    void release_unused_memory();
+
 private:
-    scoped_page_aligned_ptr_t<char> stack;
+    // Mapped with `MAP_NORESERVE` where available, so that the stack only counts
+    // against the system's memory once it's actually touched.
+    char *stack;
     size_t stack_size;
     bool overflow_protection_enabled;
 #ifdef VALGRIND
@@ -224,9 +233,10 @@ public:
     /* Returns how many more bytes below the given address can be used */
     size_t free_space_below(const void *addr) const;
 
-    /* These two are currently not implemented for threaded stacks. */
+    /* These three are currently not implemented for threaded stacks. */
     void enable_overflow_protection() {}
     void disable_overflow_protection() {}
+    void release_unused_memory() {}
 
 private:
     static void *internal_run(void *p);
@@ -2,6 +2,7 @@
 #ifndef ARCH_RUNTIME_CORO_PROFILER_HPP_
 #define	ARCH_RUNTIME_CORO_PROFILER_HPP_
 
+#include "arch/runtime/coro_sampler.hpp"
 
 #ifdef ENABLE_CORO_PROFILER
 
@@ -173,7 +174,7 @@ private:
 //
 // PROFILER_CORO_RESUME and PROFILER_CORO_YIELD are meant to be used in
 // the internal coroutine implementation to notify the profiler about when a coroutine
-// yields and resumes execution respectively.
+// yields and resumes execution respectively. They also notify the `coro_sampler_t`.
 //
 // PROFILER_RECORD_SAMPLE on the other hand can be used throughout the code to
 // increase the granularity of profiling. By default, the coro profiler collects
@@ -182,15 +183,21 @@ private:
 // such yields and can be used to "trace" execution times through different
 // sections of a given piece of code.
 #define PROFILER_RECORD_SAMPLE coro_profiler_t::get_global_profiler().record_sample()
-#define PROFILER_CORO_RESUME coro_profiler_t::get_global_profiler().record_coro_resume()
-#define PROFILER_CORO_YIELD(STRIP_FRAMES) coro_profiler_t::get_global_profiler().record_coro_yield(STRIP_FRAMES)
+#define PROFILER_CORO_RESUME do { \
+        coro_profiler_t::get_global_profiler().record_coro_resume(); \
+        coro_sampler_t::on_coro_resume(); \
+    } while (0)
+#define PROFILER_CORO_YIELD(STRIP_FRAMES) do { \
+        coro_profiler_t::get_global_profiler().record_coro_yield(STRIP_FRAMES); \
+        coro_sampler_t::on_coro_yield(); \
+    } while (0)
 
 #else /* ENABLE_CORO_PROFILER */
 
-// Short-cuts (no-ops for disabled coro profiler)
+// Short-cuts (for disabled coro profiler, only the `coro_sampler_t` gets notified)
 #define PROFILER_RECORD_SAMPLE do {} while(0)
-#define PROFILER_CORO_RESUME do {} while(0)
-#define PROFILER_CORO_YIELD(STRIP_FRAMES) do {} while(0)
+#define PROFILER_CORO_RESUME coro_sampler_t::on_coro_resume()
+#define PROFILER_CORO_YIELD(STRIP_FRAMES) coro_sampler_t::on_coro_yield()
 
 #endif /* not ENABLE_CORO_PROFILER */
 
@@ -0,0 +1,274 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/runtime/coro_sampler.hpp"
+
+#include <string.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "arch/runtime/runtime.hpp"
+#include "backtrace.hpp"
+#include "config/args.hpp"
+#include "containers/scoped.hpp"
+#include "perfmon/perfmon.hpp"
+#include "rdb_protocol/datum.hpp"
+#include "rethinkdb_backtrace.hpp"
+#include "time.hpp"
+
+std::atomic<bool> coro_sampler_t::enabled(false);
+std::atomic<int64_t> coro_sampler_t::sample_interval_nanos(MILLION);
+
+namespace {
+
+// Incremented every time the sampler gets enabled. Threads whose samples are from
+// an older epoch throw them away before they record anything new.
+std::atomic<uint64_t> sampler_epoch(0);
+
+struct stack_slot_t {
+    // 0 if the slot is unused.
+    uint64_t hash;
+    int depth;
+    void *frames[CORO_SAMPLER_BACKTRACE_DEPTH];
+    uint64_t samples;
+};
+
+struct thread_samples_t {
+    uint64_t epoch;
+    // When the current coroutine resumed, or 0 if we don't know.
+    int64_t resumed_at;
+    // How much running time is left until the next sample.
+    int64_t nanos_until_sample;
+    uint64_t total_samples;
+    uint64_t dropped_samples;
+    stack_slot_t slots[CORO_SAMPLER_SLOTS_PER_THREAD];
+
+    void reset(uint64_t new_epoch) {
+        epoch = new_epoch;
+        resumed_at = 0;
+        nanos_until_sample = 0;
+        total_samples = 0;
+        dropped_samples = 0;
+        memset(slots, 0, sizeof(slots));
+    }
+};
+
+// Each of these is only ever accessed on its own thread; they are allocated the
+// first time that the thread records anything.
+scoped_ptr_t<thread_samples_t> per_thread_samples[MAX_THREADS];
+
+thread_samples_t *get_thread_samples() {
+    scoped_ptr_t<thread_samples_t> *samples =
+        &per_thread_samples[get_thread_id().threadnum];
+    const uint64_t epoch = sampler_epoch.load(std::memory_order_acquire);
+    if (!samples->has()) {
+        samples->init(new thread_samples_t);
+        (*samples)->reset(epoch);
+    } else if ((*samples)->epoch != epoch) {
+        (*samples)->reset(epoch);
+    }
+    return samples->get();
+}
+
+uint64_t hash_frames(void *const *frames, int depth) {
+    // FNV-1a over the frame addresses
+    uint64_t hash = 14695981039346656037ULL;
+    for (int i = 0; i < depth; ++i) {
+        hash ^= reinterpret_cast<uintptr_t>(frames[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash == 0 ? 1 : hash;
+}
+
+// How many slots we look at before we give up on finding a place for a stack.
+const int MAX_PROBES = 32;
+
+void add_samples(thread_samples_t *ts, void *const *frames, int depth,
+                 uint64_t samples) {
+    ts->total_samples += samples;
+    const uint64_t hash = hash_frames(frames, depth);
+    for (int probe = 0; probe < MAX_PROBES; ++probe) {
+        stack_slot_t *slot = &ts->slots[(hash + probe) % CORO_SAMPLER_SLOTS_PER_THREAD];
+        if (slot->hash == 0) {
+            slot->hash = hash;
+            slot->depth = depth;
+            memcpy(slot->frames, frames, depth * sizeof(void *));
+            slot->samples = samples;
+            return;
+        }
+        if (slot->hash == hash && slot->depth == depth
+            && memcmp(slot->frames, frames, depth * sizeof(void *)) == 0) {
+            slot->samples += samples;
+            return;
+        }
+    }
+    ts->dropped_samples += samples;
+}
+
+/* Reports the samples of all threads. This is registered as "coro_profile" in the
+global perfmon collection. */
+class coro_sampler_perfmon_t : public perfmon_t {
+public:
+    void *begin_stats() {
+        return new thread_report_t[get_num_threads()];
+    }
+
+    void visit_stats(void *data) {
+        thread_report_t *report =
+            &static_cast<thread_report_t *>(data)[get_thread_id().threadnum];
+        const scoped_ptr_t<thread_samples_t> &ts =
+            per_thread_samples[get_thread_id().threadnum];
+        if (!ts.has() || ts->epoch != sampler_epoch.load(std::memory_order_acquire)) {
+            return;
+        }
+        report->total_samples = ts->total_samples;
+        report->dropped_samples = ts->dropped_samples;
+        for (const stack_slot_t &slot : ts->slots) {
+            if (slot.hash != 0) {
+                report->stacks.push_back(std::make_pair(
+                    std::vector<void *>(slot.frames, slot.frames + slot.depth),
+                    slot.samples));
+            }
+        }
+    }
+
+    ql::datum_t end_stats(void *data) {
+        scoped_array_t<thread_report_t> reports(
+            static_cast<thread_report_t *>(data), get_num_threads());
+
+        uint64_t total_samples = 0, dropped_samples = 0;
+        std::map<std::vector<void *>, uint64_t> merged;
+        for (size_t i = 0; i < reports.size(); ++i) {
+            total_samples += reports[i].total_samples;
+            dropped_samples += reports[i].dropped_samples;
+            for (const auto &stack : reports[i].stacks) {
+                merged[stack.first] += stack.second;
+            }
+        }
+
+        std::vector<std::pair<uint64_t, const std::vector<void *> *> > by_samples;
+        for (const auto &stack : merged) {
+            by_samples.push_back(std::make_pair(stack.second, &stack.first));
+        }
+        std::sort(by_samples.begin(), by_samples.end(),
+            [](const std::pair<uint64_t, const std::vector<void *> *> &a,
+               const std::pair<uint64_t, const std::vector<void *> *> &b) {
+                return a.first > b.first;
+            });
+        if (by_samples.size() > CORO_SAMPLER_MAX_REPORTED_STACKS) {
+            by_samples.resize(CORO_SAMPLER_MAX_REPORTED_STACKS);
+        }
+
+        std::map<void *, std::string> frame_names;
+        std::vector<ql::datum_t> stacks;
+        for (const auto &stack : by_samples) {
+            // Stack traces start at the innermost frame, but flamegraphs want the
+            // outermost one first.
+            std::string folded;
+            for (auto it = stack.second->rbegin(); it != stack.second->rend(); ++it) {
+                if (!folded.empty()) {
+                    folded += ";";
+                }
+                folded += get_frame_name(*it, &frame_names);
+            }
+            ql::datum_object_builder_t builder;
+            builder.overwrite("stack", ql::datum_t(datum_string_t(folded)));
+            builder.overwrite("samples",
+                ql::datum_t(static_cast<double>(stack.first)));
+            stacks.push_back(std::move(builder).to_datum());
+        }
+
+        ql::datum_object_builder_t builder;
+        builder.overwrite("enabled", ql::datum_t::boolean(coro_sampler_t::is_enabled()));
+        builder.overwrite("sample_interval_ms", ql::datum_t(
+            static_cast<double>(coro_sampler_t::get_sample_interval_nanos()) / MILLION));
+        builder.overwrite("samples", ql::datum_t(static_cast<double>(total_samples)));
+        builder.overwrite("dropped_samples",
+            ql::datum_t(static_cast<double>(dropped_samples)));
+        builder.overwrite("stacks", ql::datum_t(
+            std::move(stacks), ql::configured_limits_t::unlimited));
+        return std::move(builder).to_datum();
+    }
+
+private:
+    struct thread_report_t {
+        thread_report_t() : total_samples(0), dropped_samples(0) { }
+        uint64_t total_samples;
+        uint64_t dropped_samples;
+        std::vector<std::pair<std::vector<void *>, uint64_t> > stacks;
+    };
+
+    static const std::string &get_frame_name(
+            void *addr, std::map<void *, std::string> *cache) {
+        auto it = cache->find(addr);
+        if (it != cache->end()) {
+            return it->second;
+        }
+        backtrace_frame_t frame(addr);
+        frame.initialize_symbols();
+        std::string name;
+        try {
+            name = frame.get_demangled_name();
+        } catch (const demangle_failed_exc_t &) {
+            name = frame.get_name();
+        }
+        if (name.empty()) {
+            name = strprintf("%p", addr);
+        }
+        // Semicolons separate the frames of folded stacks.
+        std::replace(name.begin(), name.end(), ';', ',');
+        return cache->insert(std::make_pair(addr, name)).first->second;
+    }
+};
+
+coro_sampler_perfmon_t pm_coro_sampler;
+perfmon_membership_t pm_coro_sampler_membership(
+    &get_global_perfmon_collection(), &pm_coro_sampler, "coro_profile");
+
+}  // namespace
+
+void coro_sampler_t::enable(int64_t interval_nanos) {
+    guarantee(interval_nanos > 0);
+    sample_interval_nanos.store(interval_nanos, std::memory_order_relaxed);
+    sampler_epoch.fetch_add(1, std::memory_order_acq_rel);
+    enabled.store(true, std::memory_order_relaxed);
+}
+
+void coro_sampler_t::disable() {
+    enabled.store(false, std::memory_order_relaxed);
+}
+
+void coro_sampler_t::record_resume() {
+    get_thread_samples()->resumed_at = get_ticks().nanos;
+}
+
+void coro_sampler_t::record_yield() {
+    thread_samples_t *ts = get_thread_samples();
+    if (ts->resumed_at == 0) {
+        // We got enabled while the coroutine was running.
+        return;
+    }
+    const int64_t now = get_ticks().nanos;
+    ts->nanos_until_sample -= now - ts->resumed_at;
+    ts->resumed_at = 0;
+    if (ts->nanos_until_sample > 0) {
+        return;
+    }
+
+    const int64_t interval = get_sample_interval_nanos();
+    const uint64_t samples = 1 + (-ts->nanos_until_sample) / interval;
+    ts->nanos_until_sample += samples * interval;
+
+    // Skip the frames for `rethinkdb_backtrace()` and for us.
+    const int frames_to_skip = NUM_FRAMES_INSIDE_RETHINKDB_BACKTRACE + 1;
+    void *frames[CORO_SAMPLER_BACKTRACE_DEPTH + frames_to_skip];
+    const int depth = rethinkdb_backtrace(
+        frames, CORO_SAMPLER_BACKTRACE_DEPTH + frames_to_skip);
+    if (depth <= frames_to_skip) {
+        ts->dropped_samples += samples;
+        return;
+    }
+    add_samples(ts, frames + frames_to_skip, depth - frames_to_skip, samples);
+}
@@ -0,0 +1,74 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef ARCH_RUNTIME_CORO_SAMPLER_HPP_
+#define ARCH_RUNTIME_CORO_SAMPLER_HPP_
+
+#include <stdint.h>
+
+#include <atomic>
+
+/* Depth of the stack traces taken by the coro sampler. */
+#define CORO_SAMPLER_BACKTRACE_DEPTH            24
+
+/* How many distinct stack traces every thread can keep track of. Samples of stack
+traces that don't fit anymore are only counted as dropped. */
+#define CORO_SAMPLER_SLOTS_PER_THREAD           1024
+
+/* How many of the most frequent stack traces the stats report. */
+#define CORO_SAMPLER_MAX_REPORTED_STACKS        1000
+
+/*
+ * The `coro_sampler_t` is a sampling profiler for coroutines. Unlike the
+ * `coro_profiler_t`, it's always compiled in and can be turned on and off while
+ * the server is running. While it's off, the only cost is a check of an atomic
+ * flag whenever a coroutine resumes or yields.
+ *
+ * While it's on, every thread keeps track of how much time its coroutines spend
+ * running between yields. Whenever another `sample_interval` of running time has
+ * accumulated on a thread, the coroutine that yields next gets sampled: the
+ * sampler takes a stack trace of it and counts one sample (or several, if the
+ * coroutine ran for several intervals) for that stack trace. So the number of
+ * samples of a stack trace approximates the running time spent in it, in units
+ * of `sample_interval`.
+ *
+ * Each thread counts its samples in its own table, so recording a sample doesn't
+ * need any locks or atomic operations. The tables are read by the "coro_profile"
+ * perfmon, which visits every thread, and which merges the stack traces of all
+ * threads into flamegraph-ready "root;...;leaf" strings. The
+ * `rethinkdb._debug_coro_profile` table shows them for every server.
+ */
+class coro_sampler_t {
+public:
+    /* Starts sampling on all threads, discarding any earlier samples. */
+    static void enable(int64_t sample_interval_nanos);
+    /* Stops sampling. The samples collected so far are kept around. */
+    static void disable();
+
+    static bool is_enabled() {
+        return enabled.load(std::memory_order_relaxed);
+    }
+    static int64_t get_sample_interval_nanos() {
+        return sample_interval_nanos.load(std::memory_order_relaxed);
+    }
+
+    // Called by the coroutine implementation whenever a coroutine resumes or
+    // yields.
+    static void on_coro_resume() {
+        if (is_enabled()) {
+            record_resume();
+        }
+    }
+    static void on_coro_yield() {
+        if (is_enabled()) {
+            record_yield();
+        }
+    }
+
+private:
+    static void record_resume();
+    static void record_yield();
+
+    static std::atomic<bool> enabled;
+    static std::atomic<int64_t> sample_interval_nanos;
+};
+
+#endif  // ARCH_RUNTIME_CORO_SAMPLER_HPP_
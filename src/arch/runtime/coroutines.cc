@@ -28,9 +28,13 @@
 size_t coro_stack_size = COROUTINE_STACK_SIZE;
 
 // How many unused coroutine stacks to keep around (at most), before they are
-// freed. This value is per thread.
+// freed. This value is per thread and per stack size class.
 const size_t COROUTINE_FREE_LIST_SIZE = 64;
 
+// How many of those unused stacks keep their memory. The others give most of their
+// memory back to the operating system until they get reused.
+const size_t COROUTINE_HOT_FREE_LIST_SIZE = 16;
+
 // In debug mode, we print a warning if more than this many coroutines have been
 // allocated on one thread.
 #ifndef NDEBUG
@@ -68,8 +72,12 @@ struct coro_globals_t {
     /* The previous context. */
     coro_t *prev_coro;
 
-    /* A list of coro_t objects that are not in use. */
-    intrusive_list_t<coro_t> free_coros;
+    /* Lists of coro_t objects that are not in use, one of each per stack size class.
+    The coroutines on `hot_free_coros` were in use recently and still have the
+    memory of their stacks; the ones on `cold_free_coros` have given it back. We
+    always reuse the most recently used coroutine first. */
+    intrusive_list_t<coro_t> hot_free_coros[NUM_CORO_STACK_CLASSES];
+    intrusive_list_t<coro_t> cold_free_coros[NUM_CORO_STACK_CLASSES];
 
     /* A list of coroutines that currently have protected stacks. The least recently
     used protected coroutine is always at the front of the list. */
@@ -120,9 +128,14 @@ struct coro_globals_t {
         rassert(!current_coro);
 
         /* Destroy remaining coroutines */
-        while (coro_t *s = free_coros.head()) {
-            free_coros.remove(s);
-            delete s;
+        for (int i = 0; i < NUM_CORO_STACK_CLASSES; ++i) {
+            for (intrusive_list_t<coro_t> *list : {&hot_free_coros[i],
+                                                   &cold_free_coros[i]}) {
+                while (coro_t *s = list->head()) {
+                    list->remove(s);
+                    delete s;
+                }
+            }
         }
     }
 
@@ -162,8 +175,17 @@ void coro_runtime_t::get_coroutine_counts(std::map<std::string, size_t> *dest) {
 TLS_with_init(int64_t, coro_selfname_counter, 0);
 #endif
 
-coro_t::coro_t() :
-    stack(&coro_t::run, coro_stack_size),
+size_t stack_size_for_class(coro_stack_class_t stack_class) {
+    switch (stack_class) {
+    case coro_stack_class_t::normal: return coro_stack_size;
+    case coro_stack_class_t::small: return COROUTINE_SMALL_STACK_SIZE;
+    default: unreachable();
+    }
+}
+
+coro_t::coro_t(coro_stack_class_t stack_class) :
+    stack_class_(stack_class),
+    stack(&coro_t::run, stack_size_for_class(stack_class)),
     current_thread_(linux_thread_pool_t::get_thread_id()),
     notified_(false),
     waiting_(false),
@@ -194,18 +216,33 @@ coro_t::coro_t() :
 
 void coro_t::return_coro_to_free_list(coro_t *coro) {
     coro_globals_t *cglobals = TLS_get_cglobals();
-    // Note that we must guarantee that `coro` is never evicted immediately. We do so
-    // by checking the free list size *before* we push `coro` onto it.
-    // This is important because when we call `return_coro_to_free_list` in
-    // `coro_t::run`, that coroutine is still active and must not be deleted yet.
-    static_assert(COROUTINE_FREE_LIST_SIZE > 0, "COROUTINE_FREE_LIST_SIZE cannot be 0");
-    if (cglobals->free_coros.size() >= COROUTINE_FREE_LIST_SIZE) {
-        coro_t *coro_to_delete = cglobals->free_coros.tail();
-        cglobals->free_coros.remove(coro_to_delete);
-        delete coro_to_delete;
+    const int c = static_cast<int>(coro->stack_class_);
+    intrusive_list_t<coro_t> *hot = &cglobals->hot_free_coros[c];
+    intrusive_list_t<coro_t> *cold = &cglobals->cold_free_coros[c];
+
+    // Note that we must guarantee that `coro` is neither evicted nor has its stack
+    // released immediately. This is important because when we call
+    // `return_coro_to_free_list` in `coro_t::run`, that coroutine is still active
+    // and running on its stack. We only ever release or delete the least recently
+    // used coroutines, and `coro` is the most recently used one.
+    static_assert(COROUTINE_HOT_FREE_LIST_SIZE > 0,
+                  "COROUTINE_HOT_FREE_LIST_SIZE cannot be 0");
+    static_assert(COROUTINE_FREE_LIST_SIZE > COROUTINE_HOT_FREE_LIST_SIZE,
+                  "COROUTINE_FREE_LIST_SIZE must be larger than "
+                  "COROUTINE_HOT_FREE_LIST_SIZE");
+    hot->push_back(coro);
+    if (hot->size() > COROUTINE_HOT_FREE_LIST_SIZE) {
+        coro_t *coro_to_cool = hot->head();
+        rassert(coro_to_cool != coro);
+        hot->remove(coro_to_cool);
+        coro_to_cool->stack.release_unused_memory();
+        cold->push_back(coro_to_cool);
+        if (cold->size() > COROUTINE_FREE_LIST_SIZE - COROUTINE_HOT_FREE_LIST_SIZE) {
+            coro_t *coro_to_delete = cold->head();
+            cold->remove(coro_to_delete);
+            delete coro_to_delete;
+        }
     }
-    rassert(cglobals->free_coros.size() < COROUTINE_FREE_LIST_SIZE);
-    cglobals->free_coros.push_back(coro);
 }
 
 coro_t::~coro_t() {
@@ -297,7 +334,7 @@ void coro_t::run() {
         We don't call `disable_stack_protection()` here to increase the efficiency
         of the free list. This means that we can slightly exceed the maximum number of
         protected coroutines (`MAX_PROTECTED_COROS`), by at most
-        `COROUTINE_FREE_LIST_SIZE` per thread. */
+        `COROUTINE_FREE_LIST_SIZE` per thread and stack size class. */
         if (coro->protected_stack_lru_entry_.in_a_list()) {
             cglobals_on_final_thread->protected_coros_lru.remove(
                 &coro->protected_stack_lru_entry_);
@@ -514,15 +551,21 @@ bool coroutines_have_been_initialized() {
     return TLS_get_cglobals() != nullptr;
 }
 
-coro_t * coro_t::get_coro() {
+coro_t * coro_t::get_coro(coro_stack_class_t stack_class) {
     rassert(coroutines_have_been_initialized());
     coro_t *coro;
 
-    if (TLS_get_cglobals()->free_coros.size() == 0) {
-        coro = new coro_t();
+    const int c = static_cast<int>(stack_class);
+    intrusive_list_t<coro_t> *hot = &TLS_get_cglobals()->hot_free_coros[c];
+    intrusive_list_t<coro_t> *cold = &TLS_get_cglobals()->cold_free_coros[c];
+    if (hot->size() != 0) {
+        coro = hot->tail();
+        hot->remove(coro);
+    } else if (cold->size() != 0) {
+        coro = cold->tail();
+        cold->remove(coro);
     } else {
-        coro = TLS_get_cglobals()->free_coros.tail();
-        TLS_get_cglobals()->free_coros.remove(coro);
+        coro = new coro_t(stack_class);
     }
 
     rassert(!coro->intrusive_list_node_t<coro_t>::in_a_list());
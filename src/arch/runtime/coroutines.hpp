@@ -43,6 +43,17 @@ struct coro_lru_entry_t : public intrusive_list_node_t<coro_lru_entry_t> {
     coro_t *coro;
 };
 
+/* Every coroutine runs on a stack of one of these size classes. Coroutines that are
+known to stay shallow, and that don't call into code of unbounded depth, can be
+spawned on a `small` stack of `COROUTINE_SMALL_STACK_SIZE` bytes to save memory.
+Code that might recurse deeply protects itself with `call_with_enough_stack()`,
+which moves it onto a `normal` stack if there isn't enough space left. */
+enum class coro_stack_class_t {
+    normal = 0,
+    small = 1
+};
+const int NUM_CORO_STACK_CLASSES = 2;
+
 /* A coro_t represents a fiber of execution within a thread. Create one with spawn_*(). Within a
 coroutine, call wait() to return control to the scheduler; the coroutine will be resumed when
 another fiber calls notify_*() on it.
@@ -70,6 +81,21 @@ public:
         return coro;
     }
 
+    /* Like the above, but run `action` on a stack of the given size class. */
+    template<class callable_t>
+    static void spawn_now_dangerously(coro_stack_class_t stack_class,
+                                      callable_t &&action) {
+        coro_t *coro = get_and_init_coro(std::forward<callable_t>(action), stack_class);
+        coro->notify_now_deprecated();
+    }
+
+    template<class callable_t>
+    static coro_t *spawn_sometime(coro_stack_class_t stack_class, callable_t &&action) {
+        coro_t *coro = get_and_init_coro(std::forward<callable_t>(action), stack_class);
+        coro->notify_sometime();
+        return coro;
+    }
+
     /* This is an optimization over spawn_sometime() followed by an on_thread_t.
     It avoids two thread messages, since it doesn't have to run on the original
     thread first, and also doesn't switch back at the end of the coro's lifetime. */
@@ -174,7 +200,7 @@ private:
 
     // Constructor sets up the stack, get_and_init_coro will load a function to be run
     //  at which point the coroutine can be notified
-    coro_t();
+    explicit coro_t(coro_stack_class_t stack_class);
 
     // Generates a spawn-time backtrace and stores it into `spawn_backtrace`.
     void grab_spawn_backtrace();
@@ -185,8 +211,10 @@ private:
 
     // If this function footprint ever changes, you may need to update the parse_coroutine_info function
     template<class callable_t>
-    static coro_t *get_and_init_coro(callable_t &&action) {
-        coro_t *coro = get_coro();
+    static coro_t *get_and_init_coro(
+            callable_t &&action,
+            coro_stack_class_t stack_class = coro_stack_class_t::normal) {
+        coro_t *coro = get_coro(stack_class);
 #ifndef NDEBUG
         coro->parse_coroutine_type(CURRENT_FUNCTION_PRETTY);
 #endif
@@ -205,7 +233,7 @@ private:
         return coro;
     }
 
-    static coro_t *get_coro();
+    static coro_t *get_coro(coro_stack_class_t stack_class);
 
     static void return_coro_to_free_list(coro_t *coro);
 
@@ -217,6 +245,7 @@ private:
 
     virtual void on_thread_switch();
 
+    const coro_stack_class_t stack_class_;
     coro_stack_t stack;
 
     threadnum_t current_thread_;
@@ -7,6 +7,7 @@
 #include <algorithm>
 
 #include "config/args.hpp"
+#include "concurrency/cache_line_padded.hpp"
 #include "arch/runtime/event_queue.hpp"
 #include "arch/runtime/thread_pool.hpp"
 #include "logger.hpp"
@@ -18,13 +19,101 @@
 #define RDB_RELOOP_MESSAGES 0
 #endif
 
+/* The sending thread puts messages into `slots` and advances `tail`; the
+receiving thread takes them out and advances `head`. Both only ever increase, so
+`tail - head` is the number of messages in the ring.
+
+If the ring is full, the sender puts the remaining messages on the `overflow`
+list instead, and keeps doing so until the receiver has emptied it. That way the
+messages from one thread are always received in the order they were sent. */
+class linux_message_hub_t::incoming_ring_t {
+public:
+    incoming_ring_t() : head(0), tail(0), has_overflow(false) { }
+
+    ~incoming_ring_t() {
+        guarantee(head.value.load() == tail.value.load());
+        guarantee(overflow.empty());
+    }
+
+    // Called on the sending thread. Moves all of `msgs` into the ring.
+    void push(msg_list_t *msgs) {
+        if (has_overflow.load(std::memory_order_acquire)) {
+            spinlock_acq_t acq(&overflow_lock);
+            // The receiver might have emptied the overflow list in the meantime.
+            if (has_overflow.load(std::memory_order_relaxed)) {
+                overflow.append_and_clear(msgs);
+                return;
+            }
+        }
+
+        size_t t = tail.value.load(std::memory_order_relaxed);
+        size_t h = head.value.load(std::memory_order_acquire);
+        while (linux_thread_message_t *m = msgs->head()) {
+            if (t - h == MESSAGE_RING_SIZE) {
+                h = head.value.load(std::memory_order_acquire);
+                if (t - h == MESSAGE_RING_SIZE) {
+                    break;
+                }
+            }
+            msgs->remove(m);
+            slots[t % MESSAGE_RING_SIZE] = m;
+            ++t;
+        }
+        tail.value.store(t, std::memory_order_release);
+
+        if (!msgs->empty()) {
+            spinlock_acq_t acq(&overflow_lock);
+            overflow.append_and_clear(msgs);
+            has_overflow.store(true, std::memory_order_release);
+        }
+    }
+
+    // Called on the receiving thread. Appends all messages to `out`.
+    void pop_all(msg_list_t *out) {
+        // If we see the overflow flag, we also see all messages that were put
+        // into the ring before the sender started overflowing.
+        const bool overflowed = has_overflow.load(std::memory_order_acquire);
+
+        size_t h = head.value.load(std::memory_order_relaxed);
+        const size_t t = tail.value.load(std::memory_order_acquire);
+        for (; h != t; ++h) {
+            out->push_back(slots[h % MESSAGE_RING_SIZE]);
+        }
+        head.value.store(h, std::memory_order_release);
+
+        if (overflowed) {
+            spinlock_acq_t acq(&overflow_lock);
+            out->append_and_clear(&overflow);
+            has_overflow.store(false, std::memory_order_release);
+        }
+    }
+
+private:
+    // `head` and `tail` are written by different threads, so they get their own
+    // cache lines.
+    cache_line_padded_t<std::atomic<size_t> > head;
+    cache_line_padded_t<std::atomic<size_t> > tail;
+    linux_thread_message_t *slots[MESSAGE_RING_SIZE];
+
+    std::atomic<bool> has_overflow;
+    spinlock_t overflow_lock;
+    msg_list_t overflow;
+
+    DISABLE_COPYING(incoming_ring_t);
+};
+
 linux_message_hub_t::linux_message_hub_t(linux_event_queue_t *queue,
                                          linux_thread_pool_t *thread_pool,
                                          threadnum_t current_thread)
     : queue_(queue),
       thread_pool_(thread_pool),
       is_woken_up_(false),
+      same_node_messages_(0),
+      other_node_messages_(0),
       current_thread_(current_thread) {
+    for (int i = 0; i < MAX_THREADS; ++i) {
+        incoming_rings_[i].store(nullptr, std::memory_order_relaxed);
+    }
 
 #ifndef NDEBUG
     if(MESSAGE_SCHEDULER_GRANULARITY < (1 << (NUM_SCHEDULER_PRIORITIES))) {
@@ -48,11 +137,37 @@ linux_message_hub_t::~linux_message_hub_t() {
     }
 
     guarantee(incoming_messages_.empty());
+    for (int i = 0; i < MAX_THREADS; ++i) {
+        delete incoming_rings_[i].load();
+    }
+}
+
+linux_message_hub_t::incoming_ring_t *linux_message_hub_t::get_incoming_ring(
+        threadnum_t source_thread) {
+    std::atomic<incoming_ring_t *> *slot = &incoming_rings_[source_thread.threadnum];
+    // Only `source_thread` ever sets the pointer, so we don't have to worry about
+    // two threads creating the ring at the same time.
+    incoming_ring_t *ring = slot->load(std::memory_order_relaxed);
+    if (ring == nullptr) {
+        ring = new incoming_ring_t;
+        slot->store(ring, std::memory_order_release);
+    }
+    return ring;
 }
 
 void linux_message_hub_t::do_store_message(threadnum_t nthread, linux_thread_message_t *msg) {
     rassert(0 <= nthread.threadnum && nthread.threadnum < thread_pool_->n_threads);
     queues_[nthread.threadnum].msg_local_list.push_back(msg);
+
+    const int node = thread_pool_->thread_placements[current_thread_.threadnum].node;
+    if (node != -1 && nthread != current_thread_) {
+        const int destination_node = thread_pool_->thread_placements[nthread.threadnum].node;
+        if (destination_node == node) {
+            ++same_node_messages_;
+        } else if (destination_node != -1) {
+            ++other_node_messages_;
+        }
+    }
 }
 
 // Collects a message for a given thread onto a local list.
@@ -94,15 +209,13 @@ void linux_message_hub_t::store_message_sometime(threadnum_t nthread, linux_thre
 
 
 void linux_message_hub_t::insert_external_message(linux_thread_message_t *msg) {
-    bool do_wake_up;
     {
         spinlock_acq_t acq(&incoming_messages_lock_);
-        do_wake_up = !check_and_set_is_woken_up();
         incoming_messages_.push_back(msg);
     }
 
     // Wakey wakey eggs and bakey
-    if (do_wake_up) {
+    if (!check_and_set_is_woken_up()) {
         event_.wakey_wakey();
     }
 }
@@ -178,12 +291,7 @@ void linux_message_hub_t::on_event(int events) {
             // Place wakey_wakey and then yield to the event processing.
             // It will wake us up again immediately, but can handle a few
             // OS events (such as timers, network messages etc.) in the meantime.
-            bool do_wake_up;
-            {
-                spinlock_acq_t acq(&incoming_messages_lock_);
-                do_wake_up = !check_and_set_is_woken_up();
-            }
-            if (do_wake_up) {
+            if (!check_and_set_is_woken_up()) {
                 event_.wakey_wakey();
             }
             break;
@@ -197,12 +305,21 @@ void linux_message_hub_t::sort_incoming_messages_by_priority() {
     // assigning each message to a different priority queue
     // is more expensive.
 
-    // 1. Pull the messages
+    // 1. Pull the messages. We reset `is_woken_up_` first, so that anyone who
+    // hands us a message after we've looked for it will wake us up again.
+    is_woken_up_.store(false);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
     msg_list_t new_messages;
+    for (int i = 0; i < thread_pool_->n_threads; ++i) {
+        incoming_ring_t *ring = incoming_rings_[i].load(std::memory_order_acquire);
+        if (ring != nullptr) {
+            ring->pop_all(&new_messages);
+        }
+    }
     {
         spinlock_acq_t acq(&incoming_messages_lock_);
         new_messages.append_and_clear(&incoming_messages_);
-        is_woken_up_ = false;
     }
 
     // 2. Sort the messages into their respective priority queues
@@ -222,9 +339,7 @@ void linux_message_hub_t::sort_incoming_messages_by_priority() {
 }
 
 bool linux_message_hub_t::check_and_set_is_woken_up() {
-    const bool was_woken_up = is_woken_up_;
-    is_woken_up_ = true;
-    return was_woken_up;
+    return is_woken_up_.exchange(true);
 }
 
 // Pushes messages collected locally global lists available to all
@@ -236,22 +351,16 @@ void linux_message_hub_t::push_messages() {
         thread_queue_t *queue = &queues_[i];
         if (!queue->msg_local_list.empty()) {
             // Transfer messages to the other core
-
-            bool do_wake_up;
-            {
-                spinlock_acq_t acq(&thread_pool_->threads[i]->message_hub.incoming_messages_lock_);
-
-                // We only need to do a wake up if we're the first people to do a
-                // wake up.
-                do_wake_up =
-                    !thread_pool_->threads[i]->message_hub.check_and_set_is_woken_up();
-
-                thread_pool_->threads[i]->message_hub.incoming_messages_.append_and_clear(&queue->msg_local_list);
-            }
-
-            // Wakey wakey, perhaps eggs and bakey
-            if (do_wake_up) {
-                thread_pool_->threads[i]->message_hub.event_.wakey_wakey();
+            linux_message_hub_t *other_hub = &thread_pool_->threads[i]->message_hub;
+            other_hub->get_incoming_ring(current_thread_)->push(&queue->msg_local_list);
+            // Makes sure that the other thread either sees the messages when it
+            // resets `is_woken_up_`, or we see that it reset it.
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            // We only need to do a wake up if we're the first people to do a
+            // wake up. Wakey wakey, perhaps eggs and bakey.
+            if (!other_hub->check_and_set_is_woken_up()) {
+                other_hub->event_.wakey_wakey();
             }
         }
     }
@@ -4,6 +4,8 @@
 
 #include <pthread.h>
 
+#include <atomic>
+
 #include "arch/runtime/event_queue.hpp"
 #include "arch/runtime/runtime_utils.hpp"
 #include "arch/runtime/system_event.hpp"
@@ -23,7 +25,14 @@ class linux_thread_pool_t;
 /* There is one message hub per thread, NOT one message hub for the entire program.
 
 Each message hub stores messages that are going from that message hub's home thread to
-other threads. It keeps a separate queue for messages destined for each other thread. */
+other threads. It keeps a separate queue for messages destined for each other thread.
+
+Once per pass through the event loop, `push_messages()` hands the queued messages to
+the destination threads' hubs. Each hub has a single-producer, single-consumer ring
+for every thread that sends it messages, so handing over messages doesn't need any
+locks. The sender only notifies the receiving thread's event if the receiver isn't
+already going to look at its rings, so one wakeup can deliver the messages of many
+passes from many threads. */
 
 class linux_message_hub_t : private linux_event_callback_t {
 public:
@@ -48,6 +57,20 @@ public:
     // (which does not have an event queue)
     void insert_external_message(linux_thread_message_t *msg);
 
+    // Returns true if our thread has picked up every message that was sent to it so
+    // far. That's a cheap hint that the thread has time on its hands. It may be
+    // called from any thread.
+    bool is_idle() const {
+        return !is_woken_up_.load(std::memory_order_relaxed);
+    }
+
+    // How many messages we sent to other threads on the same NUMA node, and to
+    // threads on other nodes. Only counted if our thread is on a known node.
+    void get_numa_message_counts(int64_t *same_node_out, int64_t *other_node_out) const {
+        *same_node_out = same_node_messages_;
+        *other_node_out = other_node_messages_;
+    }
+
     ~linux_message_hub_t();
 
 private:
@@ -73,9 +96,24 @@ private:
         msg_list_t msg_local_list;
     } queues_[MAX_THREADS];
 
-    // Must only be used with acquired incoming_messages_lock_
+    /* Receives the messages that one particular thread sends to us. */
+    class incoming_ring_t;
+
+    /* Returns the ring for messages from `source_thread` to us, creating it if
+    this is the first time that `source_thread` sends us anything. Must only be
+    called on `source_thread`. */
+    incoming_ring_t *get_incoming_ring(threadnum_t source_thread);
+
+    // Returns true if someone else already woke us up since we last looked at our
+    // incoming messages, and makes sure that the next caller gets true as well.
     bool check_and_set_is_woken_up();
-    bool is_woken_up_;
+    std::atomic<bool> is_woken_up_;
+
+    // Indexed by the sending thread. Only the sending thread creates rings, so the
+    // ring pointers are atomic; the rings are destroyed along with the hub.
+    std::atomic<incoming_ring_t *> incoming_rings_[MAX_THREADS];
+
+    // Messages from outside the thread pool, which can't have a ring.
     msg_list_t incoming_messages_;
     spinlock_t incoming_messages_lock_;
 
@@ -93,6 +131,9 @@ private:
     // message is put onto incoming_messages_.
     system_event_t event_;
 
+    int64_t same_node_messages_;
+    int64_t other_node_messages_;
+
     /* The thread that we queue messages originating from. (Recall that there is one
     message_hub_t per thread.) */
     const threadnum_t current_thread_;
@@ -0,0 +1,317 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/runtime/numa.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef __linux__
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <set>
+
+#include "arch/runtime/runtime.hpp"
+#include "arch/runtime/runtime_utils.hpp"
+#include "arch/runtime/thread_pool.hpp"
+#include "perfmon/perfmon.hpp"
+#include "rdb_protocol/datum.hpp"
+
+static thread_affinity_t global_thread_affinity = thread_affinity_t::none;
+
+void set_thread_affinity(thread_affinity_t affinity) {
+    global_thread_affinity = affinity;
+}
+
+thread_affinity_t get_thread_affinity() {
+    return global_thread_affinity;
+}
+
+const char *thread_affinity_name(thread_affinity_t affinity) {
+    switch (affinity) {
+    case thread_affinity_t::none: return "none";
+    case thread_affinity_t::cores: return "cores";
+    case thread_affinity_t::numa: return "numa";
+    default: unreachable();
+    }
+}
+
+bool parse_numa_id_list(const std::string &list, std::vector<int> *ids_out) {
+    ids_out->clear();
+    const char *p = list.c_str();
+    while (*p != '\0' && *p != '\n') {
+        char *end;
+        const long first = strtol(p, &end, 10);
+        if (end == p || first < 0) {
+            return false;
+        }
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            ++p;
+            last = strtol(p, &end, 10);
+            if (end == p || last < first) {
+                return false;
+            }
+            p = end;
+        }
+        for (long id = first; id <= last; ++id) {
+            ids_out->push_back(id);
+        }
+        if (*p == ',') {
+            ++p;
+        } else if (*p != '\0' && *p != '\n') {
+            return false;
+        }
+    }
+    return true;
+}
+
+#ifdef __linux__
+static bool read_id_list_file(const std::string &path, std::vector<int> *ids_out) {
+    FILE *file = fopen(path.c_str(), "r");
+    if (file == nullptr) {
+        return false;
+    }
+    char line[4096];
+    const bool ok = fgets(line, sizeof(line), file) != nullptr
+        && parse_numa_id_list(line, ids_out);
+    fclose(file);
+    return ok;
+}
+#endif
+
+numa_topology_t::numa_topology_t(const std::vector<std::vector<int> > &_cpus_by_node) {
+    for (size_t i = 0; i < _cpus_by_node.size(); ++i) {
+        if (!_cpus_by_node[i].empty()) {
+            cpus_by_node.push_back(_cpus_by_node[i]);
+            os_node_ids.push_back(i);
+        }
+    }
+    guarantee(!cpus_by_node.empty());
+}
+
+numa_topology_t::numa_topology_t() {
+#ifdef __linux__
+    // We only use the CPUs that we're allowed to run on (e.g. because of `taskset`).
+    std::set<int> allowed_cpus;
+    cpu_set_t mask;
+    if (sched_getaffinity(0, sizeof(mask), &mask) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &mask)) {
+                allowed_cpus.insert(cpu);
+            }
+        }
+    }
+
+    std::vector<int> nodes;
+    if (read_id_list_file("/sys/devices/system/node/online", &nodes)) {
+        for (int node : nodes) {
+            std::vector<int> cpus;
+            if (!read_id_list_file(
+                    strprintf("/sys/devices/system/node/node%d/cpulist", node),
+                    &cpus)) {
+                continue;
+            }
+            if (!allowed_cpus.empty()) {
+                cpus.erase(std::remove_if(cpus.begin(), cpus.end(),
+                    [&](int cpu) { return allowed_cpus.count(cpu) == 0; }),
+                    cpus.end());
+            }
+            if (!cpus.empty()) {
+                cpus_by_node.push_back(cpus);
+                os_node_ids.push_back(node);
+            }
+        }
+    }
+    if (!cpus_by_node.empty()) {
+        return;
+    }
+    if (!allowed_cpus.empty()) {
+        cpus_by_node.push_back(std::vector<int>(allowed_cpus.begin(),
+                                                allowed_cpus.end()));
+        os_node_ids.push_back(-1);
+        return;
+    }
+#endif
+    // We don't know anything about the machine, so pretend it's a single node.
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < get_cpu_count(); ++cpu) {
+        cpus.push_back(cpu);
+    }
+    cpus_by_node.push_back(cpus);
+    os_node_ids.push_back(-1);
+}
+
+const numa_topology_t &numa_topology_t::get() {
+    static const numa_topology_t topology;
+    return topology;
+}
+
+int numa_topology_t::node_of_cpu(int cpu) const {
+    for (size_t node = 0; node < cpus_by_node.size(); ++node) {
+        const std::vector<int> &cpus = cpus_by_node[node];
+        if (std::find(cpus.begin(), cpus.end(), cpu) != cpus.end()) {
+            return node;
+        }
+    }
+    return -1;
+}
+
+std::vector<thread_placement_t> plan_thread_placement(
+        thread_affinity_t affinity,
+        int num_worker_threads,
+        const numa_topology_t &topology) {
+    std::vector<thread_placement_t> placements(num_worker_threads,
+                                               thread_placement_t{-1, -1});
+    switch (affinity) {
+    case thread_affinity_t::none:
+        break;
+    case thread_affinity_t::cores: {
+        // Distribute threads evenly among CPUs
+        std::vector<int> cpus;
+        for (int node = 0; node < topology.num_nodes(); ++node) {
+            const std::vector<int> &node_cpus = topology.cpus_of_node(node);
+            cpus.insert(cpus.end(), node_cpus.begin(), node_cpus.end());
+        }
+        std::sort(cpus.begin(), cpus.end());
+        for (int i = 0; i < num_worker_threads; ++i) {
+            placements[i].cpu = cpus[i % cpus.size()];
+            placements[i].node = topology.node_of_cpu(placements[i].cpu);
+        }
+    } break;
+    case thread_affinity_t::numa: {
+        // Contiguous groups of threads, as equal in size as possible, so that
+        // neighbouring thread numbers tend to share a node.
+        const int num_nodes = std::min(topology.num_nodes(), num_worker_threads);
+        int first_thread = 0;
+        for (int node = 0; node < num_nodes; ++node) {
+            const int end_thread =
+                static_cast<int64_t>(num_worker_threads) * (node + 1) / num_nodes;
+            const std::vector<int> &cpus = topology.cpus_of_node(node);
+            for (int i = first_thread; i < end_thread; ++i) {
+                placements[i].cpu = cpus[(i - first_thread) % cpus.size()];
+                placements[i].node = node;
+            }
+            first_thread = end_thread;
+        }
+    } break;
+    default:
+        unreachable();
+    }
+    return placements;
+}
+
+bool pin_current_thread_to_cpu(int cpu) {
+    // On Apple, the thread affinity API has awful documentation, so we don't even bother.
+#ifdef _GNU_SOURCE
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    CPU_SET(cpu, &mask);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &mask) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+bool prefer_current_thread_memory_on_node(int os_node_id) {
+#if defined(__linux__) && defined(SYS_set_mempolicy)
+    if (os_node_id < 0) {
+        return false;
+    }
+    // From <numaif.h>, which we don't want to depend on.
+    const int mpol_preferred = 1;
+    const int bits_per_word = 8 * sizeof(unsigned long);
+    unsigned long nodemask[1024 / bits_per_word] = { };
+    if (os_node_id >= static_cast<int>(sizeof(nodemask) * 8)) {
+        return false;
+    }
+    nodemask[os_node_id / bits_per_word] |= 1UL << (os_node_id % bits_per_word);
+    return syscall(SYS_set_mempolicy, mpol_preferred, nodemask,
+                   sizeof(nodemask) * 8 + 1) == 0;
+#else
+    (void)os_node_id;
+    return false;
+#endif
+}
+
+int get_thread_numa_node(threadnum_t thread) {
+    return linux_thread_pool_t::get_thread_pool()
+        ->thread_placements[thread.threadnum].node;
+}
+
+/* Reports where the threads are and how often they send messages to threads on
+the same node or on other nodes, as "numa" in the stats. */
+class numa_stats_t : public perfmon_t {
+public:
+    void *begin_stats() {
+        return new thread_stats_t[get_num_threads()];
+    }
+
+    void visit_stats(void *data) {
+        const int thread = get_thread_id().threadnum;
+        thread_stats_t *stats = &static_cast<thread_stats_t *>(data)[thread];
+        linux_thread_pool_t *pool = linux_thread_pool_t::get_thread_pool();
+        stats->placement = pool->thread_placements[thread];
+        stats->memory_on_node = pool->thread_memory_on_node[thread];
+        pool->threads[thread]->message_hub.get_numa_message_counts(
+            &stats->same_node_messages, &stats->other_node_messages);
+    }
+
+    ql::datum_t end_stats(void *data) {
+        scoped_array_t<thread_stats_t> stats(
+            static_cast<thread_stats_t *>(data), get_num_threads());
+
+        int64_t same_node_messages = 0, other_node_messages = 0;
+        std::vector<ql::datum_t> threads;
+        for (size_t i = 0; i < stats.size(); ++i) {
+            same_node_messages += stats[i].same_node_messages;
+            other_node_messages += stats[i].other_node_messages;
+
+            ql::datum_object_builder_t builder;
+            builder.overwrite("cpu", stats[i].placement.cpu == -1
+                ? ql::datum_t::null()
+                : ql::datum_t(static_cast<double>(stats[i].placement.cpu)));
+            builder.overwrite("node", stats[i].placement.node == -1
+                ? ql::datum_t::null()
+                : ql::datum_t(static_cast<double>(stats[i].placement.node)));
+            builder.overwrite("memory_on_node",
+                ql::datum_t::boolean(stats[i].memory_on_node));
+            builder.overwrite("same_node_messages",
+                ql::datum_t(static_cast<double>(stats[i].same_node_messages)));
+            builder.overwrite("other_node_messages",
+                ql::datum_t(static_cast<double>(stats[i].other_node_messages)));
+            threads.push_back(std::move(builder).to_datum());
+        }
+
+        ql::datum_object_builder_t builder;
+        builder.overwrite("thread_affinity", ql::datum_t(
+            thread_affinity_name(get_thread_affinity())));
+        builder.overwrite("nodes", ql::datum_t(
+            static_cast<double>(numa_topology_t::get().num_nodes())));
+        builder.overwrite("same_node_messages",
+            ql::datum_t(static_cast<double>(same_node_messages)));
+        builder.overwrite("other_node_messages",
+            ql::datum_t(static_cast<double>(other_node_messages)));
+        builder.overwrite("threads", ql::datum_t(
+            std::move(threads), ql::configured_limits_t::unlimited));
+        return std::move(builder).to_datum();
+    }
+
+private:
+    struct thread_stats_t {
+        thread_stats_t()
+            : placement{-1, -1}, memory_on_node(false),
+              same_node_messages(0), other_node_messages(0) { }
+        thread_placement_t placement;
+        bool memory_on_node;
+        int64_t same_node_messages;
+        int64_t other_node_messages;
+    };
+};
+
+static numa_stats_t pm_numa;
+static perfmon_membership_t pm_numa_membership(
+    &get_global_perfmon_collection(), &pm_numa, "numa");
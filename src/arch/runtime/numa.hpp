@@ -0,0 +1,84 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef ARCH_RUNTIME_NUMA_HPP_
+#define ARCH_RUNTIME_NUMA_HPP_
+
+#include <string>
+#include <vector>
+
+#include "threading.hpp"
+
+// How the thread pool places its worker threads on the machine's CPUs. With `cores`,
+// worker thread `i` is pinned to CPU `i` (modulo the number of CPUs). With `numa`,
+// the worker threads are split into one contiguous group per NUMA node, each thread
+// is pinned to a CPU of its node, and the memory that a thread touches first is
+// allocated on its node. The utility thread is never pinned.
+enum class thread_affinity_t {
+    none,
+    cores,
+    numa
+};
+
+/* Selects the thread affinity for thread pools that are started from now on. */
+void set_thread_affinity(thread_affinity_t affinity);
+thread_affinity_t get_thread_affinity();
+
+const char *thread_affinity_name(thread_affinity_t affinity);
+
+/* The NUMA nodes of the machine and the CPUs that belong to them, as far as we're
+allowed to run on them. On machines (or platforms) without NUMA information, there's
+a single node with all CPUs. */
+class numa_topology_t {
+public:
+    static const numa_topology_t &get();
+
+    // Mostly for the unit tests. `cpus_by_node[i]` lists the CPUs of the i-th node;
+    // nodes without any CPUs are dropped.
+    explicit numa_topology_t(const std::vector<std::vector<int> > &cpus_by_node);
+
+    int num_nodes() const {
+        return cpus_by_node.size();
+    }
+    const std::vector<int> &cpus_of_node(int node) const {
+        return cpus_by_node[node];
+    }
+    // The operating system's number for the node, for use with `set_mempolicy`.
+    int os_node_id(int node) const {
+        return os_node_ids[node];
+    }
+    // Returns -1 if the CPU isn't part of any node.
+    int node_of_cpu(int cpu) const;
+
+private:
+    numa_topology_t();
+
+    std::vector<std::vector<int> > cpus_by_node;
+    std::vector<int> os_node_ids;
+};
+
+/* Parses a Linux CPU or node list such as "0-3,8,10-11". Returns false if the list
+is malformed. */
+bool parse_numa_id_list(const std::string &list, std::vector<int> *ids_out);
+
+struct thread_placement_t {
+    // -1 means the thread isn't pinned, or isn't known to be on any node.
+    int cpu;
+    int node;
+};
+
+/* Decides where each of `num_worker_threads` worker threads goes. */
+std::vector<thread_placement_t> plan_thread_placement(
+    thread_affinity_t affinity,
+    int num_worker_threads,
+    const numa_topology_t &topology);
+
+/* Pin the calling thread to a CPU, and make the kernel prefer allocating the
+calling thread's memory on a node (given by `numa_topology_t::os_node_id()`). They
+return false if that's not possible on this system. */
+bool pin_current_thread_to_cpu(int cpu);
+bool prefer_current_thread_memory_on_node(int os_node_id);
+
+/* Returns the topology node that `thread` was placed on, or -1 if its threads
+aren't placed on nodes. */
+int get_thread_numa_node(threadnum_t thread);
+
+#endif  // ARCH_RUNTIME_NUMA_HPP_
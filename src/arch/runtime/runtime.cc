@@ -72,7 +72,7 @@ private:
 
 // Runs the action 'fun()' on thread zero.
 void run_in_thread_pool(const std::function<void()> &fun, int worker_threads) {
-    linux_thread_pool_t thread_pool(worker_threads, false);
+    linux_thread_pool_t thread_pool(worker_threads, get_thread_affinity());
     starter_t starter(&thread_pool, fun);
     thread_pool.run_thread_pool(&starter);
 }
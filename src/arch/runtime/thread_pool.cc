@@ -6,6 +6,8 @@
 #include <string.h>
 #include <unistd.h>
 
+#include <atomic>
+
 #ifndef _WIN32
 #include <sys/time.h>
 #endif
@@ -13,6 +15,7 @@
 #include "arch/compiler.hpp"
 #include "arch/barrier.hpp"
 #include "arch/os_signal.hpp"
+#include "arch/io/network_uring.hpp"
 #include "arch/io/timer_provider.hpp"
 #include "arch/runtime/event_queue.hpp"
 #include "arch/runtime/runtime.hpp"
@@ -62,14 +65,15 @@ void linux_thread_pool_t::set_thread(linux_thread_t *val) {
     thread = val;
 }
 
-linux_thread_pool_t::linux_thread_pool_t(int worker_threads, bool _do_set_affinity) :
+linux_thread_pool_t::linux_thread_pool_t(int worker_threads,
+                                         thread_affinity_t _thread_affinity) :
 #ifndef NDEBUG
       coroutine_summary(false),
 #endif
       interrupt_message(nullptr),
       generic_blocker_pool(nullptr),
       n_threads(worker_threads + 1),    // we create an extra utility thread
-      do_set_affinity(_do_set_affinity)
+      thread_affinity(_thread_affinity)
 {
     rassert(n_threads > 1);             // we want at least one non-utility thread
     rassert(n_threads <= MAX_THREADS);
@@ -128,6 +132,29 @@ void *linux_thread_pool_t::start_thread(void *arg) {
     set_thread_pool(tdata->thread_pool);
     set_thread_id(tdata->current_thread);
 
+    // Move to our CPU before we allocate anything, so that with NUMA affinity all of
+    // the thread's data structures end up on its node.
+    {
+        const thread_placement_t &placement =
+            tdata->thread_pool->thread_placements[tdata->current_thread];
+        if (placement.cpu != -1 && !pin_current_thread_to_cpu(placement.cpu)) {
+            // Pinning is only an optimization, so we carry on without it. One
+            // warning is enough for all of the threads. No thread has a log
+            // writer yet, so this goes to the fallback log writer.
+            static std::atomic<bool> warned(false);
+            if (!warned.exchange(true)) {
+                logWRN("Could not pin threads to CPU cores on this platform. Running "
+                       "them without thread affinity.");
+            }
+        }
+        if (placement.node != -1
+            && tdata->thread_pool->thread_affinity == thread_affinity_t::numa) {
+            tdata->thread_pool->thread_memory_on_node[tdata->current_thread] =
+                prefer_current_thread_memory_on_node(
+                    numa_topology_t::get().os_node_id(placement.node));
+        }
+    }
+
     // Use a separate block so that it's very clear how long the thread lives for
     // It's not really necessary, but I like it.
     {
@@ -212,6 +239,15 @@ void linux_thread_pool_t::enable_coroutine_summary() {
 void linux_thread_pool_t::run_thread_pool(linux_thread_message_t *initial_message) {
     do_shutdown = false;
 
+    // Decide where the threads go. We don't set affinity for the utility thread.
+    std::vector<thread_placement_t> placements = plan_thread_placement(
+        thread_affinity, n_threads - 1, numa_topology_t::get());
+    placements.push_back(thread_placement_t{-1, -1});
+    for (int i = 0; i < n_threads; ++i) {
+        thread_placements[i] = placements[i];
+        thread_memory_on_node[i] = false;
+    }
+
     // Start child threads
     thread_barrier_t barrier(n_threads + 1);
 
@@ -226,20 +262,6 @@ void linux_thread_pool_t::run_thread_pool(linux_thread_message_t *initial_messag
 
         int res = pthread_create(&pthreads[i], nullptr, &start_thread, tdata);
         guarantee_xerr(res == 0, res, "Could not create thread");
-
-        // Don't set affinity for the utility thread
-        if (do_set_affinity && !is_utility_thread) {
-            // On Apple, the thread affinity API has awful documentation, so we don't even bother.
-#ifdef _GNU_SOURCE
-            // Distribute threads evenly among CPUs
-            int ncpus = get_cpu_count();
-            cpu_set_t mask;
-            CPU_ZERO(&mask);
-            CPU_SET(i % ncpus, &mask);
-            res = pthread_setaffinity_np(pthreads[i], sizeof(cpu_set_t), &mask);
-            guarantee_xerr(res == 0, res, "Could not set thread affinity");
-#endif
-        }
     }
 
     // Mark the main thread (for use in assertions etc.)
@@ -469,6 +491,12 @@ linux_thread_t::linux_thread_t(linux_thread_pool_t *parent_pool, int thread_id)
 
     // Watch an eventfd for shutdown notifications
     queue.watch_event(&shutdown_notify_event, this);
+
+#if RDB_HAS_IO_URING
+    if (get_network_io_backend() == network_io_backend_t::io_uring) {
+        network_uring.init(new linux_network_uring_t(&queue));
+    }
+#endif
 }
 
 linux_thread_t::~linux_thread_t() {
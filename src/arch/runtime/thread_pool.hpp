@@ -14,10 +14,14 @@
 #include "arch/runtime/system_event.hpp"
 #include "arch/runtime/message_hub.hpp"
 #include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/numa.hpp"
 #include "arch/io/blocker_pool.hpp"
+#include "arch/io/io_uring.hpp"
 #include "arch/io/timer_provider.hpp"
 #include "arch/timer.hpp"
+#include "containers/scoped.hpp"
 
+class linux_network_uring_t;
 class linux_thread_t;
 class os_signal_cond_t;
 
@@ -41,7 +45,7 @@ and shutting down the threads and event queues. */
 
 class linux_thread_pool_t {
 public:
-    linux_thread_pool_t(int worker_threads, bool do_set_affinity);
+    linux_thread_pool_t(int worker_threads, thread_affinity_t thread_affinity);
 
     // When the process receives a SIGINT or SIGTERM, interrupt_message will be delivered to the
     // same thread that initial_message was delivered to, and interrupt_message will be set to
@@ -101,7 +105,12 @@ public:
     static void run_in_blocker_pool(const Callable &);
 
     int n_threads;
-    bool do_set_affinity;
+    thread_affinity_t thread_affinity;
+
+    // Where each thread runs, and whether the memory that it touches first gets
+    // allocated on its NUMA node. Set before the threads are started.
+    thread_placement_t thread_placements[MAX_THREADS];
+    bool thread_memory_on_node[MAX_THREADS];
 
 #ifdef _WIN32
     static linux_thread_pool_t *get_global_thread_pool();
@@ -183,6 +192,10 @@ public:
     linux_event_queue_t queue;
     linux_message_hub_t message_hub;
     timer_handler_t timer_handler;
+#if RDB_HAS_IO_URING
+    // Only set if the io_uring network backend is enabled.
+    scoped_ptr_t<linux_network_uring_t> network_uring;
+#endif
 
     /* Never accessed; its constructor and destructor set up and tear down thread-local variables
     for coroutines. */
@@ -4,17 +4,17 @@
 #include <algorithm>
 
 #include "arch/runtime/thread_pool.hpp"
+#include "config/args.hpp"
+#include "math.hpp"
 #include "time.hpp"
 #include "utils.hpp"
 
-class timer_token_t : public intrusive_priority_queue_node_t<timer_token_t> {
+class timer_token_t : public timer_wheel_node_t {
     friend class timer_handler_t;
 
 private:
     timer_token_t() : interval_nanos(-1), next_time_in_nanos(-1), callback(nullptr) { }
 
-    friend bool left_is_higher_priority(const timer_token_t *left, const timer_token_t *right);
-
     // The time between rings, if a repeating timer, otherwise zero.
     int64_t interval_nanos;
 
@@ -27,51 +27,71 @@ private:
     DISABLE_COPYING(timer_token_t);
 };
 
-bool left_is_higher_priority(const timer_token_t *left, const timer_token_t *right) {
-    return left->next_time_in_nanos < right->next_time_in_nanos;
+// The first wheel tick at or after the given time.
+static int64_t wheel_tick_for_time(int64_t nanos) {
+    return ceil_divide(nanos, TIMER_WHEEL_TICK_NANOS);
 }
 
 timer_handler_t::timer_handler_t(linux_event_queue_t *queue)
     : timer_provider(queue),
-      expected_oneshot_time_in_nanos(0) {
+      expected_oneshot_time_in_nanos(0),
+      scheduled_tick(-1),
+      token_wheel(get_ticks().nanos / TIMER_WHEEL_TICK_NANOS) {
     // Right now, we have no tokens.  So we don't ask the timer provider to do anything for us.
 }
 
 timer_handler_t::~timer_handler_t() {
-    guarantee(token_queue.empty());
+    guarantee(token_wheel.empty());
 }
 
 void timer_handler_t::on_oneshot() {
     // If the timer_provider tends to return its callback a touch early, we don't want to make a
     // bunch of calls to it, returning a tad early over and over again, leading up to a ticks
-    // threshold.  So we bump the real time up to the threshold when processing the priority queue.
+    // threshold.  So we bump the real time up to the threshold when processing the wheel.
     int64_t real_ticks = get_ticks().nanos;
     int64_t ticks = std::max(real_ticks, expected_oneshot_time_in_nanos);
 
-    while (!token_queue.empty() && token_queue.peek()->next_time_in_nanos <= ticks) {
-        timer_token_t *token = token_queue.pop();
+    // Timers that get added by the callbacks below either ring in this batch or at a
+    // later tick, so they don't need to touch the timer provider; we schedule the
+    // next one-shot once the batch is done.
+    scheduled_tick = ticks / TIMER_WHEEL_TICK_NANOS;
+    token_wheel.advance(scheduled_tick);
+
+    while (timer_wheel_node_t *node = token_wheel.pop_due()) {
+        timer_token_t *token = static_cast<timer_token_t *>(node);
+        // The callback may cancel a repeating timer, which deletes the token.
+        const bool repeating = token->interval_nanos != 0;
 
-        // Put the repeating timer back on the queue before the callback can be called (so that it
-        // may be canceled).
-        if (token->interval_nanos != 0) {
+        // Put the repeating timer back into the wheel before the callback can be called
+        // (so that it may be canceled).
+        if (repeating) {
             token->next_time_in_nanos = real_ticks + token->interval_nanos;
-            token_queue.push(token);
+            token_wheel.add(token, wheel_tick_for_time(token->next_time_in_nanos));
         }
 
         token->callback->on_timer(ticks_t{real_ticks});
 
         // Delete nonrepeating timer tokens.
-        if (token->interval_nanos == 0) {
+        if (!repeating) {
             delete token;
         }
     }
 
     // We've processed young tokens.  Now schedule a new one-shot (if necessary).
-    if (!token_queue.empty()) {
-        timer_provider.schedule_oneshot(token_queue.peek()->next_time_in_nanos, this);
+    int64_t next_tick;
+    if (token_wheel.next_event_tick(&next_tick)) {
+        schedule_oneshot(next_tick);
+    } else {
+        scheduled_tick = -1;
     }
 }
 
+void timer_handler_t::schedule_oneshot(int64_t tick) {
+    scheduled_tick = tick;
+    expected_oneshot_time_in_nanos = tick * TIMER_WHEEL_TICK_NANOS;
+    timer_provider.schedule_oneshot(expected_oneshot_time_in_nanos, this);
+}
+
 timer_token_t *timer_handler_t::add_timer_internal(
         const ticks_t next_time, const int64_t interval_ms,
         timer_callback_t *callback) {
@@ -83,22 +103,23 @@ timer_token_t *timer_handler_t::add_timer_internal(
     token->next_time_in_nanos = next_time.nanos;
     token->callback = callback;
 
-    const timer_token_t *top_entry = token_queue.peek();
-    token_queue.push(token);
+    const int64_t tick = wheel_tick_for_time(next_time.nanos);
+    token_wheel.add(token, tick);
 
-    if (top_entry == nullptr || next_time.nanos < top_entry->next_time_in_nanos) {
-        timer_provider.schedule_oneshot(next_time.nanos, this);
+    if (scheduled_tick == -1 || tick < scheduled_tick) {
+        schedule_oneshot(tick);
     }
 
     return token;
 }
 
 void timer_handler_t::cancel_timer(timer_token_t *token) {
-    token_queue.remove(token);
+    token_wheel.remove(token);
     delete token;
 
-    if (token_queue.empty()) {
+    if (token_wheel.empty()) {
         timer_provider.unschedule_oneshot();
+        scheduled_tick = -1;
     }
 }
 
@@ -3,7 +3,7 @@
 #define ARCH_TIMER_HPP_
 
 #include "arch/io/timer_provider.hpp"
-#include "containers/intrusive_priority_queue.hpp"
+#include "containers/timer_wheel.hpp"
 #include "time.hpp"
 
 class timer_token_t;
@@ -18,7 +18,12 @@ struct timer_callback_t {
 /* This timer class uses the underlying OS timer provider to get one-shot timing
  * events. It then manages a list of application timers based on that lower level
  * interface. Everyone who needs a timer should use this class (through the thread
- * pool). */
+ * pool).
+ *
+ * The application timers are kept in a `timer_wheel_t` with ticks of
+ * `TIMER_WHEEL_TICK_NANOS`, so adding and canceling a timer is O(1) no matter how
+ * many timers there are, and all timers that ring at the same tick get handled in
+ * one batch. Timers never ring early, but they can ring up to one tick late. */
 class timer_handler_t : private timer_provider_callback_t {
 public:
     explicit timer_handler_t(linux_event_queue_t *queue);
@@ -35,12 +40,18 @@ private:
     // The timer provider, a platform-dependent typedef for interfacing with the OS.
     timer_provider_t timer_provider;
 
+    void schedule_oneshot(int64_t tick);
+
     // The expected time of the next on_oneshot call.  If the oneshot arrived earlier
     // than this time, we pretend that it had arrived on time.
     int64_t expected_oneshot_time_in_nanos;
 
-    // A priority queue of timer tokens, ordered by the soonest.
-    intrusive_priority_queue_t<timer_token_t> token_queue;
+    // The wheel tick that the timer provider has been asked to wake us up at, or -1
+    // if it hasn't been asked to do anything.
+    int64_t scheduled_tick;
+
+    // The timer tokens, by the tick at which they ring next.
+    timer_wheel_t token_wheel;
 
     DISABLE_COPYING(timer_handler_t);
 };
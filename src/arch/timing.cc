@@ -69,24 +69,29 @@ void signal_timer_t::on_timer(ticks_t) {
 
 repeating_timer_t::repeating_timer_t(
         int64_t interval_ms, const std::function<void()> &_ringee) :
-    interval(interval_ms),
-    last_ticks(get_ticks()),
-    expected_next_ticks(ticks_t{last_ticks.nanos + interval * MILLION}),
-    ringee(_ringee) {
-    rassert(interval_ms > 0);
-    timer = add_timer(interval_ms, this);
-}
+    repeating_timer_t(interval_ms, _ringee, coro_stack_class_t::normal) { }
 
 repeating_timer_t::repeating_timer_t(
         int64_t interval_ms, repeating_timer_callback_t *_cb) :
+    repeating_timer_t(interval_ms, _cb, coro_stack_class_t::normal) { }
+
+repeating_timer_t::repeating_timer_t(
+        int64_t interval_ms, const std::function<void()> &_ringee,
+        coro_stack_class_t _stack_class) :
     interval(interval_ms),
     last_ticks(get_ticks()),
     expected_next_ticks(ticks_t{last_ticks.nanos + interval * MILLION}),
-    ringee([_cb]() { _cb->on_ring(); }) {
+    ringee(_ringee),
+    stack_class(_stack_class) {
     rassert(interval_ms > 0);
     timer = add_timer(interval_ms, this);
 }
 
+repeating_timer_t::repeating_timer_t(
+        int64_t interval_ms, repeating_timer_callback_t *_cb,
+        coro_stack_class_t _stack_class) :
+    repeating_timer_t(interval_ms, [_cb]() { _cb->on_ring(); }, _stack_class) { }
+
 repeating_timer_t::~repeating_timer_t() {
     cancel_timer(timer);
 }
@@ -125,5 +130,5 @@ void repeating_timer_t::on_timer(ticks_t ticks) {
     // before ring gets used.
     last_ticks = ticks;
     expected_next_ticks.nanos = last_ticks.nanos + interval * MILLION;
-    coro_t::spawn_now_dangerously(std::bind(call_ringer, ringee));
+    coro_t::spawn_now_dangerously(stack_class, std::bind(call_ringer, ringee));
 }
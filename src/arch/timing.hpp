@@ -56,10 +56,18 @@ protected:
     virtual ~repeating_timer_callback_t() { }
 };
 
+enum class coro_stack_class_t;
+
 class repeating_timer_t : private timer_callback_t {
 public:
     repeating_timer_t(int64_t interval_ms, const std::function<void()> &ringee);
     repeating_timer_t(int64_t interval_ms, repeating_timer_callback_t *ringee);
+    /* Every ring runs in a new coroutine with a stack of the given class. Only pick
+    `coro_stack_class_t::small` if the ringee is known to be shallow. */
+    repeating_timer_t(int64_t interval_ms, const std::function<void()> &ringee,
+                      coro_stack_class_t stack_class);
+    repeating_timer_t(int64_t interval_ms, repeating_timer_callback_t *ringee,
+                      coro_stack_class_t stack_class);
     ~repeating_timer_t();
 
     // Increases or decreases the interval.  The next ring of the timer will always be
@@ -79,6 +87,7 @@ private:
     ticks_t expected_next_ticks;
     timer_token_t *timer;
     std::function<void()> ringee;
+    coro_stack_class_t stack_class;
 
     DISABLE_COPYING(repeating_timer_t);
 };
@@ -105,6 +105,36 @@ enum class file_direct_io_mode_t {
     buffered_desired
 };
 
+// Which disk manager actually sends IO requests to the kernel.  `io_uring` falls
+// back to `pool` if the running kernel doesn't support it.
+enum class file_io_backend_t {
+    pool,
+    io_uring
+};
+
+// How `linux_tcp_conn_t` and the TCP listeners talk to the kernel.  With
+// `io_uring`, socket reads, writes and accepts go through a per-thread io_uring
+// instead of `read`/`write`/`accept` calls driven by epoll readiness.  Falls back
+// to `epoll` if the running kernel doesn't support it.
+enum class network_io_backend_t {
+    epoll,
+    io_uring
+};
+
+// The latency class of a disk account.  Operations in each class jump ahead of
+// operations in lower classes, and any class whose oldest operation has waited
+// longer than the class's latency target gets served first (see
+// `accounting_diskmgr_t`).  Within a class, the disk is shared between the
+// accounts in proportion to their priorities.
+enum class file_io_class_t {
+    // Reads that a user is waiting for, such as cache misses.
+    interactive,
+    // Writes that flush data to disk.
+    normal,
+    // Garbage collection, backfilling and other maintenance work.
+    background
+};
+
 enum class datasync_op { no_datasyncs, wrap_in_datasyncs, datasync_after };
 
 // A linux file.  It expects reads and writes and buffers to have an
@@ -126,8 +156,13 @@ public:
     // writev_async doesn't provide the atomicity guarantees of writev.
     virtual void writev_async(int64_t offset, size_t length, scoped_array_t<iovec> &&bufs,
                               file_account_t *account, linux_iocallback_t *cb) = 0;
+    // Frees the disk space of the given range, which reads as zeros afterwards.  Calls
+    // `cb->on_io_failure()` if the file system doesn't support that.
+    virtual void punch_hole_async(int64_t offset, size_t length,
+                                  file_account_t *account, linux_iocallback_t *cb) = 0;
 
-    virtual void *create_account(int priority, int outstanding_requests_limit) = 0;
+    virtual void *create_account(int priority, int outstanding_requests_limit,
+                                 file_io_class_t io_class) = 0;
     virtual void destroy_account(void *account) = 0;
 
     virtual bool coop_lock_and_check() = 0;
@@ -138,7 +173,9 @@ private:
 
 class file_account_t {
 public:
-    file_account_t(file_t *f, int p, int outstanding_requests_limit = UNLIMITED_OUTSTANDING_REQUESTS);
+    file_account_t(file_t *f, int p,
+                   int outstanding_requests_limit = UNLIMITED_OUTSTANDING_REQUESTS,
+                   file_io_class_t io_class = file_io_class_t::normal);
     ~file_account_t();
     void *get_account() { return account; }
 
@@ -163,7 +163,9 @@ continue_bool_t btree_depth_first_traversal(
     if (skip) {
         return continue_bool_t::CONTINUE;
     }
-    block->read.init(new buf_read_t(&block->lock));
+    // A traversal reads each node of the range once, so it shouldn't make the
+    // evicter keep the nodes around.
+    block->read.init(new buf_read_t(&block->lock, page_access_hint_t::use_once));
     const node_t *node = static_cast<const node_t *>(block->read->get_data_read());
     if (node::is_internal(node)) {
         if (continue_bool_t::ABORT == cb->handle_pre_internal(
@@ -816,8 +816,8 @@ page_t *buf_lock_t::get_held_page_for_write() {
     return current_page_acq_->current_page_for_write(txn()->account());
 }
 
-buf_read_t::buf_read_t(buf_lock_t *lock)
-    : lock_(lock) {
+buf_read_t::buf_read_t(buf_lock_t *lock, page_access_hint_t hint)
+    : lock_(lock), hint_(hint) {
     guarantee(!lock_->empty());
     lock_->access_ref_count_++;
 }
@@ -831,7 +831,7 @@ const void *buf_read_t::get_data_read(uint16_t *block_size_out) {
     page_t *page = lock_->get_held_page_for_read();
     if (!page_acq_.has()) {
         page_acq_.init(page, &lock_->cache()->page_cache_,
-                       lock_->txn()->account());
+                       lock_->txn()->account(), hint_);
     }
     page_acq_.buf_ready_signal()->wait();
     *block_size_out = page_acq_.get_buf_size().value();
@@ -853,7 +853,7 @@ void *buf_write_t::get_data_write(uint16_t block_size) {
     page_t *page = lock_->get_held_page_for_write();
     if (!page_acq_.has()) {
         page_acq_.init(page, &lock_->cache()->page_cache_,
-                       lock_->txn()->account());
+                       lock_->txn()->account(), page_access_hint_t::normal);
     }
     page_acq_.buf_ready_signal()->wait();
     return page_acq_.get_buf_write(block_size_t::make_from_cache(block_size));
@@ -327,7 +327,8 @@ private:
 
 class buf_read_t {
 public:
-    explicit buf_read_t(buf_lock_t *lock);
+    explicit buf_read_t(buf_lock_t *lock,
+                        page_access_hint_t hint = page_access_hint_t::normal);
     ~buf_read_t();
 
     const void *get_data_read(uint16_t *block_size_out);
@@ -340,6 +341,7 @@ public:
 
 private:
     buf_lock_t *lock_;
+    const page_access_hint_t hint_;
     alt::page_acq_t page_acq_;
 
     DISABLE_COPYING(buf_read_t);
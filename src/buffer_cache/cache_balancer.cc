@@ -2,15 +2,21 @@
 
 #include <algorithm>
 #include <limits>
+#include <queue>
 
 #include "buffer_cache/evicter.hpp"
 #include "arch/runtime/runtime.hpp"
+#include "config/args.hpp"
 #include "concurrency/pmap.hpp"
 
 const uint64_t alt_cache_balancer_t::rebalance_check_interval_ms = 20;
 const uint64_t alt_cache_balancer_t::rebalance_access_count_threshold = 100;
 const int64_t alt_cache_balancer_t::rebalance_timeout_ms = 500;
 
+const double alt_cache_balancer_t::miss_ratio_curve_min_accesses = 1000;
+const uint64_t alt_cache_balancer_t::miss_ratio_curve_allocation_steps = 512;
+const uint64_t alt_cache_balancer_t::miss_ratio_curve_min_step = 64 * KILOBYTE;
+
 const double alt_cache_balancer_t::read_ahead_proportion = 0.9;
 
 alt_cache_balancer_t::cache_data_t::cache_data_t(alt::evicter_t *_evicter) :
@@ -21,12 +27,27 @@ alt_cache_balancer_t::cache_data_t::cache_data_t(alt::evicter_t *_evicter) :
     evictable_disk_backed_size(evicter->evictable_disk_backed_size()),
     evictable_unbacked_size(evicter->evictable_unbacked_size()),
     bytes_loaded(evicter->get_bytes_loaded()),
-    access_count(evicter->access_count()) { }
+    access_count(evicter->access_count()),
+    curve_accesses(evicter->miss_ratio_curve().accesses()),
+    curve_hits(evicter->miss_ratio_curve().hits_at_cache_sizes()),
+    curve_target_size(0) { }
+
+alt_cache_balancer_t::cache_data_t::cache_data_t() :
+    evicter(nullptr),
+    new_size(0),
+    old_size(0),
+    unevictable_size(0),
+    evictable_disk_backed_size(0),
+    evictable_unbacked_size(0),
+    bytes_loaded(0),
+    access_count(0),
+    curve_accesses(0),
+    curve_target_size(0) { }
 
 alt_cache_balancer_t::alt_cache_balancer_t(
         clone_ptr_t<watchable_t<uint64_t> > _total_cache_size_watchable) :
     total_cache_size_watchable(_total_cache_size_watchable),
-    rebalance_timer(make_scoped<repeating_timer_t>(rebalance_check_interval_ms, this)),
+    rebalance_timer(make_rebalance_timer()),
     rebalance_timer_state(rebalance_timer_state_t::normal),
     last_rebalance_time{0},
     read_ahead_ok(true),
@@ -44,6 +65,13 @@ alt_cache_balancer_t::alt_cache_balancer_t(
     cache_size_change_subscription.reset(total_cache_size_watchable, &freeze);
 }
 
+scoped_ptr_t<repeating_timer_t> alt_cache_balancer_t::make_rebalance_timer() {
+    // `on_ring()` only notifies `rebalance_pumper`, which runs the rebalance in a
+    // coroutine of its own, so the ringer can use a small stack.
+    return make_scoped<repeating_timer_t>(
+        rebalance_check_interval_ms, this, coro_stack_class_t::small);
+}
+
 alt_cache_balancer_t::~alt_cache_balancer_t() {
     assert_thread();
 }
@@ -65,7 +93,7 @@ void alt_cache_balancer_t::wake_up_activity_happened() {
         break;
     case rebalance_timer_state_t::deactivated:
         rebalance_timer_state = rebalance_timer_state_t::normal;
-        rebalance_timer = make_scoped<repeating_timer_t>(rebalance_check_interval_ms, this);
+        rebalance_timer = make_rebalance_timer();
         break;
     default:
         unreachable();
@@ -156,19 +184,31 @@ void alt_cache_balancer_t::rebalance_blocking(UNUSED signal_t *interruptor) {
 
         uint64_t total_unmaxed_evicters = 0;
 
+        // Without good enough miss ratio curves, we give each cache memory in
+        // proportion to how much it has been loading.
+        const bool use_miss_ratio_curves = total_cache_size > 0
+            && size_from_miss_ratio_curves(total_cache_size, &cache_data);
+
         for (size_t i = 0; i < cache_data.size(); ++i) {
             for (size_t j = 0; j < cache_data[i].size(); ++j) {
                 cache_data_t *data = &cache_data[i][j];
 
                 if (total_cache_size > 0) {
-                    double temp = data->old_size;
-                    temp /= static_cast<double>(total_cache_size);
-                    temp *= static_cast<double>(total_bytes_loaded);
-
-                    int64_t new_size = std::max<int64_t>(0, data->bytes_loaded);
-                    new_size -= static_cast<int64_t>(temp);
-                    new_size += data->old_size;
-                    new_size = std::max<int64_t>(new_size, 0);
+                    int64_t new_size;
+                    if (use_miss_ratio_curves) {
+                        // Only go halfway, so that the noise in the curves doesn't
+                        // make the sizes swing back and forth.
+                        new_size = (data->old_size + data->curve_target_size) / 2;
+                    } else {
+                        double temp = data->old_size;
+                        temp /= static_cast<double>(total_cache_size);
+                        temp *= static_cast<double>(total_bytes_loaded);
+
+                        new_size = std::max<int64_t>(0, data->bytes_loaded);
+                        new_size -= static_cast<int64_t>(temp);
+                        new_size += data->old_size;
+                        new_size = std::max<int64_t>(new_size, 0);
+                    }
 
                     int64_t existing_unevictable
                         = data->unevictable_size + data->evictable_unbacked_size;
@@ -257,9 +297,94 @@ void alt_cache_balancer_t::rebalance_blocking(UNUSED signal_t *interruptor) {
     } else {
         rebalance_timer_state = rebalance_timer_state_t::normal;
         if (!rebalance_timer.has()) {
-            rebalance_timer = make_scoped<repeating_timer_t>(rebalance_check_interval_ms, this);
+            rebalance_timer = make_rebalance_timer();
+        }
+    }
+}
+
+bool alt_cache_balancer_t::size_from_miss_ratio_curves(
+        uint64_t total_cache_size,
+        scoped_array_t<std::vector<cache_data_t> > *cache_data) {
+    std::vector<cache_data_t *> caches;
+    uint64_t total_access_count = 0;
+    for (size_t i = 0; i < cache_data->size(); ++i) {
+        for (cache_data_t &data : (*cache_data)[i]) {
+            if (data.access_count > 0
+                && data.curve_accesses < miss_ratio_curve_min_accesses) {
+                return false;
+            }
+            caches.push_back(&data);
+            total_access_count += data.access_count;
+        }
+    }
+    if (total_access_count == 0) {
+        return false;
+    }
+
+    // The curves count the recent accesses of each cache, however long ago they
+    // were, so we scale them to the accesses since the last rebalance to compare
+    // the caches.
+    auto hits = [](const cache_data_t *data, uint64_t size) {
+        return alt::miss_ratio_curve_t::hits_for_cache_size(data->curve_hits, size)
+            / data->curve_accesses * static_cast<double>(data->access_count);
+    };
+
+    int64_t unallocated = total_cache_size;
+    for (cache_data_t *data : caches) {
+        data->curve_target_size = data->unevictable_size + data->evictable_unbacked_size;
+        unallocated -= data->curve_target_size;
+    }
+
+    const uint64_t step = std::max(total_cache_size / miss_ratio_curve_allocation_steps,
+                                   miss_ratio_curve_min_step);
+
+    // The hits per byte that a cache would gain from its next allocation, and the
+    // size of that allocation.  We look a few steps ahead, because a curve can be
+    // flat for a while before a working set fits.
+    struct candidate_t {
+        double gain;
+        uint64_t bytes;
+        size_t index;
+        bool operator<(const candidate_t &other) const {
+            return gain < other.gain;
+        }
+    };
+    auto best_candidate = [&](size_t index) {
+        const cache_data_t *data = caches[index];
+        candidate_t candidate{0, 0, index};
+        if (data->access_count == 0) {
+            return candidate;
+        }
+        const double hits_now = hits(data, data->curve_target_size);
+        for (uint64_t bytes = step; bytes <= 64 * step; bytes *= 2) {
+            const double gain = (hits(data, data->curve_target_size + bytes) - hits_now)
+                / static_cast<double>(bytes);
+            if (gain > candidate.gain) {
+                candidate.gain = gain;
+                candidate.bytes = bytes;
+            }
+        }
+        return candidate;
+    };
+
+    std::priority_queue<candidate_t> candidates;
+    for (size_t i = 0; i < caches.size(); ++i) {
+        candidates.push(best_candidate(i));
+    }
+    while (unallocated > 0 && !candidates.empty()) {
+        candidate_t candidate = candidates.top();
+        candidates.pop();
+        if (candidate.gain <= 0) {
+            // More memory wouldn't get any cache more hits.  What's left gets spread
+            // evenly by the caller.
+            break;
         }
+        const uint64_t bytes = std::min<uint64_t>(candidate.bytes, unallocated);
+        caches[candidate.index]->curve_target_size += bytes;
+        unallocated -= bytes;
+        candidates.push(best_candidate(candidate.index));
     }
+    return true;
 }
 
 void alt_cache_balancer_t::collect_stats_from_thread(
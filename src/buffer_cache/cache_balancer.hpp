@@ -18,6 +18,10 @@ namespace alt {
 class evicter_t;
 }
 
+namespace unittest {
+void run_MissRatioCurveTest_BalancerFollowsCurves();
+}
+
 // Base class so we can have a dummy implementation for tests
 class cache_balancer_t : public home_thread_mixin_t {
 public:
@@ -107,6 +111,7 @@ public:
 
 private:
     friend class alt::evicter_t;
+    friend void unittest::run_MissRatioCurveTest_BalancerFollowsCurves();
 
     // Constants to control how often we rebalance
     static const uint64_t rebalance_access_count_threshold;
@@ -116,6 +121,12 @@ private:
     // Controls how much read ahead is allowed out of total cache size
     static const double read_ahead_proportion;
 
+    // Constants to control the sizing by miss ratio curves, see
+    // `size_from_miss_ratio_curves()`
+    static const double miss_ratio_curve_min_accesses;
+    static const uint64_t miss_ratio_curve_allocation_steps;
+    static const uint64_t miss_ratio_curve_min_step;
+
     // Constants to determine when to stop read-ahead
     static const uint64_t read_ahead_ratio_numerator;
     static const uint64_t read_ahead_ratio_denominator;
@@ -129,6 +140,7 @@ private:
 
     // Callback for repeating timer
     void on_ring();
+    scoped_ptr_t<repeating_timer_t> make_rebalance_timer();
 
     // Callback that handles rebalancing in a coroutine. Called by `rebalance_pumper`.
     void rebalance_blocking(UNUSED signal_t *interruptor);
@@ -136,6 +148,8 @@ private:
     // Used when calculating new cache sizes
     struct cache_data_t {
         explicit cache_data_t(alt::evicter_t *_evicter);
+        // For the tests, which fill in the fields themselves.
+        cache_data_t();
 
         alt::evicter_t *evicter;
 
@@ -149,8 +163,26 @@ private:
 
         int64_t bytes_loaded;
         uint64_t access_count;
+
+        // The evicter's miss ratio curve, see `alt::miss_ratio_curve_t`
+        double curve_accesses;
+        std::vector<double> curve_hits;
+
+        // The size that `size_from_miss_ratio_curves()` would give the cache
+        uint64_t curve_target_size;
     };
 
+    // Splits the total cache size between the caches so that they get the most hits
+    // in total, going by their miss ratio curves: each cache gets the memory it
+    // can't evict, then we keep giving a bit of memory to the cache whose hits would
+    // grow the most for it.  The curves assume LRU eviction, while the evicters use a
+    // segmented LRU, see `alt::miss_ratio_curve_t`.  The result goes into each
+    // `curve_target_size`.  Returns false, and leaves them alone, if a cache with
+    // accesses doesn't have enough of them in its curve yet to go by.
+    static bool size_from_miss_ratio_curves(
+        uint64_t total_cache_size,
+        scoped_array_t<std::vector<cache_data_t> > *cache_data);
+
     // Helper function to collect stats from each thread so we don't need
     //  atomic variables slowing down normal operations
     void collect_stats_from_thread(int index,
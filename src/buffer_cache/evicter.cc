@@ -18,6 +18,10 @@ evicter_t::evicter_t()
       access_count_counter_(0),
       access_time_counter_(INITIAL_ACCESS_TIME),
       evict_if_necessary_active_(false),
+      protected_hits_(0),
+      probationary_hits_(0),
+      misses_(0),
+      accesses_since_halving_(0),
       last_force_flush_time_(ticks_t{0}) { }
 
 evicter_t::~evicter_t() {
@@ -127,7 +131,9 @@ void evicter_t::add_to_evictable_unbacked(page_t *page) {
 
 void evicter_t::add_to_evictable_disk_backed(page_t *page) {
     guarantee_initialized();
-    evictable_disk_backed_.add(page, page->hypothetical_memory_usage(page_cache_));
+    eviction_bag_t *bag = correct_eviction_category(page);
+    rassert(bag == &evictable_probationary_ || bag == &evictable_protected_);
+    bag->add(page, page->hypothetical_memory_usage(page_cache_));
     evict_if_necessary();
     notify_bytes_loading(page->hypothetical_memory_usage(page_cache_));
 }
@@ -137,7 +143,8 @@ void evicter_t::move_unevictable_to_evictable(page_t *page) {
     rassert(unevictable_.has_page(page));
     unevictable_.remove(page, page->hypothetical_memory_usage(page_cache_));
     eviction_bag_t *new_bag = correct_eviction_category(page);
-    rassert(new_bag == &evictable_disk_backed_
+    rassert(new_bag == &evictable_probationary_
+            || new_bag == &evictable_protected_
             || new_bag == &evictable_unbacked_);
     new_bag->add(page, page->hypothetical_memory_usage(page_cache_));
     evict_if_necessary();
@@ -160,12 +167,41 @@ eviction_bag_t *evicter_t::correct_eviction_category(page_t *page) {
     } else if (!page->is_loaded()) {
         return &evicted_;
     } else if (page->is_disk_backed()) {
-        return &evictable_disk_backed_;
+        return page->is_protected() ? &evictable_protected_ : &evictable_probationary_;
     } else {
         return &evictable_unbacked_;
     }
 }
 
+void evicter_t::record_access(page_t *page, page_access_hint_t hint) {
+    guarantee_initialized();
+    if (!page->is_loaded()) {
+        ++misses_;
+    } else if (page->is_protected()) {
+        ++protected_hits_;
+    } else {
+        ++probationary_hits_;
+        // If the page already has waiters, this is probably the same operation
+        // acquiring it again rather than a second use.
+        if (hint == page_access_hint_t::normal && !page->has_waiters()) {
+            page->set_protected(true);
+        }
+    }
+
+    if (hint == page_access_hint_t::normal) {
+        miss_ratio_curve_.record_access(page->block_id(),
+                                        page->hypothetical_memory_usage(page_cache_));
+    }
+
+    ++accesses_since_halving_;
+    if (accesses_since_halving_ >= HIT_RATE_HALVING_INTERVAL) {
+        accesses_since_halving_ = 0;
+        protected_hits_ /= 2;
+        probationary_hits_ /= 2;
+        misses_ /= 2;
+    }
+}
+
 void evicter_t::remove_page(page_t *page) {
     guarantee_initialized();
     eviction_bag_t *bag = correct_eviction_category(page);
@@ -176,7 +212,8 @@ void evicter_t::remove_page(page_t *page) {
 uint64_t evicter_t::in_memory_size() const {
     guarantee_initialized();
     return unevictable_.size()
-        + evictable_disk_backed_.size()
+        + evictable_probationary_.size()
+        + evictable_protected_.size()
         + evictable_unbacked_.size();
 }
 
@@ -196,11 +233,29 @@ void evicter_t::evict_if_necessary() THROWS_NOTHING {
 
     evict_if_necessary_active_ = true;
     page_t *page;
-    while (in_memory_size() > memory_limit_
+
+    // Demote pages until the protected segment is within its share.
+    const uint64_t protected_limit = memory_limit_ / 100 * PROTECTED_SEGMENT_PERCENT;
+    while (evictable_protected_.size() > protected_limit
            && eviction_bag_t::select_oldish(
-                &evictable_disk_backed_, access_time_counter_, &page)) {
+                &evictable_protected_, access_time_counter_, &page)) {
+        uint32_t mem_usage = page->hypothetical_memory_usage(page_cache_);
+        evictable_protected_.remove(page, mem_usage);
+        page->set_protected(false);
+        evictable_probationary_.add(page, mem_usage);
+    }
+
+    // We only evict protected pages if there are no probationary ones left, for
+    // example because most of the memory is unevictable.
+    while (in_memory_size() > memory_limit_
+           && (eviction_bag_t::select_oldish(
+                   &evictable_probationary_, access_time_counter_, &page)
+               || eviction_bag_t::select_oldish(
+                   &evictable_protected_, access_time_counter_, &page))) {
         uint32_t mem_usage = page->hypothetical_memory_usage(page_cache_);
-        evictable_disk_backed_.remove(page, mem_usage);
+        correct_eviction_category(page)->remove(page, mem_usage);
+        // When the page gets loaded again, it has to earn its promotion again.
+        page->set_protected(false);
         evicted_.add(page, mem_usage);
         page->evict_self(page_cache_);
         page_cache_->consider_evicting_current_page(page->block_id());
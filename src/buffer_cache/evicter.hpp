@@ -6,6 +6,8 @@
 #include <functional>
 
 #include "buffer_cache/eviction_bag.hpp"
+#include "buffer_cache/miss_ratio_curve.hpp"
+#include "buffer_cache/types.hpp"
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/cache_line_padded.hpp"
 #include "concurrency/pubsub.hpp"
@@ -19,6 +21,13 @@ namespace alt {
 
 class page_cache_t;
 
+// The evictable disk backed pages are split into two segments, like in a segmented
+// LRU.  Pages start out in the probationary segment and get promoted to the
+// protected segment when they're accessed again while they're still loaded (unless
+// the access is `page_access_hint_t::use_once`).  We evict from the probationary
+// segment first, and the protected segment demotes its oldish pages when it's over
+// its share of the memory limit.  So a large scan only cycles pages through the
+// probationary segment, and the pages that are used again and again stay.
 class evicter_t : public home_thread_mixin_debug_only_t {
 public:
     void add_not_yet_loaded(page_t *page);
@@ -34,6 +43,10 @@ public:
     eviction_bag_t *evicted_category() { return &evicted_; }
     void remove_page(page_t *page);
     void reloading_page(page_t *page);
+    // Counts a hit or a miss, and promotes the page if it's a hit that warrants it.
+    // Also feeds the miss ratio curve.  Must be called before the page gets the
+    // waiter for the access.
+    void record_access(page_t *page, page_access_hint_t hint);
 
     // Evicter will be unusable until initialize is called
     evicter_t();
@@ -66,7 +79,15 @@ public:
     }
     uint64_t evictable_disk_backed_size() const {
         guarantee_initialized();
-        return evictable_disk_backed_.size();
+        return evictable_probationary_.size() + evictable_protected_.size();
+    }
+    uint64_t evictable_probationary_size() const {
+        guarantee_initialized();
+        return evictable_probationary_.size();
+    }
+    uint64_t evictable_protected_size() const {
+        guarantee_initialized();
+        return evictable_protected_.size();
     }
     uint64_t evictable_unbacked_size() const {
         guarantee_initialized();
@@ -81,10 +102,40 @@ public:
 
     uint64_t in_memory_size() const;
 
+    // The recent page accesses that found the page in the protected segment, in the
+    // probationary segment, or not loaded.  See HIT_RATE_HALVING_INTERVAL.
+    uint64_t protected_hits() const {
+        guarantee_initialized();
+        return protected_hits_;
+    }
+    uint64_t probationary_hits() const {
+        guarantee_initialized();
+        return probationary_hits_;
+    }
+    uint64_t misses() const {
+        guarantee_initialized();
+        return misses_;
+    }
+
+    // How the hits would change with the memory limit.  The balancer uses it to give
+    // the memory to the caches that would make the best use of it.
+    const miss_ratio_curve_t &miss_ratio_curve() const {
+        guarantee_initialized();
+        return miss_ratio_curve_;
+    }
+
     // This is decremented past UINT64_MAX to force code to be aware of access time
     // rollovers.
     static const uint64_t INITIAL_ACCESS_TIME = UINT64_MAX - 100;
 
+    // The share of the memory limit that the protected segment can take up.
+    static const uint64_t PROTECTED_SEGMENT_PERCENT = 75;
+
+    // The access counts are halved whenever there have been this many accesses
+    // since the last time, so that the hit rates they give follow the recent
+    // accesses.
+    static const uint64_t HIT_RATE_HALVING_INTERVAL = 10000;
+
 private:
     void guarantee_initialized() const {
         assert_thread();
@@ -121,9 +172,21 @@ private:
     // It avoids reentrant calls to that function.
     bool evict_if_necessary_active_;
 
-    // These track every page's eviction status.
+    // Decayed counts of the page accesses, by where they found the page.
+    uint64_t protected_hits_;
+    uint64_t probationary_hits_;
+    uint64_t misses_;
+    uint64_t accesses_since_halving_;
+
+    // Only sees the `page_access_hint_t::normal` accesses, because a scan wouldn't
+    // get more hits from a bigger cache.
+    miss_ratio_curve_t miss_ratio_curve_;
+
+    // These track every page's eviction status.  The evictable disk backed pages are
+    // split into the two segments.
     eviction_bag_t unevictable_;
-    eviction_bag_t evictable_disk_backed_;
+    eviction_bag_t evictable_probationary_;
+    eviction_bag_t evictable_protected_;
     eviction_bag_t evictable_unbacked_;
     eviction_bag_t evicted_;
 
@@ -0,0 +1,167 @@
+#include "buffer_cache/miss_ratio_curve.hpp"
+
+#include <math.h>
+
+#include <algorithm>
+
+#include "config/args.hpp"
+
+namespace alt {
+
+// The sampling rate we start with.
+static const int INITIAL_SAMPLING_SHIFT = 5;
+
+// The most sampled blocks we keep in the LRU stack.  Finding a block in the stack
+// costs up to this much, but only for the sampled accesses.
+static const size_t MAX_STACK_SIZE = 1024;
+
+// The smallest cache size of the grid.
+static const uint64_t SMALLEST_CACHE_SIZE = 256 * KILOBYTE;
+
+// A block ages out of the stack if it hasn't been accessed since this many halvings
+// of the counts, and its next access counts as a miss.  Two halvings are at least
+// 2000 sampled accesses (see `HALVING_INTERVAL`), more than the 1024 blocks that the
+// stack holds, so a loop that fits into the stack comes back to each of its blocks
+// before they age out.
+static const uint64_t STALE_BLOCK_HALVINGS = 2;
+
+miss_ratio_curve_t::miss_ratio_curve_t()
+    : stack_bytes_(0),
+      sampling_shift_(INITIAL_SAMPLING_SHIFT),
+      accesses_(0),
+      sampled_accesses_since_halving_(0),
+      halvings_(0) {
+    std::fill(distance_counts_, distance_counts_ + NUM_CACHE_SIZES, 0.0);
+}
+
+uint64_t miss_ratio_curve_t::cache_size_at(size_t index) {
+    rassert(index < NUM_CACHE_SIZES);
+    const uint64_t size = SMALLEST_CACHE_SIZE << (index / 2);
+    return index % 2 == 0 ? size : static_cast<uint64_t>(size * M_SQRT2);
+}
+
+bool miss_ratio_curve_t::is_sampled(block_id_t block_id) const {
+    // Fibonacci hashing, so that the sample is spread over the block ids.
+    const uint64_t hash = block_id * 0x9E3779B97F4A7C15ull;
+    return (hash >> (64 - sampling_shift_)) == 0;
+}
+
+void miss_ratio_curve_t::record_access(block_id_t block_id, uint32_t size) {
+    if (!is_sampled(block_id)) {
+        return;
+    }
+    const double weight = static_cast<double>(uint64_t(1) << sampling_shift_);
+
+    // Look for the block from the most recently accessed end, adding up the sizes
+    // of the blocks that were accessed after it.
+    uint64_t distance = 0;
+    bool found = false;
+    for (size_t i = stack_.size(); i-- > 0;) {
+        if (stack_[i].block_id == block_id) {
+            distance += size;
+            stack_bytes_ -= stack_[i].size;
+            stack_.erase(stack_.begin() + i);
+            found = true;
+            break;
+        }
+        distance += stack_[i].size;
+    }
+    stack_.push_back(sampled_block_t{block_id, size, halvings_});
+    stack_bytes_ += size;
+
+    accesses_ += weight;
+    if (found) {
+        // Only a 1 / weight share of the blocks that were accessed in between are
+        // sampled.
+        const uint64_t scaled_distance = distance << sampling_shift_;
+        for (size_t i = 0; i < NUM_CACHE_SIZES; ++i) {
+            if (scaled_distance <= cache_size_at(i)) {
+                distance_counts_[i] += weight;
+                break;
+            }
+        }
+        // Longer distances are misses for every cache size of the grid.
+    }
+
+    drop_stale_blocks();
+    if (stack_.size() > MAX_STACK_SIZE) {
+        // Halve the sampling rate, and forget the blocks that aren't sampled anymore.
+        ++sampling_shift_;
+        stack_.erase(
+            std::remove_if(stack_.begin(), stack_.end(),
+                [this](const sampled_block_t &b) { return !is_sampled(b.block_id); }),
+            stack_.end());
+        stack_bytes_ = 0;
+        for (const sampled_block_t &b : stack_) {
+            stack_bytes_ += b.size;
+        }
+    }
+
+    ++sampled_accesses_since_halving_;
+    if (sampled_accesses_since_halving_ >= HALVING_INTERVAL) {
+        sampled_accesses_since_halving_ = 0;
+        ++halvings_;
+        for (size_t i = 0; i < NUM_CACHE_SIZES; ++i) {
+            distance_counts_[i] /= 2;
+        }
+        accesses_ /= 2;
+
+        drop_stale_blocks();
+        if (stack_.size() < MAX_STACK_SIZE / 4
+            && sampling_shift_ > INITIAL_SAMPLING_SHIFT) {
+            // Double the sampling rate again.  The blocks that this starts sampling
+            // aren't in the stack yet, so the distances come out a bit short until
+            // they are.
+            --sampling_shift_;
+        }
+    }
+}
+
+void miss_ratio_curve_t::drop_stale_blocks() {
+    // The next access to the least recently accessed block has a reuse distance of
+    // at least `stack_bytes_`, before scaling.
+    const uint64_t max_distance =
+        cache_size_at(NUM_CACHE_SIZES - 1) >> sampling_shift_;
+    size_t num_stale = 0;
+    while (num_stale < stack_.size()
+           && (stack_bytes_ > max_distance
+               || stack_[num_stale].halving + STALE_BLOCK_HALVINGS < halvings_)) {
+        stack_bytes_ -= stack_[num_stale].size;
+        ++num_stale;
+    }
+    // The stack is in the order of the accesses, so the stale blocks are all at its
+    // start.
+    stack_.erase(stack_.begin(), stack_.begin() + num_stale);
+}
+
+std::vector<double> miss_ratio_curve_t::hits_at_cache_sizes() const {
+    std::vector<double> hits(NUM_CACHE_SIZES);
+    double total = 0;
+    for (size_t i = 0; i < NUM_CACHE_SIZES; ++i) {
+        total += distance_counts_[i];
+        hits[i] = total;
+    }
+    return hits;
+}
+
+double miss_ratio_curve_t::hits_for_cache_size(
+        const std::vector<double> &hits_at_cache_sizes, uint64_t cache_size) {
+    rassert(hits_at_cache_sizes.size() == NUM_CACHE_SIZES);
+    // Interpolate linearly between the grid points, and between no hits at a size of
+    // zero and the first point.
+    uint64_t lower_size = 0;
+    double lower_hits = 0;
+    for (size_t i = 0; i < NUM_CACHE_SIZES; ++i) {
+        const uint64_t upper_size = cache_size_at(i);
+        if (cache_size <= upper_size) {
+            const double fraction = static_cast<double>(cache_size - lower_size)
+                / static_cast<double>(upper_size - lower_size);
+            return lower_hits + fraction * (hits_at_cache_sizes[i] - lower_hits);
+        }
+        lower_size = upper_size;
+        lower_hits = hits_at_cache_sizes[i];
+    }
+    return lower_hits;
+}
+
+}  // namespace alt
@@ -0,0 +1,101 @@
+#ifndef BUFFER_CACHE_MISS_RATIO_CURVE_HPP_
+#define BUFFER_CACHE_MISS_RATIO_CURVE_HPP_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "errors.hpp"
+#include "serializer/types.hpp"
+
+namespace unittest {
+void run_MissRatioCurveTest_AgesOutStaleBlocks();
+}
+
+namespace alt {
+
+// Estimates the miss ratio curve of a cache: how many of its recent page accesses
+// would have been hits if the cache had been of a given size, assuming LRU eviction.
+// It follows the approach of SHARDS: we only look at the accesses to a sample of the
+// blocks, picked by a hash of the block id, and measure the reuse distance of each
+// access (the bytes of the distinct sampled blocks that were accessed since the
+// previous access to the same block) in a small LRU stack.  The distances are scaled
+// up by the inverse of the sampling rate.  When the stack gets too big, we halve the
+// sampling rate, so the memory use is bounded however large the working set is.
+// Blocks that haven't been accessed for a while age out of the stack, and once it has
+// shrunk the sampling rate goes back up, so that a working set that used to be large
+// doesn't leave the curve with a coarse sample for good.
+//
+// The curve is kept for a fixed grid of cache sizes, see `cache_size_at()`.
+//
+// The evicter doesn't quite do LRU, it keeps the pages that were accessed twice in a
+// protected segment (see `evicter_t`).  That only does better than LRU, for example
+// with scans, so for a given size the curve can underestimate the hits.  It's good
+// enough for comparing caches with each other, which is all the balancer does.
+class miss_ratio_curve_t {
+public:
+    miss_ratio_curve_t();
+
+    // `size` is how much memory the block takes up in the cache.
+    void record_access(block_id_t block_id, uint32_t size);
+
+    // The number of points of the grid, and the cache size of each point.  The
+    // sizes grow by a factor of sqrt(2) from one point to the next.
+    static const size_t NUM_CACHE_SIZES = 41;
+    static uint64_t cache_size_at(size_t index);
+
+    // The estimated number of recent accesses.
+    double accesses() const { return accesses_; }
+
+    // The estimated number of recent accesses that would have been hits for a cache
+    // of `cache_size_at(index)` bytes, for each index.
+    std::vector<double> hits_at_cache_sizes() const;
+
+    // Interpolates `hits_at_cache_sizes` (as returned by `hits_at_cache_sizes()`)
+    // for any cache size.
+    static double hits_for_cache_size(const std::vector<double> &hits_at_cache_sizes,
+                                      uint64_t cache_size);
+
+    // The counts are halved whenever there have been this many sampled accesses
+    // since the last time, so that the curve follows the recent accesses.
+    static const uint64_t HALVING_INTERVAL = 1000;
+
+private:
+    friend void unittest::run_MissRatioCurveTest_AgesOutStaleBlocks();
+
+    struct sampled_block_t {
+        block_id_t block_id;
+        uint32_t size;
+        // The value of `halvings_` when the block was last accessed.
+        uint64_t halving;
+    };
+
+    bool is_sampled(block_id_t block_id) const;
+
+    // Drops the least recently accessed blocks that the next access to them would be
+    // a miss for anyway, or that haven't been accessed for a while.
+    void drop_stale_blocks();
+
+    // The sampled blocks, least recently accessed first.
+    std::vector<sampled_block_t> stack_;
+    // The sum of their sizes.
+    uint64_t stack_bytes_;
+
+    // We sample the blocks whose hash is below 2^(64 - sampling_shift_), that is
+    // 1 in 2^sampling_shift_ blocks.
+    int sampling_shift_;
+
+    // Weighted by the inverse of the sampling rate at the time of the access.
+    // `distance_counts_[i]` counts the accesses whose reuse distance was more than
+    // `cache_size_at(i - 1)` and at most `cache_size_at(i)`.
+    double distance_counts_[NUM_CACHE_SIZES];
+    double accesses_;
+    uint64_t sampled_accesses_since_halving_;
+    uint64_t halvings_;
+
+    DISABLE_COPYING(miss_ratio_curve_t);
+};
+
+}  // namespace alt
+
+#endif  // BUFFER_CACHE_MISS_RATIO_CURVE_HPP_
@@ -56,6 +56,7 @@ page_t::page_t(block_id_t _block_id, page_cache_t *page_cache)
     : block_id_(_block_id),
       loader_(nullptr),
       access_time_(page_cache->evicter().next_access_time()),
+      is_protected_(false),
       snapshot_refcount_(0) {
     page_cache->evicter().add_deferred_loaded(this);
 
@@ -70,6 +71,7 @@ page_t::page_t(block_id_t _block_id, page_cache_t *page_cache,
     : block_id_(_block_id),
       loader_(nullptr),
       access_time_(page_cache->evicter().next_access_time()),
+      is_protected_(false),
       snapshot_refcount_(0) {
     page_cache->evicter().add_not_yet_loaded(this);
 
@@ -86,6 +88,7 @@ page_t::page_t(block_id_t _block_id, buf_ptr_t buf,
       loader_(nullptr),
       buf_(std::move(buf)),
       access_time_(page_cache->evicter().next_access_time()),
+      is_protected_(false),
       snapshot_refcount_(0) {
     rassert(buf_.has());
     page_cache->evicter().add_to_evictable_unbacked(this);
@@ -100,6 +103,7 @@ page_t::page_t(block_id_t _block_id,
       buf_(std::move(buf)),
       block_token_(_block_token),
       access_time_(READ_AHEAD_ACCESS_TIME),
+      is_protected_(false),
       snapshot_refcount_(0) {
     rassert(buf_.has());
     page_cache->evicter().add_to_evictable_disk_backed(this);
@@ -109,6 +113,7 @@ page_t::page_t(page_t *copyee, page_cache_t *page_cache, cache_account_t *accoun
     : block_id_(copyee->block_id_),
       loader_(nullptr),
       access_time_(page_cache->evicter().next_access_time()),
+      is_protected_(false),
       snapshot_refcount_(0) {
     page_cache->evicter().add_not_yet_loaded(this);
     coro_t::spawn_now_dangerously(std::bind(&page_t::load_from_copyee,
@@ -145,8 +150,9 @@ void page_t::load_from_copyee(page_t *page, page_t *copyee,
 
     // Okay, it's safe to block.
     {
+        // Copying the page isn't a use of it that should promote it.
         page_acq_t acq;
-        acq.init(copyee, page_cache, account);
+        acq.init(copyee, page_cache, account, page_access_hint_t::use_once);
         acq.buf_ready_signal()->wait();
 
         ASSERT_FINITE_CORO_WAITING;
@@ -161,6 +167,8 @@ void page_t::load_from_copyee(page_t *page, page_t *copyee,
                 page->buf_ = buf_ptr_t::alloc_copy(copyee->buf_);
                 page->loader_ = nullptr;
             }
+            // The copy takes over from the copyee, so it keeps its segment.
+            page->is_protected_ = copyee->is_protected_;
 
             page->pulse_waiters_or_make_evictable(page_cache);
         }
@@ -410,9 +418,13 @@ void page_t::pulse_waiters_or_make_evictable(page_cache_t *page_cache) {
     }
 }
 
-void page_t::add_waiter(page_acq_t *acq, cache_account_t *account) {
+void page_t::add_waiter(page_acq_t *acq, cache_account_t *account,
+                        page_access_hint_t hint) {
     eviction_bag_t *old_bag
         = acq->page_cache()->evicter().correct_eviction_category(this);
+    // This can promote the page, which is fine because adding the waiter makes it
+    // unevictable anyway.
+    acq->page_cache()->evicter().record_access(this, hint);
     waiters_.push_front(acq);
     acq->page_cache()->evicter().change_to_correct_eviction_bag(old_bag, this);
     if (buf_.has()) {
@@ -591,13 +603,13 @@ page_acq_t::page_acq_t() : page_(nullptr), page_cache_(nullptr) {
 }
 
 void page_acq_t::init(page_t *page, page_cache_t *_page_cache,
-                      cache_account_t *account) {
+                      cache_account_t *account, page_access_hint_t hint) {
     rassert(page_ == nullptr);
     rassert(page_cache_ == nullptr);
     rassert(!buf_ready_signal_.is_pulsed());
     page_ = page;
     page_cache_ = _page_cache;
-    page_->add_waiter(this, account);
+    page_->add_waiter(this, account, hint);
 }
 
 page_acq_t::~page_acq_t() {
@@ -1,6 +1,7 @@
 #ifndef BUFFER_CACHE_PAGE_HPP_
 #define BUFFER_CACHE_PAGE_HPP_
 
+#include "buffer_cache/types.hpp"
 #include "concurrency/cond_var.hpp"
 #include "containers/backindex_bag.hpp"
 #include "containers/half_intrusive_list.hpp"
@@ -39,7 +40,8 @@ public:
 
     page_t *make_copy(page_cache_t *page_cache, cache_account_t *account);
 
-    void add_waiter(page_acq_t *acq, cache_account_t *account);
+    void add_waiter(page_acq_t *acq, cache_account_t *account,
+                    page_access_hint_t hint);
     void remove_waiter(page_acq_t *acq);
 
     // These may not be called until the page_acq_t's buf_ready_signal is pulsed.
@@ -66,6 +68,11 @@ public:
     bool is_loaded() const { return buf_.has(); }
     bool is_disk_backed() const { return block_token_.has(); }
 
+    // Whether the page is in the evicter's protected segment (if it's evictable and
+    // disk backed) or would be put there.  Managed by the evicter_t.
+    bool is_protected() const { return is_protected_; }
+    void set_protected(bool is_protected) { is_protected_ = is_protected; }
+
     void evict_self(page_cache_t *page_cache);
 
     block_id_t block_id() const { return block_id_; }
@@ -132,6 +139,9 @@ private:
 
     uint64_t access_time_;
 
+    // See is_protected().  Pages start out unprotected, in the probationary segment.
+    bool is_protected_;
+
     // How many page_ptr_t's point at this page, expecting nothing to modify it,
     // other than themselves.
     size_t snapshot_refcount_;
@@ -146,7 +156,8 @@ private:
     // if loader_ is non-null:  unevictable_
     // else if waiters_ is non-empty: unevictable_
     // else if buf_ is null: evicted_ (and block_token_ is non-null)
-    // else if block_token_ is non-null: evictable_disk_backed_
+    // else if block_token_ is non-null: evictable_protected_ if is_protected_,
+    //                                   evictable_probationary_ otherwise
     // else: evictable_unbacked_ (buf_ is non-null, block_token_ is null)
     //
     // So, when loader_, waiters_, buf_, or block_token_ is touched, we might
@@ -257,7 +268,8 @@ public:
     }
     void operator=(page_acq_t &&) = delete;
 
-    void init(page_t *page, page_cache_t *page_cache, cache_account_t *account);
+    void init(page_t *page, page_cache_t *page_cache, cache_account_t *account,
+              page_access_hint_t hint);
 
     page_t *page() const {
         rassert(page_ != nullptr);
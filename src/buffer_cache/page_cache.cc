@@ -264,7 +264,8 @@ page_cache_t::page_cache_t(serializer_t *_serializer,
             local_read_ahead_cb = new page_read_ahead_cb_t(_serializer, this);
         }
         default_reads_account_.init(_serializer->home_thread(),
-                                    _serializer->make_io_account(CACHE_READS_IO_PRIORITY));
+                                    _serializer->make_io_account(CACHE_READS_IO_PRIORITY,
+                                                                 file_io_class_t::interactive));
         index_write_sink_.init(new page_cache_index_write_sink_t);
         recencies_ = _serializer->get_all_recencies();
     }
@@ -453,13 +454,16 @@ cache_account_t page_cache_t::create_cache_account(int priority) {
     // either.
     int outstanding_requests_limit = std::max(1, 16 * priority / 100);
 
+    // Cache accounts are only used for background work like backfilling and
+    // secondary index post construction, so they shouldn't hold up cache misses.
     file_account_t *io_account;
     {
         // Ideally we shouldn't have to switch to the serializer thread.  But that's
         // what the file account API is right now, deep in the I/O layer.
         on_thread_t thread_switcher(serializer_->home_thread());
         io_account = serializer_->make_io_account(io_priority,
-                                                  outstanding_requests_limit);
+                                                  outstanding_requests_limit,
+                                                  file_io_class_t::background);
     }
 
     return cache_account_t(serializer_->home_thread(), io_account);
@@ -1552,9 +1556,10 @@ flush_prep_t page_cache_t::prep_flush_changes(
                         it->first);
                     prep.ancillary_infos.emplace_back(it->second.tstamp);
                     // The account doesn't matter because the page is already
-                    // loaded.
+                    // loaded.  Flushing the page isn't a use of it.
                     prep.ancillary_infos.back().page_acq.init(
-                        page, page_cache, page_cache->default_reads_account());
+                        page, page_cache, page_cache->default_reads_account(),
+                        page_access_hint_t::use_once);
                 }
             }
         } else {
@@ -2,34 +2,107 @@
 #include "buffer_cache/stats.hpp"
 
 #include "perfmon/perfmon.hpp"
+#include "rdb_protocol/datum.hpp"
 
 alt_cache_stats_t::alt_cache_stats_t(alt::page_cache_t *_page_cache,
                                      perfmon_collection_t *parent) :
     page_cache(_page_cache),
     cache_collection(),
     cache_membership(parent, &cache_collection, "cache"),
-    in_use_bytes(this),
-    in_use_bytes_membership(&cache_collection,
-                            &in_use_bytes, "in_use_bytes"),
+    in_use_bytes(this, [](const alt::evicter_t &evicter) {
+        return static_cast<double>(evicter.in_memory_size());
+    }),
+    protected_bytes(this, [](const alt::evicter_t &evicter) {
+        return static_cast<double>(evicter.evictable_protected_size());
+    }),
+    probationary_bytes(this, [](const alt::evicter_t &evicter) {
+        return static_cast<double>(evicter.evictable_probationary_size());
+    }),
+    protected_hits(this, [](const alt::evicter_t &evicter) {
+        return static_cast<double>(evicter.protected_hits());
+    }),
+    probationary_hits(this, [](const alt::evicter_t &evicter) {
+        return static_cast<double>(evicter.probationary_hits());
+    }),
+    misses(this, [](const alt::evicter_t &evicter) {
+        return static_cast<double>(evicter.misses());
+    }),
+    values_membership(&cache_collection,
+                      &in_use_bytes, "in_use_bytes",
+                      &protected_bytes, "protected_bytes",
+                      &probationary_bytes, "probationary_bytes",
+                      &protected_hits, "protected_hits",
+                      &probationary_hits, "probationary_hits",
+                      &misses, "misses"),
+    miss_ratio_curve(this),
+    miss_ratio_curve_membership(&cache_collection, &miss_ratio_curve,
+                                "miss_ratio_curve"),
     cache_collection_membership(&cache_collection) { }
 
-alt_cache_stats_t::perfmon_value_t::perfmon_value_t(alt_cache_stats_t *_parent) :
-    parent(_parent) { }
+alt_cache_stats_t::perfmon_value_t::perfmon_value_t(
+        alt_cache_stats_t *_parent,
+        std::function<double(const alt::evicter_t &)> _get_value) :
+    parent(_parent), get_value(std::move(_get_value)) { }
 
 void *alt_cache_stats_t::perfmon_value_t::begin_stats() {
-    return new uint64_t;
+    return new double(0);
 }
 
 void alt_cache_stats_t::perfmon_value_t::visit_stats(void *ptr) {
     if (get_thread_id() == parent->home_thread()) {
-        uint64_t *value = reinterpret_cast<uint64_t *>(ptr);
-        *value = parent->page_cache->evicter().in_memory_size();
+        double *value = reinterpret_cast<double *>(ptr);
+        *value = get_value(parent->page_cache->evicter());
     }
 }
 
 ql::datum_t alt_cache_stats_t::perfmon_value_t::end_stats(void *ptr) {
-    uint64_t *value = reinterpret_cast<uint64_t *>(ptr);
-    ql::datum_t res(static_cast<double>(*value));
+    double *value = reinterpret_cast<double *>(ptr);
+    ql::datum_t res(*value);
     delete value;
     return res;
 }
+
+struct miss_ratio_curve_stats_t {
+    miss_ratio_curve_stats_t() : memory_limit(0), accesses(0) { }
+    uint64_t memory_limit;
+    double accesses;
+    std::vector<double> hits;
+};
+
+alt_cache_stats_t::perfmon_miss_ratio_curve_t::perfmon_miss_ratio_curve_t(
+        alt_cache_stats_t *_parent) :
+    parent(_parent) { }
+
+void *alt_cache_stats_t::perfmon_miss_ratio_curve_t::begin_stats() {
+    return new miss_ratio_curve_stats_t();
+}
+
+void alt_cache_stats_t::perfmon_miss_ratio_curve_t::visit_stats(void *ptr) {
+    if (get_thread_id() == parent->home_thread()) {
+        miss_ratio_curve_stats_t *stats =
+            reinterpret_cast<miss_ratio_curve_stats_t *>(ptr);
+        const alt::evicter_t &evicter = parent->page_cache->evicter();
+        stats->memory_limit = evicter.memory_limit();
+        stats->accesses = evicter.miss_ratio_curve().accesses();
+        stats->hits = evicter.miss_ratio_curve().hits_at_cache_sizes();
+    }
+}
+
+ql::datum_t alt_cache_stats_t::perfmon_miss_ratio_curve_t::end_stats(void *ptr) {
+    miss_ratio_curve_stats_t *stats = reinterpret_cast<miss_ratio_curve_stats_t *>(ptr);
+    ql::datum_array_builder_t cache_sizes(ql::configured_limits_t::unlimited);
+    ql::datum_array_builder_t hits(ql::configured_limits_t::unlimited);
+    for (size_t i = 0; i < stats->hits.size(); ++i) {
+        cache_sizes.add(ql::datum_t(static_cast<double>(
+            alt::miss_ratio_curve_t::cache_size_at(i))));
+        hits.add(ql::datum_t(stats->hits[i]));
+    }
+    ql::datum_object_builder_t builder;
+    builder.overwrite("memory_limit",
+                      ql::datum_t(static_cast<double>(stats->memory_limit)));
+    builder.overwrite("accesses", ql::datum_t(stats->accesses));
+    builder.overwrite("cache_sizes", std::move(cache_sizes).to_datum());
+    builder.overwrite("hits", std::move(hits).to_datum());
+    delete stats;
+    return std::move(builder).to_datum();
+}
@@ -2,6 +2,8 @@
 #ifndef BUFFER_CACHE_STATS_HPP_
 #define BUFFER_CACHE_STATS_HPP_
 
+#include <functional>
+
 #include "perfmon/perfmon.hpp"
 #include "buffer_cache/page_cache.hpp"
 
@@ -15,18 +17,42 @@ public:
     perfmon_collection_t cache_collection;
     perfmon_membership_t cache_membership;
 
+    // Reports a value of the cache's evicter.
     class perfmon_value_t : public perfmon_t {
     public:
-        explicit perfmon_value_t(alt_cache_stats_t *_parent);
+        perfmon_value_t(alt_cache_stats_t *_parent,
+                        std::function<double(const alt::evicter_t &)> _get_value);
         void *begin_stats();
         void visit_stats(void *);
         ql::datum_t end_stats(void *);
     private:
         alt_cache_stats_t *parent;
+        std::function<double(const alt::evicter_t &)> get_value;
         DISABLE_COPYING(perfmon_value_t);
     };
     perfmon_value_t in_use_bytes;
-    perfmon_membership_t in_use_bytes_membership;
+    perfmon_value_t protected_bytes;
+    perfmon_value_t probationary_bytes;
+    perfmon_value_t protected_hits;
+    perfmon_value_t probationary_hits;
+    perfmon_value_t misses;
+    perfmon_multi_membership_t values_membership;
+
+    // Reports the evicter's miss ratio curve, as an object with the `memory_limit`,
+    // the recent `accesses`, and the `hits` the cache would have had for each of the
+    // `cache_sizes`.
+    class perfmon_miss_ratio_curve_t : public perfmon_t {
+    public:
+        explicit perfmon_miss_ratio_curve_t(alt_cache_stats_t *_parent);
+        void *begin_stats();
+        void visit_stats(void *);
+        ql::datum_t end_stats(void *);
+    private:
+        alt_cache_stats_t *parent;
+        DISABLE_COPYING(perfmon_miss_ratio_curve_t);
+    };
+    perfmon_miss_ratio_curve_t miss_ratio_curve;
+    perfmon_membership_t miss_ratio_curve_membership;
 
 
     perfmon_multi_membership_t cache_collection_membership;
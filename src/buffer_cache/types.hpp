@@ -18,6 +18,12 @@ ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(write_durability_t, int8_t,
 // Converting this value from millis to nanos is less than half of 2^63.
 #define NEVER_FLUSH_INTERVAL (0x100000000ll * 1000ll)
 
+// A hint for the evicter about how a page access fits in with the other accesses.
+// Traversals that read each page of a range once, like counting a table or a
+// backfill, use `use_once` so that the pages they touch don't get promoted over the
+// cache's working set (see `evicter_t`).
+enum class page_access_hint_t { normal, use_once };
+
 struct flush_interval_t {
     int64_t millis;
 };
@@ -394,6 +394,41 @@ bool artificial_reql_cluster_interface_t::db_rebalance(
         user_context, db, interruptor, result_out, error_out);
 }
 
+bool artificial_reql_cluster_interface_t::table_compact(
+        auth::user_context_t const &user_context,
+        counted_t<const ql::db_t> db,
+        const name_string_t &name,
+        signal_t *interruptor,
+        ql::datum_t *result_out,
+        admin_err_t *error_out) {
+    if (db->name == artificial_reql_cluster_interface_t::database_name) {
+        *error_out = admin_err_t{
+            strprintf("Database `%s` is special; you can't compact the "
+                      "tables in it.", artificial_reql_cluster_interface_t::database_name.c_str()),
+            query_state_t::FAILED};
+        return false;
+    }
+    return next_or_error(error_out) && m_next->table_compact(
+        user_context, db, name, interruptor, result_out, error_out);
+}
+
+bool artificial_reql_cluster_interface_t::db_compact(
+        auth::user_context_t const &user_context,
+        counted_t<const ql::db_t> db,
+        signal_t *interruptor,
+        ql::datum_t *result_out,
+        admin_err_t *error_out) {
+    if (db->name == artificial_reql_cluster_interface_t::database_name) {
+        *error_out = admin_err_t{
+            strprintf("Database `%s` is special; you can't compact the "
+                      "tables in it.", artificial_reql_cluster_interface_t::database_name.c_str()),
+            query_state_t::FAILED};
+        return false;
+    }
+    return next_or_error(error_out) && m_next->db_compact(
+        user_context, db, interruptor, result_out, error_out);
+}
+
 bool artificial_reql_cluster_interface_t::grant_global(
         auth::user_context_t const &user_context,
         auth::username_t username,
@@ -842,6 +877,32 @@ artificial_reql_cluster_backends_t::artificial_reql_cluster_backends_t(
         name_string_t::guarantee_valid("_debug_stats"),
         std::make_pair(debug_stats_backend.get(), debug_stats_backend.get()));
 
+    debug_coro_profile_backend.init(
+        new debug_coro_profile_artificial_table_backend_t(
+            rdb_context,
+            name_resolver,
+            directory_map_view,
+            server_config_client,
+            mailbox_manager));
+    debug_coro_profile_sentry = backend_sentry_t(
+        artificial_reql_cluster_interface->get_table_backends_map_mutable(),
+        name_string_t::guarantee_valid("_debug_coro_profile"),
+        std::make_pair(debug_coro_profile_backend.get(),
+                       debug_coro_profile_backend.get()));
+
+    debug_cache_curves_backend.init(
+        new debug_cache_curves_artificial_table_backend_t(
+            rdb_context,
+            name_resolver,
+            directory_map_view,
+            server_config_client,
+            mailbox_manager));
+    debug_cache_curves_sentry = backend_sentry_t(
+        artificial_reql_cluster_interface->get_table_backends_map_mutable(),
+        name_string_t::guarantee_valid("_debug_cache_curves"),
+        std::make_pair(debug_cache_curves_backend.get(),
+                       debug_cache_curves_backend.get()));
+
     debug_table_status_backend.init(
         new debug_table_status_artificial_table_backend_t(
             rdb_context,
@@ -10,6 +10,8 @@
 #include "clustering/administration/metadata.hpp"
 #include "clustering/administration/servers/server_config.hpp"
 #include "clustering/administration/servers/server_status.hpp"
+#include "clustering/administration/stats/debug_cache_curves_backend.hpp"
+#include "clustering/administration/stats/debug_coro_profile_backend.hpp"
 #include "clustering/administration/stats/debug_stats_backend.hpp"
 #include "clustering/administration/stats/stats_backend.hpp"
 #include "clustering/administration/tables/db_config.hpp"
@@ -181,6 +183,20 @@ public:
             ql::datum_t *result_out,
             admin_err_t *error_out);
 
+    bool table_compact(
+            auth::user_context_t const &user_context,
+            counted_t<const ql::db_t> db,
+            const name_string_t &name,
+            signal_t *interruptor,
+            ql::datum_t *result_out,
+            admin_err_t *error_out);
+    bool db_compact(
+            auth::user_context_t const &user_context,
+            counted_t<const ql::db_t> db,
+            signal_t *interruptor,
+            ql::datum_t *result_out,
+            admin_err_t *error_out);
+
     bool grant_global(
             auth::user_context_t const &user_context,
             auth::username_t username,
@@ -344,6 +360,12 @@ private:
 
     scoped_ptr_t<debug_stats_artificial_table_backend_t> debug_stats_backend;
     backend_sentry_t debug_stats_sentry;
+    scoped_ptr_t<debug_coro_profile_artificial_table_backend_t>
+        debug_coro_profile_backend;
+    backend_sentry_t debug_coro_profile_sentry;
+    scoped_ptr_t<debug_cache_curves_artificial_table_backend_t>
+        debug_cache_curves_backend;
+    backend_sentry_t debug_cache_curves_sentry;
 
     scoped_ptr_t<debug_table_status_artificial_table_backend_t>
         debug_table_status_backend;
@@ -39,8 +39,11 @@
 #include <re2/re2.h>
 
 #include "arch/io/disk.hpp"
+#include "arch/io/network_uring.hpp"
 #include "arch/io/openssl.hpp"
 #include "arch/os_signal.hpp"
+#include "arch/page_arena.hpp"
+#include "arch/runtime/numa.hpp"
 #include "arch/runtime/starter.hpp"
 #include "arch/filesystem.hpp"
 
@@ -60,10 +63,15 @@
 #include "clustering/administration/persist/file_keys.hpp"
 #include "clustering/administration/persist/migrate/migrate_v1_16.hpp"
 #include "clustering/administration/persist/migrate/migrate_v2_1.hpp"
+#include "clustering/administration/persist/table_interface.hpp"
 #include "clustering/administration/servers/server_metadata.hpp"
 #include "containers/scoped.hpp"
 #include "crypto/random.hpp"
 #include "logger.hpp"
+#include "serializer/log/block_compression.hpp"
+#include "serializer/log/compaction.hpp"
+#include "serializer/log/extent_manager.hpp"
+#include "serializer/merger.hpp"
 
 #define RETHINKDB_EXPORT_SCRIPT "rethinkdb-export"
 #define RETHINKDB_IMPORT_SCRIPT "rethinkdb-import"
@@ -883,6 +891,17 @@ bool initialize_tls_ctx(
     }
     SSL_CTX_set_options(tls_ctx_out->get(), protocol_flags);
 
+    if (exists_option(opts, "--tls-kernel-offload")) {
+#ifdef SSL_OP_ENABLE_KTLS
+        // OpenSSL only hands the keys to the kernel if the kernel supports the
+        // negotiated cipher suite, and keeps encrypting by itself otherwise.
+        SSL_CTX_set_options(tls_ctx_out->get(), SSL_OP_ENABLE_KTLS);
+#else
+        logWRN("This build of RethinkDB was linked against a version of OpenSSL "
+               "that doesn't support kernel TLS. Ignoring --tls-kernel-offload.");
+#endif
+    }
+
     // Prefer server ciphers, and always generate new keys for DHE or ECDHE.
     SSL_CTX_set_options(
         tls_ctx_out->get(),
@@ -1045,6 +1064,7 @@ void run_rethinkdb_create(const base_path_t &base_path,
                           optional<uint64_t> total_cache_size,
                           const file_direct_io_mode_t direct_io_mode,
                           const int max_concurrent_io_requests,
+                          const file_io_backend_t io_backend,
                           bool *const result_out) {
     server_id_t our_server_id = server_id_t::generate_server_id();
 
@@ -1058,7 +1078,7 @@ void run_rethinkdb_create(const base_path_t &base_path,
     server_config.config.cache_size_bytes = total_cache_size;
     server_config.version = 1;
 
-    io_backender_t io_backender(direct_io_mode, max_concurrent_io_requests);
+    io_backender_t io_backender(direct_io_mode, max_concurrent_io_requests, io_backend);
 
     perfmon_collection_t metadata_perfmon_collection;
     perfmon_membership_t metadata_perfmon_membership(&get_global_perfmon_collection(), &metadata_perfmon_collection, "metadata");
@@ -1090,6 +1110,86 @@ void run_rethinkdb_create(const base_path_t &base_path,
     }
 }
 
+void run_rethinkdb_compact(const base_path_t &base_path,
+                           const optional<namespace_id_t> &table_id,
+                           const file_direct_io_mode_t direct_io_mode,
+                           const int max_concurrent_io_requests,
+                           const file_io_backend_t io_backend,
+                           bool *const result_out) {
+    io_backender_t io_backender(direct_io_mode, max_concurrent_io_requests, io_backend);
+
+    perfmon_collection_t metadata_perfmon_collection;
+    perfmon_membership_t metadata_perfmon_membership(&get_global_perfmon_collection(), &metadata_perfmon_collection, "metadata");
+
+    try {
+        cond_t non_interruptor;
+
+        // Only the tables that are active on this server have data files here.
+        std::vector<namespace_id_t> table_ids;
+        {
+            metadata_file_t metadata_file(
+                &io_backender,
+                base_path,
+                &metadata_perfmon_collection,
+                &non_interruptor);
+            metadata_file_t::read_txn_t read_txn(&metadata_file, &non_interruptor);
+            read_txn.read_many<table_active_persistent_state_t>(
+                mdprefix_table_active(),
+                [&](const std::string &uuid_str, const table_active_persistent_state_t &) {
+                    namespace_id_t id = str_to_uuid(uuid_str);
+                    if (!static_cast<bool>(table_id) || *table_id == id) {
+                        table_ids.push_back(id);
+                    }
+                },
+                &non_interruptor);
+        }
+
+        if (static_cast<bool>(table_id) && table_ids.empty()) {
+            logERR("Table %s doesn't have any data on this server.\n",
+                   uuid_to_str(*table_id).c_str());
+            *result_out = false;
+            return;
+        }
+
+        const ticks_t start_time = get_ticks();
+        int64_t total_old_size = 0;
+        int64_t total_new_size = 0;
+        for (const namespace_id_t &id : table_ids) {
+            /* A striped table has one more file in each of the stripe directories that
+            it was created with (see `set_table_stripe_directories()`). */
+            std::vector<serializer_filepath_t> paths(
+                1, serializer_filepath_t(base_path, uuid_to_str(id)));
+            for (const base_path_t &directory : get_table_stripe_directories()) {
+                serializer_filepath_t stripe_path(directory, uuid_to_str(id));
+                if (access(stripe_path.permanent_path().c_str(), R_OK | W_OK) == 0) {
+                    paths.push_back(stripe_path);
+                }
+            }
+
+            for (const serializer_filepath_t &path : paths) {
+                const ticks_t file_start_time = get_ticks();
+                int64_t old_size;
+                int64_t new_size;
+                compact_serializer_file(&io_backender, path, &old_size, &new_size);
+                logNTC("Compacted %s from %" PRIi64 " to %" PRIi64 " bytes in %.3f "
+                       "seconds.\n", path.permanent_path().c_str(), old_size, new_size,
+                       ticks_to_secs(ticks_t{get_ticks().nanos - file_start_time.nanos}));
+                total_old_size += old_size;
+                total_new_size += new_size;
+            }
+        }
+
+        logINF("Compacted the data files of %zu table(s) in %.3f seconds, reclaiming "
+               "%" PRIi64 " bytes.\n", table_ids.size(),
+               ticks_to_secs(ticks_t{get_ticks().nanos - start_time.nanos}),
+               total_old_size - total_new_size);
+        *result_out = true;
+    } catch (const file_in_use_exc_t &ex) {
+        logNTC("Directory '%s' is in use by another rethinkdb process.\n", base_path.path().c_str());
+        *result_out = false;
+    }
+}
+
 #ifdef _WIN32
 std::string windows_version_string() {
     // TODO WINDOWS: the return value of GetVersion may be capped,
@@ -1139,6 +1239,7 @@ void run_rethinkdb_serve(const base_path_t &base_path,
                          const std::string &initial_password,
                          const file_direct_io_mode_t direct_io_mode,
                          const int max_concurrent_io_requests,
+                         const file_io_backend_t io_backend,
                          const optional<optional<uint64_t> >
                             &total_cache_size,
                          const server_id_t *our_server_id,
@@ -1156,7 +1257,7 @@ void run_rethinkdb_serve(const base_path_t &base_path,
 
     logNTC("Loading data from directory %s\n", base_path.path().c_str());
 
-    io_backender_t io_backender(direct_io_mode, max_concurrent_io_requests);
+    io_backender_t io_backender(direct_io_mode, max_concurrent_io_requests, io_backend);
 
     perfmon_collection_t metadata_perfmon_collection;
     perfmon_membership_t metadata_perfmon_membership(&get_global_perfmon_collection(), &metadata_perfmon_collection, "metadata");
@@ -1284,6 +1385,7 @@ void run_rethinkdb_porcelain(const base_path_t &base_path,
                              const std::string &initial_password,
                              const file_direct_io_mode_t direct_io_mode,
                              const int max_concurrent_io_requests,
+                             const file_io_backend_t io_backend,
                              const optional<optional<uint64_t> >
                                 &total_cache_size,
                              const bool new_directory,
@@ -1292,7 +1394,7 @@ void run_rethinkdb_porcelain(const base_path_t &base_path,
                              bool *const result_out) {
     if (!new_directory) {
         run_rethinkdb_serve(base_path, serve_info, initial_password, direct_io_mode,
-                            max_concurrent_io_requests, total_cache_size,
+                            max_concurrent_io_requests, io_backend, total_cache_size,
                             nullptr, nullptr, nullptr, data_directory_lock,
                             result_out);
     } else {
@@ -1328,7 +1430,7 @@ void run_rethinkdb_porcelain(const base_path_t &base_path,
         server_config.version = 1;
 
         run_rethinkdb_serve(base_path, serve_info, initial_password, direct_io_mode,
-                            max_concurrent_io_requests,
+                            max_concurrent_io_requests, io_backend,
                             optional<optional<uint64_t> >(),
                             &our_server_id, &server_config, &cluster_metadata,
                             data_directory_lock, result_out);
@@ -1402,24 +1504,160 @@ options::help_section_t get_file_options(std::vector<options::option_t> *options
                                              options::OPTIONAL,
                                              "rethinkdb_data"));
     help.add("-d [ --directory ] path", "specify directory to store data and metadata");
+    options_out->push_back(options::option_t(options::names_t("--stripe-directory"),
+                                             options::OPTIONAL_REPEAT));
+    help.add("--stripe-directory path",
+             "spread the data of tables that are created from now on over the data "
+             "directory and this directory, e.g. to use the bandwidth of another disk. "
+             "Can be specified multiple times. Tables that were created with stripe "
+             "directories need all of them to be specified.");
     options_out->push_back(options::option_t(options::names_t("--io-threads"),
                                              options::OPTIONAL,
                                              strprintf("%d", DEFAULT_MAX_CONCURRENT_IO_REQUESTS)));
     help.add("--io-threads n",
              "how many simultaneous I/O operations can happen at the same time");
+    options_out->push_back(options::option_t(options::names_t("--io-backend"),
+                                             options::OPTIONAL,
+                                             "pool"));
+    help.add("--io-backend {pool|io_uring}",
+             "how I/O operations are sent to the disk: from a pool of threads, or "
+             "through io_uring (Linux only, falls back to 'pool' if unsupported)");
 #ifndef _WIN32
     // TODO WINDOWS: accept this option, but error out if it is passed
     options_out->push_back(options::option_t(options::names_t("--direct-io"),
                                              options::OPTIONAL_NO_PARAMETER));
     help.add("--direct-io", "use direct I/O for file access");
 #endif
+    options_out->push_back(options::option_t(options::names_t("--block-compression"),
+                                             options::OPTIONAL,
+                                             "none"));
+    help.add("--block-compression {none|zlib}",
+             "how to compress the blocks that tables write to disk (blocks that are "
+             "already on disk can always be read)");
+    options_out->push_back(options::option_t(options::names_t("--hole-punching-rate"),
+                                             options::OPTIONAL,
+                                             "0"));
+    help.add("--hole-punching-rate mb",
+             "how many megabytes per second of freed space to punch out of the data "
+             "files, so that the file system and the disk can reuse it (Linux only, "
+             "0 turns it off)");
+    options_out->push_back(options::option_t(options::names_t("--group-commit-window"),
+                                             options::OPTIONAL,
+                                             "0"));
+    help.add("--group-commit-window us",
+             "how many microseconds a table holds back a hard durability write to "
+             "commit the writes that come in meanwhile together with it, with a "
+             "single fsync (0 turns it off)");
     options_out->push_back(options::option_t(options::names_t("--cache-size"),
                                              options::OPTIONAL));
     help.add("--cache-size mb", "total cache size (in megabytes) for the process. Can "
         "be 'auto'.");
+    options_out->push_back(options::option_t(options::names_t("--cache-huge-pages"),
+                                             options::OPTIONAL,
+                                             "off"));
+    help.add("--cache-huge-pages {off|transparent|hugetlb}",
+             "whether to back the cache with 2MB pages: transparent huge pages, or "
+             "pages from the hugetlbfs pool (Linux only, falls back to transparent "
+             "huge pages when the pool runs out)");
     return help;
 }
 
+MUST_USE bool parse_cache_huge_pages_option(
+        const std::map<std::string, options::values_t> &opts,
+        page_arena_mode_t *page_arena_mode_out) {
+    const std::string huge_pages = get_single_option(opts, "--cache-huge-pages");
+    if (huge_pages == "off") {
+        *page_arena_mode_out = page_arena_mode_t::off;
+    } else if (huge_pages == "transparent") {
+        *page_arena_mode_out = page_arena_mode_t::transparent;
+    } else if (huge_pages == "hugetlb") {
+        *page_arena_mode_out = page_arena_mode_t::hugetlb;
+    } else {
+        fprintf(stderr, "ERROR: cache-huge-pages must be 'off', 'transparent' or "
+                "'hugetlb'\n");
+        return false;
+    }
+    return true;
+}
+
+MUST_USE bool parse_block_compression_option(
+        const std::map<std::string, options::values_t> &opts,
+        block_compression_t *block_compression_out) {
+    const std::string compression = get_single_option(opts, "--block-compression");
+    if (compression == "none") {
+        *block_compression_out = block_compression_t::none;
+    } else if (compression == "zlib") {
+        *block_compression_out = block_compression_t::zlib;
+    } else {
+        fprintf(stderr, "ERROR: block-compression must be 'none' or 'zlib'\n");
+        return false;
+    }
+    return true;
+}
+
+MUST_USE bool parse_hole_punching_rate_option(
+        const std::map<std::string, options::values_t> &opts,
+        int64_t *hole_punching_rate_out) {
+    const int rate = get_single_int(opts, "--hole-punching-rate");
+    if (rate < 0) {
+        fprintf(stderr, "ERROR: hole-punching-rate must not be negative\n");
+        return false;
+    }
+    *hole_punching_rate_out = rate * MEGABYTE;
+    return true;
+}
+
+MUST_USE bool parse_stripe_directory_options(
+        const std::map<std::string, options::values_t> &opts,
+        std::vector<base_path_t> *stripe_directories_out) {
+    for (const std::string &directory : all_options(opts, "--stripe-directory")) {
+        if (access(directory.c_str(), R_OK | W_OK | X_OK) != 0) {
+            fprintf(stderr, "ERROR: stripe-directory '%s' is not a writable "
+                    "directory\n", directory.c_str());
+            return false;
+        }
+        base_path_t path(directory);
+        path.make_absolute();
+        for (const base_path_t &other : *stripe_directories_out) {
+            if (other.path() == path.path()) {
+                fprintf(stderr, "ERROR: stripe-directory '%s' is given twice\n",
+                        directory.c_str());
+                return false;
+            }
+        }
+        stripe_directories_out->push_back(path);
+    }
+    return true;
+}
+
+// Checks that none of the stripe directories is the data directory, and creates their
+// temporary directories, which new table files are created in.
+MUST_USE bool prepare_stripe_directories(
+        const base_path_t &base_path,
+        const std::vector<base_path_t> &stripe_directories) {
+    for (const base_path_t &directory : stripe_directories) {
+        if (directory.path() == base_path.path()) {
+            fprintf(stderr, "ERROR: stripe-directory '%s' is the data directory\n",
+                    directory.path().c_str());
+            return false;
+        }
+        recreate_temporary_directory(directory);
+    }
+    return true;
+}
+
+MUST_USE bool parse_group_commit_window_option(
+        const std::map<std::string, options::values_t> &opts,
+        int64_t *group_commit_window_out) {
+    const int window = get_single_int(opts, "--group-commit-window");
+    if (window < 0) {
+        fprintf(stderr, "ERROR: group-commit-window must not be negative\n");
+        return false;
+    }
+    *group_commit_window_out = window;
+    return true;
+}
+
 options::help_section_t get_config_file_options(std::vector<options::option_t> *options_out) {
     options::help_section_t help("Configuration file options");
     options_out->push_back(options::option_t(options::names_t("--config-file"),
@@ -1577,6 +1815,14 @@ options::help_section_t get_network_options(const bool join_required, std::vecto
                                              options::OPTIONAL_NO_PARAMETER));
     help.add("--no-default-bind", "disable automatic listening on loopback addresses");
 
+    options_out->push_back(options::option_t(options::names_t("--network-backend"),
+                                             options::OPTIONAL,
+                                             "epoll"));
+    help.add("--network-backend {epoll|io_uring}",
+             "how connections send and receive data: with a system call per "
+             "operation, or in batches through io_uring (Linux only, falls back to "
+             "'epoll' if unsupported)");
+
     options_out->push_back(options::option_t(options::names_t("--cluster-port"),
                                              options::OPTIONAL,
                                              strprintf("%d", port_defaults::peer_port)));
@@ -1633,9 +1879,32 @@ options::help_section_t get_cpu_options(std::vector<options::option_t> *options_
                                              options::OPTIONAL,
                                              strprintf("%d", get_cpu_count())));
     help.add("-c [ --cores ] n", "the number of cores to use");
+    options_out->push_back(options::option_t(options::names_t("--thread-affinity"),
+                                             options::OPTIONAL,
+                                             "none"));
+    help.add("--thread-affinity {none|cores|numa}",
+             "whether to pin worker threads to cores, and with 'numa', to group "
+             "them by NUMA node and allocate their memory on their node");
     return help;
 }
 
+MUST_USE bool parse_thread_affinity_option(
+        const std::map<std::string, options::values_t> &opts,
+        thread_affinity_t *thread_affinity_out) {
+    const std::string thread_affinity = get_single_option(opts, "--thread-affinity");
+    if (thread_affinity == "none") {
+        *thread_affinity_out = thread_affinity_t::none;
+    } else if (thread_affinity == "cores") {
+        *thread_affinity_out = thread_affinity_t::cores;
+    } else if (thread_affinity == "numa") {
+        *thread_affinity_out = thread_affinity_t::numa;
+    } else {
+        fprintf(stderr, "ERROR: thread-affinity must be 'none', 'cores' or 'numa'\n");
+        return false;
+    }
+    return true;
+}
+
 MUST_USE bool parse_cores_option(const std::map<std::string, options::values_t> &opts,
                                  int *num_workers_out) {
     int num_workers = get_single_int(opts, "--cores");
@@ -1730,6 +1999,8 @@ options::help_section_t get_tls_options(std::vector<options::option_t> *options_
                                              options::OPTIONAL));
     options_out->push_back(options::option_t(options::names_t("--tls-dhparams"),
                                              options::OPTIONAL));
+    options_out->push_back(options::option_t(options::names_t("--tls-kernel-offload"),
+                                             options::OPTIONAL_NO_PARAMETER));
     help.add(
         "--tls-min-protocol protocol",
         "the minimum TLS protocol version that the server accepts; options are "
@@ -1744,6 +2015,11 @@ options::help_section_t get_tls_options(std::vector<options::option_t> *options_
         "--tls-dhparams dhparams_filename",
         "provide parameters for DHE key agreement; REQUIRED if using DHE cipher suites; "
         "at least 2048-bit recommended");
+    help.add(
+        "--tls-kernel-offload",
+        "let the kernel encrypt outgoing TLS data after the handshake (Linux kTLS, "
+        "needs the 'tls' kernel module); connections whose cipher suite the kernel "
+        "doesn't support are encrypted by OpenSSL as usual");
 
     return help;
 }
@@ -1760,6 +2036,15 @@ options::help_section_t get_help_options(std::vector<options::option_t> *options
     return help;
 }
 
+options::help_section_t get_compact_options(std::vector<options::option_t> *options_out) {
+    options::help_section_t help("Compaction options");
+    options_out->push_back(options::option_t(options::names_t("--table"),
+                                             options::OPTIONAL));
+    help.add("--table uuid", "only compact the data files of the table with this id; "
+             "by default the data files of all tables on this server are compacted");
+    return help;
+}
+
 void get_rethinkdb_create_options(std::vector<options::help_section_t> *help_out,
                                   std::vector<options::option_t> *options_out) {
     help_out->push_back(get_file_options(options_out));
@@ -1821,6 +2106,16 @@ void get_rethinkdb_porcelain_options(std::vector<options::help_section_t> *help_
     help_out->push_back(get_config_file_options(options_out));
 }
 
+void get_rethinkdb_compact_options(std::vector<options::help_section_t> *help_out,
+                                   std::vector<options::option_t> *options_out) {
+    help_out->push_back(get_file_options(options_out));
+    help_out->push_back(get_compact_options(options_out));
+    help_out->push_back(get_setuser_options(options_out));
+    help_out->push_back(get_help_options(options_out));
+    help_out->push_back(get_log_options(options_out));
+    help_out->push_back(get_config_file_options(options_out));
+}
+
 std::map<std::string, options::values_t> parse_config_file_flat(const std::string &config_filepath,
                                                                 const std::vector<options::option_t> &options) {
     std::string file;
@@ -1893,6 +2188,35 @@ update_check_t parse_update_checking_option(const std::map<std::string, options:
         : update_check_t::perform;
 }
 
+MUST_USE bool parse_io_backend_option(const std::map<std::string, options::values_t> &opts,
+                                      file_io_backend_t *io_backend_out) {
+    const std::string io_backend = get_single_option(opts, "--io-backend");
+    if (io_backend == "pool") {
+        *io_backend_out = file_io_backend_t::pool;
+    } else if (io_backend == "io_uring") {
+        *io_backend_out = file_io_backend_t::io_uring;
+    } else {
+        fprintf(stderr, "ERROR: io-backend must be either 'pool' or 'io_uring'\n");
+        return false;
+    }
+    return true;
+}
+
+MUST_USE bool parse_network_backend_option(
+        const std::map<std::string, options::values_t> &opts,
+        network_io_backend_t *network_backend_out) {
+    const std::string network_backend = get_single_option(opts, "--network-backend");
+    if (network_backend == "epoll") {
+        *network_backend_out = network_io_backend_t::epoll;
+    } else if (network_backend == "io_uring") {
+        *network_backend_out = network_io_backend_t::io_uring;
+    } else {
+        fprintf(stderr, "ERROR: network-backend must be either 'epoll' or 'io_uring'\n");
+        return false;
+    }
+    return true;
+}
+
 file_direct_io_mode_t parse_direct_io_mode_option(const std::map<std::string, options::values_t> &opts) {
     return exists_option(opts, "--direct-io") ?
         file_direct_io_mode_t::direct_desired :
@@ -1929,6 +2253,11 @@ int main_rethinkdb_create(int argc, char *argv[]) {
             return EXIT_FAILURE;
         }
 
+        file_io_backend_t io_backend;
+        if (!parse_io_backend_option(opts, &io_backend)) {
+            return EXIT_FAILURE;
+        }
+
         const int num_workers = get_cpu_count();
 
         bool is_new_directory = false;
@@ -1958,6 +2287,7 @@ int main_rethinkdb_create(int argc, char *argv[]) {
                                      total_cache_size,
                                      direct_io_mode,
                                      max_concurrent_io_requests,
+                                     io_backend,
                                      &result),
                            num_workers);
 
@@ -1979,6 +2309,102 @@ int main_rethinkdb_create(int argc, char *argv[]) {
     return EXIT_FAILURE;
 }
 
+int main_rethinkdb_compact(int argc, char *argv[]) {
+    std::vector<options::option_t> options;
+    std::vector<options::help_section_t> help;
+    get_rethinkdb_compact_options(&help, &options);
+
+    try {
+        std::map<std::string, options::values_t> opts = parse_commands_deep(argc - 2, argv + 2, options);
+
+        if (handle_help_or_version_option(opts, &help_rethinkdb_compact)) {
+            return EXIT_SUCCESS;
+        }
+
+        options::verify_option_counts(options, opts);
+
+#ifndef _WIN32
+        get_and_set_user_group(opts);
+#endif
+
+        base_path_t base_path(get_single_option(opts, "--directory"));
+
+        optional<namespace_id_t> table_id;
+        if (optional<std::string> table_str = get_optional_option(opts, "--table")) {
+            namespace_id_t id;
+            if (!str_to_uuid(*table_str, &id)) {
+                fprintf(stderr, "ERROR: table '%s' is not a valid table id\n",
+                        table_str->c_str());
+                return EXIT_FAILURE;
+            }
+            table_id.set(id);
+        }
+
+        block_compression_t block_compression;
+        if (!parse_block_compression_option(opts, &block_compression)) {
+            return EXIT_FAILURE;
+        }
+
+        std::vector<base_path_t> stripe_directories;
+        if (!parse_stripe_directory_options(opts, &stripe_directories)) {
+            return EXIT_FAILURE;
+        }
+
+        int max_concurrent_io_requests;
+        if (!parse_io_threads_option(opts, &max_concurrent_io_requests)) {
+            return EXIT_FAILURE;
+        }
+
+        file_io_backend_t io_backend;
+        if (!parse_io_backend_option(opts, &io_backend)) {
+            return EXIT_FAILURE;
+        }
+
+        const int num_workers = get_cpu_count();
+
+        // Open and lock the directory, but do not create it. This also keeps a server
+        // from using the directory while we compact it.
+        bool is_new_directory = false;
+        directory_lock_t data_directory_lock(base_path, false, &is_new_directory);
+        guarantee(!is_new_directory);
+
+        base_path.make_absolute();
+        initialize_logfile(opts, base_path);
+
+        recreate_temporary_directory(base_path);
+        if (!prepare_stripe_directories(base_path, stripe_directories)) {
+            return EXIT_FAILURE;
+        }
+
+        const file_direct_io_mode_t direct_io_mode = parse_direct_io_mode_option(opts);
+
+        // The compacted files are written with the given block compression.
+        set_table_block_compression(block_compression);
+        set_table_stripe_directories(stripe_directories);
+
+        bool result;
+        run_in_thread_pool(std::bind(&run_rethinkdb_compact,
+                                     base_path,
+                                     table_id,
+                                     direct_io_mode,
+                                     max_concurrent_io_requests,
+                                     io_backend,
+                                     &result),
+                           num_workers);
+
+        return result ? EXIT_SUCCESS : EXIT_FAILURE;
+    } catch (const options::named_error_t &ex) {
+        output_named_error(ex, help);
+        fprintf(stderr, "Run 'rethinkdb help compact' for help on the command\n");
+    } catch (const options::option_error_t &ex) {
+        output_sourced_error(ex);
+        fprintf(stderr, "Run 'rethinkdb help compact' for help on the command\n");
+    } catch (const std::exception &ex) {
+        fprintf(stderr, "%s\n", ex.what());
+    }
+    return EXIT_FAILURE;
+}
+
 bool maybe_daemonize(const std::map<std::string, options::values_t> &opts) {
     if (exists_option(opts, "--daemon")) {
 #ifdef _WIN32
@@ -2052,11 +2478,51 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
             return EXIT_FAILURE;
         }
 
+        thread_affinity_t thread_affinity;
+        if (!parse_thread_affinity_option(opts, &thread_affinity)) {
+            return EXIT_FAILURE;
+        }
+
+        page_arena_mode_t page_arena_mode;
+        if (!parse_cache_huge_pages_option(opts, &page_arena_mode)) {
+            return EXIT_FAILURE;
+        }
+
+        block_compression_t block_compression;
+        if (!parse_block_compression_option(opts, &block_compression)) {
+            return EXIT_FAILURE;
+        }
+
+        int64_t hole_punching_rate;
+        if (!parse_hole_punching_rate_option(opts, &hole_punching_rate)) {
+            return EXIT_FAILURE;
+        }
+
+        int64_t group_commit_window;
+        if (!parse_group_commit_window_option(opts, &group_commit_window)) {
+            return EXIT_FAILURE;
+        }
+
+        std::vector<base_path_t> stripe_directories;
+        if (!parse_stripe_directory_options(opts, &stripe_directories)) {
+            return EXIT_FAILURE;
+        }
+
         int max_concurrent_io_requests;
         if (!parse_io_threads_option(opts, &max_concurrent_io_requests)) {
             return EXIT_FAILURE;
         }
 
+        file_io_backend_t io_backend;
+        if (!parse_io_backend_option(opts, &io_backend)) {
+            return EXIT_FAILURE;
+        }
+
+        network_io_backend_t network_backend;
+        if (!parse_network_backend_option(opts, &network_backend)) {
+            return EXIT_FAILURE;
+        }
+
         update_check_t do_update_checking = parse_update_checking_option(opts);
 
         optional<optional<uint64_t> > total_cache_size =
@@ -2075,6 +2541,9 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
         initialize_logfile(opts, base_path);
 
         recreate_temporary_directory(base_path);
+        if (!prepare_stripe_directories(base_path, stripe_directories)) {
+            return EXIT_FAILURE;
+        }
 
         if (check_pid_file(opts) != EXIT_SUCCESS) {
             return EXIT_FAILURE;
@@ -2111,6 +2580,16 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
 
         const file_direct_io_mode_t direct_io_mode = parse_direct_io_mode_option(opts);
 
+        set_network_io_backend(network_backend);
+        set_thread_affinity(thread_affinity);
+        // If huge pages aren't available, this logs a warning and the cache uses
+        // regular memory instead.
+        set_page_arena_mode(page_arena_mode);
+        set_table_block_compression(block_compression);
+        set_hole_punching_rate(hole_punching_rate);
+        set_group_commit_window(group_commit_window);
+        set_table_stripe_directories(stripe_directories);
+
         bool result;
         run_in_thread_pool(std::bind(&run_rethinkdb_serve,
                                      base_path,
@@ -2118,6 +2597,7 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
                                      initial_password,
                                      direct_io_mode,
                                      max_concurrent_io_requests,
+                                     io_backend,
                                      total_cache_size,
                                      static_cast<server_id_t*>(nullptr),
                                      static_cast<server_config_versioned_t *>(nullptr),
@@ -2158,6 +2638,11 @@ int main_rethinkdb_proxy(int argc, char *argv[]) {
 
         std::string initial_password = parse_initial_password_option(opts);
 
+        network_io_backend_t network_backend;
+        if (!parse_network_backend_option(opts, &network_backend)) {
+            return EXIT_FAILURE;
+        }
+
         if (joins.empty()) {
             fprintf(stderr, "No --join option(s) given. A proxy needs to connect to something!\n"
                     "Run 'rethinkdb help proxy' for more information.\n");
@@ -2212,6 +2697,8 @@ int main_rethinkdb_proxy(int argc, char *argv[]) {
                                 node_reconnect_timeout_secs.value_or(cluster_defaults::reconnect_timeout),
                                 tls_configs);
 
+        set_network_io_backend(network_backend);
+
         bool result;
         run_in_thread_pool(
             std::bind(&run_rethinkdb_proxy, &serve_info, initial_password, &result),
@@ -2323,11 +2810,51 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
             return EXIT_FAILURE;
         }
 
+        thread_affinity_t thread_affinity;
+        if (!parse_thread_affinity_option(opts, &thread_affinity)) {
+            return EXIT_FAILURE;
+        }
+
+        page_arena_mode_t page_arena_mode;
+        if (!parse_cache_huge_pages_option(opts, &page_arena_mode)) {
+            return EXIT_FAILURE;
+        }
+
+        block_compression_t block_compression;
+        if (!parse_block_compression_option(opts, &block_compression)) {
+            return EXIT_FAILURE;
+        }
+
+        int64_t hole_punching_rate;
+        if (!parse_hole_punching_rate_option(opts, &hole_punching_rate)) {
+            return EXIT_FAILURE;
+        }
+
+        int64_t group_commit_window;
+        if (!parse_group_commit_window_option(opts, &group_commit_window)) {
+            return EXIT_FAILURE;
+        }
+
+        std::vector<base_path_t> stripe_directories;
+        if (!parse_stripe_directory_options(opts, &stripe_directories)) {
+            return EXIT_FAILURE;
+        }
+
         int max_concurrent_io_requests;
         if (!parse_io_threads_option(opts, &max_concurrent_io_requests)) {
             return EXIT_FAILURE;
         }
 
+        file_io_backend_t io_backend;
+        if (!parse_io_backend_option(opts, &io_backend)) {
+            return EXIT_FAILURE;
+        }
+
+        network_io_backend_t network_backend;
+        if (!parse_network_backend_option(opts, &network_backend)) {
+            return EXIT_FAILURE;
+        }
+
         update_check_t do_update_checking = parse_update_checking_option(opts);
 
         optional<int> join_delay_secs = parse_join_delay_secs_option(opts);
@@ -2352,6 +2879,9 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
         initialize_logfile(opts, base_path);
 
         recreate_temporary_directory(base_path);
+        if (!prepare_stripe_directories(base_path, stripe_directories)) {
+            return EXIT_FAILURE;
+        }
 
         name_string_t server_name;
         if (is_new_directory) {
@@ -2404,6 +2934,16 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
 
         const file_direct_io_mode_t direct_io_mode = parse_direct_io_mode_option(opts);
 
+        set_network_io_backend(network_backend);
+        set_thread_affinity(thread_affinity);
+        // If huge pages aren't available, this logs a warning and the cache uses
+        // regular memory instead.
+        set_page_arena_mode(page_arena_mode);
+        set_table_block_compression(block_compression);
+        set_hole_punching_rate(hole_punching_rate);
+        set_group_commit_window(group_commit_window);
+        set_table_stripe_directories(stripe_directories);
+
         bool result;
         run_in_thread_pool(std::bind(&run_rethinkdb_porcelain,
                                      base_path,
@@ -2412,6 +2952,7 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
                                      initial_password,
                                      direct_io_mode,
                                      max_concurrent_io_requests,
+                                     io_backend,
                                      total_cache_size,
                                      is_new_directory,
                                      &serve_info,
@@ -2453,6 +2994,7 @@ void help_rethinkdb_porcelain() {
     printf("    'rethinkdb dump': export and compress data from an existing cluster\n");
     printf("    'rethinkdb restore': import compressed data into an existing cluster\n");
     printf("    'rethinkdb index-rebuild': rebuild outdated secondary indexes\n");
+    printf("    'rethinkdb compact': rewrite the data files of tables densely to reclaim space\n");
     printf("    'rethinkdb repl': start a Python REPL with the RethinkDB driver\n");
 #ifdef _WIN32
     printf("    'rethinkdb install-service': install RethinkDB as a Windows service\n");
@@ -2474,6 +3016,20 @@ void help_rethinkdb_create() {
     printf("%s", format_help(help_sections).c_str());
 }
 
+void help_rethinkdb_compact() {
+    std::vector<options::help_section_t> help_sections;
+    {
+        std::vector<options::option_t> options;
+        get_rethinkdb_compact_options(&help_sections, &options);
+    }
+
+    printf("'rethinkdb compact' rewrites the data files of the tables in an existing"
+                " data directory, so that they take up no more space than their data.\n");
+    printf("The server must not be running. To compact the files of a running server,"
+                " insert {type: \"disk_compaction\"} into the `rethinkdb.jobs` table.\n");
+    printf("%s", format_help(help_sections).c_str());
+}
+
 void help_rethinkdb_serve() {
     std::vector<options::help_section_t> help_sections;
     {
@@ -14,6 +14,7 @@ int main_rethinkdb_dump(int argc, char *argv[]);
 int main_rethinkdb_restore(int argc, char *argv[]);
 int main_rethinkdb_index_rebuild(int argc, char *argv[]);
 int main_rethinkdb_repl(int argc, char *argv[]);
+int main_rethinkdb_compact(int argc, char *argv[]);
 #ifdef _WIN32
 int main_rethinkdb_run_service(int argc, char *argv[]);
 int main_rethinkdb_install_service(int argc, char *argv[]);
@@ -30,6 +31,7 @@ void help_rethinkdb_dump();
 void help_rethinkdb_restore();
 void help_rethinkdb_index_rebuild();
 void help_rethinkdb_repl();
+void help_rethinkdb_compact();
 #ifdef _WIN32
 void help_rethinkdb_install_service();
 void help_rethinkdb_remove_service();
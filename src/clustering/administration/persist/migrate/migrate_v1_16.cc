@@ -413,7 +413,8 @@ void check_for_obsolete_sindexes(io_backender_t *io_backender,
                     new log_serializer_t(log_serializer_t::dynamic_config_t(),
                                               &file_opener, &dummy_stats));
                 merger_serializer_t merger_serializer(std::move(inner_serializer),
-                                                      MERGER_SERIALIZER_MAX_ACTIVE_WRITES);
+                                                      MERGER_SERIALIZER_MAX_ACTIVE_WRITES,
+                                                      &dummy_stats);
                 std::vector<serializer_t *> underlying({ &merger_serializer });
                 serializer_multiplexer_t multiplexer(underlying);
 
@@ -460,7 +461,8 @@ void migrate_tables(io_backender_t *io_backender,
                     new log_serializer_t(log_serializer_t::dynamic_config_t(),
                                               &file_opener, &dummy_stats));
                 merger_serializer_t merger_serializer(std::move(inner_serializer),
-                                                      MERGER_SERIALIZER_MAX_ACTIVE_WRITES);
+                                                      MERGER_SERIALIZER_MAX_ACTIVE_WRITES,
+                                                      &dummy_stats);
                 std::vector<serializer_t *> underlying({ &merger_serializer });
                 serializer_multiplexer_t multiplexer(underlying);
 
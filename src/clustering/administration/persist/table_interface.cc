@@ -14,6 +14,16 @@
 #include "serializer/merger.hpp"
 #include "serializer/translator.hpp"
 
+static std::vector<base_path_t> table_stripe_directories;
+
+void set_table_stripe_directories(const std::vector<base_path_t> &directories) {
+    table_stripe_directories = directories;
+}
+
+const std::vector<base_path_t> &get_table_stripe_directories() {
+    return table_stripe_directories;
+}
+
 class real_multistore_ptr_t :
     public multistore_ptr_t {
 public:
@@ -44,34 +54,69 @@ public:
         // exists and then assume it exists or does not exist when
         // loading or creating it.
 
-        // TODO: We should use N slices on M serializers, not N slices
-        // on 1 serializer.
-
         int res = access(path.permanent_path().c_str(), R_OK | W_OK);
         bool create = (res != 0);
 
+        /* The table's first file is in the data directory. If the table is striped,
+        it has one more file in each of the stripe directories that were set when it
+        was created (see `set_table_stripe_directories()`). When we load the table, we
+        pick up the ones that exist; the `serializer_multiplexer_t` checks that we
+        found all of them. */
+        std::vector<serializer_filepath_t> paths(1, path);
+        for (const base_path_t &directory : get_table_stripe_directories()) {
+            serializer_filepath_t stripe_path(directory, uuid_to_str(table_id));
+            if (create ||
+                    access(stripe_path.permanent_path().c_str(), R_OK | W_OK) == 0) {
+                paths.push_back(stripe_path);
+            }
+        }
+
         on_thread_t thread_switcher(serializer_thread_allocation->get_thread());
-        filepath_file_opener_t file_opener(path, io_backender);
+        std::vector<scoped_ptr_t<filepath_file_opener_t> > file_openers;
+        for (size_t i = 0; i < paths.size(); ++i) {
+            file_openers.push_back(make_scoped<filepath_file_opener_t>(
+                paths[i], io_backender));
+            storage_files.push_back(paths[i].permanent_path());
 
-        if (create) {
-            log_serializer_t::create(
-                &file_opener,
-                log_serializer_t::static_config_t());
-        }
+            if (create) {
+                log_serializer_t::create(
+                    file_openers[i].get(),
+                    log_serializer_t::static_config_t());
+            }
 
-        // TODO: Could we handle failure when loading the serializer?  Right
-        // now, we don't.
+            /* The stats of the first file go directly into
+            `perfmon_collection_serializers`, like for a table that isn't striped.
+            The others get a collection each, so that their names don't clash. */
+            perfmon_collection_t *perfmon_collection = perfmon_collection_serializers;
+            if (i > 0) {
+                stripe_perfmon_collections.push_back(
+                    make_scoped<perfmon_collection_t>());
+                perfmon_collection = stripe_perfmon_collections.back().get();
+                stripe_perfmon_memberships.push_back(
+                    make_scoped<perfmon_membership_t>(
+                        perfmon_collection_serializers, perfmon_collection,
+                        strprintf("stripe_%zu", i)));
+            }
 
-        scoped_ptr_t<serializer_t> inner_serializer(new log_serializer_t(
-            log_serializer_t::dynamic_config_t(),
-            &file_opener,
-            perfmon_collection_serializers));
-        serializer.init(new merger_serializer_t(
-            std::move(inner_serializer),
-            MERGER_SERIALIZER_MAX_ACTIVE_WRITES));
+            // TODO: Could we handle failure when loading the serializer?  Right
+            // now, we don't.
+
+            log_serializer_t::dynamic_config_t dynamic_config;
+            dynamic_config.compression = get_table_block_compression();
+            scoped_ptr_t<serializer_t> inner_serializer(new log_serializer_t(
+                dynamic_config,
+                file_openers[i].get(),
+                perfmon_collection));
+            serializers.push_back(make_scoped<merger_serializer_t>(
+                std::move(inner_serializer),
+                MERGER_SERIALIZER_MAX_ACTIVE_WRITES,
+                perfmon_collection));
+        }
 
         std::vector<serializer_t *> ptrs;
-        ptrs.push_back(serializer.get());
+        for (const auto &serializer : serializers) {
+            ptrs.push_back(serializer.get());
+        }
         if (create) {
             serializer_multiplexer_t::create(ptrs, CPU_SHARDING_FACTOR);
         }
@@ -115,7 +160,14 @@ public:
         });
 
         if (create) {
-            file_opener.move_serializer_file_to_permanent_location();
+            /* Whether the first file exists decides whether we create the table or
+            load it, so it goes to its permanent location last. If we crash before
+            that, the next start creates the table again and overwrites the stripe
+            files that made it. Each rename syncs the file's directory. */
+            for (size_t i = 1; i < file_openers.size(); ++i) {
+                file_openers[i]->move_serializer_file_to_permanent_location();
+            }
+            file_openers[0]->move_serializer_file_to_permanent_location();
         }
     }
 
@@ -130,12 +182,14 @@ public:
                 stores[ix].reset();
             }
         });
-        if (serializer.has()) {
-            on_thread_t thread_switcher(serializer->home_thread());
+        if (!serializers.empty()) {
+            on_thread_t thread_switcher(serializers[0]->home_thread());
             if (multiplexer.has()) {
                 multiplexer.reset();
             }
-            serializer.reset();
+            serializers.clear();
+            stripe_perfmon_memberships.clear();
+            stripe_perfmon_collections.clear();
         }
     }
 
@@ -143,8 +197,23 @@ public:
         return branch_history_manager.get();
     }
 
-    serializer_t *get_serializer() {
-        return serializer.get_or_null();
+    std::vector<serializer_t *> get_serializers() {
+        std::vector<serializer_t *> result;
+        for (const auto &serializer : serializers) {
+            result.push_back(serializer.get());
+        }
+        return result;
+    }
+
+    std::vector<std::string> get_storage_files() {
+        return storage_files;
+    }
+
+    void start_compaction() {
+        for (const auto &serializer : serializers) {
+            on_thread_t thread_switcher(serializer->home_thread());
+            serializer->start_compaction();
+        }
     }
 
     store_view_t *get_cpu_sharded_store(size_t i) {
@@ -157,16 +226,20 @@ public:
 
     bool is_gc_active() {
         rassert(!drainer.is_draining());
-        if (serializer.has()) {
-            return serializer->is_gc_active();
-        } else {
-            return false;
+        for (const auto &serializer : serializers) {
+            if (serializer->is_gc_active()) {
+                return true;
+            }
         }
+        return false;
     }
 
 private:
     scoped_ptr_t<real_branch_history_manager_t> branch_history_manager;
-    scoped_ptr_t<serializer_t> serializer;
+    std::vector<scoped_ptr_t<perfmon_collection_t> > stripe_perfmon_collections;
+    std::vector<scoped_ptr_t<perfmon_membership_t> > stripe_perfmon_memberships;
+    std::vector<scoped_ptr_t<serializer_t> > serializers;
+    std::vector<std::string> storage_files;
     scoped_ptr_t<serializer_multiplexer_t> multiplexer;
     scoped_ptr_t<store_t> stores[CPU_SHARDING_FACTOR];
 
@@ -286,9 +359,8 @@ void real_table_persistence_interface_t::load_multistore(
     scoped_ptr_t<thread_allocation_t> serializer_thread(
         new thread_allocation_t(&thread_allocator));
     std::vector<scoped_ptr_t<thread_allocation_t> > store_threads;
-    for (size_t i = 0; i < CPU_SHARDING_FACTOR; ++i) {
-        store_threads.emplace_back(new thread_allocation_t(&thread_allocator));
-    }
+    allocate_cpu_shard_threads(
+        &thread_allocator, serializer_thread->get_thread(), &store_threads);
 
     multistore_ptr_out->init(new real_multistore_ptr_t(
         table_id,
@@ -319,13 +391,17 @@ void real_table_persistence_interface_t::destroy_multistore(
         const namespace_id_t &table_id,
         scoped_ptr_t<multistore_ptr_t> *multistore_ptr_in) {
     guarantee(multistore_ptr_in->has());
+    std::vector<std::string> filepaths = (*multistore_ptr_in)->get_storage_files();
     multistore_ptr_in->reset();
 
-    std::string filepath = file_name_for(table_id).permanent_path();
-    logNTC("Removing file %s\n", filepath.c_str());
-    const int res = ::unlink(filepath.c_str());
-    guarantee_err(res == 0 || get_errno() == ENOENT,
-                  "unlink failed for file %s", filepath.c_str());
+    guarantee(!filepaths.empty());
+    guarantee(filepaths[0] == file_name_for(table_id).permanent_path());
+    for (const std::string &filepath : filepaths) {
+        logNTC("Removing file %s\n", filepath.c_str());
+        const int res = ::unlink(filepath.c_str());
+        guarantee_err(res == 0 || get_errno() == ENOENT,
+                      "unlink failed for file %s", filepath.c_str());
+    }
 }
 
 serializer_filepath_t real_table_persistence_interface_t::file_name_for(
@@ -340,14 +416,14 @@ bool real_table_persistence_interface_t::is_gc_active() const {
         // Note the copy in the loop below is intentional, one of the members is a
         // `auto_drainer_t::lock_t` that we want to hold.
         for (auto real_multistore : real_multistores) {
-            serializer_t *serializer =
-                real_multistore.second.first->get_serializer();
-            if (serializer == nullptr ||
-                    serializer->home_thread() != threadnum_t(thread)) {
-                continue;
+            for (serializer_t *serializer :
+                    real_multistore.second.first->get_serializers()) {
+                if (serializer->home_thread() != threadnum_t(thread)) {
+                    continue;
+                }
+                serializers_copy.insert(
+                    std::make_pair(serializer, real_multistore.second.second));
             }
-            serializers_copy.insert(
-                std::make_pair(serializer, real_multistore.second.second));
         }
 
         {
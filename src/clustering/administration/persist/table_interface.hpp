@@ -11,6 +11,15 @@ class metadata_file_t;
 class real_multistore_ptr_t;
 class table_raft_storage_interface_t;
 
+/* Tables that are created after this is set spread their data over one file in the
+data directory plus one file in each of `directories`, which would usually be on
+different devices. The CPU shards of the table are distributed over the files, so a
+busy table can use the bandwidth of all of the devices. Tables that already exist keep
+the layout they were created with, but all of their directories must still be set
+when they are loaded. */
+void set_table_stripe_directories(const std::vector<base_path_t> &directories);
+const std::vector<base_path_t> &get_table_stripe_directories();
+
 class real_table_persistence_interface_t :
     public table_persistence_interface_t {
 public:
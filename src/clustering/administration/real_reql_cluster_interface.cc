@@ -1116,6 +1116,107 @@ bool real_reql_cluster_interface_t::db_rebalance(
     return true;
 }
 
+void real_reql_cluster_interface_t::compact_internal(
+        const std::set<namespace_id_t> &table_ids,
+        signal_t *interruptor_on_home,
+        ql::datum_t *result_out,
+        std::set<namespace_id_t> *failures_out)
+        THROWS_ONLY(interrupted_exc_t) {
+    assert_thread();
+
+    std::map<server_id_t, std::map<namespace_id_t, std::vector<std::string> > > files;
+    m_table_meta_client->compact(table_ids, interruptor_on_home, &files, failures_out);
+
+    /* The result lists the files that each server is compacting. */
+    std::set<namespace_id_t> compacted;
+    ql::datum_array_builder_t servers_builder(ql::configured_limits_t::unlimited);
+    for (const auto &server_pair : files) {
+        ql::datum_array_builder_t files_builder(ql::configured_limits_t::unlimited);
+        for (const auto &table_pair : server_pair.second) {
+            compacted.insert(table_pair.first);
+            for (const std::string &file : table_pair.second) {
+                files_builder.add(ql::datum_t(datum_string_t(file)));
+            }
+        }
+        ql::datum_t server_name;
+        m_server_config_client->get_server_config_map()->read_key(server_pair.first,
+            [&](const server_config_versioned_t *config) {
+                server_name = config != nullptr
+                    ? convert_name_to_datum(config->config.name)
+                    : convert_uuid_to_datum(server_pair.first.get_uuid());
+            });
+        ql::datum_object_builder_t server_builder;
+        server_builder.overwrite("server", server_name);
+        server_builder.overwrite("files", std::move(files_builder).to_datum());
+        servers_builder.add(std::move(server_builder).to_datum());
+    }
+
+    ql::datum_object_builder_t builder;
+    builder.overwrite("compacted", ql::datum_t(static_cast<double>(compacted.size())));
+    builder.overwrite("servers", std::move(servers_builder).to_datum());
+    *result_out = std::move(builder).to_datum();
+}
+
+bool real_reql_cluster_interface_t::table_compact(
+        auth::user_context_t const &user_context,
+        counted_t<const ql::db_t> db,
+        const name_string_t &name,
+        signal_t *interruptor_on_caller,
+        ql::datum_t *result_out,
+        admin_err_t *error_out) {
+    guarantee(db->name != name_string_t::guarantee_valid("rethinkdb"),
+        "real_reql_cluster_interface_t should never get queries for system tables");
+
+    cross_thread_signal_t interruptor_on_home(interruptor_on_caller, home_thread());
+    try {
+        on_thread_t thread_switcher(home_thread());
+        namespace_id_t table_id;
+        m_table_meta_client->find(db->id, name, &table_id);
+
+        user_context.require_config_permission(m_rdb_context, db->id, table_id);
+
+        std::set<namespace_id_t> failures;
+        compact_internal(
+            std::set<namespace_id_t>{table_id}, &interruptor_on_home, result_out,
+            &failures);
+        if (!failures.empty()) {
+            throw failed_table_op_exc_t();
+        }
+        return true;
+    } CATCH_NAME_ERRORS(db->name, name, error_out)
+      CATCH_OP_ERRORS(db->name, name, error_out,
+        "The table was not compacted.",
+        "The table may or may not have been compacted.")
+}
+
+bool real_reql_cluster_interface_t::db_compact(
+        auth::user_context_t const &user_context,
+        counted_t<const ql::db_t> db,
+        signal_t *interruptor_on_caller,
+        ql::datum_t *result_out,
+        UNUSED admin_err_t *error_out) {
+    guarantee(db->name != name_string_t::guarantee_valid("rethinkdb"),
+        "real_reql_cluster_interface_t should never get queries for system tables");
+    cross_thread_signal_t interruptor_on_home(interruptor_on_caller, home_thread());
+    on_thread_t thread_switcher(home_thread());
+
+    std::map<namespace_id_t, table_basic_config_t> table_names;
+    m_table_meta_client->list_names(&table_names);
+    std::set<namespace_id_t> table_ids;
+    for (auto const &table_name : table_names) {
+        if (table_name.second.database == db->id) {
+            table_ids.insert(table_name.first);
+        }
+    }
+
+    user_context.require_config_permission(m_rdb_context, db->id, table_ids);
+
+    /* The tables that no server could be reached for are left out of `compacted`. */
+    std::set<namespace_id_t> failures;
+    compact_internal(table_ids, &interruptor_on_home, result_out, &failures);
+    return true;
+}
+
 bool real_reql_cluster_interface_t::grant_global(
         auth::user_context_t const &user_context,
         auth::username_t username,
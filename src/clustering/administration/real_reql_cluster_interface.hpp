@@ -186,6 +186,20 @@ public:
             ql::datum_t *result_out,
             admin_err_t *error_out);
 
+    bool table_compact(
+            auth::user_context_t const &user_context,
+            counted_t<const ql::db_t> db,
+            const name_string_t &name,
+            signal_t *interruptor,
+            ql::datum_t *result_out,
+            admin_err_t *error_out);
+    bool db_compact(
+            auth::user_context_t const &user_context,
+            counted_t<const ql::db_t> db,
+            signal_t *interruptor,
+            ql::datum_t *result_out,
+            admin_err_t *error_out);
+
     bool grant_global(
             auth::user_context_t const &user_context,
             auth::username_t username,
@@ -341,6 +355,13 @@ private:
             THROWS_ONLY(interrupted_exc_t, no_such_table_exc_t,
                 failed_table_op_exc_t, maybe_failed_table_op_exc_t, admin_op_exc_t);
 
+    void compact_internal(
+            const std::set<namespace_id_t> &table_ids,
+            signal_t *interruptor,
+            ql::datum_t *result_out,
+            std::set<namespace_id_t> *failures_out)
+            THROWS_ONLY(interrupted_exc_t);
+
     DISABLE_COPYING(real_reql_cluster_interface_t);
 };
 
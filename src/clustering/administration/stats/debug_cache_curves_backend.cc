@@ -0,0 +1,203 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "clustering/administration/stats/debug_cache_curves_backend.hpp"
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "buffer_cache/miss_ratio_curve.hpp"
+#include "clustering/administration/datum_adapter.hpp"
+#include "clustering/administration/servers/config_client.hpp"
+#include "clustering/administration/stats/stat_manager.hpp"
+#include "containers/uuid.hpp"
+
+debug_cache_curves_artificial_table_backend_t::debug_cache_curves_artificial_table_backend_t(
+        rdb_context_t *rdb_context,
+        lifetime_t<name_resolver_t const &> name_resolver,
+        watchable_map_t<peer_id_t, cluster_directory_metadata_t> *_directory_view,
+        server_config_client_t *_server_config_client,
+        mailbox_manager_t *_mailbox_manager)
+    : common_server_artificial_table_backend_t(
+        name_string_t::guarantee_valid("_debug_cache_curves"),
+        rdb_context,
+        name_resolver,
+        _server_config_client,
+        _directory_view),
+      mailbox_manager(_mailbox_manager) {
+}
+
+debug_cache_curves_artificial_table_backend_t::~debug_cache_curves_artificial_table_backend_t() {
+    begin_changefeed_destruction();
+}
+
+bool debug_cache_curves_artificial_table_backend_t::write_row(
+        auth::user_context_t const &user_context,
+        UNUSED ql::datum_t primary_key,
+        UNUSED bool pkey_was_autogenerated,
+        UNUSED ql::datum_t *new_value_inout,
+        UNUSED signal_t *interruptor_on_caller,
+        admin_err_t *error_out) {
+    user_context.require_admin_user();
+
+    *error_out = admin_err_t{
+        "It's illegal to write to the `rethinkdb._debug_cache_curves` table.",
+        query_state_t::FAILED};
+    return false;
+}
+
+bool debug_cache_curves_artificial_table_backend_t::format_row(
+        auth::user_context_t const &user_context,
+        server_id_t const & server_id,
+        UNUSED peer_id_t const & peer_id,
+        cluster_directory_metadata_t const & metadata,
+        signal_t *interruptor_on_home,
+        ql::datum_t *row_out,
+        UNUSED admin_err_t *error_out) {
+    user_context.require_admin_user();
+
+    ql::datum_object_builder_t builder;
+    ql::datum_t tables;
+    admin_err_t curves_error;
+    if (curves_for_server(metadata, interruptor_on_home, &tables, &curves_error)) {
+        builder.overwrite("tables", tables);
+    } else {
+        builder.overwrite("error", ql::datum_t(datum_string_t(curves_error.msg)));
+    }
+    builder.overwrite("name", convert_name_to_datum(
+        metadata.server_config.config.name));
+    builder.overwrite("id", convert_uuid_to_datum(server_id.get_uuid()));
+
+    *row_out = std::move(builder).to_datum();
+    return true;
+}
+
+// The sum of the curves of a table's shards.
+struct table_curve_t {
+    table_curve_t()
+        : memory_limit(0), accesses(0), hits_at_memory_limit(0),
+          hits(alt::miss_ratio_curve_t::NUM_CACHE_SIZES, 0.0), num_shards(0) { }
+    double memory_limit;
+    double accesses;
+    double hits_at_memory_limit;
+    std::vector<double> hits;
+    size_t num_shards;
+};
+
+// Adds the curve that a shard's cache reports as "miss_ratio_curve" to `table_out`.
+// Skips curves that don't look like they should.
+static void add_shard_curve(const ql::datum_t &curve, table_curve_t *table_out) {
+    if (curve.get_type() != ql::datum_t::R_OBJECT) {
+        return;
+    }
+    ql::datum_t memory_limit = curve.get_field("memory_limit", ql::NOTHROW);
+    ql::datum_t accesses = curve.get_field("accesses", ql::NOTHROW);
+    ql::datum_t hits = curve.get_field("hits", ql::NOTHROW);
+    if (!memory_limit.has() || memory_limit.get_type() != ql::datum_t::R_NUM
+            || !accesses.has() || accesses.get_type() != ql::datum_t::R_NUM
+            || !hits.has() || hits.get_type() != ql::datum_t::R_ARRAY
+            || hits.arr_size() != alt::miss_ratio_curve_t::NUM_CACHE_SIZES) {
+        return;
+    }
+    std::vector<double> shard_hits;
+    for (size_t i = 0; i < hits.arr_size(); ++i) {
+        ql::datum_t h = hits.get(i);
+        if (h.get_type() != ql::datum_t::R_NUM) {
+            return;
+        }
+        shard_hits.push_back(h.as_num());
+    }
+
+    table_out->memory_limit += memory_limit.as_num();
+    table_out->accesses += accesses.as_num();
+    table_out->hits_at_memory_limit += alt::miss_ratio_curve_t::hits_for_cache_size(
+        shard_hits, static_cast<uint64_t>(memory_limit.as_num()));
+    for (size_t i = 0; i < shard_hits.size(); ++i) {
+        table_out->hits[i] += shard_hits[i];
+    }
+    ++table_out->num_shards;
+}
+
+static ql::datum_t table_curve_to_datum(const table_curve_t &table) {
+    ql::datum_object_builder_t builder;
+    builder.overwrite("memory_limit", ql::datum_t(table.memory_limit));
+    builder.overwrite("accesses", ql::datum_t(table.accesses));
+    if (table.accesses > 0) {
+        builder.overwrite("hit_rate",
+            ql::datum_t(table.hits_at_memory_limit / table.accesses));
+    } else {
+        builder.overwrite("hit_rate", ql::datum_t::null());
+    }
+    ql::datum_array_builder_t curve(ql::configured_limits_t::unlimited);
+    if (table.accesses > 0) {
+        for (size_t i = 0; i < table.hits.size(); ++i) {
+            ql::datum_object_builder_t point;
+            point.overwrite("cache_bytes", ql::datum_t(static_cast<double>(
+                alt::miss_ratio_curve_t::cache_size_at(i) * table.num_shards)));
+            point.overwrite("hit_rate", ql::datum_t(table.hits[i] / table.accesses));
+            curve.add(std::move(point).to_datum());
+        }
+    }
+    builder.overwrite("curve", std::move(curve).to_datum());
+    return std::move(builder).to_datum();
+}
+
+bool debug_cache_curves_artificial_table_backend_t::curves_for_server(
+        cluster_directory_metadata_t const & metadata,
+        signal_t *interruptor_on_home,
+        ql::datum_t *tables_out,
+        admin_err_t *error_out) {
+    if (metadata.get_stats_mailbox_address.is_nil()) {
+        *error_out = admin_err_t{"Server is not connected.", query_state_t::FAILED};
+        return false;
+    }
+
+    std::set<std::vector<stat_manager_t::stat_id_t> > filter;
+    filter.insert(std::vector<stat_manager_t::stat_id_t>(
+        {"[0-9A-Fa-f-]+", "serializers", "shard_[0-9]+", "cache", "miss_ratio_curve"}));
+
+    ql::datum_t stats;
+    if (!fetch_stats_from_server(
+            mailbox_manager,
+            metadata.get_stats_mailbox_address,
+            filter,
+            interruptor_on_home,
+            &stats,
+            error_out)) {
+        return false;
+    }
+    r_sanity_check(stats.get_type() == ql::datum_t::R_OBJECT);
+
+    ql::datum_object_builder_t builder;
+    for (size_t i = 0; i < stats.obj_size(); ++i) {
+        std::pair<datum_string_t, ql::datum_t> table_pair = stats.get_pair(i);
+        namespace_id_t table_id;
+        if (!str_to_uuid(table_pair.first.to_std(), &table_id)
+                || table_pair.second.get_type() != ql::datum_t::R_OBJECT) {
+            continue;
+        }
+        ql::datum_t shards = table_pair.second.get_field("serializers", ql::NOTHROW);
+        if (!shards.has() || shards.get_type() != ql::datum_t::R_OBJECT) {
+            continue;
+        }
+        table_curve_t table;
+        for (size_t j = 0; j < shards.obj_size(); ++j) {
+            ql::datum_t shard = shards.get_pair(j).second;
+            if (shard.get_type() != ql::datum_t::R_OBJECT) {
+                continue;
+            }
+            ql::datum_t cache = shard.get_field("cache", ql::NOTHROW);
+            if (!cache.has() || cache.get_type() != ql::datum_t::R_OBJECT) {
+                continue;
+            }
+            ql::datum_t curve = cache.get_field("miss_ratio_curve", ql::NOTHROW);
+            if (curve.has()) {
+                add_shard_curve(curve, &table);
+            }
+        }
+        if (table.num_shards > 0) {
+            builder.overwrite(table_pair.first, table_curve_to_datum(table));
+        }
+    }
+    *tables_out = std::move(builder).to_datum();
+    return true;
+}
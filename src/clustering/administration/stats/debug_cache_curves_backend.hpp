@@ -0,0 +1,56 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CLUSTERING_ADMINISTRATION_STATS_DEBUG_CACHE_CURVES_BACKEND_HPP_
+#define CLUSTERING_ADMINISTRATION_STATS_DEBUG_CACHE_CURVES_BACKEND_HPP_
+
+#include "clustering/administration/metadata.hpp"
+#include "clustering/administration/servers/server_common.hpp"
+#include "rdb_protocol/artificial_table/backend.hpp"
+
+class server_config_client_t;
+
+/* `rethinkdb._debug_cache_curves` has one row per connected server, showing the miss
+ratio curves that the cache balancer sizes that server's table caches by. Each table's
+`curve` adds up the curves of its shards' caches: every point gives the hit rate the
+table's recent accesses would have had if each of its shards had had an equal part of
+`cache_bytes`. The curves are fetched through the servers' stats mailboxes, where each
+shard's cache reports its curve as "miss_ratio_curve". */
+class debug_cache_curves_artificial_table_backend_t :
+    public common_server_artificial_table_backend_t
+{
+public:
+    debug_cache_curves_artificial_table_backend_t(
+            rdb_context_t *rdb_context,
+            lifetime_t<name_resolver_t const &> name_resolver,
+            watchable_map_t<peer_id_t, cluster_directory_metadata_t> *_directory,
+            server_config_client_t *_server_config_client,
+            mailbox_manager_t *_mailbox_manager);
+    ~debug_cache_curves_artificial_table_backend_t();
+
+    bool write_row(
+            auth::user_context_t const &user_context,
+            ql::datum_t primary_key,
+            bool pkey_was_autogenerated,
+            ql::datum_t *new_value_inout,
+            signal_t *interruptor_on_caller,
+            admin_err_t *error_out);
+
+private:
+    bool format_row(
+            auth::user_context_t const &user_context,
+            server_id_t const & server_id,
+            peer_id_t const & peer_id,
+            cluster_directory_metadata_t const & metadata,
+            signal_t *interruptor_on_home,
+            ql::datum_t *row_out,
+            admin_err_t *error_out);
+
+    bool curves_for_server(
+            cluster_directory_metadata_t const & metadata,
+            signal_t *interruptor_on_home,
+            ql::datum_t *tables_out,
+            admin_err_t *error_out);
+
+    mailbox_manager_t *mailbox_manager;
+};
+
+#endif /* CLUSTERING_ADMINISTRATION_STATS_DEBUG_CACHE_CURVES_BACKEND_HPP_ */
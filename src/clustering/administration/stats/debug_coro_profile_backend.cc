@@ -0,0 +1,160 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "clustering/administration/stats/debug_coro_profile_backend.hpp"
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "arch/runtime/coro_sampler.hpp"
+#include "clustering/administration/datum_adapter.hpp"
+#include "clustering/administration/servers/config_client.hpp"
+#include "clustering/administration/stats/stat_manager.hpp"
+#include "concurrency/cross_thread_signal.hpp"
+
+debug_coro_profile_artificial_table_backend_t::debug_coro_profile_artificial_table_backend_t(
+        rdb_context_t *rdb_context,
+        lifetime_t<name_resolver_t const &> name_resolver,
+        watchable_map_t<peer_id_t, cluster_directory_metadata_t> *_directory_view,
+        server_config_client_t *_server_config_client,
+        mailbox_manager_t *_mailbox_manager)
+    : common_server_artificial_table_backend_t(
+        name_string_t::guarantee_valid("_debug_coro_profile"),
+        rdb_context,
+        name_resolver,
+        _server_config_client,
+        _directory_view),
+      mailbox_manager(_mailbox_manager) {
+}
+
+debug_coro_profile_artificial_table_backend_t::~debug_coro_profile_artificial_table_backend_t() {
+    begin_changefeed_destruction();
+}
+
+bool debug_coro_profile_artificial_table_backend_t::write_row(
+        auth::user_context_t const &user_context,
+        ql::datum_t primary_key,
+        UNUSED bool pkey_was_autogenerated,
+        ql::datum_t *new_value_inout,
+        signal_t *interruptor_on_caller,
+        admin_err_t *error_out) {
+    user_context.require_admin_user();
+
+    cross_thread_signal_t interruptor_on_home(interruptor_on_caller, home_thread());
+    on_thread_t thread_switcher(home_thread());
+    server_id_t server_id;
+    peer_id_t peer_id;
+    cluster_directory_metadata_t metadata;
+    if (!lookup(primary_key, &server_id, &peer_id, &metadata)) {
+        *error_out = admin_err_t{
+            "It's illegal to insert new rows into the `rethinkdb._debug_coro_profile` "
+            "table.",
+            query_state_t::FAILED};
+        return false;
+    }
+    if (!new_value_inout->has()) {
+        *error_out = admin_err_t{
+            "It's illegal to delete rows from the `rethinkdb._debug_coro_profile` "
+            "table.",
+            query_state_t::FAILED};
+        return false;
+    }
+    if (peer_id != mailbox_manager->get_me()) {
+        *error_out = admin_err_t{
+            strprintf("The coroutine profiler can only be turned on or off on the "
+                      "server that you are connected to. Connect to server `%s` to "
+                      "change its profiler.",
+                      metadata.server_config.config.name.c_str()),
+            query_state_t::FAILED};
+        return false;
+    }
+
+    ql::datum_t enabled = new_value_inout->get_field("enabled", ql::NOTHROW);
+    if (!enabled.has() || enabled.get_type() != ql::datum_t::R_BOOL) {
+        *error_out = admin_err_t{
+            "In `rethinkdb._debug_coro_profile`, `enabled` must be a boolean.",
+            query_state_t::FAILED};
+        return false;
+    }
+    int64_t sample_interval_nanos = coro_sampler_t::get_sample_interval_nanos();
+    ql::datum_t interval = new_value_inout->get_field("sample_interval_ms", ql::NOTHROW);
+    if (interval.has()) {
+        if (interval.get_type() != ql::datum_t::R_NUM
+                || !(interval.as_num() >= 0.001 && interval.as_num() <= 60000)) {
+            *error_out = admin_err_t{
+                "In `rethinkdb._debug_coro_profile`, `sample_interval_ms` must be a "
+                "number between 0.001 and 60000.",
+                query_state_t::FAILED};
+            return false;
+        }
+        sample_interval_nanos = static_cast<int64_t>(interval.as_num() * MILLION);
+    }
+
+    if (enabled.as_bool()) {
+        coro_sampler_t::enable(sample_interval_nanos);
+    } else {
+        coro_sampler_t::disable();
+    }
+    return true;
+}
+
+bool debug_coro_profile_artificial_table_backend_t::format_row(
+        auth::user_context_t const &user_context,
+        server_id_t const & server_id,
+        peer_id_t const & peer_id,
+        cluster_directory_metadata_t const & metadata,
+        signal_t *interruptor_on_home,
+        ql::datum_t *row_out,
+        UNUSED admin_err_t *error_out) {
+    user_context.require_admin_user();
+
+    ql::datum_t profile;
+    admin_err_t profile_error;
+    if (!profile_for_server(
+            peer_id, metadata, interruptor_on_home, &profile, &profile_error)) {
+        ql::datum_object_builder_t error_builder;
+        error_builder.overwrite(
+            "error", ql::datum_t(datum_string_t(profile_error.msg)));
+        profile = std::move(error_builder).to_datum();
+    }
+    ql::datum_object_builder_t builder(profile);
+    builder.overwrite("name", convert_name_to_datum(
+        metadata.server_config.config.name));
+    builder.overwrite("id", convert_uuid_to_datum(server_id.get_uuid()));
+
+    *row_out = std::move(builder).to_datum();
+    return true;
+}
+
+bool debug_coro_profile_artificial_table_backend_t::profile_for_server(
+        UNUSED peer_id_t const & peer_id,
+        cluster_directory_metadata_t const & metadata,
+        signal_t *interruptor_on_home,
+        ql::datum_t *profile_out,
+        admin_err_t *error_out) {
+    if (metadata.get_stats_mailbox_address.is_nil()) {
+        *error_out = admin_err_t{"Server is not connected.", query_state_t::FAILED};
+        return false;
+    }
+
+    std::set<std::vector<stat_manager_t::stat_id_t> > filter;
+    filter.insert(std::vector<stat_manager_t::stat_id_t>({"coro_profile"}));
+
+    ql::datum_t stats;
+    if (!fetch_stats_from_server(
+            mailbox_manager,
+            metadata.get_stats_mailbox_address,
+            filter,
+            interruptor_on_home,
+            &stats,
+            error_out)) {
+        return false;
+    }
+    *profile_out = stats.get_field("coro_profile", ql::NOTHROW);
+    if (!profile_out->has() || profile_out->get_type() != ql::datum_t::R_OBJECT) {
+        *error_out = admin_err_t{
+            "This server doesn't support the coroutine profiler.",
+            query_state_t::FAILED};
+        return false;
+    }
+    return true;
+}
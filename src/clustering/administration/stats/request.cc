@@ -39,7 +39,9 @@ parsed_stats_t::server_stats_t::server_stats_t() :
 parsed_stats_t::table_stats_t::table_stats_t() :
     read_docs_per_sec(0), read_docs_total(0),
     written_docs_per_sec(0), written_docs_total(0),
-    in_use_bytes(0), metadata_bytes(0), data_bytes(0),
+    in_use_bytes(0), protected_bytes(0), probationary_bytes(0),
+    protected_hits(0), probationary_hits(0), misses(0),
+    metadata_bytes(0), data_bytes(0),
     garbage_bytes(0), preallocated_bytes(0),
     read_bytes_per_sec(0), read_bytes_total(0),
     written_bytes_per_sec(0), written_bytes_total(0) { }
@@ -65,6 +67,10 @@ parsed_stats_t::parsed_stats_t(const std::vector<ql::datum_t> &stats) {
             std::pair<datum_string_t, ql::datum_t> perf_pair = s.get_pair(i);
             if (perf_pair.first == "query_engine") {
                 store_query_engine_stats(perf_pair.second, &serv_stats);
+            } else if (perf_pair.first == "disk") {
+                r_sanity_check(perf_pair.second.get_type() == ql::datum_t::R_OBJECT);
+                serv_stats.disk_latency = perf_pair.second.get_field(
+                    "latency", ql::throw_bool_t::NOTHROW);
             } else {
                 namespace_id_t table_id;
                 res = str_to_uuid(perf_pair.first.to_std(), &table_id);
@@ -125,6 +131,16 @@ void parsed_stats_t::store_shard_values(const ql::datum_t &shard_perf,
                 } else if (key == "cache") {
                     add_perfmon_value(sub_pair.second, "in_use_bytes",
                                       &stats_out->in_use_bytes);
+                    add_perfmon_value(sub_pair.second, "protected_bytes",
+                                      &stats_out->protected_bytes);
+                    add_perfmon_value(sub_pair.second, "probationary_bytes",
+                                      &stats_out->probationary_bytes);
+                    add_perfmon_value(sub_pair.second, "protected_hits",
+                                      &stats_out->protected_hits);
+                    add_perfmon_value(sub_pair.second, "probationary_hits",
+                                      &stats_out->probationary_hits);
+                    add_perfmon_value(sub_pair.second, "misses",
+                                      &stats_out->misses);
                 }
             }
         }
@@ -407,6 +423,7 @@ server_stats_request_t::server_stats_request_t(const server_id_t &_server_id) :
 std::set<std::vector<std::string> > server_stats_request_t::get_filter() const {
     return std::set<std::vector<std::string> >(
         { {"query_engine"},
+          {"disk", "latency"},
           {".*", "serializers", "shard_[0-9]+", "btree-.*" } });
 }
 
@@ -457,6 +474,14 @@ bool server_stats_request_t::to_datum(const parsed_stats_t &stats,
         ADD_SERVER_STAT(qe_builder, stats, server_id, written_docs_per_sec);
         ADD_SERVER_STAT(qe_builder, stats, server_id, written_docs_total);
         row_builder.overwrite("query_engine", std::move(qe_builder).to_datum());
+
+        if (server_stats.disk_latency.has()) {
+            ql::datum_object_builder_t se_disk_builder;
+            se_disk_builder.overwrite("latency", server_stats.disk_latency);
+            ql::datum_object_builder_t se_builder;
+            se_builder.overwrite("disk", std::move(se_disk_builder).to_datum());
+            row_builder.overwrite("storage_engine", std::move(se_builder).to_datum());
+        }
     }
     *result_out = std::move(row_builder).to_datum();
     return true;
@@ -552,6 +577,15 @@ bool table_server_stats_request_t::to_datum(const parsed_stats_t &stats,
 
         ql::datum_object_builder_t se_cache_builder;
         ADD_STAT(se_cache_builder, table_stats, in_use_bytes);
+        ADD_STAT(se_cache_builder, table_stats, protected_bytes);
+        ADD_STAT(se_cache_builder, table_stats, probationary_bytes);
+        // The fractions of the recent page accesses that hit each segment.
+        const double accesses = table_stats.protected_hits
+            + table_stats.probationary_hits + table_stats.misses;
+        se_cache_builder.overwrite("protected_hit_rate", ql::datum_t(
+            accesses == 0 ? 0.0 : table_stats.protected_hits / accesses));
+        se_cache_builder.overwrite("probationary_hit_rate", ql::datum_t(
+            accesses == 0 ? 0.0 : table_stats.probationary_hits / accesses));
 
         ql::datum_object_builder_t se_disk_space_builder;
         ADD_STAT(se_disk_space_builder, table_stats, metadata_bytes);
@@ -28,6 +28,12 @@ public:
         double written_docs_per_sec;
         double written_docs_total;
         double in_use_bytes;
+        double protected_bytes;
+        double probationary_bytes;
+        // Recent page accesses of the caches, see `evicter_t`.
+        double protected_hits;
+        double probationary_hits;
+        double misses;
         double metadata_bytes;
         double data_bytes;
         double garbage_bytes;
@@ -47,6 +53,10 @@ public:
         double client_connections;
         double clients_active;
 
+        // The server's disk latency histograms, split by I/O class, as reported
+        // by the `accounting_diskmgr_t`. Empty if they weren't requested.
+        ql::datum_t disk_latency;
+
         std::map<namespace_id_t, table_stats_t> tables;
     };
 
@@ -27,7 +27,7 @@ bool wait_for_table_readiness(
             try {
                 table_meta_client->get_shard_status(
                     table_id, all_replicas_ready_mode_t::INCLUDE_RAFT_TEST, interruptor,
-                    nullptr, &ok);
+                    nullptr, nullptr, &ok);
             } catch (const failed_table_op_exc_t &) {
                 ok = false;
             }
@@ -87,10 +87,12 @@ void get_table_status(
     try {
         table_meta_client->get_shard_status(
             table_id, all_replicas_ready_mode_t::EXCLUDE_RAFT_TEST, interruptor,
-            &status_out->server_shards, &all_replicas_ready);
+            &status_out->server_shards, &status_out->server_storage_files,
+            &all_replicas_ready);
     } catch (const failed_table_op_exc_t &) {
         all_replicas_ready = false;
         status_out->server_shards.clear();
+        status_out->server_storage_files.clear();
     }
 
     /* We need to pay special attention to servers that appear in the config but not in
@@ -57,6 +57,9 @@ public:
     table_config_and_shards_t config;
     std::map<server_id_t, range_map_t<key_range_t::right_bound_t,
         table_shard_status_t> > server_shards;
+    /* The files that each server in `server_shards` that has the table's data stores
+    it in */
+    std::map<server_id_t, std::vector<std::string> > server_storage_files;
     optional<server_id_t> raft_leader;
     std::set<server_id_t> disconnected;
     server_name_map_t server_names;
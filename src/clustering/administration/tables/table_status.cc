@@ -96,6 +96,22 @@ ql::datum_t convert_shard_status_to_datum(
     return std::move(shard_builder).to_datum();
 }
 
+ql::datum_t convert_storage_files_to_datum(
+        const server_id_t &server_id,
+        const std::vector<std::string> &files,
+        admin_identifier_format_t identifier_format,
+        const server_name_map_t &server_names) {
+    ql::datum_array_builder_t files_builder(ql::configured_limits_t::unlimited);
+    for (const std::string &file : files) {
+        files_builder.add(ql::datum_t(datum_string_t(file)));
+    }
+    ql::datum_object_builder_t builder;
+    builder.overwrite("server", convert_name_or_uuid_to_datum(
+        server_names.get(server_id), server_id.get_uuid(), identifier_format));
+    builder.overwrite("files", std::move(files_builder).to_datum());
+    return std::move(builder).to_datum();
+}
+
 ql::datum_t convert_raft_leader_to_datum(
         const table_status_t &status,
         admin_identifier_format_t identifier_format) {
@@ -116,6 +132,7 @@ ql::datum_t convert_table_status_to_datum(
 
     if (status.total_loss) {
         builder.overwrite("shards", ql::datum_t::null());
+        builder.overwrite("storage", ql::datum_t::null());
     } else {
         ql::datum_array_builder_t shards_builder(ql::configured_limits_t::unlimited);
         for (size_t i = 0; i < status.config.config.shards.size(); ++i) {
@@ -136,6 +153,13 @@ ql::datum_t convert_table_status_to_datum(
                 identifier_format, status.server_names));
         }
         builder.overwrite("shards", std::move(shards_builder).to_datum());
+
+        ql::datum_array_builder_t storage_builder(ql::configured_limits_t::unlimited);
+        for (const auto &pair : status.server_storage_files) {
+            storage_builder.add(convert_storage_files_to_datum(
+                pair.first, pair.second, identifier_format, status.server_names));
+        }
+        builder.overwrite("storage", std::move(storage_builder).to_datum());
     }
 
     // add raft leader information
@@ -1,6 +1,8 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "clustering/table_contract/cpu_sharding.hpp"
 
+#include "arch/runtime/numa.hpp"
+
 static const uint64_t CPU_SHARD_WIDTH = HASH_REGION_HASH_SIZE / CPU_SHARDING_FACTOR;
 
 region_t cpu_sharding_subspace(int subregion_number) {
@@ -32,3 +34,16 @@ int get_cpu_shard_approx_number(const region_t &region) {
     return region.beg / CPU_SHARD_WIDTH;
 }
 
+
+void allocate_cpu_shard_threads(
+        thread_allocator_t *allocator,
+        threadnum_t serializer_thread,
+        std::vector<scoped_ptr_t<thread_allocation_t> > *threads_out) {
+    const int node = get_thread_numa_node(serializer_thread);
+    for (size_t i = 0; i < CPU_SHARDING_FACTOR; ++i) {
+        threads_out->emplace_back(new thread_allocation_t(allocator,
+            [&](threadnum_t thread) {
+                return node == -1 || get_thread_numa_node(thread) == node;
+            }));
+    }
+}
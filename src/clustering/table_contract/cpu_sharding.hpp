@@ -2,11 +2,17 @@
 #ifndef CLUSTERING_TABLE_CONTRACT_CPU_SHARDING_HPP_
 #define CLUSTERING_TABLE_CONTRACT_CPU_SHARDING_HPP_
 
+#include <string>
+#include <vector>
+
 #include "clustering/immediate_consistency/history.hpp"
+#include "containers/scoped.hpp"
 #include "protocol_api.hpp"
 #include "region/region.hpp"
 
 class store_t;
+class thread_allocation_t;
+class thread_allocator_t;
 
 /* Changing this number would break backwards compatibility in the disk format. */
 #define CPU_SHARDING_FACTOR 8
@@ -25,6 +31,15 @@ int get_cpu_shard_number(const region_t &region);
 input doesn't correspond exactly to a CPU shard, it returns an estimate. */
 int get_cpu_shard_approx_number(const region_t &region);
 
+/* `allocate_cpu_shard_threads()` picks a thread for each of the CPU_SHARDING_FACTOR
+stores of a table whose serializer is on `serializer_thread`. If the thread pool
+has placed its threads on NUMA nodes, it picks threads on the serializer thread's
+node, so that the stores' caches and the serializer's buffers share a node. */
+void allocate_cpu_shard_threads(
+    thread_allocator_t *allocator,
+    threadnum_t serializer_thread,
+    std::vector<scoped_ptr_t<thread_allocation_t> > *threads_out);
+
 /* `multistore_ptr_t` is a bundle of `store_view_t`s, one for each CPU shard. The rule
 is that `get_cpu_sharded_store(i)->get_region() == cpu_sharding_subspace(i)`. The
 individual stores' home threads may be different from the `multistore_ptr_t`'s home
@@ -41,6 +56,12 @@ public:
     it can create and destroy sindexes on them. The `table_contract` code should never
     use it, and some unit tests will return `nullptr` from here. */
     virtual store_t *get_underlying_store(size_t i) = 0;
+
+    /* Returns the paths of the files that the table's data is stored in. */
+    virtual std::vector<std::string> get_storage_files() = 0;
+
+    /* Starts compacting the files (see `serializer_t::start_compaction()`). */
+    virtual void start_compaction() = 0;
 };
 
 #endif /* CLUSTERING_TABLE_CONTRACT_CPU_SHARDING_HPP_ */
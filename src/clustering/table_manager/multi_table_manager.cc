@@ -95,6 +95,7 @@ multi_table_manager_t::~multi_table_manager_t() {
     /* First, shut out further mailbox events or watchable callbacks. This ensures that
     tables are not created or destroyed, nor are their states changed (active vs.
     inactive vs. deleted). */
+    compact_mailbox.reset();
     get_status_mailbox.reset();
     action_mailbox.reset();
     table_manager_directory_subs.reset();
@@ -261,6 +262,10 @@ void multi_table_manager_t::help_construct() {
     get_status_mailbox.init(new multi_table_manager_bcard_t::get_status_mailbox_t(
         mailbox_manager,
         std::bind(&multi_table_manager_t::on_get_status, this, ph::_1, ph::_2)));
+
+    compact_mailbox.init(new multi_table_manager_bcard_t::compact_mailbox_t(
+        mailbox_manager,
+        std::bind(&multi_table_manager_t::on_compact, this, ph::_1, ph::_2)));
 }
 
 void multi_table_manager_t::on_action(
@@ -554,6 +559,29 @@ void multi_table_manager_t::on_get_status(
     send(mailbox_manager, reply_addr, responses);
 }
 
+void multi_table_manager_t::on_compact(
+        signal_t *interruptor,
+        const multi_table_manager_bcard_t::compact_message_t &msg) {
+    std::map<namespace_id_t, std::vector<std::string> > files;
+    for (const namespace_id_t &table_id : msg.table_ids) {
+        visit_table(table_id, interruptor, access_t::read,
+        [&](multistore_ptr_t *multistore_ptr, table_manager_t *) {
+            if (multistore_ptr != nullptr) {
+                multistore_ptr->start_compaction();
+                files[table_id] = multistore_ptr->get_storage_files();
+            }
+        });
+    }
+    if (!files.empty()) {
+        /* The compaction shows up as a "disk_compaction" job while the garbage
+        collector works on it, and each file logs how much smaller it got once it's
+        done. */
+        logNTC("Compacting the data files of %zu table%s.\n",
+               files.size(), files.size() == 1 ? "" : "s");
+    }
+    send(mailbox_manager, msg.reply_addr, files);
+}
+
 void multi_table_manager_t::do_sync(
         const namespace_id_t &table_id,
         const table_t &table,
@@ -96,6 +96,7 @@ public:
         multi_table_manager_bcard_t bcard;
         bcard.action_mailbox = action_mailbox->get_address();
         bcard.get_status_mailbox = get_status_mailbox->get_address();
+        bcard.compact_mailbox = compact_mailbox->get_address();
         bcard.server_id = server_id;
         return bcard;
     }
@@ -335,6 +336,10 @@ private:
         signal_t *interruptor,
         const multi_table_manager_bcard_t::get_status_message_t &msg);
 
+    void on_compact(
+        signal_t *interruptor,
+        const multi_table_manager_bcard_t::compact_message_t &msg);
+
     /* `do_sync()` checks if it is necessary to send an action message to the given
     server regarding the given table, and sends one if so. It is called in the following
     situations:
@@ -427,6 +432,7 @@ private:
 
     scoped_ptr_t<multi_table_manager_bcard_t::action_mailbox_t> action_mailbox;
     scoped_ptr_t<multi_table_manager_bcard_t::get_status_mailbox_t> get_status_mailbox;
+    scoped_ptr_t<multi_table_manager_bcard_t::compact_mailbox_t> compact_mailbox;
 };
 
 #endif /* CLUSTERING_TABLE_MANAGER_MULTI_TABLE_MANAGER_HPP_ */
@@ -29,6 +29,7 @@ table_manager_t::table_manager_t(
     mailbox_manager(_mailbox_manager),
     server_config_client(_server_config_client),
     connections_map(_connections_map),
+    storage_files(multistore_ptr->get_storage_files()),
     perfmon_membership(perfmon_collection_namespace, &perfmon_collection, "regions"),
     raft(raft_member_id, _mailbox_manager, raft_directory.get_values(), raft_storage,
         "Table " + uuid_to_str(table_id), start_election_immediately),
@@ -138,6 +139,9 @@ void table_manager_t::get_status(
     if (request.want_shard_status) {
         response->shard_status = contract_executor.get_shard_status();
     }
+    if (request.want_storage_files) {
+        response->storage_files = storage_files;
+    }
     if (request.want_all_replicas_ready) {
         switch (request.all_replicas_ready_mode) {
         case all_replicas_ready_mode_t::EXCLUDE_RAFT_TEST: {
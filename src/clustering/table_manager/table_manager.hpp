@@ -105,6 +105,10 @@ private:
     watchable_map_t<std::pair<server_id_t, server_id_t>, empty_value_t>
         * const connections_map;
 
+    /* The files that our `multistore_ptr_t` stores the table's data in, for
+    `get_status()` */
+    const std::vector<std::string> storage_files;
+
     perfmon_collection_t perfmon_collection;
     perfmon_membership_t perfmon_membership;
 
@@ -199,6 +199,7 @@ void table_meta_client_t::get_shard_status(
         signal_t *interruptor_on_caller,
         std::map<server_id_t, range_map_t<key_range_t::right_bound_t,
             table_shard_status_t> > *shard_statuses_out,
+        std::map<server_id_t, std::vector<std::string> > *storage_files_out,
         bool *all_replicas_ready_out)
         THROWS_ONLY(interrupted_exc_t, no_such_table_exc_t, failed_table_op_exc_t) {
     cross_thread_signal_t interruptor(interruptor_on_caller, home_thread());
@@ -206,6 +207,7 @@ void table_meta_client_t::get_shard_status(
     *all_replicas_ready_out = false;
     table_status_request_t request;
     request.want_shard_status = (shard_statuses_out != nullptr);
+    request.want_storage_files = (storage_files_out != nullptr);
     request.want_all_replicas_ready = true;
     request.all_replicas_ready_mode = all_replicas_ready_mode;
     std::set<namespace_id_t> failures;
@@ -214,7 +216,7 @@ void table_meta_client_t::get_shard_status(
         request,
         /* If we only care about `all_replicas_ready`, there's no need to contact any
         server other than the primary */
-        shard_statuses_out != nullptr
+        shard_statuses_out != nullptr || storage_files_out != nullptr
             ? server_selector_t::EVERY_SERVER
             : server_selector_t::BEST_SERVER_ONLY,
         &interruptor,
@@ -224,6 +226,10 @@ void table_meta_client_t::get_shard_status(
                 shard_statuses_out->insert(
                     std::make_pair(server_id, response.shard_status));
             }
+            if (storage_files_out != nullptr) {
+                storage_files_out->insert(
+                    std::make_pair(server_id, response.storage_files));
+            }
             *all_replicas_ready_out |= response.all_replicas_ready;
         },
         &failures);
@@ -773,6 +779,62 @@ void table_meta_client_t::get_status(
     *failures_out = std::move(tables_todo);
 }
 
+void table_meta_client_t::compact(
+        const std::set<namespace_id_t> &table_ids,
+        signal_t *interruptor_on_caller,
+        std::map<server_id_t, std::map<namespace_id_t, std::vector<std::string> > >
+            *files_out,
+        std::set<namespace_id_t> *failures_out)
+        THROWS_ONLY(interrupted_exc_t) {
+    cross_thread_signal_t interruptor(interruptor_on_caller, home_thread());
+    on_thread_t thread_switcher(home_thread());
+
+    /* As in `get_status()` with `server_selector_t::EVERY_SERVER`, we send a message to
+    every server that has a `table_manager_bcard_t` for any of the tables. */
+    std::set<namespace_id_t> tables_todo = table_ids;
+    std::map<peer_id_t, std::set<namespace_id_t> > targets;
+    table_manager_directory->read_all(
+    [&](const std::pair<peer_id_t, namespace_id_t> &key,
+            const table_manager_bcard_t *) {
+        if (table_ids.count(key.second) == 1) {
+            targets[key.first].insert(key.second);
+        }
+    });
+
+    pmap(targets.begin(), targets.end(),
+    [&](const std::pair<peer_id_t, std::set<namespace_id_t> > &target) {
+        optional<multi_table_manager_bcard_t> bcard =
+            multi_table_manager_directory->get_key(target.first);
+        if (!bcard.has_value()) {
+            return;
+        }
+        disconnect_watcher_t dw(mailbox_manager, bcard->compact_mailbox.get_peer());
+        cond_t got_ack;
+        mailbox_t<std::map<namespace_id_t, std::vector<std::string> > >
+        ack_mailbox(mailbox_manager,
+            [&](signal_t *,
+                    const std::map<namespace_id_t, std::vector<std::string> > &resp) {
+                if (!resp.empty()) {
+                    (*files_out)[bcard->server_id] = resp;
+                }
+                for (const auto &pair : resp) {
+                    tables_todo.erase(pair.first);
+                }
+                got_ack.pulse();
+            });
+        send(mailbox_manager, bcard->compact_mailbox,
+             {target.second, ack_mailbox.get_address()});
+        wait_any_t waiter(&dw, &interruptor, &got_ack);
+        waiter.wait_lazily_unordered();
+    });
+
+    if (interruptor.is_pulsed()) {
+        throw interrupted_exc_t();
+    }
+
+    *failures_out = std::move(tables_todo);
+}
+
 void table_meta_client_t::retry(
         const std::function<void(signal_t *)> &fun,
         signal_t *interruptor) {
@@ -136,13 +136,16 @@ public:
 
     /* `get_shard_status()` returns some of the information necessary to fill in the
     `rethinkdb.table_status` system table. If `server_shards_out` is set to `nullptr`, it
-    that information will not be retrieved, which will improve performance. */
+    that information will not be retrieved, which will improve performance. The same
+    goes for `storage_files_out`, which gets the files that each server stores the
+    table's data in. */
     void get_shard_status(
         const namespace_id_t &table_id,
         all_replicas_ready_mode_t all_replicas_ready_mode,
         signal_t *interruptor,
         std::map<server_id_t, range_map_t<key_range_t::right_bound_t,
             table_shard_status_t> > *shard_statuses_out,
+        std::map<server_id_t, std::vector<std::string> > *storage_files_out,
         bool *all_replicas_ready_out)
         THROWS_ONLY(interrupted_exc_t, no_such_table_exc_t, failed_table_op_exc_t);
 
@@ -207,6 +210,18 @@ public:
         THROWS_ONLY(interrupted_exc_t, no_such_table_exc_t, failed_table_op_exc_t,
             maybe_failed_table_op_exc_t);
 
+    /* `compact()` makes every server that hosts any of the given tables start
+    compacting the table's files. `files_out` gets the files that each server is
+    compacting, by table. The tables that no server could be reached for go into
+    `failures_out`. */
+    void compact(
+        const std::set<namespace_id_t> &table_ids,
+        signal_t *interruptor,
+        std::map<server_id_t, std::map<namespace_id_t, std::vector<std::string> > >
+            *files_out,
+        std::set<namespace_id_t> *failures_out)
+        THROWS_ONLY(interrupted_exc_t);
+
 private:
     typedef std::pair<table_basic_config_t, multi_table_manager_timestamp_t>
         timestamped_basic_config_t;
@@ -14,12 +14,12 @@ RDB_IMPL_SERIALIZABLE_6_FOR_CLUSTER(
     table_manager_bcard_t,
     leader, timestamp, raft_member_id, raft_business_card,
     execution_bcard_minidir_bcard, server_id);
-RDB_IMPL_SERIALIZABLE_7_FOR_CLUSTER(table_status_request_t,
+RDB_IMPL_SERIALIZABLE_8_FOR_CLUSTER(table_status_request_t,
     want_config, want_sindexes, want_raft_state, want_contract_acks, want_shard_status,
-    want_all_replicas_ready, all_replicas_ready_mode);
-RDB_IMPL_SERIALIZABLE_7_FOR_CLUSTER(table_status_response_t,
+    want_storage_files, want_all_replicas_ready, all_replicas_ready_mode);
+RDB_IMPL_SERIALIZABLE_8_FOR_CLUSTER(table_status_response_t,
     config, sindexes, raft_state, raft_state_timestamp, contract_acks, shard_status,
-    all_replicas_ready);
+    storage_files, all_replicas_ready);
 
 RDB_IMPL_SERIALIZABLE_8_FOR_CLUSTER(
     multi_table_manager_bcard_t::action_message_t,
@@ -28,9 +28,12 @@ RDB_IMPL_SERIALIZABLE_8_FOR_CLUSTER(
 RDB_IMPL_SERIALIZABLE_3_FOR_CLUSTER(
     multi_table_manager_bcard_t::get_status_message_t,
     table_ids, request, reply_addr);
-RDB_IMPL_SERIALIZABLE_3_FOR_CLUSTER(
+RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(
+    multi_table_manager_bcard_t::compact_message_t,
+    table_ids, reply_addr);
+RDB_IMPL_SERIALIZABLE_4_FOR_CLUSTER(
     multi_table_manager_bcard_t,
-    action_mailbox, get_status_mailbox, server_id);
+    action_mailbox, get_status_mailbox, compact_mailbox, server_id);
 
 RDB_IMPL_SERIALIZABLE_2_SINCE_v2_1(table_active_persistent_state_t,
     epoch, raft_member_id);
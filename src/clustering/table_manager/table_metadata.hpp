@@ -109,7 +109,7 @@ public:
     table_status_request_t() :
         want_config(false), want_sindexes(false), want_raft_state(false),
         want_contract_acks(false), want_shard_status(false),
-        want_all_replicas_ready(false),
+        want_storage_files(false), want_all_replicas_ready(false),
         all_replicas_ready_mode(all_replicas_ready_mode_t::INCLUDE_RAFT_TEST) { }
 
     bool want_config;
@@ -117,6 +117,7 @@ public:
     bool want_raft_state;
     bool want_contract_acks;
     bool want_shard_status;
+    bool want_storage_files;
     bool want_all_replicas_ready;
     all_replicas_ready_mode_t all_replicas_ready_mode;
 };
@@ -149,6 +150,10 @@ public:
     /* `shard_status` is controlled by `want_shard_status`. */
     range_map_t<key_range_t::right_bound_t, table_shard_status_t> shard_status;
 
+    /* `storage_files` is controlled by `want_storage_files`. It lists the files that
+    the responding server stores the table's data in. */
+    std::vector<std::string> storage_files;
+
     /* `all_replicas_ready` is controlled by `want_all_replicas_ready`. It will be set to
     `true` if the responding server is leader and can confirm that all backfills are
     completed, the status matches the config, etc. Otherwise it will be set to `false`.
@@ -202,6 +207,16 @@ public:
     typedef mailbox_t<get_status_message_t> get_status_mailbox_t;
     get_status_mailbox_t::address_t get_status_mailbox;
 
+    /* `compact_mailbox` makes the server start compacting the files of the tables that
+    it hosts among `table_ids`. It replies with the files of each of those tables. */
+    struct compact_message_t {
+        std::set<namespace_id_t> table_ids;
+        mailbox_t<std::map<namespace_id_t, std::vector<std::string> > >::address_t
+            reply_addr;
+    };
+    typedef mailbox_t<compact_message_t> compact_mailbox_t;
+    compact_mailbox_t::address_t compact_mailbox;
+
     /* The server ID of the server sending this business card. In theory you could figure
     it out from the peer ID, but this is way more convenient. Proxy servers will set this
     to `nil_uuid()`. */
@@ -214,6 +229,7 @@ ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(
     multi_table_manager_bcard_t::status_t::MAYBE_ACTIVE);
 RDB_DECLARE_SERIALIZABLE(multi_table_manager_bcard_t::action_message_t);
 RDB_DECLARE_SERIALIZABLE(multi_table_manager_bcard_t::get_status_message_t);
+RDB_DECLARE_SERIALIZABLE(multi_table_manager_bcard_t::compact_message_t);
 RDB_DECLARE_SERIALIZABLE(multi_table_manager_bcard_t);
 
 class table_manager_bcard_t {
@@ -0,0 +1,182 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "concurrency/work_stealing.hpp"
+
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <vector>
+
+#include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/thread_pool.hpp"
+#include "concurrency/cond_var.hpp"
+#include "perfmon/perfmon.hpp"
+#include "rdb_protocol/datum.hpp"
+
+namespace work_stealing {
+
+struct counts_t {
+    counts_t() : stolen(0), stolen_from(0) { }
+    // Chunks that this thread ran for batches started on other threads.
+    int64_t stolen;
+    // Chunks of batches started on this thread that other threads ran.
+    int64_t stolen_from;
+};
+
+}  // namespace work_stealing
+
+/* Reports the steal counts as one array entry per thread. */
+class work_stealing_stats_t
+    : public perfmon_perthread_t<work_stealing::counts_t,
+                                 std::vector<work_stealing::counts_t> > {
+public:
+    static work_stealing_stats_t *get() {
+        static work_stealing_stats_t stats;
+        static perfmon_membership_t membership(
+            &get_global_perfmon_collection(), &stats, "work_stealing");
+        return &stats;
+    }
+
+    work_stealing::counts_t *local() {
+        return &thread_data[get_thread_id().threadnum].value;
+    }
+
+private:
+    typedef work_stealing::counts_t counts_t;
+
+    void get_thread_stat(counts_t *stat) {
+        *stat = *local();
+    }
+    std::vector<counts_t> combine_stats(const counts_t *stats) {
+        return std::vector<counts_t>(stats, stats + get_num_threads());
+    }
+    ql::datum_t output_stat(const std::vector<counts_t> &stats) {
+        std::vector<ql::datum_t> stolen, stolen_from;
+        for (const counts_t &c : stats) {
+            stolen.push_back(ql::datum_t(static_cast<double>(c.stolen)));
+            stolen_from.push_back(ql::datum_t(static_cast<double>(c.stolen_from)));
+        }
+        ql::datum_object_builder_t builder;
+        builder.overwrite("chunks_stolen", ql::datum_t(
+            std::move(stolen), ql::configured_limits_t::unlimited));
+        builder.overwrite("chunks_stolen_from", ql::datum_t(
+            std::move(stolen_from), ql::configured_limits_t::unlimited));
+        return std::move(builder).to_datum();
+    }
+
+    cache_line_padded_t<counts_t> thread_data[MAX_THREADS];
+};
+
+/* The state of one call to `run_stealable_batch()`. It's shared between the
+calling coroutine and the coroutines it invites onto other threads, which may
+only show up after the batch is done; so it's reference counted, and the
+pointers to the caller's stack are only followed by someone who holds an
+unfinished chunk. */
+class stealable_batch_t {
+public:
+    stealable_batch_t(size_t _count, size_t _chunk_size,
+                      const std::function<void(size_t, size_t)> *_fn,
+                      cond_t *_done)
+        : count(_count), chunk_size(_chunk_size),
+          num_chunks((_count + _chunk_size - 1) / _chunk_size),
+          fn(_fn), done(_done), home_thread(get_thread_id()),
+          next_chunk(0), chunks_left(num_chunks), exceptions(num_chunks) { }
+
+    /* Claims and runs chunks until there are none left to claim. Sets `*ran_out` to
+    the number of chunks that we ran. Returns true if we finished the last
+    outstanding chunk, in which case `done` has been pulsed. */
+    bool run_chunks(size_t *ran_out) {
+        size_t ran = 0;
+        for (;;) {
+            const size_t chunk = next_chunk.fetch_add(1);
+            if (chunk >= num_chunks) {
+                break;
+            }
+            const size_t begin = chunk * chunk_size;
+            try {
+                (*fn)(begin, std::min(begin + chunk_size, count));
+            } catch (...) {
+                exceptions[chunk] = std::current_exception();
+            }
+            ++ran;
+            if (chunks_left.fetch_sub(1) == 1) {
+                *ran_out = ran;
+                if (get_thread_id() == home_thread) {
+                    done->pulse();
+                } else {
+                    on_thread_t thread_switcher(home_thread);
+                    done->pulse();
+                }
+                return true;
+            }
+        }
+        *ran_out = ran;
+        return false;
+    }
+
+    void rethrow_first_exception() const {
+        for (const std::exception_ptr &e : exceptions) {
+            if (e) {
+                std::rethrow_exception(e);
+            }
+        }
+    }
+
+    const size_t count;
+    const size_t chunk_size;
+    const size_t num_chunks;
+
+private:
+    const std::function<void(size_t, size_t)> *const fn;
+    cond_t *const done;
+    const threadnum_t home_thread;
+
+    std::atomic<size_t> next_chunk;
+    std::atomic<size_t> chunks_left;
+    // Every chunk writes only its own entry.
+    std::vector<std::exception_ptr> exceptions;
+
+    DISABLE_COPYING(stealable_batch_t);
+};
+
+void run_stealable_batch(
+        size_t count, size_t chunk_size,
+        const std::function<void(size_t, size_t)> &fn,
+        const std::function<void(threadnum_t)> &prepare_thread) {
+    guarantee(chunk_size > 0);
+    if (count == 0) {
+        return;
+    }
+
+    cond_t done;
+    std::shared_ptr<stealable_batch_t> batch =
+        std::make_shared<stealable_batch_t>(count, chunk_size, &fn, &done);
+
+    // We keep one chunk for ourselves, and invite at most one thread for every other
+    // chunk.
+    size_t invitations = batch->num_chunks - 1;
+    const threadnum_t me = get_thread_id();
+    const int num_threads = get_num_threads();
+    linux_thread_pool_t *pool = linux_thread_pool_t::get_thread_pool();
+    for (int i = 1; i < num_threads && invitations > 0; ++i) {
+        const threadnum_t thread((me.threadnum + i) % num_threads);
+        if (!pool->threads[thread.threadnum]->message_hub.is_idle()) {
+            continue;
+        }
+        --invitations;
+        if (prepare_thread) {
+            prepare_thread(thread);
+        }
+        coro_t::spawn_on_thread([batch]() {
+            size_t ran;
+            batch->run_chunks(&ran);
+            work_stealing_stats_t::get()->local()->stolen += ran;
+        }, thread);
+    }
+
+    size_t ran;
+    if (!batch->run_chunks(&ran)) {
+        done.wait_lazily_unordered();
+    }
+    work_stealing_stats_t::get()->local()->stolen_from += batch->num_chunks - ran;
+    batch->rethrow_first_exception();
+}
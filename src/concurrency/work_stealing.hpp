@@ -0,0 +1,36 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CONCURRENCY_WORK_STEALING_HPP_
+#define CONCURRENCY_WORK_STEALING_HPP_
+
+#include <stddef.h>
+
+#include <functional>
+
+#include "threading.hpp"
+
+/* `run_stealable_batch()` is for CPU-heavy loops that don't care which thread they
+run on, such as evaluating a deterministic ReQL function on every element of a
+batch. It splits the indices `[0, count)` into chunks of `chunk_size` and calls
+`fn(begin, end)` once for each chunk. The calling coroutine works through the
+chunks itself, but it also invites threads that look idle to steal chunks from
+it, so a single big query doesn't leave the other cores sitting around.
+
+`fn` may be called concurrently on several threads and must only touch state that
+is safe to share between them; `get_thread_id()` tells it which thread it's on.
+`run_stealable_batch()` returns once every chunk has been processed. If any of
+the calls to `fn` throws, the exception from the chunk with the lowest indices
+is rethrown once all chunks are done.
+
+If `prepare_thread` is given, it's called on the calling thread with every thread
+that gets invited to steal chunks, before that thread can run any of them. That's
+where the caller can set up what `fn` needs on that thread.
+
+How many chunks every thread ran for other threads, and how many chunks every
+thread had stolen from it, is reported under "work_stealing" in the stats. */
+
+void run_stealable_batch(
+    size_t count, size_t chunk_size,
+    const std::function<void(size_t, size_t)> &fn,
+    const std::function<void(threadnum_t)> &prepare_thread = nullptr);
+
+#endif  // CONCURRENCY_WORK_STEALING_HPP_
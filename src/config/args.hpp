@@ -44,6 +44,30 @@
 // useful.
 #define DEFAULT_IO_BATCH_FACTOR                   1
 
+// The most disk requests that the IO layer merges into a single vectored read or
+// write.
+#define DISK_MERGE_MAX_OPS                        16
+
+// Reads that are at most this many bytes apart can still be merged. The gap
+// between them gets read into a scratch buffer and thrown away. Writes are only
+// merged if they are exactly adjacent.
+#define DISK_MERGE_MAX_READ_GAP                   (16 * KILOBYTE)
+
+// The largest read or write that the IO layer will create by merging requests.
+#define DISK_MERGE_MAX_SIZE                       (1 * MEGABYTE)
+
+// Latency targets (in milliseconds) of the disk account classes.  Once the oldest
+// queued operation of a class has been waiting for longer than its class's target,
+// that class gets served ahead of the others.  See `file_io_class_t`.
+#define INTERACTIVE_IO_LATENCY_TARGET_MS          2
+#define NORMAL_IO_LATENCY_TARGET_MS               100
+#define BACKGROUND_IO_LATENCY_TARGET_MS           1000
+
+// The disk latency histograms report on intervals of this many seconds.  The
+// interval needs to be long enough to see a thousand operations or so, or the
+// 99.9th percentile is just the maximum.
+#define DISK_LATENCY_HISTOGRAM_INTERVAL_SECS      10
+
 // I/O priority of index writes in the log serializer
 #define INDEX_WRITE_IO_PRIORITY                   128
 
@@ -72,6 +96,18 @@
 // Size of the device block size (in bytes)
 #define DEVICE_BLOCK_SIZE                         512
 
+// The page arena (see arch/page_arena.hpp) carves buffers of up to
+// PAGE_ARENA_MAX_BUFFER_SIZE bytes out of slabs the size of a huge page, in a
+// region of PAGE_ARENA_REGION_SIZE bytes of address space that it reserves up
+// front. Each thread keeps up to PAGE_ARENA_THREAD_CACHE_SIZE free buffers per
+// size class, and the arena keeps up to PAGE_ARENA_EMPTY_SLABS_KEPT empty slabs
+// before it returns their memory to the kernel.
+#define PAGE_ARENA_SLAB_SIZE                      (2 * MEGABYTE)
+#define PAGE_ARENA_MAX_BUFFER_SIZE                (64 * KILOBYTE)
+#define PAGE_ARENA_REGION_SIZE                    (256 * GIGABYTE)
+#define PAGE_ARENA_THREAD_CACHE_SIZE              64
+#define PAGE_ARENA_EMPTY_SLABS_KEPT               16
+
 // Size of each btree node (in bytes) on disk
 #define DEFAULT_BTREE_BLOCK_SIZE                  (4 * KILOBYTE)
 
@@ -117,15 +153,31 @@
 
 // If the size of the LBA on a given disk exceeds LBA_MIN_SIZE_FOR_GC, then the fraction of the
 // entries that are live and not garbage should be at least LBA_MIN_UNGARBAGE_FRACTION.
+// The LBA garbage collector rewrites a shard as a checkpoint: a dense list of its live
+// entries, sorted by block id. On startup we read the checkpoint plus the entries that
+// were appended since, so this fraction also bounds how long that tail can get
+// (a third of the checkpoint, at 0.75).
 #define LBA_MIN_SIZE_FOR_GC                       (MEGABYTE * 1)
-#define LBA_MIN_UNGARBAGE_FRACTION                0.5
+#define LBA_MIN_UNGARBAGE_FRACTION                0.75
 
 // I/O priority for LBA garbage collection
 #define LBA_GC_IO_PRIORITY                        8
 
+// If hole punching is on (see `set_hole_punching_rate()`), every
+// HOLE_PUNCHING_INTERVAL_MS the extent manager punches holes into some of the free
+// extents, with this I/O priority in the background I/O class.
+#define HOLE_PUNCHING_INTERVAL_MS                 100
+#define HOLE_PUNCHING_IO_PRIORITY                 8
+
 // How many block ids should the LBA garbage collector rewrite before yielding?
 #define LBA_GC_BATCH_SIZE                         (1024 * 8)
 
+// `rethinkdb compact` copies the live blocks of a file into the new file in batches
+// of about COMPACTION_BATCH_SIZE bytes, each written with one `block_writes()` call,
+// with up to COMPACTION_MAX_CONCURRENT_READS reads in flight to gather a batch.
+#define COMPACTION_BATCH_SIZE                     (8 * MEGABYTE)
+#define COMPACTION_MAX_CONCURRENT_READS           64
+
 // How many LBA structures to have for each file (This value defines the disk format!
 // It can't change unless you're very careful.)
 #define LBA_SHARD_FACTOR                          4
@@ -141,6 +193,10 @@
 // block infos.
 #define LBA_RECONSTRUCTION_BATCH_SIZE             1024
 
+// The in-memory LBA index is split into chunks of this many block ids, each of which
+// is allocated as a whole once any of its blocks exists.
+#define IN_MEMORY_INDEX_CHUNK_SIZE                16384
+
 #if defined (__powerpc64__)
 // getifaddrs() calls alloca() and it tries to allocate 64KB of memory
 // in stack frame. To avoid stack overflow, increasing the stack size
@@ -150,6 +206,10 @@
 #define COROUTINE_STACK_SIZE                      131072
 #endif
 
+// Coroutines that are known to only need a little stack space, such as the ones
+// running repeating timer callbacks, get a stack of this size instead.
+#define COROUTINE_SMALL_STACK_SIZE                65536
+
 
 /**
  * Message scheduler configuration
@@ -180,6 +240,20 @@
 // 2^(MESSAGE_SCHEDULER_MAX_PRIORITY - MESSAGE_SCHEDULER_MIN_PRIORITY + 1)
 #define MESSAGE_SCHEDULER_GRANULARITY           32
 
+// Messages from one thread to another go through a lock-free ring with room for
+// this many messages. If the receiving thread falls behind and the ring fills
+// up, the rest go onto a spinlock-protected overflow list.
+#define MESSAGE_RING_SIZE                       256
+
+// Every thread's timers are kept in a timing wheel with ticks of this many
+// nanoseconds. Timers ring at the first tick at or after their deadline.
+#define TIMER_WHEEL_TICK_NANOS                  1000000
+
+// ReQL transformations that evaluate a function on a batch of at least this many
+// elements let idle threads steal chunks of WORK_STEALING_CHUNK_SIZE elements.
+#define WORK_STEALING_MIN_BATCH_SIZE            64
+#define WORK_STEALING_CHUNK_SIZE                16
+
 // Priorities for specific tasks
 #define CORO_PRIORITY_SINDEX_CONSTRUCTION       (-2)
 #define CORO_PRIORITY_BACKFILL_SENDER           (-2)
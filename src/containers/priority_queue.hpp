@@ -54,6 +54,10 @@ public:
     void remove(entry_t *);
     T pop();
     void update(int);
+    /* \brief rebuild() restores the order in the queue after a change that
+     * affects the order of many elements at once
+     */
+    void rebuild();
 public:
     void validate();
 
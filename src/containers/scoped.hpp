@@ -6,6 +6,7 @@
 
 #include <utility>
 
+#include "arch/page_arena.hpp"
 #include "config/args.hpp"
 #include "errors.hpp"
 #include "memory_utils.hpp"
@@ -364,8 +365,9 @@ template <class T>
 TEMPLATE_ALIAS(scoped_page_aligned_ptr_t, scoped_alloc_t<T, raw_malloc_page_aligned, raw_free_aligned>);
 #endif
 
-// A type for device-block-aligned pointers
+// A type for device-block-aligned pointers. They come from the page arena, which
+// backs them with huge pages if it's turned on.
 template <class T>
-TEMPLATE_ALIAS(scoped_device_block_aligned_ptr_t, scoped_alloc_t<T, raw_malloc_aligned<DEVICE_BLOCK_SIZE>, raw_free_aligned>);
+TEMPLATE_ALIAS(scoped_device_block_aligned_ptr_t, scoped_alloc_t<T, page_arena_alloc, page_arena_free>);
 
 #endif  // CONTAINERS_SCOPED_HPP_
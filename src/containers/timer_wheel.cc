@@ -0,0 +1,180 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "containers/timer_wheel.hpp"
+
+#include <string.h>
+
+#include <algorithm>
+
+namespace {
+
+inline int level_shift(int level) {
+    return level * timer_wheel_t::LEVEL_BITS;
+}
+
+inline int slot_for_tick(int level, int64_t tick) {
+    return (tick >> level_shift(level)) & (timer_wheel_t::SLOTS_PER_LEVEL - 1);
+}
+
+// Nodes can be at most this many ticks ahead of the wheel's time.
+const int64_t MAX_DELTA =
+    (int64_t(1) << (timer_wheel_t::LEVEL_BITS * timer_wheel_t::NUM_LEVELS)) - 1;
+
+}  // namespace
+
+timer_wheel_t::timer_wheel_t(int64_t current_tick)
+    : next_tick(current_tick + 1), num_nodes(0) {
+    for (int i = 0; i < NUM_LEVELS; ++i) {
+        memset(levels[i].occupied, 0, sizeof(levels[i].occupied));
+    }
+}
+
+timer_wheel_t::~timer_wheel_t() {
+    guarantee(num_nodes == 0);
+}
+
+void timer_wheel_t::add(timer_wheel_node_t *node, int64_t deadline_tick) {
+    guarantee(!node->in_wheel());
+    node->deadline_tick = deadline_tick;
+    insert(node);
+    ++num_nodes;
+}
+
+void timer_wheel_t::remove(timer_wheel_node_t *node) {
+    intrusive_list_t<timer_wheel_node_t> *bucket = node->bucket;
+    guarantee(bucket != nullptr);
+    bucket->remove(node);
+    node->bucket = nullptr;
+    --num_nodes;
+
+    if (bucket != &due && bucket->empty()) {
+        for (int level = 0; level < NUM_LEVELS; ++level) {
+            level_t *l = &levels[level];
+            if (bucket >= l->slots && bucket < l->slots + SLOTS_PER_LEVEL) {
+                const int slot = bucket - l->slots;
+                l->occupied[slot / 64] &= ~(uint64_t(1) << (slot % 64));
+                return;
+            }
+        }
+        unreachable();
+    }
+}
+
+void timer_wheel_t::advance(int64_t tick) {
+    while (next_tick <= tick) {
+        int64_t event_tick;
+        if (!next_slot_event_tick(&event_tick) || event_tick > tick) {
+            break;
+        }
+        // Everything between here and the event is empty.
+        next_tick = std::max(next_tick, event_tick);
+        process_next_tick();
+    }
+    next_tick = std::max(next_tick, tick + 1);
+}
+
+timer_wheel_node_t *timer_wheel_t::pop_due() {
+    timer_wheel_node_t *node = due.head();
+    if (node != nullptr) {
+        due.remove(node);
+        node->bucket = nullptr;
+        --num_nodes;
+    }
+    return node;
+}
+
+bool timer_wheel_t::next_event_tick(int64_t *tick_out) const {
+    if (!due.empty()) {
+        *tick_out = get_current_tick();
+        return true;
+    }
+    return next_slot_event_tick(tick_out);
+}
+
+bool timer_wheel_t::next_slot_event_tick(int64_t *tick_out) const {
+    bool found = false;
+    for (int level = 0; level < NUM_LEVELS; ++level) {
+        // The first tick at or after `next_tick` where a slot of this level
+        // starts, counted in slots of this level.
+        const int64_t first_slot_start =
+            (next_tick + (int64_t(1) << level_shift(level)) - 1) >> level_shift(level);
+        const int start = first_slot_start & (SLOTS_PER_LEVEL - 1);
+        const int slot = find_occupied_slot(level, start);
+        if (slot == -1) {
+            continue;
+        }
+        const int64_t tick =
+            (first_slot_start + ((slot - start) & (SLOTS_PER_LEVEL - 1)))
+            << level_shift(level);
+        if (!found || tick < *tick_out) {
+            *tick_out = tick;
+            found = true;
+        }
+    }
+    return found;
+}
+
+void timer_wheel_t::insert(timer_wheel_node_t *node) {
+    const int64_t delta = node->deadline_tick - next_tick;
+    if (delta < 0) {
+        due.push_back(node);
+        node->bucket = &due;
+        return;
+    }
+    const int64_t tick = delta > MAX_DELTA ? next_tick + MAX_DELTA : node->deadline_tick;
+    int level = 0;
+    while (level < NUM_LEVELS - 1
+           && std::min(delta, MAX_DELTA) >= (int64_t(1) << level_shift(level + 1))) {
+        ++level;
+    }
+    const int slot = slot_for_tick(level, tick);
+    levels[level].slots[slot].push_back(node);
+    levels[level].occupied[slot / 64] |= uint64_t(1) << (slot % 64);
+    node->bucket = &levels[level].slots[slot];
+}
+
+void timer_wheel_t::cascade(int level, int slot) {
+    intrusive_list_t<timer_wheel_node_t> nodes;
+    nodes.append_and_clear(&levels[level].slots[slot]);
+    levels[level].occupied[slot / 64] &= ~(uint64_t(1) << (slot % 64));
+    while (timer_wheel_node_t *node = nodes.head()) {
+        nodes.remove(node);
+        insert(node);
+    }
+}
+
+void timer_wheel_t::process_next_tick() {
+    // Cascade the outer slots that start at this tick, outermost first.
+    for (int level = NUM_LEVELS - 1; level > 0; --level) {
+        if ((next_tick & ((int64_t(1) << level_shift(level)) - 1)) == 0) {
+            cascade(level, slot_for_tick(level, next_tick));
+        }
+    }
+
+    const int slot = slot_for_tick(0, next_tick);
+    intrusive_list_t<timer_wheel_node_t> *expired = &levels[0].slots[slot];
+    while (timer_wheel_node_t *node = expired->head()) {
+        rassert(node->deadline_tick == next_tick);
+        expired->remove(node);
+        due.push_back(node);
+        node->bucket = &due;
+    }
+    levels[0].occupied[slot / 64] &= ~(uint64_t(1) << (slot % 64));
+
+    ++next_tick;
+}
+
+int timer_wheel_t::find_occupied_slot(int level, int start) const {
+    const uint64_t *occupied = levels[level].occupied;
+    int word = start / 64;
+    uint64_t bits = occupied[word] & (~uint64_t(0) << (start % 64));
+    for (int i = 0; ; ++i) {
+        if (bits != 0) {
+            return word * 64 + __builtin_ctzll(bits);
+        }
+        if (i == BITMAP_WORDS) {
+            return -1;
+        }
+        word = (word + 1) % BITMAP_WORDS;
+        bits = occupied[word];
+    }
+}
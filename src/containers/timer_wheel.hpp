@@ -0,0 +1,123 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CONTAINERS_TIMER_WHEEL_HPP_
+#define CONTAINERS_TIMER_WHEEL_HPP_
+
+#include <stdint.h>
+
+#include "containers/intrusive_list.hpp"
+#include "errors.hpp"
+
+class timer_wheel_t;
+
+class timer_wheel_node_t : public intrusive_list_node_t<timer_wheel_node_t> {
+public:
+    bool in_wheel() const {
+        return bucket != nullptr;
+    }
+    int64_t get_deadline_tick() const {
+        return deadline_tick;
+    }
+
+protected:
+    timer_wheel_node_t() : deadline_tick(0), bucket(nullptr) { }
+    ~timer_wheel_node_t() {
+        rassert(bucket == nullptr);
+    }
+
+private:
+    friend class timer_wheel_t;
+
+    int64_t deadline_tick;
+    // The list of the wheel that the node is in, so it can be removed in O(1).
+    intrusive_list_t<timer_wheel_node_t> *bucket;
+
+    DISABLE_COPYING(timer_wheel_node_t);
+};
+
+/* `timer_wheel_t` is a hierarchical timing wheel (Varghese & Lauck). Time is
+measured in integer ticks. Nodes whose deadline is less than 256 ticks away sit
+in one of the 256 slots of the innermost level, one slot per tick; nodes that
+are further away sit in the slots of an outer level, where each slot covers 256
+times as many ticks as a slot of the level below. When the wheel's time reaches
+the start of an outer slot, that slot gets "cascaded": its nodes are put back
+into the wheel and end up on a lower level. Adding and removing a node is O(1),
+and every node gets cascaded at most once per level.
+
+`advance()` moves the wheel's time forward and puts every node whose deadline
+has passed on the "due" list, where `pop_due()` picks them up. Nodes are only
+ever moved to the due list when their deadline tick has been reached, never
+before. */
+class timer_wheel_t {
+public:
+    static const int LEVEL_BITS = 8;
+    static const int SLOTS_PER_LEVEL = 1 << LEVEL_BITS;
+    // With 1ms ticks, four levels reach about 49 days ahead. Nodes that are
+    // further away than that are put as far ahead as the outermost level
+    // reaches, and get cascaded back into it until their deadline is in range.
+    static const int NUM_LEVELS = 4;
+
+    // `current_tick` is the latest tick that counts as processed.
+    explicit timer_wheel_t(int64_t current_tick);
+    ~timer_wheel_t();
+
+    // If the deadline has already been reached, the node goes directly onto the due
+    // list.
+    void add(timer_wheel_node_t *node, int64_t deadline_tick);
+    // Removes a node from the wheel or from the due list.
+    void remove(timer_wheel_node_t *node);
+
+    // Processes every tick up to and including `tick`.
+    void advance(int64_t tick);
+
+    // Returns the next node on the due list, or `nullptr` if there is none.
+    timer_wheel_node_t *pop_due();
+
+    // Sets `*tick_out` to the earliest tick at which `advance()` may find a node
+    // that's due, and returns false if the wheel is empty. The tick may be
+    // earlier than any deadline if a cascade has to happen first; calling
+    // `advance()` later than that is fine too. If there already are due nodes,
+    // this is the current tick.
+    bool next_event_tick(int64_t *tick_out) const;
+
+    int64_t get_current_tick() const {
+        return next_tick - 1;
+    }
+    size_t size() const {
+        return num_nodes;
+    }
+    bool empty() const {
+        return num_nodes == 0;
+    }
+
+private:
+    static const int BITMAP_WORDS = SLOTS_PER_LEVEL / 64;
+
+    struct level_t {
+        intrusive_list_t<timer_wheel_node_t> slots[SLOTS_PER_LEVEL];
+        // Which of the slots are non-empty.
+        uint64_t occupied[BITMAP_WORDS];
+    };
+
+    void insert(timer_wheel_node_t *node);
+    void cascade(int level, int slot);
+    void process_next_tick();
+
+    // Like `next_event_tick()`, but ignores the due list.
+    bool next_slot_event_tick(int64_t *tick_out) const;
+
+    // Returns the first non-empty slot of the level, searching from `start` and
+    // wrapping around, or -1 if the level is empty.
+    int find_occupied_slot(int level, int start) const;
+
+    // All ticks before this one have been processed.
+    int64_t next_tick;
+
+    size_t num_nodes;
+
+    level_t levels[NUM_LEVELS];
+    intrusive_list_t<timer_wheel_node_t> due;
+
+    DISABLE_COPYING(timer_wheel_t);
+};
+
+#endif  // CONTAINERS_TIMER_WHEEL_HPP_
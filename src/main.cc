@@ -51,6 +51,8 @@ int main(int argc, char *argv[]) {
             return main_rethinkdb_index_rebuild(argc, argv);
         } else if (subcommand == "repl") {
             return main_rethinkdb_repl(argc, argv);
+        } else if (subcommand == "compact") {
+            return main_rethinkdb_compact(argc, argv);
 #ifdef _WIN32
         } else if (subcommand == "run-service") {
             return main_rethinkdb_run_service(argc, argv);
@@ -93,6 +95,8 @@ int main(int argc, char *argv[]) {
                     help_rethinkdb_index_rebuild();
                 } else if (subcommand2 == "repl") {
                     help_rethinkdb_repl();
+                } else if (subcommand2 == "compact") {
+                    help_rethinkdb_compact();
 #ifdef _WIN32
                 } else if (subcommand2 == "install-service") {
                     help_rethinkdb_install_service();
@@ -5,6 +5,7 @@
 
 #include <cmath>
 #include <map>
+#include <utility>
 
 #include "concurrency/pmap.hpp"
 #include "arch/arch.hpp"
@@ -16,6 +17,9 @@ static const char *stat_per_sec = "per_sec";
 static const char *stat_count = "count";
 static const char *stat_mean = "mean";
 static const char *stat_std_dev = "std_dev";
+static const char *stat_p50 = "p50";
+static const char *stat_p99 = "p99";
+static const char *stat_p999 = "p999";
 
 
 #ifdef FULL_PERFMON
@@ -67,6 +71,31 @@ scoped_perfmon_counter_t::~scoped_perfmon_counter_t() {
     --(*counter);
 }
 
+/* perfmon_counter_ratio_t */
+
+perfmon_counter_ratio_t::perfmon_counter_ratio_t(perfmon_counter_t *numerator,
+                                                 perfmon_counter_t *denominator)
+    : numerator_(numerator), denominator_(denominator) { }
+
+void *perfmon_counter_ratio_t::begin_stats() {
+    return new std::pair<void *, void *>(numerator_->begin_stats(),
+                                         denominator_->begin_stats());
+}
+
+void perfmon_counter_ratio_t::visit_stats(void *ctx) {
+    std::pair<void *, void *> *contexts = static_cast<std::pair<void *, void *> *>(ctx);
+    numerator_->visit_stats(contexts->first);
+    denominator_->visit_stats(contexts->second);
+}
+
+ql::datum_t perfmon_counter_ratio_t::end_stats(void *ctx) {
+    std::pair<void *, void *> *contexts = static_cast<std::pair<void *, void *> *>(ctx);
+    const double numerator = numerator_->end_stats(contexts->first).as_num();
+    const double denominator = denominator_->end_stats(contexts->second).as_num();
+    delete contexts;
+    return ql::datum_t(denominator == 0 ? 0.0 : numerator / denominator);
+}
+
 /* perfmon_sampler_t */
 
 perfmon_sampler_t::perfmon_sampler_t(ticks_t _length, bool _include_rate)
@@ -302,6 +331,146 @@ ql::datum_t perfmon_rate_monitor_t::output_stat(const double &stat) {
     return ql::datum_t(stat / ticks_to_secs(length));
 }
 
+/* perfmon_histogram_t */
+
+namespace perfmon_histogram {
+
+int bucket_for_value(int64_t value) {
+    if (value < (1 << sub_bucket_bits)) {
+        return std::max<int64_t>(value, 0);
+    }
+    const int msb = 63 - __builtin_clzll(value);
+    const int64_t sub_bucket =
+        (value >> (msb - sub_bucket_bits)) & ((1 << sub_bucket_bits) - 1);
+    const int64_t bucket =
+        ((msb - sub_bucket_bits + 1) << sub_bucket_bits) + sub_bucket;
+    return std::min<int64_t>(bucket, num_buckets - 1);
+}
+
+int64_t bucket_lower_bound(int bucket) {
+    rassert(bucket >= 0 && bucket < num_buckets);
+    if (bucket < (1 << sub_bucket_bits)) {
+        return bucket;
+    }
+    const int octave = bucket >> sub_bucket_bits;
+    const int64_t sub_bucket = bucket & ((1 << sub_bucket_bits) - 1);
+    return ((int64_t{1} << sub_bucket_bits) + sub_bucket) << (octave - 1);
+}
+
+stats_t::stats_t() : count(0), max(0) {
+    std::fill(buckets, buckets + num_buckets, 0);
+}
+
+void stats_t::record(int64_t value) {
+    ++count;
+    max = std::max(max, value);
+    ++buckets[bucket_for_value(value)];
+}
+
+void stats_t::aggregate(const stats_t &s) {
+    count += s.count;
+    max = std::max(max, s.max);
+    for (int i = 0; i < num_buckets; ++i) {
+        buckets[i] += s.buckets[i];
+    }
+}
+
+int64_t stats_t::percentile(double q) const {
+    rassert(count > 0);
+    rassert(q > 0 && q <= 1);
+    const uint64_t rank = std::max<uint64_t>(1, ceil(q * count));
+    uint64_t seen = 0;
+    for (int i = 0; i < num_buckets - 1; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return std::min(bucket_lower_bound(i + 1) - 1, max);
+        }
+    }
+    return max;
+}
+
+}   /* namespace perfmon_histogram */
+
+perfmon_histogram_t::perfmon_histogram_t(ticks_t _length)
+    : perfmon_histogram_t(_length, 1.0) { }
+
+perfmon_histogram_t::perfmon_histogram_t(ticks_t _length, double _output_divisor)
+    : perfmon_perthread_t<stats_t>(), length(_length),
+      output_divisor(_output_divisor) { }
+
+perfmon_histogram_t::thread_info_t *
+perfmon_histogram_t::get_thread_info(ticks_t now) {
+    rassert(get_thread_id().threadnum >= 0);
+    scoped_ptr_t<thread_info_t> *thread = &thread_data[get_thread_id().threadnum];
+    const int64_t interval = now.nanos / length.nanos;
+    if (!thread->has()) {
+        thread->init(new thread_info_t);
+        (*thread)->current_interval = interval;
+    }
+
+    thread_info_t *info = thread->get();
+    if (info->current_interval == interval) {
+        /* We're up to date; nothing to do */
+    } else if (info->current_interval + 1 == interval) {
+        /* We're one step behind */
+        info->last_stats = info->current_stats;
+        info->current_stats = stats_t();
+        info->current_interval = interval;
+    } else {
+        /* We're more than one step behind */
+        info->last_stats = info->current_stats = stats_t();
+        info->current_interval = interval;
+    }
+    return info;
+}
+
+void perfmon_histogram_t::record(int64_t value) {
+    thread_info_t *info = get_thread_info(get_ticks());
+    info->current_stats.record(value);
+}
+
+void perfmon_histogram_t::get_thread_stat(stats_t *stat) {
+    rassert(get_thread_id().threadnum >= 0);
+    if (thread_data[get_thread_id().threadnum].has()) {
+        /* As in `perfmon_sampler_t`, we return the last complete interval. */
+        *stat = get_thread_info(get_ticks())->last_stats;
+    }
+}
+
+perfmon_histogram_t::stats_t perfmon_histogram_t::combine_stats(
+        const stats_t *stats) {
+    stats_t aggregated;
+    for (int i = 0; i < get_num_threads(); i++) {
+        aggregated.aggregate(stats[i]);
+    }
+    return aggregated;
+}
+
+ql::datum_t perfmon_histogram_t::output_stat(const stats_t &aggregated) {
+    ql::datum_object_builder_t builder;
+
+    builder.overwrite(stat_count, ql::datum_t(static_cast<double>(aggregated.count)));
+    if (aggregated.count > 0) {
+        builder.overwrite(stat_p50, ql::datum_t(aggregated.percentile(0.5) / output_divisor));
+        builder.overwrite(stat_p99, ql::datum_t(aggregated.percentile(0.99) / output_divisor));
+        builder.overwrite(stat_p999, ql::datum_t(aggregated.percentile(0.999) / output_divisor));
+        builder.overwrite(stat_max, ql::datum_t(aggregated.max / output_divisor));
+    } else {
+        builder.overwrite(stat_p50, ql::datum_t::null());
+        builder.overwrite(stat_p99, ql::datum_t::null());
+        builder.overwrite(stat_p999, ql::datum_t::null());
+        builder.overwrite(stat_max, ql::datum_t::null());
+    }
+    return std::move(builder).to_datum();
+}
+
+perfmon_latency_histogram_t::perfmon_latency_histogram_t(ticks_t _length)
+    : perfmon_histogram_t(_length, 1000.0) { }
+
+void perfmon_latency_histogram_t::record(ticks_t duration) {
+    perfmon_histogram_t::record(duration.nanos / THOUSAND);
+}
+
 perfmon_duration_sampler_t::perfmon_duration_sampler_t(ticks_t length, bool _ignore_global_full_perfmon)
     : stat(), active(), total(), recent(length, true),
       active_membership(&stat, &active, "active_count"),
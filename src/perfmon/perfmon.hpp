@@ -87,6 +87,21 @@ private:
     DISABLE_COPYING(scoped_perfmon_counter_t);
 };
 
+/* Reports the ratio of two counters, or 0 if the denominator is 0. */
+class perfmon_counter_ratio_t : public perfmon_t {
+public:
+    perfmon_counter_ratio_t(perfmon_counter_t *numerator,
+                            perfmon_counter_t *denominator);
+
+    void *begin_stats();
+    void visit_stats(void *ctx);
+    ql::datum_t end_stats(void *ctx);
+
+private:
+    perfmon_counter_t *const numerator_;
+    perfmon_counter_t *const denominator_;
+};
+
 /* perfmon_sampler_t is a perfmon_t that keeps a log of events that happen.
  * When something happens, call the perfmon_sampler_t's record() method. The
  * perfmon_sampler_t will retain that record until 'length' ticks have passed.
@@ -215,6 +230,78 @@ public:
     void record(double value = 1.0);
 };
 
+/* perfmon_histogram_t records non-negative values into logarithmically sized
+ * buckets, so that it can report percentiles and not just averages. Like
+ * `perfmon_sampler_t`, it reports on the last complete interval of `length`
+ * ticks. It produces stats for the number of records in that interval, their
+ * 50th, 99th and 99.9th percentiles and the maximum. Percentiles are rounded up
+ * to the end of their bucket, so they can be off by up to 25% (but never more
+ * than the maximum).
+ *
+ * The per-thread buckets are only allocated on the threads that record
+ * anything, which usually is just one.
+ *
+ * perfmon_latency_histogram_t is a perfmon_histogram_t for durations. It
+ * records them in microseconds and reports them in milliseconds.
+ */
+namespace perfmon_histogram {
+
+// Values below 4 each get their own bucket; above that, every power of two is
+// split into 4 buckets.
+static const int sub_bucket_bits = 2;
+static const int num_buckets = 128;
+
+// Returns the bucket that `value` falls into.
+int bucket_for_value(int64_t value);
+// Returns the smallest value that falls into `bucket`.
+int64_t bucket_lower_bound(int bucket);
+
+struct stats_t {
+    stats_t();
+    void record(int64_t value);
+    void aggregate(const stats_t &s);
+    // Returns an upper bound on the `q`th quantile (0 < q <= 1).
+    int64_t percentile(double q) const;
+
+    uint64_t count;
+    int64_t max;
+    uint64_t buckets[num_buckets];
+};
+
+}   /* namespace perfmon_histogram */
+
+class perfmon_histogram_t
+    : public perfmon_perthread_t<perfmon_histogram::stats_t> {
+    typedef perfmon_histogram::stats_t stats_t;
+    struct thread_info_t {
+        stats_t current_stats, last_stats;
+        int64_t current_interval;
+    };
+
+    scoped_ptr_t<thread_info_t> thread_data[MAX_THREADS];
+
+    void get_thread_stat(stats_t *);
+    stats_t combine_stats(const stats_t *);
+    ql::datum_t output_stat(const stats_t &);
+
+    thread_info_t *get_thread_info(ticks_t now);
+
+    ticks_t length;
+    // The reported percentiles and maximum are divided by this.
+    double output_divisor;
+protected:
+    perfmon_histogram_t(ticks_t _length, double _output_divisor);
+public:
+    explicit perfmon_histogram_t(ticks_t _length);
+    void record(int64_t value);
+};
+
+class perfmon_latency_histogram_t : public perfmon_histogram_t {
+public:
+    explicit perfmon_latency_histogram_t(ticks_t _length);
+    void record(ticks_t duration);
+};
+
 /* perfmon_duration_sampler_t is a perfmon_t that monitors events that have a
  * starting and ending time. When something starts, call begin(); when
  * something ends, call end() with the same value as begin. It will produce
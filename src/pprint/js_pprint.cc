@@ -893,6 +893,7 @@ static void pprint_update_reminder() {
     case Term::WAIT:
     case Term::RECONFIGURE:
     case Term::REBALANCE:
+    case Term::COMPACT:
     case Term::SYNC:
     case Term::GRANT:
     case Term::SET_WRITE_HOOK:
@@ -118,6 +118,20 @@ env_t::env_t(signal_t *_interruptor,
     rassert(interruptor != NULL);
 }
 
+env_t::env_t(signal_t *_interruptor, const env_t *parent)
+    : serializable_(parent->serializable_),
+      limits_(parent->limits_),
+      reql_version_(parent->reql_version_),
+      regex_cache_(LRU_CACHE_SIZE),
+      return_empty_normal_batches(parent->return_empty_normal_batches),
+      interruptor(_interruptor),
+      trace(NULL),
+      evals_since_yield_(0),
+      rdb_ctx_(NULL),
+      eval_callback_(NULL) {
+    rassert(interruptor != NULL);
+}
+
 env_t::~env_t() { }
 
 void env_t::maybe_yield() {
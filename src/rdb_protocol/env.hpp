@@ -64,6 +64,11 @@ public:
           return_empty_normal_batches_t return_empty_normal_batches,
           reql_version_t reql_version);
 
+    // Used by `run_stealable_batch()` to evaluate functions from `parent` on another
+    // thread. It has the same optargs, limits and ReQL version as `parent`, but no
+    // `rdb_context_t` and no profiling, so it's only good for deterministic functions.
+    env_t(signal_t *interruptor, const env_t *parent);
+
     ~env_t();
 
     // Will yield after EVALS_BEFORE_YIELD calls
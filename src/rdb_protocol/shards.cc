@@ -6,6 +6,8 @@
 #include "errors.hpp"
 #include <boost/variant.hpp>
 
+#include "concurrency/cross_thread_signal.hpp"
+#include "concurrency/work_stealing.hpp"
 #include "debug.hpp"
 #include "rdb_protocol/func.hpp"
 #include "rdb_protocol/profile.hpp"
@@ -979,6 +981,50 @@ private:
     backtrace_id_t bt;
 };
 
+// Returns true if it's worth letting other threads help with evaluating `f` on
+// every element of a batch of `batch_size` elements. That's only safe if `f` depends
+// on nothing but its argument, so that it can run in an `env_t` without an
+// `rdb_context_t`. We don't bother while profiling, since the other threads' time
+// wouldn't show up in the profile.
+bool should_steal(env_t *env, size_t batch_size, const counted_t<const func_t> &f) {
+    return batch_size >= WORK_STEALING_MIN_BATCH_SIZE
+        && env->trace == nullptr
+        && f->is_deterministic().test(single_server_t::yes, constant_now_t::no);
+}
+
+// Calls `fn(i)` for every `i` in `[0, batch_size)`, letting idle threads steal some
+// of the calls. Calls on other threads get their own copy of `env`, with the query's
+// interruptor carried over to their thread, and stop between elements once it's
+// pulsed.
+void stealable_for_each(env_t *env, size_t batch_size,
+                        const std::function<void(env_t *, size_t)> &fn) {
+    // Only the threads that get invited to steal get one.
+    scoped_array_t<scoped_ptr_t<cross_thread_signal_t> > thief_interruptors(
+        get_num_threads());
+    run_stealable_batch(batch_size, WORK_STEALING_CHUNK_SIZE,
+        [&](size_t begin, size_t end) {
+            if (get_thread_id() == env->home_thread()) {
+                for (size_t i = begin; i < end; ++i) {
+                    fn(env, i);
+                }
+            } else {
+                signal_t *interruptor =
+                    thief_interruptors[get_thread_id().threadnum].get();
+                env_t thief_env(interruptor, env);
+                for (size_t i = begin; i < end; ++i) {
+                    if (interruptor->is_pulsed()) {
+                        throw interrupted_exc_t();
+                    }
+                    fn(&thief_env, i);
+                }
+            }
+        },
+        [&](threadnum_t thread) {
+            thief_interruptors[thread.threadnum].init(
+                new cross_thread_signal_t(env->interruptor, thread));
+        });
+}
+
 class map_trans_t : public ungrouped_op_t {
 public:
     explicit map_trans_t(const map_wire_func_t &_f)
@@ -987,6 +1033,12 @@ private:
     virtual void lst_transform(
         env_t *env, datums_t *lst, const std::function<datum_t()> &) {
         try {
+            if (should_steal(env, lst->size(), f)) {
+                stealable_for_each(env, lst->size(), [&](env_t *e, size_t i) {
+                    (*lst)[i] = f->call(e, (*lst)[i])->as_datum();
+                });
+                return;
+            }
             for (auto it = lst->begin(); it != lst->end(); ++it) {
                 *it = f->call(env, *it)->as_datum();
             }
@@ -1039,6 +1091,28 @@ public:
 private:
     virtual void lst_transform(
         env_t *env, datums_t *lst, const std::function<datum_t()> &) {
+        if (should_steal(env, lst->size(), f)
+            && (!default_val.has()
+                || should_steal(env, lst->size(), default_val))) {
+            // `char` rather than `bool`, so that threads don't share bytes.
+            std::vector<char> keep(lst->size());
+            try {
+                stealable_for_each(env, lst->size(), [&](env_t *e, size_t i) {
+                    keep[i] = f->filter_call(e, (*lst)[i], default_val);
+                });
+            } catch (const datum_exc_t &e) {
+                throw exc_t(e, f->backtrace(), 1);
+            }
+            auto loc = lst->begin();
+            for (size_t i = 0; i < keep.size(); ++i) {
+                if (keep[i]) {
+                    std::swap(*loc, (*lst)[i]);
+                    ++loc;
+                }
+            }
+            lst->erase(loc, lst->end());
+            return;
+        }
         auto it = lst->begin();
         auto loc = it;
         try {
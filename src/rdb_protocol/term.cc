@@ -126,6 +126,7 @@ counted_t<const term_t> compile_on_current_stack(
     case Term::WAIT:               return make_wait_term(env, t);
     case Term::RECONFIGURE:        return make_reconfigure_term(env, t);
     case Term::REBALANCE:          return make_rebalance_term(env, t);
+    case Term::COMPACT:            return make_compact_term(env, t);
     case Term::SYNC:               return make_sync_term(env, t);
     case Term::GRANT:              return make_grant_term(env, t);
     case Term::SET_WRITE_HOOK:     return make_set_write_hook_term(env, t);
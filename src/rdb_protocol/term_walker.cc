@@ -217,6 +217,7 @@ bool term_type_is_valid(Term::TermType type) {
     case Term::WAIT:
     case Term::RECONFIGURE:
     case Term::REBALANCE:
+    case Term::COMPACT:
     case Term::SYNC:
     case Term::GRANT:
     case Term::SET_WRITE_HOOK:
@@ -412,6 +413,7 @@ bool term_is_write_or_meta(Term::TermType type) {
     case Term::WAIT:
     case Term::RECONFIGURE:
     case Term::REBALANCE:
+    case Term::COMPACT:
     case Term::SYNC:
     case Term::GRANT:
     case Term::SET_WRITE_HOOK:
@@ -694,6 +696,7 @@ bool term_forbids_writes(Term::TermType type) {
     case Term::WAIT:
     case Term::RECONFIGURE:
     case Term::REBALANCE:
+    case Term::COMPACT:
     case Term::SYNC:
     case Term::GRANT:
     case Term::SET_WRITE_HOOK:
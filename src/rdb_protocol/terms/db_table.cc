@@ -739,6 +739,51 @@ private:
     virtual const char *name() const { return "rebalance"; }
 };
 
+class compact_term_t : public table_or_db_meta_term_t {
+public:
+    compact_term_t(compile_env_t *env, const raw_term_t &term)
+        : table_or_db_meta_term_t(env, term, optargspec_t({})) { }
+private:
+    virtual scoped_ptr_t<val_t> eval_impl_on_table_or_db(
+            scope_env_t *env, args_t *args, eval_flags_t,
+            const counted_t<const ql::db_t> &db,
+            const optional<name_string_t> &name_if_table) const {
+        // Don't allow a compact call without explicit database
+        if (args->num_args() == 0) {
+            rfail(base_exc_t::LOGIC, "`compact` can only be called on a table or database.");
+        }
+
+        ql::datum_t result;
+        bool success;
+        admin_err_t error;
+        try {
+            if (static_cast<bool>(name_if_table)) {
+                success = env->env->reql_cluster_interface()->table_compact(
+                    env->env->get_user_context(),
+                    db,
+                    *name_if_table,
+                    env->env->interruptor,
+                    &result,
+                    &error);
+            } else {
+                success = env->env->reql_cluster_interface()->db_compact(
+                    env->env->get_user_context(),
+                    db,
+                    env->env->interruptor,
+                    &result,
+                    &error);
+            }
+        } catch (auth::permission_error_t const &permission_error) {
+            rfail(ql::base_exc_t::PERMISSION_ERROR, "%s", permission_error.what());
+        }
+        if (!success) {
+            REQL_RETHROW(error);
+        }
+        return new_val(result);
+    }
+    virtual const char *name() const { return "compact"; }
+};
+
 class sync_term_t : public meta_op_term_t {
 public:
     sync_term_t(compile_env_t *env, const raw_term_t &term)
@@ -1023,6 +1068,11 @@ counted_t<term_t> make_rebalance_term(
     return make_counted<rebalance_term_t>(env, term);
 }
 
+counted_t<term_t> make_compact_term(
+        compile_env_t *env, const raw_term_t &term) {
+    return make_counted<compact_term_t>(env, term);
+}
+
 counted_t<term_t> make_sync_term(
         compile_env_t *env, const raw_term_t &term) {
     return make_counted<sync_term_t>(env, term);
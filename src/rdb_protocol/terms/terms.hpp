@@ -127,6 +127,8 @@ counted_t<term_t> make_reconfigure_term(
     compile_env_t *env, const raw_term_t &term);
 counted_t<term_t> make_rebalance_term(
     compile_env_t *env, const raw_term_t &term);
+counted_t<term_t> make_compact_term(
+    compile_env_t *env, const raw_term_t &term);
 counted_t<term_t> make_sync_term(
     compile_env_t *env, const raw_term_t &term);
 counted_t<term_t> make_grant_term(
@@ -33,7 +33,12 @@ static_assert(cluster_version_t::CLUSTER == cluster_version_t::v2_5_is_latest,
               "We need to update CLUSTER_VERSION_STRING when we add a new cluster "
               "version.");
 
-#define CLUSTER_VERSION_STRING "2.5.0"
+// The patch number goes up when the layout of a cluster message changes before the
+// release, so that servers with different layouts refuse to connect to each other
+// instead of misreading each other's messages. (2.5.1 added the storage files to
+// `table_status_request_t` and `table_status_response_t`, and 2.5.2 added the
+// compact mailbox to `multi_table_manager_bcard_t`.)
+#define CLUSTER_VERSION_STRING "2.5.2"
 
 const std::string connectivity_cluster_t::cluster_proto_header("RethinkDB cluster\n");
 const std::string connectivity_cluster_t::cluster_version_string(CLUSTER_VERSION_STRING);
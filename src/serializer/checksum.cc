@@ -1,8 +1,17 @@
 #include "serializer/checksum.hpp"
 
+#include <algorithm>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CHECKSUM_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+#include "errors.hpp"
+
 // The return value of this function or its behavior can't be changed -- the on-disk
 // format obviously requires a specific checksum algorithm.
-serializer_checksum compute_checksum(const void *word32s, size_t wordcount) {
+static serializer_checksum compute_checksum_scalar(const void *word32s, size_t wordcount) {
     const uint32_t *p = static_cast<const uint32_t *>(word32s);
 
     // This is the Fletcher-64 algorithm, applied to the input whose words are xored with
@@ -30,7 +39,7 @@ serializer_checksum compute_checksum(const void *word32s, size_t wordcount) {
     // We go through a minor shenanigan here to handle very large buffers.
     for (;;) {
         // 0xFFFFul is low enough that a and b can't overflow.
-        const size_t n = wordcount & 0xFFFFul;
+        const size_t n = std::min<size_t>(wordcount, 0xFFFFul);
 
         // At this point, a and b are <= 0x1_FFFF_FFFE and non-zero.
 
@@ -60,6 +69,175 @@ serializer_checksum compute_checksum(const void *word32s, size_t wordcount) {
     return serializer_checksum{(b << 32) | a};
 }
 
+#ifdef CHECKSUM_X86_KERNELS
+
+// The vector kernels split the buffer into chunks of this many words (at most), so
+// that their 64-bit lanes can't overflow.
+static const size_t VECTOR_CHUNK_WORDS = 0x10000;
+
+// The vector kernels run `num_lanes` interleaved Fletcher sums: lane j sees the words
+// j, j + num_lanes, j + 2 * num_lanes, ... of the chunk, and sums them into
+// `lane_a[j]` and `lane_b[j]` exactly like the scalar loop does (but starting from
+// zero, and without the modulus).  This turns the lanes into the checksum of the
+// chunk.
+//
+// With the chunk's (xored) words y0, ..., yN-1, the scalar loop computes A = (sum of
+// y_i) and B = (sum of (N - i) * y_i).  With N = num_lanes * K and i = num_lanes * k
+// + j, we have N - i = num_lanes * (K - k) - j, so B = (sum over the lanes of
+// num_lanes * lane_b[j] - j * lane_a[j]).  All of this is modulo 2**32 - 1.
+static serializer_checksum combine_checksum_lanes(const uint64_t *lane_a,
+                                                  const uint64_t *lane_b,
+                                                  int num_lanes) {
+    const uint64_t modulus = 0xFFFFFFFFull;
+    uint64_t a = 0;
+    uint64_t b = 0;
+    for (int j = 0; j < num_lanes; ++j) {
+        const uint64_t lane_a_mod = lane_a[j] % modulus;
+        a += lane_a_mod;
+        // Subtracting j * lane_a_mod is adding j * (modulus - lane_a_mod).
+        b += num_lanes * (lane_b[j] % modulus) + j * (modulus - lane_a_mod);
+    }
+    a %= modulus;
+    b %= modulus;
+    // Like the scalar loop, we represent zero as 2**32 - 1.
+    return serializer_checksum{((b == 0 ? modulus : b) << 32) | (a == 0 ? modulus : a)};
+}
+
+__attribute__((target("sse4.1")))
+static serializer_checksum compute_checksum_sse41(const void *word32s,
+                                                  size_t wordcount) {
+    const uint32_t *p = static_cast<const uint32_t *>(word32s);
+    const __m128i xorer = _mm_set1_epi32(1);
+    serializer_checksum sum = identity_checksum();
+    while (wordcount >= 4) {
+        const size_t n = std::min<size_t>(wordcount & ~size_t(3), VECTOR_CHUNK_WORDS);
+        // Lanes 0 and 1, and lanes 2 and 3.
+        __m128i a_lo = _mm_setzero_si128();
+        __m128i a_hi = _mm_setzero_si128();
+        __m128i b_lo = _mm_setzero_si128();
+        __m128i b_hi = _mm_setzero_si128();
+        for (size_t i = 0; i < n; i += 4) {
+            const __m128i x = _mm_xor_si128(
+                _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i)), xorer);
+            a_lo = _mm_add_epi64(a_lo, _mm_cvtepu32_epi64(x));
+            a_hi = _mm_add_epi64(a_hi, _mm_cvtepu32_epi64(_mm_srli_si128(x, 8)));
+            b_lo = _mm_add_epi64(b_lo, a_lo);
+            b_hi = _mm_add_epi64(b_hi, a_hi);
+        }
+        uint64_t lane_a[4];
+        uint64_t lane_b[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(lane_a), a_lo);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(lane_a + 2), a_hi);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(lane_b), b_lo);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(lane_b + 2), b_hi);
+        sum = compute_checksum_concat(sum, combine_checksum_lanes(lane_a, lane_b, 4), n);
+        p += n;
+        wordcount -= n;
+    }
+    return compute_checksum_concat(sum, compute_checksum_scalar(p, wordcount), wordcount);
+}
+
+__attribute__((target("avx2")))
+static serializer_checksum compute_checksum_avx2(const void *word32s,
+                                                 size_t wordcount) {
+    const uint32_t *p = static_cast<const uint32_t *>(word32s);
+    const __m256i xorer = _mm256_set1_epi32(1);
+    serializer_checksum sum = identity_checksum();
+    while (wordcount >= 8) {
+        const size_t n = std::min<size_t>(wordcount & ~size_t(7), VECTOR_CHUNK_WORDS);
+        // Lanes 0 to 3, and lanes 4 to 7.
+        __m256i a_lo = _mm256_setzero_si256();
+        __m256i a_hi = _mm256_setzero_si256();
+        __m256i b_lo = _mm256_setzero_si256();
+        __m256i b_hi = _mm256_setzero_si256();
+        for (size_t i = 0; i < n; i += 8) {
+            const __m256i x = _mm256_xor_si256(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i)), xorer);
+            a_lo = _mm256_add_epi64(a_lo,
+                _mm256_cvtepu32_epi64(_mm256_castsi256_si128(x)));
+            a_hi = _mm256_add_epi64(a_hi,
+                _mm256_cvtepu32_epi64(_mm256_extracti128_si256(x, 1)));
+            b_lo = _mm256_add_epi64(b_lo, a_lo);
+            b_hi = _mm256_add_epi64(b_hi, a_hi);
+        }
+        uint64_t lane_a[8];
+        uint64_t lane_b[8];
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(lane_a), a_lo);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(lane_a + 4), a_hi);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(lane_b), b_lo);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(lane_b + 4), b_hi);
+        sum = compute_checksum_concat(sum, combine_checksum_lanes(lane_a, lane_b, 8), n);
+        p += n;
+        wordcount -= n;
+    }
+    return compute_checksum_concat(sum, compute_checksum_scalar(p, wordcount), wordcount);
+}
+
+#endif  // CHECKSUM_X86_KERNELS
+
+bool checksum_kernel_supported(checksum_kernel_t kernel) {
+    switch (kernel) {
+    case checksum_kernel_t::scalar:
+        return true;
+#ifdef CHECKSUM_X86_KERNELS
+    case checksum_kernel_t::sse41:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse4.1");
+    case checksum_kernel_t::avx2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#else
+    case checksum_kernel_t::sse41:
+    case checksum_kernel_t::avx2:
+        return false;
+#endif
+    default:
+        unreachable();
+    }
+}
+
+serializer_checksum compute_checksum_using(checksum_kernel_t kernel,
+                                           const void *word32s, size_t wordcount) {
+    switch (kernel) {
+    case checksum_kernel_t::scalar:
+        return compute_checksum_scalar(word32s, wordcount);
+#ifdef CHECKSUM_X86_KERNELS
+    case checksum_kernel_t::sse41:
+        return compute_checksum_sse41(word32s, wordcount);
+    case checksum_kernel_t::avx2:
+        return compute_checksum_avx2(word32s, wordcount);
+#else
+    case checksum_kernel_t::sse41:
+    case checksum_kernel_t::avx2:
+        crash("Checksum kernel not supported on this platform.");
+#endif
+    default:
+        unreachable();
+    }
+}
+
+static checksum_kernel_t choose_checksum_kernel() {
+    if (checksum_kernel_supported(checksum_kernel_t::avx2)) {
+        return checksum_kernel_t::avx2;
+    } else if (checksum_kernel_supported(checksum_kernel_t::sse41)) {
+        return checksum_kernel_t::sse41;
+    } else {
+        return checksum_kernel_t::scalar;
+    }
+}
+
+// If `compute_checksum` gets called during static initialization before this is
+// initialized, it's still zero, which means `scalar`.
+static const checksum_kernel_t best_checksum_kernel = choose_checksum_kernel();
+
+serializer_checksum compute_checksum(const void *word32s, size_t wordcount) {
+    // The vector kernels aren't worth it for tiny buffers.
+    if (wordcount < 16) {
+        return compute_checksum_scalar(word32s, wordcount);
+    }
+    return compute_checksum_using(best_checksum_kernel, word32s, wordcount);
+}
+
 serializer_checksum compute_checksum_concat(serializer_checksum left,
                                             serializer_checksum right,
                                             uint64_t right_wordcount) {
@@ -22,6 +22,21 @@ ATTR_PACKED(struct serializer_checksum {
 // The checksum is never zero.
 serializer_checksum compute_checksum(const void *word32s, size_t wordcount);
 
+// The implementations that `compute_checksum` chooses from, depending on what the CPU
+// supports.  They all compute exactly the same checksum.
+enum class checksum_kernel_t {
+    scalar,
+    sse41,
+    avx2
+};
+
+bool checksum_kernel_supported(checksum_kernel_t kernel);
+
+// Like `compute_checksum`, but with a specific implementation, which must be supported
+// by the CPU.  For tests and benchmarks.
+serializer_checksum compute_checksum_using(checksum_kernel_t kernel,
+                                           const void *word32s, size_t wordcount);
+
 // Combines checksums into the checksum of the concatenated buffer.  Given two buffers,
 // s, and t, serializer_checksum_concat(serializer_checksum(s), serializer_checksum(t),
 // t.wordcount) computes serializer_checksum(concat(s, t)).
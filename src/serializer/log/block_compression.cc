@@ -0,0 +1,85 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "serializer/log/block_compression.hpp"
+
+#include <zlib.h>
+
+#include "errors.hpp"
+
+const char *block_compression_name(block_compression_t compression) {
+    switch (compression) {
+    case block_compression_t::none: return "none";
+    case block_compression_t::zlib: return "zlib";
+    default: unreachable();
+    }
+}
+
+static block_compression_t table_block_compression = block_compression_t::none;
+
+void set_table_block_compression(block_compression_t compression) {
+    table_block_compression = compression;
+}
+
+block_compression_t get_table_block_compression() {
+    return table_block_compression;
+}
+
+buf_ptr_t compress_block(block_compression_t compression,
+                         const ser_buffer_t *buf, block_size_t block_size) {
+    guarantee(compression == block_compression_t::zlib);
+
+    // Compression has to save at least one DEVICE_BLOCK_SIZE on disk to be worth it.
+    const uint16_t aligned_size = buf_ptr_t::compute_aligned_block_size(block_size);
+    if (aligned_size <= DEVICE_BLOCK_SIZE) {
+        return buf_ptr_t();
+    }
+    const uint16_t max_disk_size = aligned_size - DEVICE_BLOCK_SIZE;
+
+    buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(
+        block_size_t::unsafe_make(max_disk_size));
+    ls_compressed_buf_t *compressed
+        = reinterpret_cast<ls_compressed_buf_t *>(ret.ser_buffer());
+    compressed->ser_header = buf->ser_header;
+    compressed->compression = static_cast<uint8_t>(compression);
+
+    uLongf compressed_size = max_disk_size - sizeof(ls_compressed_buf_t);
+    const int res = compress2(
+        reinterpret_cast<Bytef *>(compressed->compressed_data), &compressed_size,
+        reinterpret_cast<const Bytef *>(buf->cache_data), block_size.value(),
+        Z_BEST_SPEED);
+    if (res == Z_BUF_ERROR) {
+        // It didn't fit into `max_disk_size`.
+        return buf_ptr_t();
+    }
+    guarantee(res == Z_OK, "zlib failed to compress a block (error %d).", res);
+
+    ret.resize_fill_zero(block_size_t::unsafe_make(
+        sizeof(ls_compressed_buf_t) + compressed_size));
+    return ret;
+}
+
+void decompress_block(const ser_buffer_t *compressed_buf, block_size_t disk_block_size,
+                      block_size_t block_size, ser_buffer_t *out) {
+    const ls_compressed_buf_t *compressed
+        = reinterpret_cast<const ls_compressed_buf_t *>(compressed_buf);
+    const block_id_t block_id = compressed->ser_header.block_id;
+    guarantee(disk_block_size.ser_value() > sizeof(ls_compressed_buf_t),
+              "Compressed block %" PR_BLOCK_ID " is too small.", block_id);
+
+    switch (static_cast<block_compression_t>(compressed->compression)) {
+    case block_compression_t::zlib: {
+        uLongf size = block_size.value();
+        const int res = uncompress(
+            reinterpret_cast<Bytef *>(out->cache_data), &size,
+            reinterpret_cast<const Bytef *>(compressed->compressed_data),
+            disk_block_size.ser_value() - sizeof(ls_compressed_buf_t));
+        guarantee(res == Z_OK && size == block_size.value(),
+                  "Compressed block %" PR_BLOCK_ID " is corrupted (zlib error %d).",
+                  block_id, res);
+    } break;
+    case block_compression_t::none:  // fallthrough
+    default:
+        crash("Compressed block %" PR_BLOCK_ID " uses an unknown compression (%d).",
+              block_id, static_cast<int>(compressed->compression));
+    }
+    out->ser_header = compressed->ser_header;
+}
@@ -0,0 +1,52 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef SERIALIZER_LOG_BLOCK_COMPRESSION_HPP_
+#define SERIALIZER_LOG_BLOCK_COMPRESSION_HPP_
+
+#include <stdint.h>
+
+#include "arch/compiler.hpp"
+#include "serializer/buf_ptr.hpp"
+#include "serializer/types.hpp"
+
+/* Data blocks can be stored compressed on disk. The cache never sees that: the
+serializer compresses blocks in `block_writes()` and decompresses them when they are
+read, and block tokens still report the uncompressed `block_size()`. The LBA records
+both the block's size and its (smaller) size on disk, see `lba_entry_t`.
+
+A block is only stored compressed if that saves at least one DEVICE_BLOCK_SIZE on
+disk, so a compressed block is always smaller on disk than its `block_size()`. The
+garbage collector moves compressed blocks around as they are. */
+
+enum class block_compression_t : uint8_t {
+    none = 0,
+    zlib = 1
+};
+
+const char *block_compression_name(block_compression_t compression);
+
+/* The compression that the serializers of tables use for the blocks they write. The
+blocks that are already on disk stay as they are, so this can change between runs.
+Blocks written with any compression can always be read. */
+void set_table_block_compression(block_compression_t compression);
+block_compression_t get_table_block_compression();
+
+// The layout of a compressed block on disk.
+ATTR_PACKED(struct ls_compressed_buf_t {
+    ls_buf_data_t ser_header;
+    // The `block_compression_t` that was used, never `none`.
+    uint8_t compression;
+    char compressed_data[];
+});
+
+/* Compresses the block `buf` of size `block_size`, and returns the compressed block
+(whose `block_size()` is its size on disk). Returns an empty `buf_ptr_t` if compressing
+the block wouldn't make it smaller on disk. */
+buf_ptr_t compress_block(block_compression_t compression,
+                         const ser_buffer_t *buf, block_size_t block_size);
+
+/* Decompresses the block `compressed`, which takes `disk_block_size` bytes, into
+`out`, which must have room for `block_size` bytes. Crashes if the block is corrupt. */
+void decompress_block(const ser_buffer_t *compressed, block_size_t disk_block_size,
+                      block_size_t block_size, ser_buffer_t *out);
+
+#endif  // SERIALIZER_LOG_BLOCK_COMPRESSION_HPP_
@@ -0,0 +1,156 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "serializer/log/compaction.hpp"
+
+#include <functional>
+#include <vector>
+
+#include "arch/io/disk.hpp"
+#include "concurrency/cond_var.hpp"
+#include "concurrency/new_mutex.hpp"
+#include "concurrency/pmap.hpp"
+#include "config/args.hpp"
+#include "containers/scoped.hpp"
+#include "containers/segmented_vector.hpp"
+#include "paths.hpp"
+#include "perfmon/perfmon.hpp"
+#include "serializer/buf_ptr.hpp"
+#include "serializer/log/block_compression.hpp"
+#include "serializer/log/log_serializer.hpp"
+
+// A batch also ends after this many block ids, so that long runs of deleted blocks
+// don't pile up index write ops.
+const size_t COMPACTION_MAX_BLOCK_IDS_PER_BATCH = 8192;
+
+struct compaction_write_cb_t : public cond_t, public iocallback_t {
+    void on_io_complete() {
+        pulse();
+    }
+};
+
+int64_t get_serializer_file_size(serializer_file_opener_t *file_opener) {
+    scoped_ptr_t<file_t> file;
+    file_opener->open_serializer_file_existing(&file);
+    return file->get_file_size();
+}
+
+/* Copies the blocks `block_ids` from `source` to `dest`. `tokens[i]` is the token of
+`block_ids[i]` in `source`, or empty if that block is deleted. The blocks that exist
+are written with a single `block_writes()` call, so the data block manager lays them
+out back to back. */
+void copy_block_batch(serializer_t *source,
+                      serializer_t *dest,
+                      file_account_t *read_account,
+                      file_account_t *write_account,
+                      const segmented_vector_t<repli_timestamp_t> &recencies,
+                      const std::vector<block_id_t> &block_ids,
+                      const std::vector<counted_t<block_token_t> > &tokens) {
+    guarantee(block_ids.size() == tokens.size());
+
+    std::vector<buf_ptr_t> bufs(block_ids.size());
+    throttled_pmap(0, block_ids.size(), [&](int64_t i) {
+        if (tokens[i].has()) {
+            bufs[i] = source->block_read(tokens[i], read_account);
+        }
+    }, COMPACTION_MAX_CONCURRENT_READS);
+
+    std::vector<buf_write_info_t> write_infos;
+    for (size_t i = 0; i < block_ids.size(); ++i) {
+        if (tokens[i].has()) {
+            write_infos.push_back(buf_write_info_t(
+                bufs[i].ser_buffer(), bufs[i].block_size(), block_ids[i]));
+        }
+    }
+
+    std::vector<counted_t<block_token_t> > new_tokens;
+    if (!write_infos.empty()) {
+        compaction_write_cb_t write_cb;
+        new_tokens = dest->block_writes(
+            write_infos.data(), write_infos.size(), write_account, &write_cb);
+        write_cb.wait();
+    }
+
+    std::vector<index_write_op_t> write_ops;
+    write_ops.reserve(block_ids.size());
+    size_t next_new_token = 0;
+    for (size_t i = 0; i < block_ids.size(); ++i) {
+        counted_t<block_token_t> token;
+        if (tokens[i].has()) {
+            token = new_tokens[next_new_token];
+            ++next_new_token;
+        }
+        // Aux blocks don't have recencies.
+        optional<repli_timestamp_t> recency;
+        if (!is_aux_block_id(block_ids[i])) {
+            recency.set(recencies[block_ids[i]]);
+        }
+        write_ops.push_back(
+            index_write_op_t(block_ids[i], make_optional(token), recency));
+    }
+    guarantee(next_new_token == new_tokens.size());
+
+    new_mutex_in_line_t dummy_acq;
+    dest->index_write(&dummy_acq, []() { }, write_ops);
+}
+
+void compact_serializer_file(io_backender_t *io_backender,
+                             const serializer_filepath_t &filepath,
+                             int64_t *old_size_out,
+                             int64_t *new_size_out) {
+    filepath_file_opener_t source_opener(filepath, io_backender);
+    *old_size_out = get_serializer_file_size(&source_opener);
+
+    // `create()` puts the new file at the temporary path, and `dest_opener` keeps
+    // opening it there until we move it to the permanent one.
+    filepath_file_opener_t dest_opener(filepath, io_backender);
+    log_serializer_t::create(&dest_opener, log_serializer_t::static_config_t());
+
+    {
+        perfmon_collection_t source_stats;
+        log_serializer_t source(
+            log_serializer_t::dynamic_config_t(), &source_opener, &source_stats);
+
+        perfmon_collection_t dest_stats;
+        log_serializer_t::dynamic_config_t dest_config;
+        dest_config.compression = get_table_block_compression();
+        log_serializer_t dest(dest_config, &dest_opener, &dest_stats);
+
+        scoped_ptr_t<file_account_t> read_account(
+            source.make_io_account(CACHE_READS_IO_PRIORITY));
+        scoped_ptr_t<file_account_t> write_account(
+            dest.make_io_account(MERGER_BLOCK_WRITE_IO_PRIORITY));
+
+        const segmented_vector_t<repli_timestamp_t> recencies =
+            source.get_all_recencies(0, 1);
+
+        std::vector<block_id_t> block_ids;
+        std::vector<counted_t<block_token_t> > tokens;
+        uint64_t batch_bytes = 0;
+        auto copy_range = [&](block_id_t begin, block_id_t end) {
+            for (block_id_t id = begin; id < end; ++id) {
+                counted_t<block_token_t> token = source.index_read(id);
+                if (token.has()) {
+                    batch_bytes += token->block_size().ser_value();
+                }
+                block_ids.push_back(id);
+                tokens.push_back(std::move(token));
+
+                if (batch_bytes >= COMPACTION_BATCH_SIZE
+                    || block_ids.size() >= COMPACTION_MAX_BLOCK_IDS_PER_BATCH
+                    || id + 1 == end) {
+                    copy_block_batch(&source, &dest, read_account.get(),
+                                     write_account.get(), recencies, block_ids,
+                                     tokens);
+                    block_ids.clear();
+                    tokens.clear();
+                    batch_bytes = 0;
+                }
+            }
+        };
+        copy_range(0, source.end_block_id());
+        copy_range(FIRST_AUX_BLOCK_ID, source.end_aux_block_id());
+    }
+
+    // Both files are closed now, so this atomically replaces the old file.
+    dest_opener.move_serializer_file_to_permanent_location();
+    *new_size_out = get_serializer_file_size(&dest_opener);
+}
@@ -0,0 +1,22 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef SERIALIZER_LOG_COMPACTION_HPP_
+#define SERIALIZER_LOG_COMPACTION_HPP_
+
+#include <stdint.h>
+
+class io_backender_t;
+class serializer_filepath_t;
+
+/* Copies the live blocks of the log serializer file at `filepath` into a new file, in
+large sequential writes, and then atomically renames the new file over the old one.
+Unlike `serializer_t::start_compaction()`, this leaves no free extents behind and
+writes a fresh LBA, but nothing else may have the file open. The new file uses the
+block compression that is currently set (see `set_table_block_compression()`).
+`old_size_out` and `new_size_out` are set to the size of the file before and after.
+Must be called in a coroutine. */
+void compact_serializer_file(io_backender_t *io_backender,
+                             const serializer_filepath_t &filepath,
+                             int64_t *old_size_out,
+                             int64_t *new_size_out);
+
+#endif  // SERIALIZER_LOG_COMPACTION_HPP_
@@ -11,8 +11,10 @@
 #include "concurrency/mutex.hpp"
 #include "concurrency/new_mutex.hpp"
 #include "errors.hpp"
+#include "logger.hpp"
 #include "perfmon/perfmon.hpp"
 #include "serializer/buf_ptr.hpp"
+#include "serializer/log/block_compression.hpp"
 #include "serializer/log/log_serializer.hpp"
 #include "stl_utils.hpp"
 
@@ -51,6 +53,13 @@ const size_t GC_YOUNG_EXTENT_MAX_SIZE = 50;
 // What's the definition of a "young" extent in microseconds?
 const kiloticks_t GC_YOUNG_EXTENT_TIMELIMIT = { 50000 };
 
+// How often the GC recomputes the scores of all old extents, as their data gets older.
+// In between, an extent's score only changes when its garbage does.
+const kiloticks_t GC_RESCORE_INTERVAL = { 10000000 };
+// Extents whose data is younger than this are scored as if it was this old, so that
+// they are ranked by their garbage alone.
+const kiloticks_t GC_MIN_SCORE_AGE = { 1000000 };
+
 
 // Identifies an extent, the time we started writing to the
 // extent, whether it's the extent we're currently writing to, and
@@ -72,6 +81,7 @@ public:
         : parent(_parent),
           extent_ref(parent->extent_manager->gen_extent()),
           timestamp(get_kiloticks()),
+          data_timestamp({ 0 }),
           was_written(false),
           state(state_active),
           garbage_bytes_stat(_parent->static_config->extent_size()),
@@ -87,6 +97,7 @@ public:
         : parent(_parent),
           extent_ref(parent->extent_manager->reserve_extent(_offset)),
           timestamp(get_kiloticks()),
+          data_timestamp(timestamp),
           was_written(false),
           state(state_reconstructing),
           garbage_bytes_stat(_parent->static_config->extent_size()),
@@ -194,6 +205,12 @@ public:
 
     bool all_garbage() const { return num_live_blocks() == 0; }
 
+    // How much we want to GC this extent, see `gc_cost_benefit()`.
+    double gc_score() const {
+        return gc_cost_benefit(garbage_bytes(), parent->static_config->extent_size(),
+                               parent->gc_score_time.micros - data_timestamp.micros);
+    }
+
     uint32_t garbage_bytes() const {
         return garbage_bytes_stat;
     }
@@ -360,6 +377,11 @@ public:
     // When we started writing to the extent (this time).
     const kiloticks_t timestamp;
 
+    // When the youngest block in the extent was written by a client. Blocks that the
+    // GC moves here keep the age they had. For extents that we found on startup, we
+    // don't know, and pretend it was then.
+    kiloticks_t data_timestamp;
+
     // The PQ entry pointing to us.
     priority_queue_t<gc_entry_t *, gc_entry_less_t>::entry_t *our_pq_entry;
 
@@ -400,8 +422,12 @@ data_block_manager_t::data_block_manager_t(
         const log_serializer_on_disk_static_config_t *_static_config,
         log_serializer_stats_t *_stats)
     : stats(_stats), shutdown_callback(nullptr), state(state_unstarted),
-      gc_enabled(true), static_config(_static_config), extent_manager(em),
-      serializer(_serializer),
+      gc_enabled(true), compacting(false), compaction_extents_left(0),
+      compaction_extents_gced(0), compaction_start_time(ticks_t{0}),
+      compaction_start_file_size(0),
+      static_config(_static_config), extent_manager(em),
+      serializer(_serializer), active_extent(nullptr), gc_active_extent(nullptr),
+      gc_score_time(get_kiloticks()),
       gc_index_write_pumper(std::bind(
           &data_block_manager_t::flush_gc_index_writes, this, std::placeholders::_1)),
       /* The capacity of the gc_index_write_semaphore will be scaled
@@ -453,7 +479,9 @@ void data_block_manager_t::start_existing(
         const dbm_metablock_mixin_t *last_metablock) {
     guarantee(state == state_unstarted);
     dbfile = file;
-    gc_io_account_nice.init(new file_account_t(file, GC_IO_PRIORITY_NICE));
+    gc_io_account_nice.init(new file_account_t(file, GC_IO_PRIORITY_NICE,
+                                               UNLIMITED_OUTSTANDING_REQUESTS,
+                                               file_io_class_t::background));
     gc_io_account_high.init(new file_account_t(file, GC_IO_PRIORITY_HIGH));
 
     /* Reconstruct the active data block extents from the metablock. */
@@ -479,6 +507,7 @@ void data_block_manager_t::start_existing(
     } else {
         active_extent = nullptr;
     }
+    gc_active_extent = nullptr;
 
     /* Convert any extents that we found live blocks in, but that are not active
     extents, into old extents */
@@ -665,14 +694,22 @@ public:
 
                 const block_size_t block_size
                     = block_size_t::unsafe_make(info.ser_block_size);
+                const block_size_t disk_block_size
+                    = block_size_t::unsafe_make(info.disk_block_size);
+                guarantee(info.disk_block_size <= *(lower_it + 1) - *lower_it);
                 buf_ptr_t buf = buf_ptr_t::alloc_uninitialized(block_size);
-                memcpy(buf.ser_buffer(), current_buf, info.ser_block_size);
+                if (disk_block_size.ser_value() < block_size.ser_value()) {
+                    decompress_block(reinterpret_cast<const ser_buffer_t *>(current_buf),
+                                     disk_block_size, block_size, buf.ser_buffer());
+                } else {
+                    memcpy(buf.ser_buffer(), current_buf, info.ser_block_size);
+                }
                 buf.fill_padding_zero();
-                guarantee(info.ser_block_size <= *(lower_it + 1) - *lower_it);
 
                 counted_t<block_token_t> token
                     = parent->serializer->generate_block_token(current_offset,
-                                                               block_size);
+                                                               block_size,
+                                                               disk_block_size);
 
                 parent->serializer->offer_buf_to_read_ahead_callbacks(
                         block_id,
@@ -697,8 +734,20 @@ bool data_block_manager_t::should_perform_read_ahead(int64_t offset) {
 }
 
 buf_ptr_t data_block_manager_t::read(int64_t off_in, block_size_t block_size,
-                                   file_account_t *io_account) {
+                                     block_size_t disk_block_size,
+                                     file_account_t *io_account) {
     guarantee(state == state_ready);
+    if (disk_block_size.ser_value() < block_size.ser_value()) {
+        buf_ptr_t compressed = read(off_in, disk_block_size, disk_block_size,
+                                    io_account);
+        buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(block_size);
+        decompress_block(compressed.ser_buffer(), disk_block_size, block_size,
+                         ret.ser_buffer());
+        ret.fill_padding_zero();
+        return ret;
+    }
+    guarantee(disk_block_size == block_size);
+
     if (should_perform_read_ahead(off_in)) {
         buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(block_size);
         dbm_read_ahead_t::perform_read_ahead(this, off_in, block_size.ser_value(),
@@ -740,13 +789,15 @@ buf_ptr_t data_block_manager_t::read(int64_t off_in, block_size_t block_size,
 std::vector<counted_t<block_token_t>>
 data_block_manager_t::many_writes(const buf_write_info_t *writes,
                                   size_t writes_count,
+                                  const optional<kiloticks_t> &gc_data_timestamp,
                                   file_account_t *io_account,
                                   iocallback_t *cb) {
     // These tokens are grouped by extent.  You can do a contiguous write in each
     // extent.
     uint64_t cumulative_aligned_size;
     std::vector<std::vector<counted_t<block_token_t>>> token_groups
-        = gimme_some_new_offsets(writes, writes_count, &cumulative_aligned_size);
+        = gimme_some_new_offsets(writes, writes_count, gc_data_timestamp,
+                                 &cumulative_aligned_size);
     const bool wants_checksum
         = cumulative_aligned_size <= serializer->dynamic_config.checksum_threshold;
 
@@ -823,6 +874,11 @@ data_block_manager_t::many_writes(const buf_write_info_t *writes,
         stats->bytes_written(total_aligned_size);
     }
 
+    stats->pm_serializer_data_bytes_written += cumulative_aligned_size;
+    if (!gc_data_timestamp.has_value()) {
+        stats->pm_serializer_client_data_bytes_written += cumulative_aligned_size;
+    }
+
     // Call on_io_complete for degenerate case (we added 1 to ops_remaining
     // earlier).
     intermediate_cb->on_io_complete();
@@ -1029,10 +1085,36 @@ struct block_write_cond_t : public cond_t, public iocallback_t {
     }
 };
 
+void data_block_manager_t::start_compaction() {
+    if (state != state_ready || !gc_enabled) {
+        return;
+    }
+
+    if (!compacting) {
+        compacting = true;
+        compaction_extents_gced = 0;
+        compaction_start_time = get_ticks();
+        compaction_start_file_size = dbfile->get_file_size();
+    }
+
+    // Young extents aren't GC candidates yet, but we want to compact them too.
+    while (young_extent_queue.head() != nullptr) {
+        remove_last_unyoung_entry();
+    }
+    compaction_extents_left = gc_pq.size();
+
+    // If there's nothing to GC, the GC finishes the compaction right away.
+    start_gc();
+}
+
 void data_block_manager_t::run_gc(gc_state_t *gc_state) {
     while (!gc_pq.empty()
-           && should_we_keep_gcing()
+           && (should_we_keep_gcing() || compaction_wants_to_gc())
            && !should_terminate_one_gc_thread()) {
+        if (compacting && compaction_extents_left > 0) {
+            --compaction_extents_left;
+            ++compaction_extents_gced;
+        }
         gc_one_extent(gc_state);
 
         if (state == state_shutting_down) {
@@ -1050,6 +1132,23 @@ void data_block_manager_t::run_gc(gc_state_t *gc_state) {
     active_gcs.remove(gc_state);
     gc_index_write_semaphore.set_capacity(std::max<int64_t>(1, active_gcs.size()));
     delete gc_state;
+
+    if (compacting && active_gcs.empty()) {
+        finish_compaction();
+    }
+}
+
+void data_block_manager_t::finish_compaction() {
+    guarantee(compacting);
+    compacting = false;
+    compaction_extents_left = 0;
+
+    const double secs = ticks_to_secs(
+        ticks_t{get_ticks().nanos - compaction_start_time.nanos});
+    logNTC("Compacted a data file in %.3f seconds: GCed %zu extents, the file went "
+           "from %" PRIi64 " to %" PRIi64 " bytes.\n",
+           secs, compaction_extents_gced,
+           compaction_start_file_size, dbfile->get_file_size());
 }
 
 void data_block_manager_t::gc_one_extent(gc_state_t *gc_state) {
@@ -1088,6 +1187,7 @@ void data_block_manager_t::gc_one_extent(gc_state_t *gc_state) {
 
         /* grab the entry */
         guarantee (!gc_pq.empty());
+        maybe_rescore_gc_pq();
         guarantee(gc_state->current_entry == nullptr);
         gc_state->current_entry = gc_pq.pop();
         gc_state->current_entry->our_pq_entry = nullptr;
@@ -1264,6 +1364,7 @@ void data_block_manager_t::write_gcs(
         for (size_t i = 0; i < writes.size(); ++i) {
             old_block_tokens.push_back(
                     serializer->generate_block_token(writes[i].old_offset,
+                                                     writes[i].block_size,
                                                      writes[i].block_size));
 
             the_writes.push_back(buf_write_info_t(writes[i].buf,
@@ -1272,6 +1373,8 @@ void data_block_manager_t::write_gcs(
         }
 
         new_block_tokens = many_writes(the_writes.data(), the_writes.size(),
+                                       make_optional(
+                                           gc_state->current_entry->data_timestamp),
                                        choose_gc_io_account(),
                                        &block_write_cond);
 
@@ -1337,6 +1440,16 @@ void data_block_manager_t::flush_gc_index_writes(signal_t *) {
                 if (iw.gc_state->current_entry->block_referenced_by_index(block_index)) {
                     block_id_t block_id = write.buf->ser_header.block_id;
 
+                    // We moved the block as it was on disk. If it's compressed, its
+                    // size is bigger than that, and only the LBA knows by how much.
+                    const index_block_info_t info
+                        = serializer->lba_index->get_block_info(block_id);
+                    guarantee(info.offset.has_value()
+                              && info.offset.get_value() == write.old_offset);
+                    guarantee(info.disk_block_size == write.block_size.ser_value());
+                    iw.new_block_tokens[i]->block_size_
+                        = block_size_t::unsafe_make(info.ser_block_size);
+
                     index_write_ops.push_back(
                         index_write_op_t(block_id,
                             make_optional(iw.new_block_tokens[i])));
@@ -1425,6 +1538,12 @@ void data_block_manager_t::actually_shutdown() {
         active_extent = nullptr;
     }
 
+    if (gc_active_extent != nullptr) {
+        UNUSED int64_t extent = gc_active_extent->extent_ref.release();
+        delete gc_active_extent;
+        gc_active_extent = nullptr;
+    }
+
     while (gc_entry_t *entry = young_extent_queue.head()) {
         young_extent_queue.remove(entry);
         UNUSED int64_t extent = entry->extent_ref.release();
@@ -1447,17 +1566,29 @@ void data_block_manager_t::actually_shutdown() {
 std::vector<std::vector<counted_t<block_token_t>>>
 data_block_manager_t::gimme_some_new_offsets(const buf_write_info_t *writes,
                                              size_t writes_count,
+                                             const optional<kiloticks_t> &gc_data_timestamp,
                                              uint64_t *cumulative_aligned_size_out) {
     ASSERT_NO_CORO_WAITING;
 
+    // Blocks that the GC moves have survived for a while, and are likely to survive
+    // for a while longer, so we keep them apart from the ones clients are writing.
+    // That way the extents that clients fill turn into garbage quickly, and the
+    // ones that the GC fills rarely need to be GCed again.
+    gc_entry_t **const extent = gc_data_timestamp.has_value()
+        ? &gc_active_extent
+        : &active_extent;
+    const kiloticks_t data_timestamp = gc_data_timestamp.has_value()
+        ? gc_data_timestamp.get()
+        : get_kiloticks();
+
     // Start a new extent if necessary.
-    if (active_extent == nullptr) {
-        active_extent = new gc_entry_t(this);
+    if (*extent == nullptr) {
+        *extent = new gc_entry_t(this);
         ++stats->pm_serializer_data_extents_allocated;
     }
 
 
-    guarantee(active_extent->state == gc_entry_t::state_active);
+    guarantee((*extent)->state == gc_entry_t::state_active);
 
     std::vector<std::vector<counted_t<block_token_t>>> ret;
     uint64_t cumulative_aligned_size = 0;
@@ -1468,26 +1599,26 @@ data_block_manager_t::gimme_some_new_offsets(const buf_write_info_t *writes,
         uint32_t relative_offset = valgrind_undefined<uint32_t>(UINT32_MAX);
         unsigned int block_index = valgrind_undefined<unsigned int>(UINT_MAX);
         cumulative_aligned_size += gc_entry_t::aligned_value(block_size);
-        if (!active_extent->new_offset(block_size,
-                                       &relative_offset, &block_index)) {
-            // Move the active_extent gc_entry_t to the young extent queue (if it's
+        if (!(*extent)->new_offset(block_size,
+                                   &relative_offset, &block_index)) {
+            // Move the active extent's gc_entry_t to the young extent queue (if it's
             // not already empty), and make a new gc_entry_t.
-            if (active_extent->num_live_blocks() == 0) {
-                gc_entry_t *old_active_extent = active_extent;
-                active_extent = new gc_entry_t(this);
+            if ((*extent)->num_live_blocks() == 0) {
+                gc_entry_t *old_active_extent = *extent;
+                *extent = new gc_entry_t(this);
                 destroy_entry(old_active_extent);
             } else {
-                active_extent->state = gc_entry_t::state_young;
-                active_extent->shrink_to_fit();
-                young_extent_queue.push_back(active_extent);
+                (*extent)->state = gc_entry_t::state_young;
+                (*extent)->shrink_to_fit();
+                young_extent_queue.push_back(*extent);
                 mark_unyoung_entries();
-                active_extent = new gc_entry_t(this);
+                *extent = new gc_entry_t(this);
             }
 
             ++stats->pm_serializer_data_extents_allocated;
-            const bool succeeded = active_extent->new_offset(block_size,
-                                                             &relative_offset,
-                                                             &block_index);
+            const bool succeeded = (*extent)->new_offset(block_size,
+                                                         &relative_offset,
+                                                         &block_index);
             guarantee(succeeded);
 
             // Push the current group of tokens, if it's nonempty, onto the return
@@ -1498,11 +1629,14 @@ data_block_manager_t::gimme_some_new_offsets(const buf_write_info_t *writes,
             }
         }
 
-        const int64_t offset = active_extent->extent_ref.offset() + relative_offset;
-        active_extent->was_written = true;
-        active_extent->mark_live_tokenwise(block_index);
+        const int64_t offset = (*extent)->extent_ref.offset() + relative_offset;
+        (*extent)->was_written = true;
+        (*extent)->mark_live_tokenwise(block_index);
+        (*extent)->data_timestamp.micros
+            = std::max((*extent)->data_timestamp.micros, data_timestamp.micros);
 
-        tokens.push_back(serializer->generate_block_token(offset, block_size));
+        tokens.push_back(serializer->generate_block_token(offset, block_size,
+                                                          block_size));
     }
 
     if (!tokens.empty()) {
@@ -1549,6 +1683,15 @@ void data_block_manager_t::remove_last_unyoung_entry() {
     gc_stats.old_garbage_block_bytes += entry->garbage_bytes();
 }
 
+void data_block_manager_t::maybe_rescore_gc_pq() {
+    ASSERT_NO_CORO_WAITING;
+    const kiloticks_t current_time = get_kiloticks();
+    if (current_time.micros - gc_score_time.micros > GC_RESCORE_INTERVAL.micros) {
+        gc_score_time = current_time;
+        gc_pq.rebuild();
+    }
+}
+
 /* functions for gc structures */
 
 // Answers the following question: We're in the middle of gc'ing, and
@@ -1558,6 +1701,16 @@ bool data_block_manager_t::should_we_keep_gcing() const {
     return gc_enabled && garbage_ratio() > GC_STOP_RATIO;
 }
 
+bool data_block_manager_t::compaction_wants_to_gc() {
+    // An extent with garbage in it always scores higher than one without, so once the
+    // top extent has none, no extent has.
+    return gc_enabled
+        && compacting
+        && compaction_extents_left > 0
+        && !gc_pq.empty()
+        && gc_pq.peak()->garbage_bytes() > 0;
+}
+
 bool data_block_manager_t::should_terminate_one_gc_thread() const {
     const size_t goal_num_active_gcs = compute_gc_concurrency();
     return !gc_enabled || active_gcs.size() > goal_num_active_gcs;
@@ -1571,7 +1724,17 @@ bool data_block_manager_t::do_we_want_to_start_gcing() const {
 }
 
 bool gc_entry_less_t::operator()(const gc_entry_t *x, const gc_entry_t *y) {
-    return x->garbage_bytes() < y->garbage_bytes();
+    return x->gc_score() < y->gc_score();
+}
+
+double gc_cost_benefit(int64_t garbage_bytes, int64_t extent_size, int64_t age_micros) {
+    rassert(garbage_bytes >= 0 && garbage_bytes <= extent_size);
+    const double garbage_fraction = static_cast<double>(garbage_bytes) / extent_size;
+    const double age = std::max(age_micros, GC_MIN_SCORE_AGE.micros);
+    // With u the fraction of live data: the benefit is the free space (1 - u) times
+    // how long it's likely to stay free (age), and the cost is reading the extent (1)
+    // and writing its live data (u).
+    return garbage_fraction * age / (2.0 - garbage_fraction);
 }
 
 /****************
@@ -17,6 +17,7 @@
 #include "serializer/log/config.hpp"
 #include "serializer/log/extent_manager.hpp"
 #include "serializer/types.hpp"
+#include "time.hpp"
 
 class buf_ptr_t;
 class log_serializer_t;
@@ -50,8 +51,10 @@ public:
     static void prepare_initial_metablock(dbm_metablock_mixin_t *mb);
     void start_existing(file_t *dbfile, const dbm_metablock_mixin_t *last_metablock);
 
+    // `disk_block_size` is smaller than `block_size` if the block is stored
+    // compressed, in which case this decompresses it.
     buf_ptr_t read(int64_t off_in, block_size_t block_size,
-                   file_account_t *io_account);
+                   block_size_t disk_block_size, file_account_t *io_account);
 
     /* exposed gc api */
     /* mark a buffer as garbage */
@@ -71,6 +74,13 @@ public:
     /* garbage collect the extents which meet the gc_criterion */
     void start_gc();
 
+    /* Starts GCing every extent that has garbage in it, no matter what the garbage
+    ratio is, until there are no such extents left or we have GCed as many extents as
+    the file had when we started. The GC moves the live blocks into the lowest free
+    extents, so the extents at the end of the file become free and the file shrinks.
+    Logs how much smaller the file got once it's done. */
+    void start_compaction();
+
     void prepare_metablock(dbm_metablock_mixin_t *metablock);
     bool do_we_want_to_start_gcing() const;
 
@@ -85,15 +95,22 @@ public:
     double garbage_ratio() const;
 
     // Potentially computes a checksum of the blocks to be written, depending on config.
-    // Caller may ignore that information, or use it to save an fdatasync.
+    // Caller may ignore that information, or use it to save an fdatasync.  The block
+    // sizes in `writes` are the sizes on disk, and so are the `block_size()`s of the
+    // returned tokens until the caller says otherwise.
+    // `gc_data_timestamp` is set if the GC is relocating the blocks, to the time when
+    // they were written by a client.  Relocated blocks go to their own active extent,
+    // so that they don't get mixed with the blocks that clients are writing.
     std::vector<counted_t<block_token_t> >
     many_writes(const buf_write_info_t *writes,
                 size_t writes_count,
+                const optional<kiloticks_t> &gc_data_timestamp,
                 file_account_t *io_account,
                 iocallback_t *cb);
 
     std::vector<std::vector<counted_t<block_token_t> > >
     gimme_some_new_offsets(const buf_write_info_t *writes, size_t writes_count,
+                           const optional<kiloticks_t> &gc_data_timestamp,
                            uint64_t *cumulative_aligned_size_out);
 
     bool is_gc_active() const;
@@ -151,6 +168,10 @@ private:
     // Tells if we should keep gc'ing.
     bool should_we_keep_gcing() const;
 
+    // Tells if we should keep gc'ing to compact the file, see `start_compaction()`.
+    bool compaction_wants_to_gc();
+    void finish_compaction();
+
     // Checks the size of active_gcs and determines whether at least one
     // GC thread should terminate.
     bool should_terminate_one_gc_thread() const;
@@ -162,6 +183,10 @@ private:
     // to be not young.
     void remove_last_unyoung_entry();
 
+    // The GC scores extents as of `gc_score_time`. This moves `gc_score_time` to
+    // now and reorders `gc_pq` if it's been more than GC_RESCORE_INTERVAL.
+    void maybe_rescore_gc_pq();
+
     void destroy_entry(gc_entry_t *entry);
 
     bool should_perform_read_ahead(int64_t offset);
@@ -182,6 +207,15 @@ private:
 
     bool gc_enabled;
 
+    /* Whether a compaction is in progress (see `start_compaction()`), how many more
+    extents it may GC, and how many it has GCed. We also remember when it started and
+    how large the file was then, to report it. */
+    bool compacting;
+    size_t compaction_extents_left;
+    size_t compaction_extents_gced;
+    ticks_t compaction_start_time;
+    int64_t compaction_start_file_size;
+
     const log_serializer_on_disk_static_config_t* const static_config;
 
     extent_manager_t *const extent_manager;
@@ -198,15 +232,24 @@ private:
     /* Contains every extent in the gc_entry_t::state_reconstructing state */
     intrusive_list_t<gc_entry_t> reconstructed_extents;
 
-    /* Contains the extent in the gc_entry_t::state_active state. */
+    /* Contains the extent in the gc_entry_t::state_active state that clients write
+    to. */
     gc_entry_t *active_extent;
 
+    /* Contains the extent in the gc_entry_t::state_active state that the GC moves
+    live blocks to. Unlike `active_extent`, it isn't recorded in the metablock. */
+    gc_entry_t *gc_active_extent;
+
     /* Contains every extent in the gc_entry_t::state_young state */
     intrusive_list_t<gc_entry_t> young_extent_queue;
 
     /* Contains every extent in the gc_entry_t::state_old state */
     priority_queue_t<gc_entry_t *, gc_entry_less_t> gc_pq;
 
+    /* The time as of which the extents in `gc_pq` are scored, see
+    `gc_cost_benefit()`. */
+    kiloticks_t gc_score_time;
+
     /* \brief structure to keep track of global stats about the data blocks
      */
     class gc_stat_t {
@@ -283,4 +326,12 @@ void unaligned_read_ahead_interval(const int64_t block_offset,
                                    int64_t *const offset_out,
                                    int64_t *const end_offset_out);
 
+// Exposed for unit tests.  The priority of GCing an extent that has `garbage_bytes`
+// bytes of garbage out of `extent_size`, and whose youngest block is `age_micros` old.
+// This is the cost-benefit policy from LFS: freeing the garbage takes reading the
+// extent and writing its live data, and blocks that have been left alone for a long
+// time are likely to stay live, so old extents are worth cleaning earlier than young
+// ones with as much garbage.
+double gc_cost_benefit(int64_t garbage_bytes, int64_t extent_size, int64_t age_micros);
+
 #endif /* SERIALIZER_LOG_DATA_BLOCK_MANAGER_HPP_ */
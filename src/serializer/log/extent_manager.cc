@@ -2,19 +2,35 @@
 #include "serializer/log/extent_manager.hpp"
 
 #include <queue>
+#include <set>
 
 #include "arch/arch.hpp"
+#include "arch/timing.hpp"
+#include "concurrency/auto_drainer.hpp"
 #include "logger.hpp"
 #include "math.hpp"
 #include "perfmon/perfmon.hpp"
 #include "serializer/log/log_serializer.hpp"
 
+static int64_t hole_punching_rate = 0;
+
+void set_hole_punching_rate(int64_t bytes_per_sec) {
+    guarantee(bytes_per_sec >= 0);
+    hole_punching_rate = bytes_per_sec;
+}
+
+int64_t get_hole_punching_rate() {
+    return hole_punching_rate;
+}
+
 struct extent_info_t {
 public:
     enum state_t {
         state_unreserved,
         state_in_use,
-        state_free
+        state_free,
+        // Free, but a hole is being punched into it, so it can't be handed out yet.
+        state_punching
     };
 private:
     state_t state_;
@@ -71,6 +87,14 @@ class extent_zone_t {
     // The number of free extents in the file.
     size_t held_extents_;
 
+    // If we punch holes, the free extents that we haven't punched a hole into yet.
+    bool punch_holes_;
+    std::set<size_t> punch_candidates;
+
+    // Extents that `gen_extent()` took off the free queue because a hole was being
+    // punched into them. They go back once that's done.
+    std::vector<size_t> skipped_while_punching;
+
 public:
     size_t held_extents() const {
         return held_extents_;
@@ -78,7 +102,8 @@ public:
 
     extent_zone_t(file_t *_dbfile, uint64_t _extent_size,
                   log_serializer_stats_t *_stats)
-        : extent_size(_extent_size), dbfile(_dbfile), stats(_stats), held_extents_(0) {
+        : extent_size(_extent_size), dbfile(_dbfile), stats(_stats), held_extents_(0),
+          punch_holes_(false) {
         // (Avoid a bunch of reallocations by resize calls (avoiding O(n log n)
         // work on average).)
         extents.reserve(dbfile->get_file_size() / extent_size);
@@ -108,13 +133,77 @@ public:
                 extents[extent_id].set_state(extent_info_t::state_free);
                 free_queue.push(extent_id);
                 ++held_extents_;
+                // We don't know if we punched a hole into it before.
+                if (punch_holes_) {
+                    punch_candidates.insert(extent_id);
+                }
             }
         }
     }
 
+    void set_punch_holes(bool punch_holes) {
+        punch_holes_ = punch_holes;
+        if (!punch_holes_) {
+            punch_candidates.clear();
+        }
+    }
+
+    // Picks runs of adjacent free extents to punch holes into, of up to `max_extents`
+    // extents in total, and marks them as `state_punching`. The runs are pairs of the
+    // first extent id and the number of extents.
+    void start_punching(size_t max_extents,
+                        std::vector<std::pair<size_t, size_t> > *runs_out) {
+        size_t num_extents = 0;
+        auto it = punch_candidates.begin();
+        while (it != punch_candidates.end() && num_extents < max_extents) {
+            const size_t id = *it;
+            it = punch_candidates.erase(it);
+            // It might have been handed out again, or cut off the end of the file.
+            if (id >= extents.size() || extents[id].state() != extent_info_t::state_free) {
+                continue;
+            }
+            extents[id].set_state(extent_info_t::state_punching);
+            if (!runs_out->empty()
+                && runs_out->back().first + runs_out->back().second == id) {
+                ++runs_out->back().second;
+            } else {
+                runs_out->push_back(std::make_pair(id, 1));
+            }
+            ++num_extents;
+        }
+    }
+
+    void finish_punching(size_t first_extent, size_t num_extents) {
+        for (size_t id = first_extent; id < first_extent + num_extents; ++id) {
+            guarantee(extents[id].state() == extent_info_t::state_punching);
+            extents[id].set_state(extent_info_t::state_free);
+        }
+
+        for (auto it = skipped_while_punching.begin();
+             it != skipped_while_punching.end();) {
+            if (extents[*it].state() == extent_info_t::state_free) {
+                free_queue.push(*it);
+                ++held_extents_;
+                it = skipped_while_punching.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        try_shrink_file();
+    }
+
     extent_reference_t gen_extent() {
         int64_t extent;
 
+        while (!free_queue.empty()
+               && free_queue.top() < extents.size()
+               && extents[free_queue.top()].state() == extent_info_t::state_punching) {
+            skipped_while_punching.push_back(free_queue.top());
+            free_queue.pop();
+            --held_extents_;
+        }
+
         if (free_queue.empty()) {
             rassert(held_extents_ == 0);
             extent = extents.size() * extent_size;
@@ -213,6 +302,9 @@ public:
             info->set_state(extent_info_t::state_free);
             free_queue.push(offset_to_id(extent));
             ++held_extents_;
+            if (punch_holes_) {
+                punch_candidates.insert(offset_to_id(extent));
+            }
             try_shrink_file();
         }
     }
@@ -221,8 +313,9 @@ public:
 extent_manager_t::extent_manager_t(file_t *file,
                                    const log_serializer_on_disk_static_config_t *static_config,
                                    log_serializer_stats_t *_stats)
-    : stats(_stats), extent_size(static_config->extent_size()),
-      state(state_reserving_extents) {
+    : stats(_stats), extent_size(static_config->extent_size()), dbfile(file),
+      state(state_reserving_extents),
+      punch_rate(get_hole_punching_rate()), punch_budget(0), punches_in_progress(0) {
     guarantee(divides(DEVICE_BLOCK_SIZE, extent_size));
 
     zone.init(new extent_zone_t(file, extent_size, stats));
@@ -247,11 +340,102 @@ void extent_manager_t::start_existing() {
     assert_thread();
     rassert(state == state_reserving_extents);
     current_transaction = nullptr;
+    if (punch_rate > 0) {
+        zone->set_punch_holes(true);
+        punch_io_account.init(new file_account_t(dbfile, HOLE_PUNCHING_IO_PRIORITY,
+                                                 UNLIMITED_OUTSTANDING_REQUESTS,
+                                                 file_io_class_t::background));
+        punch_drainer.init(new auto_drainer_t);
+        punch_timer.init(new repeating_timer_t(
+            HOLE_PUNCHING_INTERVAL_MS,
+            std::bind(&extent_manager_t::punch_some_holes, this)));
+    }
     zone->reconstruct_free_list();
     state = state_running;
 
 }
 
+class extent_manager_t::hole_punch_cb_t : public linux_iocallback_t {
+public:
+    hole_punch_cb_t(extent_manager_t *_parent, size_t _first_extent,
+                    size_t _num_extents)
+        : parent(_parent), first_extent(_first_extent), num_extents(_num_extents),
+          drainer_lock(parent->punch_drainer->lock()) { }
+
+    void on_io_complete() {
+        parent->on_hole_punched(first_extent, num_extents, 0);
+        delete this;
+    }
+
+    void on_io_failure(int errsv, int64_t, int64_t) {
+        parent->on_hole_punched(first_extent, num_extents, errsv);
+        delete this;
+    }
+
+private:
+    extent_manager_t *const parent;
+    const size_t first_extent;
+    const size_t num_extents;
+    auto_drainer_t::lock_t drainer_lock;
+};
+
+void extent_manager_t::punch_some_holes() {
+    assert_thread();
+    rassert(state == state_running);
+    // We let the budget build up for a second at most, but always enough to punch an
+    // extent.
+    punch_budget = std::min<int64_t>(
+        punch_budget + punch_rate * HOLE_PUNCHING_INTERVAL_MS / 1000,
+        std::max<int64_t>(punch_rate, extent_size));
+    if (punches_in_progress > 0) {
+        return;
+    }
+
+    std::vector<std::pair<size_t, size_t> > runs;
+    zone->start_punching(punch_budget / extent_size, &runs);
+    for (const auto &run : runs) {
+        punch_budget -= run.second * extent_size;
+        ++punches_in_progress;
+        dbfile->punch_hole_async(run.first * extent_size, run.second * extent_size,
+                                 punch_io_account.get(),
+                                 new hole_punch_cb_t(this, run.first, run.second));
+    }
+}
+
+void extent_manager_t::on_hole_punched(size_t first_extent, size_t num_extents,
+                                       int errsv) {
+    assert_thread();
+    --punches_in_progress;
+    zone->finish_punching(first_extent, num_extents);
+    if (errsv == 0) {
+        stats->pm_hole_punched_bytes += num_extents * extent_size;
+    } else if (punch_timer.has()) {
+        // The extents are free, so it doesn't matter what's left of their contents.
+        // Punching holes is only an optimization, so we stop doing it instead of
+        // failing.
+        if (errsv == EOPNOTSUPP || errsv == ENOSYS) {
+            logNTC("The file system doesn't support punching holes into files. The "
+                   "space of free extents stays allocated to the data files.");
+        } else {
+            logWRN("Could not punch a hole into a data file: %s (offset = %" PRIu64
+                   ", size = %" PRIu64 "). The space of its free extents stays "
+                   "allocated to it.",
+                   errno_string(errsv).c_str(), first_extent * extent_size,
+                   num_extents * extent_size);
+        }
+        zone->set_punch_holes(false);
+        punch_timer.reset();
+    }
+}
+
+void extent_manager_t::stop_punching_holes() {
+    assert_thread();
+    punch_timer.reset();
+    punch_drainer.reset();
+    rassert(punches_in_progress == 0);
+    zone->set_punch_holes(false);
+}
+
 void extent_manager_t::prepare_metablock(extent_manager_metablock_mixin_t *metablock) {
     assert_thread();
     rassert(state == state_running);
@@ -16,7 +16,9 @@
 
 #define NULL_OFFSET int64_t(-1)
 
+class auto_drainer_t;
 class extent_zone_t;
+class repeating_timer_t;
 
 struct log_serializer_stats_t;
 struct extent_manager_metablock_mixin_t;
@@ -92,6 +94,13 @@ private:
     DISABLE_COPYING(extent_transaction_t);
 };
 
+/* How many bytes per second of free extents the extent managers of tables punch out of
+their files (with `fallocate(FALLOC_FL_PUNCH_HOLE)`), so that the file system and the
+disk know that their contents are garbage. 0 turns it off. Only affects extent
+managers that start after it's set. */
+void set_hole_punching_rate(int64_t bytes_per_sec);
+int64_t get_hole_punching_rate();
+
 class extent_manager_t : public home_thread_mixin_debug_only_t {
 public:
     extent_manager_t(file_t *file,
@@ -107,6 +116,9 @@ public:
     static void prepare_initial_metablock(extent_manager_metablock_mixin_t *mb);
     void start_existing();
     void prepare_metablock(extent_manager_metablock_mixin_t *metablock);
+    // Stops punching holes and waits for the ones in progress. Must be called before
+    // `shutdown()` if the extent manager was started. Can block.
+    void stop_punching_holes();
     void shutdown();
 
     /* The extent manager uses transactions to make sure that extents are not freed
@@ -135,8 +147,17 @@ public:
     const uint64_t extent_size;   /* Same as static_config->extent_size */
 
 private:
+    class hole_punch_cb_t;
+
     void release_extent_preliminaries();
 
+    // Called by `punch_timer`. Starts punching holes into the free extents, as far as
+    // the rate allows.
+    void punch_some_holes();
+    void on_hole_punched(size_t first_extent, size_t num_extents, int errsv);
+
+    file_t *const dbfile;
+
     scoped_ptr_t<extent_zone_t> zone;
 
     /* During serializer startup, each component informs the extent manager
@@ -151,6 +172,17 @@ private:
 
     extent_transaction_t *current_transaction;
 
+    /* Free extents are punched out of the file in batches of adjacent extents, every
+    HOLE_PUNCHING_INTERVAL_MS. `punch_budget` is how many bytes we can punch without
+    going over `punch_rate`. While a batch is in progress, its extents can't be
+    handed out by `gen_extent()`. */
+    int64_t punch_rate;
+    int64_t punch_budget;
+    int punches_in_progress;
+    scoped_ptr_t<file_account_t> punch_io_account;
+    scoped_ptr_t<repeating_timer_t> punch_timer;
+    scoped_ptr_t<auto_drainer_t> punch_drainer;
+
     DISABLE_COPYING(extent_manager_t);
 };
 #endif /* SERIALIZER_LOG_EXTENT_MANAGER_HPP_ */
@@ -64,8 +64,13 @@ ATTR_PACKED(struct lba_entry_t {
     // the first 16 bits, perhaps, as a version flag.
     uint32_t zero_reserved;
 
-    // This could be a uint16_t if you wanted it to be, as long as block sizes are
-    // all less than or equal to 4K (which is less than 64K).
+    // The lower 16 bits hold the block's size (its `block_size_t::ser_value()`). If
+    // the block is stored compressed (see serializer/log/block_compression.hpp), the
+    // upper 16 bits hold the number of bytes it takes up on disk, which is smaller.
+    // Otherwise they are zero, which is what older versions always wrote.  Older
+    // versions would take a compressed block's size for a huge block size, so the
+    // metablocks of a file with compressed blocks have MB_FEATURE_COMPRESSED_BLOCKS
+    // set, which they reject.
     uint32_t ser_block_size;
 
     block_id_t block_id;
@@ -76,24 +81,37 @@ ATTR_PACKED(struct lba_entry_t {
     flagged_off64_t offset;
 
     static lba_entry_t make(block_id_t block_id, repli_timestamp_t recency,
-                            flagged_off64_t offset, uint16_t ser_block_size) {
+                            flagged_off64_t offset, uint16_t ser_block_size,
+                            uint16_t disk_block_size) {
         guarantee(ser_block_size != 0 || !offset.has_value());
+        guarantee(disk_block_size <= ser_block_size);
         lba_entry_t entry;
         entry.zero_reserved = 0;
-        entry.ser_block_size = ser_block_size;
+        entry.ser_block_size = disk_block_size == ser_block_size
+            ? ser_block_size
+            : (static_cast<uint32_t>(disk_block_size) << 16) | ser_block_size;
         entry.block_id = block_id;
         entry.recency = recency;
         entry.offset = offset;
         return entry;
     }
 
+    uint16_t get_ser_block_size() const {
+        return ser_block_size & 0xFFFF;
+    }
+
+    uint16_t get_disk_block_size() const {
+        const uint16_t disk_block_size = ser_block_size >> 16;
+        return disk_block_size == 0 ? get_ser_block_size() : disk_block_size;
+    }
+
     static bool is_padding(const lba_entry_t *entry) {
         return entry->block_id == PADDING_BLOCK_ID  && entry->offset.is_padding();
     }
 
     static lba_entry_t make_padding_entry() {
         return make(PADDING_BLOCK_ID, repli_timestamp_t::invalid,
-                    flagged_off64_t::padding(), 0);
+                    flagged_off64_t::padding(), 0, 0);
     }
 });
 
@@ -70,6 +70,7 @@ void lba_disk_structure_t::on_extent_read() {
 
 void lba_disk_structure_t::add_entry(block_id_t block_id, repli_timestamp_t recency,
                                      flagged_off64_t offset, uint16_t ser_block_size,
+                                     uint16_t disk_block_size,
                                      file_account_t *io_account,
                                      extent_transaction_t *txn,
                                      optional<std::vector<checksum_filerange>> *checksums) {
@@ -91,7 +92,8 @@ void lba_disk_structure_t::add_entry(block_id_t block_id, repli_timestamp_t rece
 
     rassert(!last_extent->full());
 
-    last_extent->add_entry(lba_entry_t::make(block_id, recency, offset, ser_block_size),
+    last_extent->add_entry(lba_entry_t::make(block_id, recency, offset,
+                                             ser_block_size, disk_block_size),
                            io_account, checksums);
 }
 
@@ -3,10 +3,185 @@
 
 #include <inttypes.h>
 
+#include <algorithm>
+
+#include "containers/scoped.hpp"
+#include "math.hpp"
 #include "serializer/log/lba/disk_format.hpp"
+#include "serializer/log/stats.hpp"
+
+/* A chunk of the in-memory index starts out compact. Every entry then takes a single
+64-bit word, laid out as
+
+    bits  0-35: the offset in DEVICE_BLOCK_SIZE units plus one, or 0 if it's unused
+    bits 36-49: the ser_block_size
+    bits 50-63: the disk_block_size
+
+plus (except in aux chunks) a 32-bit recency, relative to the chunk's base recency. The
+recency is stored plus one, so that 0 can stand for `repli_timestamp_t::invalid`. An
+all-zero entry is the default `index_block_info_t`.
+
+That covers files of up to 32TB and blocks of up to 16KB, and recencies within four
+billion writes of each other, which in practice is everything. If an entry comes along
+that doesn't fit anyway, the chunk switches to storing plain `index_block_info_t`s for
+the rest of its life. */
+class in_memory_index_chunk_t {
+public:
+    explicit in_memory_index_chunk_t(bool with_recencies)
+        : count_(0), with_recencies_(with_recencies),
+          has_base_recency_(false), base_recency_(0),
+          packed_(IN_MEMORY_INDEX_CHUNK_SIZE) {
+        std::fill(packed_.data(), packed_.data() + packed_.size(), 0);
+        if (with_recencies_) {
+            recencies_.init(IN_MEMORY_INDEX_CHUNK_SIZE);
+            std::fill(recencies_.data(), recencies_.data() + recencies_.size(), 0);
+        }
+    }
+
+    size_t count() const { return count_; }
+
+    size_t memory_usage() const {
+        size_t ret = sizeof(*this);
+        if (wide_.has()) {
+            ret += wide_.size() * sizeof(index_block_info_t);
+        } else {
+            ret += packed_.size() * sizeof(uint64_t);
+            if (with_recencies_) {
+                ret += recencies_.size() * sizeof(uint32_t);
+            }
+        }
+        return ret;
+    }
+
+    index_block_info_t get(size_t index) const {
+        if (wide_.has()) {
+            return wide_[index];
+        }
+        const uint64_t packed = packed_[index];
+        const uint64_t offset_plus_one = packed & OFFSET_MASK;
+        index_block_info_t info;
+        if (offset_plus_one != 0) {
+            info.offset = flagged_off64_t::make(
+                static_cast<int64_t>(offset_plus_one - 1) * DEVICE_BLOCK_SIZE);
+        }
+        info.ser_block_size = (packed >> SER_BLOCK_SIZE_SHIFT) & BLOCK_SIZE_MASK;
+        info.disk_block_size = packed >> DISK_BLOCK_SIZE_SHIFT;
+        if (with_recencies_ && recencies_[index] != 0) {
+            info.recency.longtime = base_recency_ + recencies_[index] - 1;
+        }
+        return info;
+    }
 
-in_memory_index_t::in_memory_index_t()
-    : end_block_id_(0), end_aux_block_id_(FIRST_AUX_BLOCK_ID) { }
+    void set(size_t index, const index_block_info_t &info) {
+        const index_block_info_t empty;
+        if (!(get(index) == empty)) {
+            --count_;
+        }
+        if (!(info == empty)) {
+            ++count_;
+        }
+
+        if (!wide_.has()) {
+            uint64_t packed;
+            uint32_t recency;
+            if (encode(info, &packed, &recency)) {
+                packed_[index] = packed;
+                if (with_recencies_) {
+                    recencies_[index] = recency;
+                }
+                return;
+            }
+            convert_to_wide();
+        }
+        wide_[index] = info;
+    }
+
+private:
+    static const int SER_BLOCK_SIZE_SHIFT = 36;
+    static const int DISK_BLOCK_SIZE_SHIFT = 50;
+    static const uint64_t OFFSET_MASK = (uint64_t(1) << SER_BLOCK_SIZE_SHIFT) - 1;
+    static const uint64_t BLOCK_SIZE_MASK
+        = (uint64_t(1) << (DISK_BLOCK_SIZE_SHIFT - SER_BLOCK_SIZE_SHIFT)) - 1;
+
+    bool encode(const index_block_info_t &info,
+                uint64_t *packed_out, uint32_t *recency_out) {
+        uint64_t offset_plus_one = 0;
+        if (info.offset.has_value()) {
+            const int64_t offset = info.offset.get_value();
+            if (!divides(DEVICE_BLOCK_SIZE, offset)
+                || static_cast<uint64_t>(offset / DEVICE_BLOCK_SIZE) >= OFFSET_MASK) {
+                return false;
+            }
+            offset_plus_one = offset / DEVICE_BLOCK_SIZE + 1;
+        } else if (!(info.offset == flagged_off64_t::unused())) {
+            return false;
+        }
+        if (info.ser_block_size > BLOCK_SIZE_MASK
+            || info.disk_block_size > BLOCK_SIZE_MASK) {
+            return false;
+        }
+        *packed_out = offset_plus_one
+            | (static_cast<uint64_t>(info.ser_block_size) << SER_BLOCK_SIZE_SHIFT)
+            | (static_cast<uint64_t>(info.disk_block_size) << DISK_BLOCK_SIZE_SHIFT);
+
+        *recency_out = 0;
+        if (info.recency != repli_timestamp_t::invalid) {
+            if (!with_recencies_) {
+                return false;
+            }
+            if (!has_base_recency_) {
+                // Leave room for recencies on either side of the first one.
+                const uint64_t half_range = uint64_t(1) << 31;
+                base_recency_ = info.recency.longtime >= half_range
+                    ? info.recency.longtime - half_range
+                    : 0;
+                has_base_recency_ = true;
+            }
+            if (info.recency.longtime < base_recency_
+                || info.recency.longtime - base_recency_ >= UINT32_MAX) {
+                return false;
+            }
+            *recency_out = info.recency.longtime - base_recency_ + 1;
+        }
+        return true;
+    }
+
+    void convert_to_wide() {
+        scoped_array_t<index_block_info_t> wide(IN_MEMORY_INDEX_CHUNK_SIZE);
+        for (size_t i = 0; i < IN_MEMORY_INDEX_CHUNK_SIZE; ++i) {
+            wide[i] = get(i);
+        }
+        wide_ = std::move(wide);
+        packed_.reset();
+        recencies_.reset();
+    }
+
+    size_t count_;
+    const bool with_recencies_;
+    bool has_base_recency_;
+    uint64_t base_recency_;
+
+    // Either `packed_` (and `recencies_` if `with_recencies_`) or `wide_` is set.
+    scoped_array_t<uint64_t> packed_;
+    scoped_array_t<uint32_t> recencies_;
+    scoped_array_t<index_block_info_t> wide_;
+
+    DISABLE_COPYING(in_memory_index_chunk_t);
+};
+
+in_memory_index_t::in_memory_index_t(log_serializer_stats_t *stats)
+    : stats_(stats), end_block_id_(0), end_aux_block_id_(FIRST_AUX_BLOCK_ID),
+      memory_usage_(0), num_blocks_(0) { }
+
+in_memory_index_t::~in_memory_index_t() {
+    for (in_memory_index_chunk_t *chunk : chunks_) {
+        delete chunk;
+    }
+    for (in_memory_index_chunk_t *chunk : aux_chunks_) {
+        delete chunk;
+    }
+    account(-memory_usage_, -num_blocks_);
+}
 
 block_id_t in_memory_index_t::end_block_id() {
     return end_block_id_;
@@ -17,20 +192,21 @@ block_id_t in_memory_index_t::end_aux_block_id() {
 }
 
 index_block_info_t in_memory_index_t::get_block_info(block_id_t id) {
-    if (is_aux_block_id(id)) {
-        index_aux_block_info_t aux_info
-            = aux_infos_.get(make_aux_block_id_relative(id));
-        return index_block_info_t(aux_info.offset,
-                                  repli_timestamp_t::invalid,
-                                  aux_info.ser_block_size);
+    const bool aux = is_aux_block_id(id);
+    const std::vector<in_memory_index_chunk_t *> &chunks = aux ? aux_chunks_ : chunks_;
+    const uint64_t key = aux ? make_aux_block_id_relative(id) : id;
+    const uint64_t chunk_id = key / IN_MEMORY_INDEX_CHUNK_SIZE;
+    if (chunk_id < chunks.size() && chunks[chunk_id] != nullptr) {
+        return chunks[chunk_id]->get(key % IN_MEMORY_INDEX_CHUNK_SIZE);
     } else {
-        return infos_.get(id);
+        return index_block_info_t();
     }
 }
 
 void in_memory_index_t::set_block_info(block_id_t id, repli_timestamp_t recency,
                                        flagged_off64_t offset,
-                                       uint16_t ser_block_size) {
+                                       uint16_t ser_block_size,
+                                       uint16_t disk_block_size) {
     if (is_aux_block_id(id)) {
         if (id >= end_aux_block_id_) {
             end_aux_block_id_ = id + 1;
@@ -39,14 +215,58 @@ void in_memory_index_t::set_block_info(block_id_t id, repli_timestamp_t recency,
         // other than `invalid`, you might be doing something wrong. It will be
         // discarded anyway.
         rassert(recency == repli_timestamp_t::invalid);
-        index_aux_block_info_t info(offset, ser_block_size);
-        aux_infos_.set(make_aux_block_id_relative(id), info);
+        index_block_info_t info(offset, repli_timestamp_t::invalid,
+                                ser_block_size, disk_block_size);
+        set_in_chunks(&aux_chunks_, false, make_aux_block_id_relative(id), info);
     } else {
         if (id >= end_block_id_) {
             end_block_id_ = id + 1;
         }
-        index_block_info_t info(offset, recency, ser_block_size);
-        infos_.set(id, info);
+        index_block_info_t info(offset, recency, ser_block_size, disk_block_size);
+        set_in_chunks(&chunks_, true, id, info);
+    }
+}
+
+void in_memory_index_t::set_in_chunks(std::vector<in_memory_index_chunk_t *> *chunks,
+                                      bool with_recencies, uint64_t key,
+                                      const index_block_info_t &info) {
+    const uint64_t chunk_id = key / IN_MEMORY_INDEX_CHUNK_SIZE;
+    const size_t old_capacity = chunks->capacity();
+    if (chunk_id >= chunks->size() || (*chunks)[chunk_id] == nullptr) {
+        if (info == index_block_info_t()) {
+            return;
+        }
+        if (chunk_id >= chunks->size()) {
+            chunks->resize(chunk_id + 1, nullptr);
+        }
+        (*chunks)[chunk_id] = new in_memory_index_chunk_t(with_recencies);
+        account((*chunks)[chunk_id]->memory_usage(), 0);
     }
+
+    in_memory_index_chunk_t *chunk = (*chunks)[chunk_id];
+    const size_t old_memory_usage = chunk->memory_usage();
+    const bool had_offset
+        = chunk->get(key % IN_MEMORY_INDEX_CHUNK_SIZE).offset.has_value();
+    chunk->set(key % IN_MEMORY_INDEX_CHUNK_SIZE, info);
+    account(static_cast<int64_t>(chunk->memory_usage()) - old_memory_usage,
+            static_cast<int64_t>(info.offset.has_value()) - had_offset);
+
+    if (chunk->count() == 0) {
+        account(-static_cast<int64_t>(chunk->memory_usage()), 0);
+        (*chunks)[chunk_id] = nullptr;
+        delete chunk;
+
+        while (!chunks->empty() && chunks->back() == nullptr) {
+            chunks->pop_back();
+        }
+    }
+    account((static_cast<int64_t>(chunks->capacity()) - old_capacity)
+            * sizeof(in_memory_index_chunk_t *), 0);
 }
 
+void in_memory_index_t::account(int64_t memory_delta, int64_t blocks_delta) {
+    memory_usage_ += memory_delta;
+    num_blocks_ += blocks_delta;
+    stats_->pm_serializer_lba_index_bytes += memory_delta;
+    stats_->pm_serializer_lba_index_blocks += blocks_delta;
+}
@@ -2,8 +2,9 @@
 #ifndef SERIALIZER_LOG_LBA_IN_MEMORY_INDEX_HPP_
 #define SERIALIZER_LOG_LBA_IN_MEMORY_INDEX_HPP_
 
+#include <vector>
+
 #include "arch/compiler.hpp"
-#include "containers/two_level_array.hpp"
 #include "config/args.hpp"
 #include "serializer/serializer.hpp"
 #include "serializer/log/lba/disk_format.hpp"
@@ -12,60 +13,48 @@ ATTR_PACKED(struct index_block_info_t {
     index_block_info_t()
         : offset(flagged_off64_t::unused()),
           recency(repli_timestamp_t::invalid),
-          ser_block_size(0) { }
+          ser_block_size(0),
+          disk_block_size(0) { }
 
     index_block_info_t(flagged_off64_t _offset,
                        repli_timestamp_t _recency,
-                       uint16_t _ser_block_size)
+                       uint16_t _ser_block_size,
+                       uint16_t _disk_block_size)
         : offset(_offset),
           recency(_recency),
-          ser_block_size(_ser_block_size) { }
+          ser_block_size(_ser_block_size),
+          disk_block_size(_disk_block_size) { }
 
-    // For two_level_array_t.
     bool operator==(const index_block_info_t &other) const {
         return offset == other.offset &&
             recency == other.recency &&
-            ser_block_size == other.ser_block_size;
+            ser_block_size == other.ser_block_size &&
+            disk_block_size == other.disk_block_size;
     }
 
     flagged_off64_t offset;
     repli_timestamp_t recency;
     uint16_t ser_block_size;
+    // Smaller than `ser_block_size` if the block is stored compressed.
+    uint16_t disk_block_size;
 });
 
-/* This is a reduced-size block info for auxiliary blocks (currently
-blob blocks used for large values). It doesn't store a replication
-timestamp, because we don't need it for those blocks. */
-ATTR_PACKED(struct index_aux_block_info_t {
-    index_aux_block_info_t()
-        : offset(flagged_off64_t::unused()),
-          ser_block_size(0) { }
-
-    index_aux_block_info_t(flagged_off64_t _offset,
-                           uint16_t _ser_block_size)
-        : offset(_offset),
-          ser_block_size(_ser_block_size) { }
-
-    // For two_level_array_t.
-    bool operator==(const index_aux_block_info_t &other) const {
-        return offset == other.offset &&
-            ser_block_size == other.ser_block_size;
-    }
-
-    flagged_off64_t offset;
-    uint16_t ser_block_size;
-});
-
+struct log_serializer_stats_t;
+class in_memory_index_chunk_t;
 
+/* The in-memory index holds an `index_block_info_t` for every block id. It splits the
+block ids into chunks of `IN_MEMORY_INDEX_CHUNK_SIZE`, and stores each chunk in a compact
+form as long as all of its entries fit into it: 12 bytes per block (8 for auxiliary
+blocks, which don't have a recency) instead of the 20 of an `index_block_info_t`. See
+in_memory_index.cc for the encoding. Lookups are O(1) either way.
 
+The memory the index uses is reported as "serializer_lba_index_bytes" in the stats,
+along with the number of blocks it holds (that is, that have an offset) and the bytes
+per block. */
 class in_memory_index_t {
-    two_level_array_t<index_block_info_t> infos_;
-    block_id_t end_block_id_;
-    two_level_array_t<index_aux_block_info_t> aux_infos_;
-    block_id_t end_aux_block_id_;
-
 public:
-    in_memory_index_t();
+    explicit in_memory_index_t(log_serializer_stats_t *stats);
+    ~in_memory_index_t();
 
     // end_block_id is one greater than the maximum used block id.
     block_id_t end_block_id();
@@ -73,8 +62,31 @@ public:
 
     index_block_info_t get_block_info(block_id_t id);
     void set_block_info(block_id_t id, repli_timestamp_t recency,
-                        flagged_off64_t offset, uint16_t ser_block_size);
+                        flagged_off64_t offset, uint16_t ser_block_size,
+                        uint16_t disk_block_size);
+
+    // The number of bytes the index takes up.
+    int64_t memory_usage() const { return memory_usage_; }
+    // The number of blocks that have an offset.
+    int64_t num_blocks() const { return num_blocks_; }
+
+private:
+    void set_in_chunks(std::vector<in_memory_index_chunk_t *> *chunks,
+                       bool with_recencies, uint64_t key,
+                       const index_block_info_t &info);
+    void account(int64_t memory_delta, int64_t blocks_delta);
+
+    log_serializer_stats_t *const stats_;
+
+    std::vector<in_memory_index_chunk_t *> chunks_;
+    block_id_t end_block_id_;
+    std::vector<in_memory_index_chunk_t *> aux_chunks_;
+    block_id_t end_aux_block_id_;
+
+    int64_t memory_usage_;
+    int64_t num_blocks_;
 
+    DISABLE_COPYING(in_memory_index_t);
 };
 
 #endif  // SERIALIZER_LOG_LBA_IN_MEMORY_INDEX_HPP_
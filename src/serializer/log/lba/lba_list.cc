@@ -13,7 +13,8 @@
 lba_list_t::lba_list_t(extent_manager_t *em,
         const lba_list_t::write_metablock_fun_t &_write_metablock_fun)
     : gc_drainer(new auto_drainer_t), write_metablock_fun(_write_metablock_fun),
-      extent_manager(em), state(state_unstarted), inline_lba_entries_count(0)
+      extent_manager(em), state(state_unstarted), in_memory_index(em->stats),
+      inline_lba_entries_count(0)
 {
     for (int i = 0; i < LBA_SHARD_FACTOR; i++) {
         gc_active[i] = false;
@@ -101,15 +102,12 @@ public:
             // the metablock into the index:
             for (int32_t i = 0; i < owner->inline_lba_entries_count; ++i) {
                 lba_entry_t *e = &owner->inline_lba_entries[i];
-                // The on-disk format still stores 32 bit block sizes.
-                // We've never actually used them, and we now use 16 bit block sizes
-                // for the in-memory index to save a few bytes.
-                guarantee(e->ser_block_size <= std::numeric_limits<uint16_t>::max());
                 owner->in_memory_index.set_block_info(
                         e->block_id,
                         e->recency,
                         e->offset,
-                        static_cast<uint16_t>(e->ser_block_size));
+                        e->get_ser_block_size(),
+                        e->get_disk_block_size());
             }
 
             owner->state = lba_list_t::state_ready;
@@ -124,7 +122,9 @@ bool lba_list_t::start_existing(file_t *file, lba_metablock_mixin_t *last_metabl
     rassert(state == state_unstarted);
 
     dbfile = file;
-    gc_io_account.init(new file_account_t(dbfile, LBA_GC_IO_PRIORITY));
+    gc_io_account.init(new file_account_t(dbfile, LBA_GC_IO_PRIORITY,
+                                          UNLIMITED_OUTSTANDING_REQUESTS,
+                                          file_io_class_t::background));
 
     lba_start_fsm_t *starter = new lba_start_fsm_t(this, last_metablock);
     if (state == state_ready) {
@@ -164,6 +164,10 @@ block_size_t lba_list_t::get_block_size(block_id_t block) {
     return block_size_t::unsafe_make(get_block_info(block).ser_block_size);
 }
 
+block_size_t lba_list_t::get_disk_block_size(block_id_t block) {
+    return block_size_t::unsafe_make(get_block_info(block).disk_block_size);
+}
+
 repli_timestamp_t lba_list_t::get_block_recency(block_id_t block) {
     return get_block_info(block).recency;
 }
@@ -192,11 +196,13 @@ segmented_vector_t<repli_timestamp_t> lba_list_t::get_block_recencies(block_id_t
 
 void lba_list_t::set_block_info(block_id_t block, repli_timestamp_t recency,
                                 flagged_off64_t offset, uint16_t ser_block_size,
+                                uint16_t disk_block_size,
                                 file_account_t *io_account, extent_transaction_t *txn,
                                 optional<std::vector<checksum_filerange>> *checksums) {
     rassert(state == state_ready || state == state_gc_shutting_down);
 
-    in_memory_index.set_block_info(block, recency, offset, ser_block_size);
+    in_memory_index.set_block_info(block, recency, offset, ser_block_size,
+                                   disk_block_size);
 
     // If the inline LBA is full, free it up first by moving its entries to
     // the LBA extents
@@ -205,7 +211,7 @@ void lba_list_t::set_block_info(block_id_t block, repli_timestamp_t recency,
         rassert(!check_inline_lba_full());
     }
     // Then store the entry inline
-    add_inline_entry(block, recency, offset, ser_block_size);
+    add_inline_entry(block, recency, offset, ser_block_size, disk_block_size);
 }
 
 bool lba_list_t::check_inline_lba_full() const {
@@ -244,7 +250,8 @@ void lba_list_t::move_inline_entries_to_extents(
                 e.block_id,
                 e.recency,
                 e.offset,
-                e.ser_block_size,
+                e.get_ser_block_size(),
+                e.get_disk_block_size(),
                 io_account,
                 txn,
                 checksums);
@@ -254,11 +261,12 @@ void lba_list_t::move_inline_entries_to_extents(
 }
 
 void lba_list_t::add_inline_entry(block_id_t block, repli_timestamp_t recency,
-                                flagged_off64_t offset, uint16_t ser_block_size) {
+                                flagged_off64_t offset, uint16_t ser_block_size,
+                                uint16_t disk_block_size) {
 
     rassert(!check_inline_lba_full());
     inline_lba_entries[inline_lba_entries_count++] =
-            lba_entry_t::make(block, recency, offset, ser_block_size);
+            lba_entry_t::make(block, recency, offset, ser_block_size, disk_block_size);
 }
 
 class lba_writer_t :
@@ -315,15 +323,29 @@ void lba_list_t::write_outstanding(file_account_t *io_account,
 void lba_list_t::consider_gc() {
     for (int i = 0; i < LBA_SHARD_FACTOR; i++) {
         if (we_want_to_gc(i)) {
-            rassert(!gc_active[i]);
-            gc_active[i] = true;
-            coro_t *gc_coro = coro_t::spawn_sometime(std::bind(&lba_list_t::gc,
-                    this, i, auto_drainer_t::lock_t(gc_drainer.get())));
-            gc_coro->set_priority(CORO_PRIORITY_LBA_GC);
+            start_gc(i);
+        }
+    }
+}
+
+void lba_list_t::compact() {
+    for (int i = 0; i < LBA_SHARD_FACTOR; i++) {
+        if (!gc_active[i]
+            && state == lba_list_t::state_ready
+            && disk_structures[i]->superblock_extent != nullptr) {
+            start_gc(i);
         }
     }
 }
 
+void lba_list_t::start_gc(int lba_shard) {
+    rassert(!gc_active[lba_shard]);
+    gc_active[lba_shard] = true;
+    coro_t *gc_coro = coro_t::spawn_sometime(std::bind(&lba_list_t::gc,
+            this, lba_shard, auto_drainer_t::lock_t(gc_drainer.get())));
+    gc_coro->set_priority(CORO_PRIORITY_LBA_GC);
+}
+
 void lba_list_t::gc(int lba_shard, auto_drainer_t::lock_t) {
     ++extent_manager->stats->pm_serializer_lba_gcs;
 
@@ -359,13 +381,13 @@ void lba_list_t::gc(int lba_shard, auto_drainer_t::lock_t) {
             break;
         }
 
-        flagged_off64_t off = get_block_offset(id);
-        if (off.has_value()) {
-            uint16_t ser_block_size = get_ser_block_size(id);
+        const index_block_info_t info = get_block_info(id);
+        if (info.offset.has_value()) {
             disk_structures[lba_shard]->add_entry(id,
-                                                  get_block_recency(id),
-                                                  off,
-                                                  ser_block_size,
+                                                  info.recency,
+                                                  info.offset,
+                                                  info.ser_block_size,
+                                                  info.disk_block_size,
                                                   gc_io_account.get(),
                                                   txns.back().get(),
                                                   &checksums);
@@ -473,12 +495,16 @@ bool lba_list_t::we_want_to_gc(int i) {
 
     // How much space are we using on disk? How much of that space is absolutely
     // necessary?  If we are not using more than N times the amount of space that we
-    // need, don't GC
+    // need, don't GC.  Since the GC rewrites the shard as a checkpoint (see
+    // LBA_MIN_UNGARBAGE_FRACTION), this also keeps the tail of entries that were
+    // appended since the last checkpoint short, which is what startup has to read on
+    // top of the checkpoint.
     int entries_per_extent = disk_structures[i]->num_entries_that_can_fit_in_an_extent();
     int64_t entries_total = disk_structures[i]->extents_in_superblock.size() * entries_per_extent;
-    int64_t entries_live = end_block_id() / LBA_SHARD_FACTOR
-                            + make_aux_block_id_relative(end_aux_block_id()) / LBA_SHARD_FACTOR;
-    if ((entries_live / static_cast<double>(entries_total)) > LBA_MIN_UNGARBAGE_FRACTION) {  // TODO: multiply both sides by common denominator
+    // Every live block has exactly one entry in its shard, and the shards get about
+    // the same number of blocks.
+    int64_t entries_live = in_memory_index.num_blocks() / LBA_SHARD_FACTOR;
+    if (!garbage_warrants_gc(entries_live, entries_total)) {
         return false;
     }
 
@@ -486,6 +512,26 @@ bool lba_list_t::we_want_to_gc(int i) {
     return true;
 }
 
+bool lba_list_t::garbage_warrants_gc(int64_t entries_live, int64_t entries_total) {
+    return entries_live <= entries_total * LBA_MIN_UNGARBAGE_FRACTION;
+}
+
+int64_t lba_list_t::num_blocks() const {
+    return in_memory_index.num_blocks();
+}
+
+int64_t lba_list_t::on_disk_entries_count() const {
+    int64_t ret = inline_lba_entries_count;
+    for (int i = 0; i < LBA_SHARD_FACTOR; ++i) {
+        ret += disk_structures[i]->extents_in_superblock.size()
+            * disk_structures[i]->num_entries_that_can_fit_in_an_extent();
+        if (disk_structures[i]->last_extent != nullptr) {
+            ret += disk_structures[i]->last_extent->count;
+        }
+    }
+    return ret;
+}
+
 void lba_list_t::shutdown_gc() {
     guarantee(state == state_ready);
     guarantee(coro_t::self() != nullptr);
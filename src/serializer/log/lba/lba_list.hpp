@@ -17,10 +17,15 @@
 class lba_start_fsm_t;
 class lba_syncer_t;
 
+namespace unittest {
+void run_SerializerTest_LbaGcThreshold();
+}
+
 class lba_list_t
 {
     friend class lba_start_fsm_t;
     friend class lba_writer_t;
+    friend void unittest::run_SerializerTest_LbaGcThreshold();
 
     typedef std::function<void(const signal_t *, file_account_t *)> write_metablock_fun_t;
 
@@ -45,6 +50,7 @@ public:
     flagged_off64_t get_block_offset(block_id_t block);
     uint16_t get_ser_block_size(block_id_t block);
     block_size_t get_block_size(block_id_t block);
+    block_size_t get_disk_block_size(block_id_t block);
     repli_timestamp_t get_block_recency(block_id_t block);
     segmented_vector_t<repli_timestamp_t> get_block_recencies(block_id_t first,
                                                               block_id_t step);
@@ -54,6 +60,17 @@ public:
     block_id_t end_block_id();
     block_id_t end_aux_block_id();
 
+    /* The number of entries the LBA has on disk, live or not. That's how many entries
+    `start_existing()` reads. */
+    int64_t on_disk_entries_count() const;
+    // The number of blocks that have an offset.
+    int64_t num_blocks() const;
+
+    /* Whether a shard whose superblock lists extents for `entries_total` entries, of
+    which `entries_live` are live, is garbage enough to GC it (see
+    LBA_MIN_UNGARBAGE_FRACTION). */
+    static bool garbage_warrants_gc(int64_t entries_live, int64_t entries_total);
+
 #ifndef NDEBUG
     bool is_extent_referenced(int64_t offset);
     bool is_offset_referenced(int64_t offset);
@@ -64,6 +81,7 @@ public:
                         repli_timestamp_t recency,
                         flagged_off64_t offset,
                         uint16_t ser_block_size,
+                        uint16_t disk_block_size,
                         file_account_t *io_account,
                         extent_transaction_t *txn,
                         optional<std::vector<checksum_filerange>> *checksums);
@@ -77,6 +95,9 @@ public:
                            completion_callback_t *cb);
 
     void consider_gc();
+    // Starts rewriting every shard that has more than its active extent, no matter how
+    // much of it is garbage.
+    void compact();
 
     // The garbage collector must be shut down first through `shutdown_gc()`
     // (must be run in a coroutine). Once that is done, call `shutdown()` to
@@ -123,10 +144,13 @@ private:
             file_account_t *io_account, extent_transaction_t *txn,
             optional<std::vector<checksum_filerange>> *checksums);
     void add_inline_entry(block_id_t block, repli_timestamp_t recency,
-                          flagged_off64_t offset, uint16_t ser_block_size);
+                          flagged_off64_t offset, uint16_t ser_block_size,
+                          uint16_t disk_block_size);
 
     lba_disk_structure_t *disk_structures[LBA_SHARD_FACTOR];
 
+    // Spawns a coroutine to garbage-collect the given shard
+    void start_gc(int lba_shard);
     // Garbage-collect the given shard
     void gc(int lba_shard, auto_drainer_t::lock_t gc_drainer_lock);
 
@@ -7,6 +7,7 @@
 #include <unistd.h>
 
 #include <functional>
+#include <utility>
 
 #include "arch/io/disk.hpp"
 #include "arch/runtime/runtime.hpp"
@@ -15,7 +16,9 @@
 #include "concurrency/new_mutex.hpp"
 #include "logger.hpp"
 #include "perfmon/perfmon.hpp"
+#include "rdb_protocol/datum.hpp"
 #include "serializer/buf_ptr.hpp"
+#include "serializer/log/block_compression.hpp"
 #include "serializer/log/data_block_manager.hpp"
 
 filepath_file_opener_t::filepath_file_opener_t(const serializer_filepath_t &filepath,
@@ -121,6 +124,8 @@ log_serializer_stats_t::log_serializer_stats_t(perfmon_collection_t *parent)
       pm_serializer_block_reads(secs_to_ticks(1)),
       pm_serializer_index_reads(),
       pm_serializer_block_writes(),
+      pm_serializer_block_writes_compressed(),
+      pm_serializer_compression_saved_bytes(),
       pm_serializer_index_writes(secs_to_ticks(1)),
       pm_serializer_index_writes_size(secs_to_ticks(1), false),
       pm_serializer_read_bytes_per_sec(secs_to_ticks(1)),
@@ -129,18 +134,29 @@ log_serializer_stats_t::log_serializer_stats_t(perfmon_collection_t *parent)
       pm_serializer_written_bytes_total(),
       pm_extents_in_use(),
       pm_file_size_bytes(),
+      pm_hole_punched_bytes(),
       pm_serializer_lba_extents(),
       pm_serializer_data_extents(),
       pm_serializer_data_extents_allocated(),
       pm_serializer_data_extents_gced(),
       pm_serializer_old_garbage_block_bytes(),
       pm_serializer_old_total_block_bytes(),
+      pm_serializer_data_bytes_written(),
+      pm_serializer_client_data_bytes_written(),
+      pm_serializer_write_amplification(&pm_serializer_data_bytes_written,
+                                        &pm_serializer_client_data_bytes_written),
       pm_serializer_lba_gcs(),
+      pm_serializer_lba_index_bytes(),
+      pm_serializer_lba_index_blocks(),
+      pm_serializer_lba_index_bytes_per_block(&pm_serializer_lba_index_bytes,
+                                              &pm_serializer_lba_index_blocks),
       parent_collection_membership(parent, &serializer_collection, "serializer"),
       stats_membership(&serializer_collection,
           &pm_serializer_block_reads, "serializer_block_reads",
           &pm_serializer_index_reads, "serializer_index_reads",
           &pm_serializer_block_writes, "serializer_block_writes",
+          &pm_serializer_block_writes_compressed, "serializer_block_writes_compressed",
+          &pm_serializer_compression_saved_bytes, "serializer_compression_saved_bytes",
           &pm_serializer_index_writes, "serializer_index_writes",
           &pm_serializer_index_writes_size, "serializer_index_writes_size",
           &pm_serializer_read_bytes_per_sec, "serializer_read_bytes_per_sec",
@@ -149,13 +165,22 @@ log_serializer_stats_t::log_serializer_stats_t(perfmon_collection_t *parent)
           &pm_serializer_written_bytes_total, "serializer_written_bytes_total",
           &pm_extents_in_use, "serializer_extents_in_use",
           &pm_file_size_bytes, "serializer_file_size_bytes",
+          &pm_hole_punched_bytes, "serializer_hole_punched_bytes",
           &pm_serializer_lba_extents, "serializer_lba_extents",
           &pm_serializer_data_extents, "serializer_data_extents",
           &pm_serializer_data_extents_allocated, "serializer_data_extents_allocated",
           &pm_serializer_data_extents_gced, "serializer_data_extents_gced",
           &pm_serializer_old_garbage_block_bytes, "serializer_old_garbage_block_bytes",
           &pm_serializer_old_total_block_bytes, "serializer_old_total_block_bytes",
-          &pm_serializer_lba_gcs, "serializer_lba_gcs")
+          &pm_serializer_data_bytes_written, "serializer_data_bytes_written",
+          &pm_serializer_client_data_bytes_written,
+          "serializer_client_data_bytes_written",
+          &pm_serializer_write_amplification, "serializer_write_amplification",
+          &pm_serializer_lba_gcs, "serializer_lba_gcs",
+          &pm_serializer_lba_index_bytes, "serializer_lba_index_bytes",
+          &pm_serializer_lba_index_blocks, "serializer_lba_index_blocks",
+          &pm_serializer_lba_index_bytes_per_block,
+          "serializer_lba_index_bytes_per_block")
 { }
 
 void log_serializer_stats_t::bytes_read(size_t count) {
@@ -213,6 +238,9 @@ struct ls_start_existing_fsm_t :
         rassert(ser->state == log_serializer_t::state_unstarted);
         ser->state = log_serializer_t::state_starting_up;
 
+        file_name = file_opener->file_name();
+        start_ticks = get_ticks();
+
         scoped_ptr_t<file_t> dbfile;
         file_opener->open_serializer_file_existing(&dbfile);
         ser->dbfile = dbfile.release();
@@ -279,6 +307,7 @@ struct ls_start_existing_fsm_t :
         if (start_existing_state == state_start_lba) {
             // STATE G
             guarantee(metablock_found, "Could not find any valid metablock.");
+            metablock_read_ticks = get_ticks();
 
             // STATE H
             if (ser->lba_index->start_existing(ser->dbfile,
@@ -295,6 +324,7 @@ struct ls_start_existing_fsm_t :
         }
 
         if (start_existing_state == state_reconstruct) {
+            lba_read_ticks = get_ticks();
             ser->data_block_manager->start_reconstruct();
             start_existing_state = state_reconstruct_ongoing;
             next_block_to_reconstruct = 0;
@@ -318,7 +348,7 @@ struct ls_start_existing_fsm_t :
                     ser->lba_index->get_block_offset(next_block_to_reconstruct);
                 if (offset.has_value()) {
                     ser->data_block_manager->mark_live(offset.get_value(),
-                        ser->lba_index->get_block_size(next_block_to_reconstruct));
+                        ser->lba_index->get_disk_block_size(next_block_to_reconstruct));
                 }
 
                 ++next_block_to_reconstruct;
@@ -338,6 +368,7 @@ struct ls_start_existing_fsm_t :
         }
 
         if (start_existing_state == state_finish) {
+            log_startup_timings();
             start_existing_state = state_done;
             rassert(ser->state == log_serializer_t::state_starting_up);
             ser->state = log_serializer_t::state_ready;
@@ -379,9 +410,33 @@ struct ls_start_existing_fsm_t :
         next_starting_up_step();
     }
 
+    // Logs how long the phases of the startup took, so that slow startups can be
+    // told apart from each other.
+    void log_startup_timings() {
+        const ticks_t end_ticks = get_ticks();
+        auto secs_between = [](ticks_t from, ticks_t to) {
+            return ticks_to_secs(ticks_t{to.nanos - from.nanos});
+        };
+        logINF("Loaded data file %s in %.3fs (metablock: %.3fs, LBA: %.3fs for %"
+               PRIi64 " entries, index reconstruction: %.3fs for %" PRIi64
+               " blocks).",
+               file_name.c_str(),
+               secs_between(start_ticks, end_ticks),
+               secs_between(start_ticks, metablock_read_ticks),
+               secs_between(metablock_read_ticks, lba_read_ticks),
+               ser->lba_index->on_disk_entries_count(),
+               secs_between(lba_read_ticks, end_ticks),
+               ser->lba_index->num_blocks());
+    }
+
     log_serializer_t *ser;
     cond_t *to_signal_when_done;
 
+    std::string file_name;
+    ticks_t start_ticks;
+    ticks_t metablock_read_ticks;
+    ticks_t lba_read_ticks;
+
     enum state_t {
         state_start,
         state_read_static_header,
@@ -447,10 +502,11 @@ log_serializer_t::~log_serializer_t() {
 }
 
 file_account_t *log_serializer_t::make_io_account(int priority,
-                                                  int outstanding_requests_limit) {
+                                                  int outstanding_requests_limit,
+                                                  file_io_class_t io_class) {
     assert_thread();
     rassert(dbfile);
-    return new file_account_t(dbfile, priority, outstanding_requests_limit);
+    return new file_account_t(dbfile, priority, outstanding_requests_limit, io_class);
 }
 
 buf_ptr_t log_serializer_t::block_read(const counted_t<block_token_t> &token,
@@ -463,7 +519,7 @@ buf_ptr_t log_serializer_t::block_read(const counted_t<block_token_t> &token,
     stats->pm_serializer_block_reads.begin(&pm_time);
 
     buf_ptr_t ret = data_block_manager->read(token->offset_, token->block_size(),
-                                             io_account);
+                                             token->disk_block_size(), io_account);
 
     stats->pm_serializer_block_reads.end(&pm_time);
     return ret;
@@ -495,8 +551,10 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
              write_op_it != write_ops.end();
              ++write_op_it) {
             const index_write_op_t &op = *write_op_it;
-            flagged_off64_t offset = lba_index->get_block_offset(op.block_id);
-            uint16_t ser_block_size = lba_index->get_ser_block_size(op.block_id);
+            const index_block_info_t info = lba_index->get_block_info(op.block_id);
+            flagged_off64_t offset = info.offset;
+            uint16_t ser_block_size = info.ser_block_size;
+            uint16_t disk_block_size = info.disk_block_size;
 
             if (op.token) {
                 // Update the offset pointed to, and mark garbage/liveness as necessary.
@@ -511,6 +569,7 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
                 if (token.has()) {
                     offset = flagged_off64_t::make(token->offset_);
                     ser_block_size = token->block_size().ser_value();
+                    disk_block_size = token->disk_block_size().ser_value();
 
                     if (checksums) {
                         serializer_checksum checksum = token->checksum_;
@@ -522,7 +581,7 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
                             checksums->push_back(
                                 checksum_filerange{
                                     token->offset_,
-                                    ceil_aligned<int64_t>(ser_block_size,
+                                    ceil_aligned<int64_t>(disk_block_size,
                                                           DEVICE_BLOCK_SIZE),
                                     checksum});
                         }
@@ -530,18 +589,19 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
 
                     /* mark the life */
                     data_block_manager->mark_live(offset.get_value(),
-                                                  token->block_size());
+                                                  token->disk_block_size());
                 } else {
                     offset = flagged_off64_t::unused();
                     ser_block_size = 0;
+                    disk_block_size = 0;
                 }
             }
 
             repli_timestamp_t recency = op.recency ? op.recency.get()
-                : lba_index->get_block_recency(op.block_id);
+                : info.recency;
 
             lba_index->set_block_info(op.block_id, recency,
-                                      offset, ser_block_size,
+                                      offset, ser_block_size, disk_block_size,
                                       index_writes_io_account.get(), &txn,
                                       &checksums);
         }
@@ -678,9 +738,11 @@ void log_serializer_t::write_metablock_sans_pipelining(
 }
 
 counted_t<block_token_t>
-log_serializer_t::generate_block_token(int64_t offset, block_size_t block_size) {
+log_serializer_t::generate_block_token(int64_t offset, block_size_t block_size,
+                                       block_size_t disk_block_size) {
     assert_thread();
-    counted_t<block_token_t> token(new block_token_t(this, offset, block_size));
+    counted_t<block_token_t> token(
+        new block_token_t(this, offset, block_size, disk_block_size));
 
     auto location = offset_tokens.find(offset);
     if (location == offset_tokens.end()) {
@@ -699,9 +761,64 @@ log_serializer_t::block_writes(const buf_write_info_t *write_infos,
     assert_thread();
     stats->pm_serializer_block_writes += write_infos_count;
 
+    if (dynamic_config.compression == block_compression_t::none) {
+        std::vector<counted_t<block_token_t> > result
+            = data_block_manager->many_writes(write_infos, write_infos_count,
+                                              r_nullopt, io_account, cb);
+        guarantee(result.size() == write_infos_count);
+        return result;
+    }
+
+    // The compressed buffers have to stay around until the writes are done.
+    struct compressed_writes_cb_t : public iocallback_t {
+        void on_io_complete() {
+            iocallback_t *local_cb = cb;
+            delete this;
+            local_cb->on_io_complete();
+        }
+        std::vector<buf_ptr_t> compressed_bufs;
+        iocallback_t *cb;
+    };
+    compressed_writes_cb_t *compressed_writes_cb = new compressed_writes_cb_t;
+    compressed_writes_cb->cb = cb;
+    compressed_writes_cb->compressed_bufs.reserve(write_infos_count);
+
+    std::vector<buf_write_info_t> disk_write_infos;
+    disk_write_infos.reserve(write_infos_count);
+    for (size_t i = 0; i < write_infos_count; ++i) {
+        const buf_write_info_t &info = write_infos[i];
+        // `many_writes()` only fills in the block id of the buffers it writes.
+        info.buf->ser_header.block_id = info.block_id;
+        buf_ptr_t compressed = compress_block(dynamic_config.compression,
+                                              info.buf, info.block_size);
+        if (compressed.has()) {
+            // The metablock that commits the block's LBA entry has to keep older
+            // versions from opening the file.
+            metablock_manager->set_feature(MB_FEATURE_COMPRESSED_BLOCKS);
+            ++stats->pm_serializer_block_writes_compressed;
+            stats->pm_serializer_compression_saved_bytes
+                += buf_ptr_t::compute_aligned_block_size(info.block_size)
+                - compressed.aligned_block_size();
+            disk_write_infos.push_back(buf_write_info_t(compressed.ser_buffer(),
+                                                        compressed.block_size(),
+                                                        info.block_id));
+        } else {
+            disk_write_infos.push_back(info);
+        }
+        compressed_writes_cb->compressed_bufs.push_back(std::move(compressed));
+    }
+
     std::vector<counted_t<block_token_t> > result
-        = data_block_manager->many_writes(write_infos, write_infos_count, io_account, cb);
+        = data_block_manager->many_writes(disk_write_infos.data(), write_infos_count,
+                                          r_nullopt, io_account,
+                                          compressed_writes_cb);
     guarantee(result.size() == write_infos_count);
+
+    // The tokens report the sizes on disk so far. The blocks' actual sizes are the
+    // ones we were given.
+    for (size_t i = 0; i < write_infos_count; ++i) {
+        result[i]->block_size_ = write_infos[i].block_size;
+    }
     return result;
 }
 
@@ -793,6 +910,15 @@ bool log_serializer_t::is_gc_active() const {
     return data_block_manager->is_gc_active() || lba_index->is_any_gc_active();
 }
 
+void log_serializer_t::start_compaction() {
+    assert_thread();
+    if (state != state_ready) {
+        return;
+    }
+    data_block_manager->start_compaction();
+    lba_index->compact();
+}
+
 block_id_t log_serializer_t::end_block_id() {
     assert_thread();
     rassert(state == state_ready);
@@ -821,7 +947,8 @@ counted_t<block_token_t> log_serializer_t::index_read(block_id_t block_id) {
     index_block_info_t info = lba_index->get_block_info(block_id);
     if (info.offset.has_value()) {
         return generate_block_token(info.offset.get_value(),
-                                    block_size_t::unsafe_make(info.ser_block_size));
+                                    block_size_t::unsafe_make(info.ser_block_size),
+                                    block_size_t::unsafe_make(info.disk_block_size));
     } else {
         return counted_t<block_token_t>();
     }
@@ -865,6 +992,10 @@ void log_serializer_t::shutdown(cond_t *cb) {
     // stops us from getting through the remaining shutdown process quickly.
     data_block_manager->disable_gc();
 
+    // Hole punching is asynchronous as well, and it has to be done before we can shut
+    // down the extent manager.
+    extent_manager->stop_punching_holes();
+
     next_shutdown_step();
 }
 
@@ -1016,9 +1147,11 @@ bool log_serializer_t::should_perform_read_ahead() {
 
 block_token_t::block_token_t(log_serializer_t *serializer,
                              int64_t initial_offset,
-                             block_size_t initial_block_size)
+                             block_size_t initial_block_size,
+                             block_size_t initial_disk_block_size)
     : serializer_(serializer), ref_count_(0),
       block_size_(initial_block_size),
+      disk_block_size_(initial_disk_block_size),
       checksum_(no_checksum()),
       offset_(initial_offset) {
     serializer_->assert_thread();
@@ -1034,8 +1167,9 @@ void block_token_t::do_destroy() {
 void debug_print(printf_buffer_t *buf,
                  const counted_t<block_token_t> &token) {
     if (token.has()) {
-        buf->appendf("standard_block_token{%" PRIi64 ", +%" PRIu16 "}",
-                     token->offset(), token->block_size().ser_value());
+        buf->appendf("standard_block_token{%" PRIi64 ", +%" PRIu16 "/%" PRIu16 "}",
+                     token->offset(), token->block_size().ser_value(),
+                     token->disk_block_size().ser_value());
     } else {
         buf->appendf("nil");
     }
@@ -94,6 +94,10 @@ private:
 // Used internally
 struct ls_start_existing_fsm_t;
 
+namespace unittest {
+void run_SerializerTest_LbaGcThreshold();
+}
+
 class log_serializer_t :
     public serializer_t,
     private data_block_manager::shutdown_callback_t
@@ -102,6 +106,7 @@ class log_serializer_t :
     friend class data_block_manager_t;
     friend class dbm_read_ahead_t;
     friend class block_token_t;
+    friend void unittest::run_SerializerTest_LbaGcThreshold();
 
 public:
     /* Serializer configuration. dynamic_config_t is everything that can be changed from
@@ -124,7 +129,8 @@ public:
     virtual ~log_serializer_t();
 
     using serializer_t::make_io_account;
-    file_account_t *make_io_account(int priority, int outstanding_requests_limit);
+    file_account_t *make_io_account(int priority, int outstanding_requests_limit,
+                                    file_io_class_t io_class);
 
     void register_read_ahead_cb(serializer_read_ahead_callback_t *cb);
     void unregister_read_ahead_cb(serializer_read_ahead_callback_t *cb);
@@ -155,11 +161,16 @@ public:
 
     virtual bool is_gc_active() const;
 
+    /* Makes the data block manager GC every extent that has garbage in it and the LBA
+    rewrite all of its shards. */
+    void start_compaction();
+
 private:
     void unregister_block_token(block_token_t *token);
     void remap_block_to_new_offset(int64_t current_offset, int64_t new_offset);
     counted_t<block_token_t> generate_block_token(int64_t offset,
-                                                             block_size_t block_size);
+                                                  block_size_t block_size,
+                                                  block_size_t disk_block_size);
 
     void offer_buf_to_read_ahead_callbacks(
             block_id_t block_id,
@@ -111,11 +111,23 @@ ATTR_PACKED(struct metablock_fileranges_checksum_t {
 
 static const char MB_MARKER_MAGIC[8] = {'m', 'e', 't', 'a', 'b', 'l', 'c', 'k'};
 
+// Feature flags in the upper 16 bits of `crc_metablock_t::disk_format_version`, for
+// disk format changes that not every file uses.  Versions that don't know about a
+// flag don't recognize the disk format version, so they refuse to open the file
+// instead of misreading it.  Once set, a flag stays set in the file's metablocks.
+#define MB_FEATURE_MASK 0xFFFF0000u
+// Some LBA entries have the size of a compressed block in their upper 16 bits (see
+// `lba_entry_t::ser_block_size`).
+#define MB_FEATURE_COMPRESSED_BLOCKS 0x00010000u
+// The flags that this version knows how to read.
+#define MB_KNOWN_FEATURES MB_FEATURE_COMPRESSED_BLOCKS
+
 // This is stored directly to disk.  Changing it will change the disk format.
 ATTR_PACKED(struct crc_metablock_t {
     char magic_marker[sizeof(MB_MARKER_MAGIC)];
     // The version that differs only when the software is upgraded to a newer
-    // version.  This field might allow for in-place upgrading of the cluster.
+    // version.  This field might allow for in-place upgrading of the cluster.  The
+    // upper 16 bits hold feature flags (see MB_FEATURE_MASK).
     uint32_t disk_format_version;
     // The CRC checksum of [disk_format_version]+[version]+[metablock].
     uint32_t _crc;
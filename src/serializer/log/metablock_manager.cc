@@ -162,6 +162,7 @@ std::vector<int64_t> initial_metablock_offsets(int64_t extent_size) {
 
 metablock_manager_t::metablock_manager_t(extent_manager_t *em)
     : next_mb_slot(SIZE_MAX),
+      features(0),
       extent_manager(em),
       state(state_unstarted),
       dbfile(nullptr) {
@@ -220,7 +221,14 @@ void metablock_manager_t::create(
              DEFAULT_DISK_ACCOUNT, datasync_op::wrap_in_datasyncs);
 }
 
-bool disk_format_version_is_recognized(uint32_t disk_format_version) {
+bool disk_format_version_is_recognized(uint32_t disk_format_version_and_features) {
+    if ((disk_format_version_and_features & MB_FEATURE_MASK & ~MB_KNOWN_FEATURES) != 0) {
+        // The file uses a disk format feature that was added in a newer version.
+        return false;
+    }
+    const uint32_t disk_format_version =
+        disk_format_version_and_features & ~MB_FEATURE_MASK;
+
     // Someday, we might have to do more than recognize a disk format version to be
     // valid -- the block structure of LBAs or extents might require us to look at
     // the current metablock's version number more closely.  If you have a new
@@ -257,7 +265,8 @@ bool metablock_manager_t::verify_checksum_fileranges(const crc_metablock_t *mb)
                 mb->disk_format_version);
     }
 
-    if (mb->disk_format_version != static_cast<uint32_t>(cluster_version_t::v2_5_is_latest_disk)) {
+    if ((mb->disk_format_version & ~MB_FEATURE_MASK)
+        != static_cast<uint32_t>(cluster_version_t::v2_5_is_latest_disk)) {
         // There are no checksums.
         return true;
     }
@@ -382,6 +391,7 @@ void metablock_manager_t::co_start_existing(file_t *file, bool *mb_found_out,
             next_version_number = indices_by_version[n].first + 1;
             next_mb_slot = metablock_offsets::next(extent_size, index);
             *mb_found_out = true;
+            features = latest_crc_mb->disk_format_version & MB_FEATURE_MASK;
             memcpy(mb_out, &latest_crc_mb->metablock, sizeof(log_serializer_metablock_t));
         } else {
             if (indices_by_version.size() == 1) {
@@ -401,6 +411,7 @@ void metablock_manager_t::co_start_existing(file_t *file, bool *mb_found_out,
                 next_version_number = indices_by_version[n].first + 1;
                 next_mb_slot = metablock_offsets::next(extent_size, index);
                 *mb_found_out = true;
+                features = latest_crc_mb->disk_format_version & MB_FEATURE_MASK;
                 memcpy(mb_out, &latest_crc_mb->metablock, sizeof(log_serializer_metablock_t));
             }
         }
@@ -437,7 +448,8 @@ void metablock_manager_t::co_write_metablock(
 
     bool double_datasync
         = crc_metablock::prepare(crc_mb.get(),
-                                 static_cast<uint32_t>(cluster_version_t::LATEST_DISK),
+                                 static_cast<uint32_t>(cluster_version_t::LATEST_DISK)
+                                 | features,
                                  next_version_number++,
                                  std::move(checksums));
     rassert(crc_metablock::check_crc(crc_mb.get()));
@@ -472,6 +484,11 @@ void metablock_manager_t::write_metablock(
                                           this, &crc_mb, io_account, &checksums, cb));
 }
 
+void metablock_manager_t::set_feature(uint32_t feature) {
+    guarantee((feature & ~MB_KNOWN_FEATURES) == 0);
+    features |= feature;
+}
+
 void metablock_manager_t::shutdown() {
 
     rassert(state == state_ready);
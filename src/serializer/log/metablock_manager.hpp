@@ -26,6 +26,10 @@
 
 std::vector<int64_t> initial_metablock_offsets(int64_t extent_size);
 
+/* Whether we can read a file whose metablock has the given `disk_format_version`,
+feature flags included.  Fails for versions that are known but too old. */
+bool disk_format_version_is_recognized(uint32_t disk_format_version_and_features);
+
 class metablock_manager_t {
 public:
     explicit metablock_manager_t(extent_manager_t *em);
@@ -64,6 +68,13 @@ public:
 
     void shutdown();
 
+    // Sets a feature flag (see MB_FEATURE_MASK) in the metablocks written from now
+    // on.  Must be called before the metablock that first depends on the feature is
+    // written.  The flags of the metablock that `co_start_existing()` loaded are set
+    // from the start.
+    void set_feature(uint32_t feature);
+    bool has_feature(uint32_t feature) const { return (features & feature) != 0; }
+
 private:
     void start_existing_callback(file_t *dbfile,
                                  bool *mb_found,
@@ -86,6 +97,9 @@ private:
 
     metablock_version_t next_version_number;
 
+    // The feature flags that go into the metablocks we write.
+    uint32_t features;
+
     extent_manager_t *const extent_manager;
 
     enum state_t {
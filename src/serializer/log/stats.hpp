@@ -14,6 +14,8 @@ struct log_serializer_stats_t {
     perfmon_duration_sampler_t pm_serializer_block_reads;
     perfmon_counter_t pm_serializer_index_reads;
     perfmon_counter_t pm_serializer_block_writes;
+    perfmon_counter_t pm_serializer_block_writes_compressed;
+    perfmon_counter_t pm_serializer_compression_saved_bytes;
     perfmon_duration_sampler_t pm_serializer_index_writes;
     perfmon_sampler_t pm_serializer_index_writes_size;
 
@@ -25,6 +27,7 @@ struct log_serializer_stats_t {
     /* used in serializer/log/extent_manager.cc */
     perfmon_counter_t pm_extents_in_use;
     perfmon_counter_t pm_file_size_bytes;
+    perfmon_counter_t pm_hole_punched_bytes;
 
     /* used in serializer/log/lba/extent.cc */
     perfmon_counter_t pm_serializer_lba_extents;
@@ -35,10 +38,21 @@ struct log_serializer_stats_t {
     perfmon_counter_t pm_serializer_data_extents_gced;
     perfmon_counter_t pm_serializer_old_garbage_block_bytes;
     perfmon_counter_t pm_serializer_old_total_block_bytes;
+    // The bytes of data blocks written, including the ones that the GC moves, and
+    // only counting the ones that clients write. Their ratio is the write
+    // amplification of the GC.
+    perfmon_counter_t pm_serializer_data_bytes_written;
+    perfmon_counter_t pm_serializer_client_data_bytes_written;
+    perfmon_counter_ratio_t pm_serializer_write_amplification;
 
     /* used in serializer/log/lba/lba_list.cc */
     perfmon_counter_t pm_serializer_lba_gcs;
 
+    /* used in serializer/log/lba/in_memory_index.cc */
+    perfmon_counter_t pm_serializer_lba_index_bytes;
+    perfmon_counter_t pm_serializer_lba_index_blocks;
+    perfmon_counter_ratio_t pm_serializer_lba_index_bytes_per_block;
+
     perfmon_membership_t parent_collection_membership;
     perfmon_multi_membership_t stats_membership;
 };
@@ -6,16 +6,43 @@
 #include "errors.hpp"
 
 #include "arch/runtime/coroutines.hpp"
+#include "arch/timing.hpp"
 #include "concurrency/new_mutex.hpp"
 #include "config/args.hpp"
 #include "serializer/types.hpp"
 
+static int64_t group_commit_window = 0;
+
+void set_group_commit_window(int64_t us) {
+    guarantee(us >= 0);
+    group_commit_window = us;
+}
+
+int64_t get_group_commit_window() {
+    return group_commit_window;
+}
 
 merger_serializer_t::merger_serializer_t(scoped_ptr_t<serializer_t> _inner,
-                                         int _max_active_writes) :
+                                         int _max_active_writes,
+                                         perfmon_collection_t *perfmon_collection) :
     inner(std::move(_inner)),
+    max_active_writes(_max_active_writes),
+    // With more than one active write, a write that is held back can't tell
+    // `write_committer` which notifications it covers (see `do_index_write()`).
+    group_commit_window_us(
+        _max_active_writes == 1 ? get_group_commit_window() : 0),
     block_writes_io_account(make_io_account(MERGER_BLOCK_WRITE_IO_PRIORITY)),
-    write_committer(std::bind(&merger_serializer_t::do_index_write, this),
+    num_outstanding_index_writes(0),
+    first_outstanding_index_write_time(ticks_t{0}),
+    pm_batch_size(secs_to_ticks(DISK_LATENCY_HISTOGRAM_INTERVAL_SECS)),
+    pm_commit_latency(secs_to_ticks(DISK_LATENCY_HISTOGRAM_INTERVAL_SECS)),
+    stats_collection_membership(perfmon_collection, &stats_collection,
+                                "group_commit"),
+    stats_membership(&stats_collection,
+        &pm_batch_size, "group_commit_batch_size",
+        &pm_commit_latency, "group_commit_latency"),
+    write_committer(std::bind(&merger_serializer_t::do_index_write, this,
+                              ph::_1),
                     _max_active_writes) { }
 
 merger_serializer_t::~merger_serializer_t() {
@@ -41,6 +68,7 @@ void merger_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
                                       const std::vector<index_write_op_t> &write_ops) {
     rassert(coro_t::self() != nullptr);
     assert_thread();
+    const ticks_t start_time = get_ticks();
 
     // Apply our set of write ops atomically
     {
@@ -48,6 +76,10 @@ void merger_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
         for (auto op = write_ops.begin(); op != write_ops.end(); ++op) {
             push_index_write_op(*op);
         }
+        if (num_outstanding_index_writes == 0) {
+            first_outstanding_index_write_time = start_time;
+        }
+        ++num_outstanding_index_writes;
     }
 
     // Changes are now visible for subsequent `index_read()` calls.
@@ -62,15 +94,42 @@ void merger_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
     write_committer.notify();
     cond_t non_interruptor;
     write_committer.flush(&non_interruptor);
+
+    pm_commit_latency.record(ticks_t{get_ticks().nanos - start_time.nanos});
 }
 
-void merger_serializer_t::do_index_write() {
+void merger_serializer_t::do_index_write(signal_t *interruptor) {
     assert_thread();
 
+    // Give other index writes until the end of the group commit window of the
+    // oldest outstanding one to join it. The timers only take whole milliseconds,
+    // so we nap for those and yield until the deadline for the rest.
+    if (group_commit_window_us > 0 && num_outstanding_index_writes > 0) {
+        const int64_t deadline_nanos = first_outstanding_index_write_time.nanos
+            + group_commit_window_us * THOUSAND;
+        const int64_t remaining_nanos = deadline_nanos - get_ticks().nanos;
+        if (remaining_nanos >= MILLION) {
+            nap(remaining_nanos / MILLION, interruptor);
+        }
+        while (get_ticks().nanos < deadline_nanos) {
+            if (interruptor->is_pulsed()) {
+                throw interrupted_exc_t();
+            }
+            coro_t::yield();
+        }
+    }
+
     // Pause changes to outstanding_index_write_ops
     new_mutex_in_line_t outstanding_mutex_acq(&outstanding_index_write_mutex);
     outstanding_mutex_acq.acq_signal()->wait_lazily_unordered();
 
+    if (group_commit_window_us > 0) {
+        // Every index write that has notified `write_committer` by now has put its
+        // ops into `outstanding_index_write_ops`, so this commit covers it.
+        rassert(max_active_writes == 1);
+        write_committer.include_latest_notifications();
+    }
+
     // Assemble the currently outstanding index writes into
     // a vector of index_write_op_t-s.
     std::vector<index_write_op_t> write_ops;
@@ -90,6 +149,10 @@ void merger_serializer_t::do_index_write() {
             // we can reset outstanding_index_write_ops and allow new write ops to
             // get in line.
             outstanding_index_write_ops.clear();
+            if (num_outstanding_index_writes > 0) {
+                pm_batch_size.record(num_outstanding_index_writes);
+            }
+            num_outstanding_index_writes = 0;
             outstanding_mutex_acq.reset();
         },
         write_ops);
@@ -10,6 +10,7 @@
 #include "concurrency/new_mutex.hpp"
 #include "concurrency/pump_coro.hpp"
 #include "containers/scoped.hpp"
+#include "perfmon/perfmon.hpp"
 #include "serializer/buf_ptr.hpp"
 #include "serializer/serializer.hpp"
 
@@ -26,19 +27,33 @@
  * for all block_writes, so reduce the amount of random disk seeks that can
  * occur when writes from multiple different accounts get interleaved (see
  * https://github.com/rethinkdb/rethinkdb/issues/3348 )
+ *
+ * If a group commit window is set (see `set_group_commit_window()`), an index
+ * write that finds the merger idle doesn't go to the inner serializer right
+ * away. Instead it waits until the window has passed since it came in, so that
+ * the index writes that come in meanwhile get committed together with it, with
+ * a single metablock write and fsync.
  */
 
+/* How many microseconds the merger serializers of tables hold back an index write
+to wait for more index writes to commit together with it. 0 turns it off. Only
+affects merger serializers that are created after it's set. */
+void set_group_commit_window(int64_t us);
+int64_t get_group_commit_window();
+
 class merger_serializer_t : public serializer_t {
 public:
-    merger_serializer_t(scoped_ptr_t<serializer_t> _inner, int _max_active_writes);
+    merger_serializer_t(scoped_ptr_t<serializer_t> _inner, int _max_active_writes,
+                        perfmon_collection_t *perfmon_collection);
     ~merger_serializer_t();
 
 
     /* Allocates a new io account for the underlying file.
     Use delete to free it. */
     using serializer_t::make_io_account;
-    file_account_t *make_io_account(int priority, int outstanding_requests_limit) {
-        return inner->make_io_account(priority, outstanding_requests_limit);
+    file_account_t *make_io_account(int priority, int outstanding_requests_limit,
+                                    file_io_class_t io_class) {
+        return inner->make_io_account(priority, outstanding_requests_limit, io_class);
     }
 
     /* Some serializer implementations support read-ahead to speed up cache warmup.
@@ -116,6 +131,10 @@ public:
         return inner->is_gc_active();
     }
 
+    void start_compaction() {
+        inner->start_compaction();
+    }
+
 private:
     // Adds `op` to `outstanding_index_write_ops`, using `merge_index_write_op()` if
     // necessary
@@ -124,9 +143,11 @@ private:
     void merge_index_write_op(const index_write_op_t &to_be_merged,
                               index_write_op_t *into_out) const;
 
-    void do_index_write();
+    void do_index_write(signal_t *interruptor);
 
     const scoped_ptr_t<serializer_t> inner;
+    const int max_active_writes;
+    const int64_t group_commit_window_us;
     const scoped_ptr_t<file_account_t> block_writes_io_account;
 
     // Used to obey the index_write API and make sure we can't possibly make
@@ -142,6 +163,17 @@ private:
     // serializer.
     new_mutex_t outstanding_index_write_mutex;
 
+    // How many `index_write()` calls have contributed to
+    // `outstanding_index_write_ops`, and when the first of them came in.
+    int64_t num_outstanding_index_writes;
+    ticks_t first_outstanding_index_write_time;
+
+    perfmon_collection_t stats_collection;
+    perfmon_histogram_t pm_batch_size;
+    perfmon_latency_histogram_t pm_commit_latency;
+    perfmon_membership_t stats_collection_membership;
+    perfmon_multi_membership_t stats_membership;
+
     pump_coro_t write_committer;
 
     DISABLE_COPYING(merger_serializer_t);
@@ -48,9 +48,11 @@ public:
 
     /* Allocates a new io account for the underlying file.
     Use delete to free it. */
-    file_account_t *make_io_account(int priority);
+    file_account_t *make_io_account(
+        int priority, file_io_class_t io_class = file_io_class_t::normal);
     virtual file_account_t *make_io_account(int priority,
-                                            int outstanding_requests_limit) = 0;
+                                            int outstanding_requests_limit,
+                                            file_io_class_t io_class) = 0;
 
     /* Some serializer implementations support read-ahead to speed up cache warmup.
     This is supported through a serializer_read_ahead_callback_t which gets called
@@ -126,6 +128,10 @@ public:
     /* Return true if the garbage collector is active */
     virtual bool is_gc_active() const = 0;
 
+    /* Starts rewriting the live data of the file densely, so that the file shrinks.
+    Returns right away; the garbage collector does the work in the background. */
+    virtual void start_compaction() = 0;
+
 private:
     DISABLE_COPYING(serializer_t);
 };
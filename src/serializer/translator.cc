@@ -122,7 +122,12 @@ void create_proxies(const std::vector<serializer_t *>& underlying,
             "the same call to 'rethinkdb create'.");
     }
 
-    guarantee(c->n_files == static_cast<int>(underlying.size()));
+    if (c->n_files != static_cast<int>(underlying.size())) {
+        fail_due_to_user_error("A table's data is spread over %d files, but the server "
+            "only found %zu of them. Make sure that the server is started with all of "
+            "the stripe directories that were set when the table was created.",
+            c->n_files, underlying.size());
+    }
     guarantee(c->this_serializer >= 0 && c->this_serializer < static_cast<int>(underlying.size()));
     guarantee(c->n_proxies == static_cast<int>(proxies->size()));
 
@@ -235,8 +240,9 @@ translator_serializer_t::translator_serializer_t(serializer_t *_inner, int _mod_
     rassert(mod_id < mod_count);
 }
 
-file_account_t *translator_serializer_t::make_io_account(int priority, int outstanding_requests_limit) {
-    return inner->make_io_account(priority, outstanding_requests_limit);
+file_account_t *translator_serializer_t::make_io_account(int priority, int outstanding_requests_limit,
+                                                         file_io_class_t io_class) {
+    return inner->make_io_account(priority, outstanding_requests_limit, io_class);
 }
 
 void translator_serializer_t::index_write(
@@ -287,6 +293,10 @@ bool translator_serializer_t::is_gc_active() const {
     return inner->is_gc_active();
 }
 
+void translator_serializer_t::start_compaction() {
+    inner->start_compaction();
+}
+
 // A helper function for `end_block_id` and `end_aux_block_id`
 // `first_block_id` is the lowest block ID in the range, either 0 for regular block
 // IDs or FIRST_AUX_BLOCK_ID for aux blocks.
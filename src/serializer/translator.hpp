@@ -119,7 +119,8 @@ public:
                             config_block_id_t cfgid);
 
     /* Allocates a new io account for the underlying file */
-    file_account_t *make_io_account(int priority, int outstanding_requests_limit);
+    file_account_t *make_io_account(int priority, int outstanding_requests_limit,
+                                    file_io_class_t io_class);
 
     void index_write(new_mutex_in_line_t *mutex_acq,
                      const std::function<void()> &on_writes_reflected,
@@ -135,6 +136,8 @@ public:
 
     bool is_gc_active() const;
 
+    void start_compaction();
+
     block_id_t end_block_id();
     block_id_t end_aux_block_id();
 
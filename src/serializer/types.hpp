@@ -135,6 +135,9 @@ class block_token_t {
 public:
     int64_t offset() const { return offset_; }
     block_size_t block_size() const { return block_size_; }
+    // The block's size on disk. Smaller than `block_size()` if the block is stored
+    // compressed, see serializer/log/block_compression.hpp.
+    block_size_t disk_block_size() const { return disk_block_size_; }
 
 private:
     friend class log_serializer_t;
@@ -146,7 +149,8 @@ private:
 
     block_token_t(log_serializer_t *serializer,
                   int64_t initial_offset,
-                  block_size_t initial_ser_block_size);
+                  block_size_t initial_ser_block_size,
+                  block_size_t initial_disk_block_size);
 
     log_serializer_t *const serializer_;
     std::atomic<intptr_t> ref_count_;
@@ -154,13 +158,16 @@ private:
     // The block's size.
     block_size_t block_size_;
 
+    // The block's size on disk.
+    block_size_t disk_block_size_;
+
     // Either (a.) a checksum of what the block's on-disk contents should be, (b.)(i.)
     // the value datasync_checksum(), which means the block's write has been datasynced,
     // or (b.)(ii.) the value no_checksum(), which means the block is not known to have
     // been datasynced.
     //
-    // This holds the checksum of the DEVICE_BLOCK_SIZE-aligned block, with padding
-    // included.
+    // This holds the checksum of the DEVICE_BLOCK_SIZE-aligned block as it is on
+    // disk (compressed, if it is), with padding included.
     serializer_checksum checksum_;
 
     // The block's offset on disk.
@@ -64,18 +64,33 @@ thread_allocator_t::~thread_allocator_t() {
 }
 
 thread_allocation_t::thread_allocation_t(thread_allocator_t *p)
+    : thread_allocation_t(p, [](threadnum_t) { return true; }) { }
+
+thread_allocation_t::thread_allocation_t(
+        thread_allocator_t *p,
+        const std::function<bool(threadnum_t)> &is_preferred)
     : thread(0), /* temporary, will be overwritten below */
       parent(p) {
     parent->assert_thread();
-    int32_t best_thread = 0;
-    for (int32_t i = 1; static_cast<size_t>(i) < parent->num_allocated.size(); ++i) {
-        if (parent->num_allocated[i] < parent->num_allocated[best_thread]) {
+    bool any_preferred = false;
+    for (size_t i = 0; i < parent->num_allocated.size() && !any_preferred; ++i) {
+        any_preferred = is_preferred(threadnum_t(i));
+    }
+    int32_t best_thread = -1;
+    for (int32_t i = 0; static_cast<size_t>(i) < parent->num_allocated.size(); ++i) {
+        if (any_preferred && !is_preferred(threadnum_t(i))) {
+            continue;
+        }
+        if (best_thread == -1) {
+            best_thread = i;
+        } else if (parent->num_allocated[i] < parent->num_allocated[best_thread]) {
             best_thread = i;
         } else if (parent->num_allocated[i] == parent->num_allocated[best_thread] &&
                    parent->secondary_lt(threadnum_t(i), threadnum_t(best_thread))) {
             best_thread = i;
         }
     }
+    guarantee(best_thread != -1);
     thread = threadnum_t(best_thread);
     ++parent->num_allocated[best_thread];
 }
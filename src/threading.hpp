@@ -111,6 +111,10 @@ private:
 class thread_allocation_t {
 public:
     explicit thread_allocation_t(thread_allocator_t *p);
+    /* Only considers the threads for which `is_preferred` returns true, unless it
+    doesn't return true for any thread. */
+    thread_allocation_t(thread_allocator_t *p,
+                        const std::function<bool(threadnum_t)> &is_preferred);
     ~thread_allocation_t();
     threadnum_t get_thread() const;
 private:
@@ -0,0 +1,46 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <string.h>
+
+#include "random.hpp"
+#include "serializer/log/block_compression.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+TEST(BlockCompressionTest, Roundtrip) {
+    const block_size_t block_size = block_size_t::unsafe_make(4096);
+    buf_ptr_t buf = buf_ptr_t::alloc_zeroed(block_size);
+    buf.ser_buffer()->ser_header.block_id = 42;
+    // Compressible, but not trivially so.
+    char *data = static_cast<char *>(buf.cache_data());
+    for (uint32_t i = 0; i < block_size.value(); ++i) {
+        data[i] = static_cast<char>('a' + (i * i) % 7);
+    }
+
+    buf_ptr_t compressed = compress_block(block_compression_t::zlib,
+                                          buf.ser_buffer(), block_size);
+    ASSERT_TRUE(compressed.has());
+    EXPECT_LT(compressed.aligned_block_size(), buf.aligned_block_size());
+    EXPECT_EQ(42u, compressed.ser_buffer()->ser_header.block_id);
+
+    buf_ptr_t decompressed = buf_ptr_t::alloc_uninitialized(block_size);
+    decompress_block(compressed.ser_buffer(), compressed.block_size(), block_size,
+                     decompressed.ser_buffer());
+    EXPECT_EQ(42u, decompressed.ser_buffer()->ser_header.block_id);
+    EXPECT_EQ(0, memcmp(buf.cache_data(), decompressed.cache_data(),
+                        block_size.value()));
+}
+
+TEST(BlockCompressionTest, Incompressible) {
+    const block_size_t block_size = block_size_t::unsafe_make(4096);
+    buf_ptr_t buf = buf_ptr_t::alloc_zeroed(block_size);
+    rng_t rng(1234);
+    char *data = static_cast<char *>(buf.cache_data());
+    for (uint32_t i = 0; i < block_size.value(); ++i) {
+        data[i] = static_cast<char>(rng.randint(256));
+    }
+    EXPECT_FALSE(compress_block(block_compression_t::zlib,
+                                buf.ser_buffer(), block_size).has());
+}
+
+}  // namespace unittest
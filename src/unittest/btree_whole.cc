@@ -52,7 +52,8 @@ public:
 
         serializer = make_scoped<merger_serializer_t>(
                 std::move(inner_serializer),
-                MERGER_SERIALIZER_MAX_ACTIVE_WRITES);
+                MERGER_SERIALIZER_MAX_ACTIVE_WRITES,
+                &get_global_perfmon_collection());
 
         cache = make_scoped<cache_t>(serializer.get(), &balancer, &get_global_perfmon_collection(),
                                      which_cpu_shard_t{0, 1});
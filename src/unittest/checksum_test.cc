@@ -0,0 +1,135 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <inttypes.h>
+
+#include <vector>
+
+#include "config/args.hpp"
+#include "random.hpp"
+#include "serializer/checksum.hpp"
+#include "time.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+const checksum_kernel_t all_checksum_kernels[] = {
+    checksum_kernel_t::scalar,
+    checksum_kernel_t::sse41,
+    checksum_kernel_t::avx2
+};
+
+// These are part of the disk format, so they must never change.
+TEST(ChecksumTest, DiskFormat) {
+    std::vector<uint32_t> words(1024);
+    for (size_t i = 0; i < words.size(); ++i) {
+        words[i] = static_cast<uint32_t>(i * 2654435761u);
+    }
+    for (checksum_kernel_t kernel : all_checksum_kernels) {
+        if (!checksum_kernel_supported(kernel)) {
+            continue;
+        }
+        EXPECT_EQ(0xFFFFFFFFFFFFFFFFull,
+                  compute_checksum_using(kernel, words.data(), 0).value);
+        EXPECT_EQ(0x905d8b005e949fffull,
+                  compute_checksum_using(kernel, words.data(), 1024).value);
+        EXPECT_EQ(0x9576103e7a2d2e25ull,
+                  compute_checksum_using(kernel, words.data(), 1021).value);
+    }
+}
+
+// Compares the vector kernels to the scalar one for every length up to a few
+// thousand words, at every alignment modulo 32 bytes, with random words and with
+// the words that are most likely to trip up the modular arithmetic.
+TEST(ChecksumTest, KernelsAgree) {
+    const size_t max_wordcount = 3000;
+    const size_t max_offset = 8;
+    std::vector<uint32_t> words(max_wordcount + max_offset);
+    const uint32_t patterns[] = { 0, 1, 0xFFFFFFFEu, 0xFFFFFFFFu };
+    rng_t rng(1234);
+
+    for (size_t pattern = 0; pattern <= sizeof(patterns) / sizeof(*patterns); ++pattern) {
+        for (uint32_t &word : words) {
+            word = pattern < sizeof(patterns) / sizeof(*patterns)
+                ? patterns[pattern]
+                : static_cast<uint32_t>(rng.randuint64(uint64_t(1) << 32));
+        }
+        for (size_t wordcount = 0; wordcount <= max_wordcount; ++wordcount) {
+            for (size_t offset = 0; offset < max_offset; ++offset) {
+                const uint32_t *p = words.data() + offset;
+                const serializer_checksum expected =
+                    compute_checksum_using(checksum_kernel_t::scalar, p, wordcount);
+                ASSERT_EQ(expected.value, compute_checksum(p, wordcount).value);
+                for (checksum_kernel_t kernel : all_checksum_kernels) {
+                    if (!checksum_kernel_supported(kernel)) {
+                        continue;
+                    }
+                    ASSERT_EQ(expected.value,
+                              compute_checksum_using(kernel, p, wordcount).value)
+                        << "kernel " << static_cast<int>(kernel)
+                        << ", pattern " << pattern << ", wordcount " << wordcount
+                        << ", offset " << offset;
+                }
+            }
+        }
+    }
+}
+
+// Buffers that span several chunks of the kernels' inner loops.
+TEST(ChecksumTest, LargeBuffers) {
+    const size_t wordcounts[] = { 0xFFFF, 0x10000, 0x10001, 0x20000, 200003 };
+    std::vector<uint32_t> words(200003);
+    rng_t rng(4321);
+    for (uint32_t &word : words) {
+        word = static_cast<uint32_t>(rng.randuint64(uint64_t(1) << 32));
+    }
+    for (size_t wordcount : wordcounts) {
+        // The checksum of the concatenation, from the checksums of the halves.
+        const size_t left = wordcount / 2;
+        const serializer_checksum expected = compute_checksum_concat(
+            compute_checksum_using(checksum_kernel_t::scalar, words.data(), left),
+            compute_checksum_using(checksum_kernel_t::scalar,
+                                   words.data() + left, wordcount - left),
+            wordcount - left);
+        for (checksum_kernel_t kernel : all_checksum_kernels) {
+            if (!checksum_kernel_supported(kernel)) {
+                continue;
+            }
+            EXPECT_EQ(expected.value,
+                      compute_checksum_using(kernel, words.data(), wordcount).value);
+        }
+    }
+}
+
+// This is not really a unit test, but a micro benchmark of the kernels on 4KB
+// blocks. No need to run this in debug mode.
+#ifdef NDEBUG
+TEST(ChecksumTest, Benchmark) {
+    const size_t block_words = 4096 / serializer_checksum::word_size;
+    const size_t num_blocks = 256;
+    const int passes = 500;
+    std::vector<uint32_t> words(block_words * num_blocks);
+    rng_t rng(5678);
+    for (uint32_t &word : words) {
+        word = static_cast<uint32_t>(rng.randuint64(uint64_t(1) << 32));
+    }
+    for (checksum_kernel_t kernel : all_checksum_kernels) {
+        if (!checksum_kernel_supported(kernel)) {
+            continue;
+        }
+        uint64_t total = 0;
+        ticks_t start_ticks = get_ticks();
+        for (int pass = 0; pass < passes; ++pass) {
+            for (size_t block = 0; block < num_blocks; ++block) {
+                total += compute_checksum_using(
+                    kernel, words.data() + block * block_words, block_words).value;
+            }
+        }
+        const double secs =
+            ticks_to_secs(ticks_t{get_ticks().nanos - start_ticks.nanos});
+        printf("checksum kernel %d: %f MB/s (%" PRIx64 ")\n",
+               static_cast<int>(kernel),
+               passes * num_blocks * 4096 / secs / MEGABYTE, total);
+    }
+}
+#endif  // NDEBUG
+
+}  // namespace unittest
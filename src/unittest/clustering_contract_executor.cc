@@ -111,6 +111,10 @@ public:
     store_t *get_underlying_store(UNUSED size_t i) {
         crash("not implemented for this unit test");
     }
+    std::vector<std::string> get_storage_files() {
+        return std::vector<std::string>();
+    }
+    void start_compaction() { }
 private:
     friend class executor_tester_t;
     server_id_t server_id;
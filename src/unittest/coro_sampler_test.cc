@@ -0,0 +1,148 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <string>
+#include <utility>
+
+#include "arch/runtime/coro_sampler.hpp"
+#include "arch/runtime/coroutines.hpp"
+#include "arch/timing.hpp"
+#include "clustering/administration/artificial_reql_cluster_interface.hpp"
+#include "clustering/administration/datum_adapter.hpp"
+#include "clustering/administration/metadata.hpp"
+#include "clustering/administration/servers/config_client.hpp"
+#include "clustering/administration/stats/debug_coro_profile_backend.hpp"
+#include "clustering/administration/tables/name_resolver.hpp"
+#include "concurrency/pmap.hpp"
+#include "concurrency/watchable_map.hpp"
+#include "extproc/extproc_pool.hpp"
+#include "perfmon/collect.hpp"
+#include "rpc/connectivity/cluster.hpp"
+#include "rpc/mailbox/mailbox.hpp"
+#include "unittest/dummy_metadata_controller.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+/* Keeps the CPU busy for `nanos` of running time, yielding in between. This isn't
+static, so that the stack traces can name it. */
+NOINLINE void coro_sampler_test_spin(int64_t nanos) {
+    const int64_t end = get_ticks().nanos + nanos;
+    while (get_ticks().nanos < end) {
+        const int64_t slice_end = get_ticks().nanos + 200 * THOUSAND;
+        while (get_ticks().nanos < slice_end) { }
+        coro_t::yield();
+    }
+}
+
+static ql::datum_t get_coro_profile() {
+    return perfmon_get_stats().get_field("coro_profile");
+}
+
+// Adds up the samples of the stacks in `profile` that go through `function`.
+static int64_t samples_in(const ql::datum_t &profile, const std::string &function) {
+    const ql::datum_t stacks = profile.get_field("stacks");
+    int64_t samples = 0;
+    for (size_t i = 0; i < stacks.arr_size(); ++i) {
+        const ql::datum_t stack = stacks.get(i);
+        if (stack.get_field("stack").as_str().to_std().find(function)
+                != std::string::npos) {
+            samples += static_cast<int64_t>(stack.get_field("samples").as_num());
+        }
+    }
+    return samples;
+}
+
+TPTEST(CoroSamplerTest, AttributesSamples) {
+    const int num_coros = 4;
+    const int64_t spin_nanos = 50 * MILLION;
+    const int64_t interval_nanos = 100 * THOUSAND;
+
+    coro_sampler_t::enable(interval_nanos);
+    pmap(num_coros, [&](int) { coro_sampler_test_spin(spin_nanos); });
+    coro_sampler_t::disable();
+
+    const ql::datum_t profile = get_coro_profile();
+    EXPECT_FALSE(profile.get_field("enabled").as_bool());
+    EXPECT_EQ(0.1, profile.get_field("sample_interval_ms").as_num());
+
+    // The coroutines ran for about `num_coros * spin_nanos`, nearly all of it in
+    // `coro_sampler_test_spin()`.
+    const int64_t total = static_cast<int64_t>(profile.get_field("samples").as_num());
+    const int64_t spinning = samples_in(profile, "coro_sampler_test_spin");
+    EXPECT_GE(total, num_coros * spin_nanos / interval_nanos);
+    EXPECT_GE(spinning * 10, total * 9);
+    EXPECT_EQ(0, static_cast<int64_t>(profile.get_field("dropped_samples").as_num()));
+
+    // Once the sampler is disabled, it keeps the samples but doesn't add any.
+    coro_sampler_test_spin(spin_nanos);
+    const ql::datum_t later_profile = get_coro_profile();
+    EXPECT_EQ(total,
+              static_cast<int64_t>(later_profile.get_field("samples").as_num()));
+    EXPECT_EQ(spinning, samples_in(later_profile, "coro_sampler_test_spin"));
+
+    // Enabling it again starts a new profile.
+    coro_sampler_t::enable(interval_nanos);
+    coro_sampler_t::disable();
+    EXPECT_EQ(0, get_coro_profile().get_field("samples").as_num());
+}
+
+TPTEST(CoroSamplerTest, DebugCoroProfileBackend) {
+    // A cluster of a single server, which the client is connected to.
+    connectivity_cluster_t connectivity_cluster;
+    mailbox_manager_t mailbox_manager(&connectivity_cluster, 'M');
+    const server_id_t server_id = server_id_t::generate_server_id();
+    watchable_map_var_t<peer_id_t, cluster_directory_metadata_t> directory;
+    cluster_directory_metadata_t metadata;
+    metadata.server_id = server_id;
+    metadata.peer_id = connectivity_cluster.get_me();
+    metadata.peer_type = SERVER_PEER;
+    metadata.server_config.config.name =
+        name_string_t::guarantee_valid("coro_sampler_test");
+    directory.set_key_no_equals(connectivity_cluster.get_me(), metadata);
+    watchable_map_var_t<std::pair<peer_id_t, server_id_t>, empty_value_t>
+        peer_connections;
+    server_config_client_t server_config_client(
+        &mailbox_manager, &directory, &peer_connections);
+
+    extproc_pool_t extproc_pool(2);
+    dummy_semilattice_controller_t<auth_semilattice_metadata_t> auth_manager;
+    rdb_context_t rdb_context(&extproc_pool, nullptr, auth_manager.get_view());
+    artificial_reql_cluster_interface_t artificial_reql_cluster_interface(
+        auth_manager.get_view(), &rdb_context);
+    dummy_semilattice_controller_t<cluster_semilattice_metadata_t> cluster_manager;
+    name_resolver_t name_resolver(
+        cluster_manager.get_view(),
+        nullptr,
+        make_lifetime(artificial_reql_cluster_interface));
+
+    debug_coro_profile_artificial_table_backend_t backend(
+        &rdb_context, make_lifetime(name_resolver), &directory,
+        &server_config_client, &mailbox_manager);
+
+    const auth::user_context_t admin(auth::username_t("admin"));
+    const ql::datum_t primary_key = convert_server_id_to_datum(server_id);
+    cond_t non_interruptor;
+    auto write_row = [&](ql::datum_t enabled, admin_err_t *error_out) {
+        ql::datum_object_builder_t builder;
+        builder.overwrite("id", primary_key);
+        builder.overwrite("enabled", enabled);
+        builder.overwrite("sample_interval_ms", ql::datum_t(0.5));
+        ql::datum_t row = std::move(builder).to_datum();
+        return backend.write_row(
+            admin, primary_key, false, &row, &non_interruptor, error_out);
+    };
+
+    admin_err_t error;
+    ASSERT_TRUE(write_row(ql::datum_t::boolean(true), &error)) << error.msg;
+    EXPECT_TRUE(coro_sampler_t::is_enabled());
+    EXPECT_EQ(500 * THOUSAND, coro_sampler_t::get_sample_interval_nanos());
+
+    ASSERT_TRUE(write_row(ql::datum_t::boolean(false), &error)) << error.msg;
+    EXPECT_FALSE(coro_sampler_t::is_enabled());
+
+    // `enabled` has to be a boolean, and the sampler stays off otherwise.
+    EXPECT_FALSE(write_row(ql::datum_t("yes"), &error));
+    EXPECT_FALSE(coro_sampler_t::is_enabled());
+}
+
+}  // namespace unittest
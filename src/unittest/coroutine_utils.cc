@@ -5,6 +5,7 @@
 #include "arch/runtime/coroutines.hpp"
 #include "arch/runtime/runtime.hpp"
 #include "arch/timing.hpp"
+#include "concurrency/auto_drainer.hpp"
 #include "concurrency/cond_var.hpp"
 #include "time.hpp"
 #include "unittest/gtest.hpp"
@@ -20,6 +21,38 @@ void run_in_coro(const std::function<void()> &fun) {
     });
 }
 
+TEST(CoroutineUtilsTest, SmallStackMovesDeepCalls) {
+    run_in_coro([&]() {
+        cond_t done;
+        coro_t::spawn_sometime(coro_stack_class_t::small, [&]() {
+            // A small stack can't hold a normal stack's worth of data...
+            EXPECT_FALSE(has_n_bytes_free_stack_space(COROUTINE_SMALL_STACK_SIZE));
+            // ... but `call_with_enough_stack()` moves such calls to a normal stack.
+            bool had_space = call_with_enough_stack<bool>([] () {
+                return has_n_bytes_free_stack_space(COROUTINE_SMALL_STACK_SIZE);
+            }, COROUTINE_SMALL_STACK_SIZE);
+            EXPECT_TRUE(had_space);
+            done.pulse();
+        });
+        done.wait();
+
+        // Churn through more coroutines of both classes than the free lists hold,
+        // so that stacks get released, reused and freed.
+        for (int round = 0; round < 10; ++round) {
+            auto_drainer_t drainer;
+            for (int i = 0; i < 200; ++i) {
+                auto_drainer_t::lock_t lock(&drainer);
+                coro_t::spawn_sometime(coro_stack_class_t::small, [lock]() {
+                    coro_t::yield();
+                });
+                coro_t::spawn_sometime([lock]() {
+                    coro_t::yield();
+                });
+            }
+        }
+    });
+}
+
 TEST(CoroutineUtilsTest, WithEnoughStackNoSpawn) {
     int res = 0;
     run_in_coro([&]() {
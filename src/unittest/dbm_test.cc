@@ -48,6 +48,32 @@ TEST(DBMTest, ReadAheadInterval) {
     ASSERT_EQ(100, end_offset);
 }
 
+TEST(DBMTest, CostBenefit) {
+    const int64_t extent_size = 1000;
+    const int64_t second = 1000000;
 
+    // Extents without garbage aren't worth GCing.
+    ASSERT_EQ(0.0, gc_cost_benefit(0, extent_size, 100 * second));
+
+    // At the same age, more garbage is better.
+    ASSERT_LT(gc_cost_benefit(100, extent_size, 10 * second),
+              gc_cost_benefit(200, extent_size, 10 * second));
+    ASSERT_LT(gc_cost_benefit(900, extent_size, 10 * second),
+              gc_cost_benefit(extent_size, extent_size, 10 * second));
+
+    // With the same garbage, older is better.
+    ASSERT_LT(gc_cost_benefit(300, extent_size, 10 * second),
+              gc_cost_benefit(300, extent_size, 20 * second));
+
+    // An old extent can beat a young one with more garbage.
+    ASSERT_LT(gc_cost_benefit(500, extent_size, 2 * second),
+              gc_cost_benefit(300, extent_size, 100 * second));
+
+    // Very young and future ages count as the same minimum age.
+    ASSERT_EQ(gc_cost_benefit(300, extent_size, 0),
+              gc_cost_benefit(300, extent_size, -5 * second));
+    ASSERT_LT(gc_cost_benefit(300, extent_size, 0),
+              gc_cost_benefit(400, extent_size, -5 * second));
+}
 
 }  // namespace unittest
@@ -0,0 +1,149 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <vector>
+
+#include "arch/io/disk/accounting.hpp"
+#include "arch/timing.hpp"
+#include "config/args.hpp"
+#include "containers/scoped.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+/* The accounting disk manager doesn't look at the file descriptor. */
+#ifdef _WIN32
+static const fd_t IRRELEVANT_DEFAULT_FD = GetStdHandle(STD_INPUT_HANDLE);
+#else
+static const fd_t IRRELEVANT_DEFAULT_FD = 0;
+#endif
+
+static int64_t ms_to_nanos(int64_t ms) {
+    return ms * MILLION;
+}
+
+/* Submits reads to the accounting disk manager, and takes them from it as the
+backend would, at a time that the test picks. The reads are never run. */
+struct accounting_test_driver_t {
+    typedef accounting_diskmgr_t::action_t action_t;
+    typedef accounting_diskmgr_t::account_t account_t;
+
+    accounting_test_driver_t()
+        : buffer(KILOBYTE),
+          diskmgr(&stats, 1),
+          interactive(&diskmgr, CACHE_READS_IO_PRIORITY,
+                      UNLIMITED_OUTSTANDING_REQUESTS, file_io_class_t::interactive),
+          normal(&diskmgr, MERGER_BLOCK_WRITE_IO_PRIORITY,
+                 UNLIMITED_OUTSTANDING_REQUESTS, file_io_class_t::normal),
+          background(&diskmgr, LBA_GC_IO_PRIORITY,
+                     UNLIMITED_OUTSTANDING_REQUESTS, file_io_class_t::background) {
+        diskmgr.done_fun = [](action_t *) { };
+    }
+
+    ~accounting_test_driver_t() {
+        EXPECT_FALSE(diskmgr.producer->available->get());
+    }
+
+    action_t *submit(account_t *account) {
+        actions.push_back(make_scoped<action_t>());
+        action_t *a = actions.back().get();
+        a->make_read(IRRELEVANT_DEFAULT_FD, buffer.data(), buffer.size(), 0);
+        a->account = account;
+        diskmgr.submit(a);
+        return a;
+    }
+
+    // Takes the next action as of `now`, and completes it right away.
+    action_t *pop(ticks_t now) {
+        EXPECT_TRUE(diskmgr.producer->available->get());
+        accounting_payload_t *p = diskmgr.pop_next(now);
+        diskmgr.dispatched(p);
+        diskmgr.done(p);
+        return static_cast<action_t *>(p);
+    }
+
+    ticks_t get_background_deadline() const {
+        return diskmgr.background_queue.get_deadline();
+    }
+
+    std::vector<char> buffer;
+    std::vector<scoped_ptr_t<action_t> > actions;
+    perfmon_collection_t stats;
+    accounting_diskmgr_t diskmgr;
+    // The accounts have to go away before `diskmgr` does.
+    account_t interactive, normal, background;
+};
+
+TPTEST(DiskAccountingTest, ExpiredDeadlineWins) {
+    accounting_test_driver_t driver;
+
+    // As long as no deadline has passed, the highest class goes first.
+    accounting_diskmgr_action_t *n1 = driver.submit(&driver.normal);
+    accounting_diskmgr_action_t *i1 = driver.submit(&driver.interactive);
+    EXPECT_EQ(i1, driver.pop(i1->enqueue_time));
+    EXPECT_EQ(n1, driver.pop(i1->enqueue_time));
+
+    // Once the normal read has waited for longer than its class's latency target,
+    // it goes ahead of an interactive read that is still within its target.
+    accounting_diskmgr_action_t *n2 = driver.submit(&driver.normal);
+    nap(NORMAL_IO_LATENCY_TARGET_MS + 10);
+    accounting_diskmgr_action_t *i2 = driver.submit(&driver.interactive);
+    ASSERT_GT(i2->enqueue_time.nanos,
+              n2->enqueue_time.nanos + ms_to_nanos(NORMAL_IO_LATENCY_TARGET_MS));
+    EXPECT_EQ(n2, driver.pop(i2->enqueue_time));
+    EXPECT_EQ(i2, driver.pop(i2->enqueue_time));
+}
+
+TPTEST(DiskAccountingTest, DeadlineOrder) {
+    accounting_test_driver_t driver;
+
+    // Within a class, the actions go in the order of their deadlines, and the
+    // class's deadline is that of its oldest action.
+    std::vector<accounting_diskmgr_action_t *> reads;
+    for (int i = 0; i < 3; ++i) {
+        reads.push_back(driver.submit(&driver.background));
+        nap(1);
+    }
+    const ticks_t now = get_ticks();
+    for (accounting_diskmgr_action_t *read : reads) {
+        EXPECT_EQ(read->enqueue_time.nanos
+                  + ms_to_nanos(BACKGROUND_IO_LATENCY_TARGET_MS),
+                  driver.get_background_deadline().nanos);
+        EXPECT_EQ(read, driver.pop(now));
+    }
+
+    // Between classes that have both missed their deadlines, the earlier deadline
+    // goes first, even if its action was queued later.
+    accounting_diskmgr_action_t *b = driver.submit(&driver.background);
+    nap(1);
+    accounting_diskmgr_action_t *n = driver.submit(&driver.normal);
+    const ticks_t late{n->enqueue_time.nanos
+                       + ms_to_nanos(BACKGROUND_IO_LATENCY_TARGET_MS) + 1};
+    EXPECT_EQ(n, driver.pop(late));
+    EXPECT_EQ(b, driver.pop(late));
+}
+
+TPTEST(DiskAccountingTest, NoStarvation) {
+    accounting_test_driver_t driver;
+
+    // The interactive account always has a read queued.  The background read still
+    // goes to the backend as soon as its deadline has passed.
+    accounting_diskmgr_action_t *b = driver.submit(&driver.background);
+    const int64_t deadline
+        = b->enqueue_time.nanos + ms_to_nanos(BACKGROUND_IO_LATENCY_TARGET_MS);
+    int interactive_served = 0;
+    for (;;) {
+        accounting_diskmgr_action_t *i = driver.submit(&driver.interactive);
+        const ticks_t now = i->enqueue_time;
+        if (now.nanos > deadline) {
+            EXPECT_EQ(b, driver.pop(now));
+            EXPECT_EQ(i, driver.pop(now));
+            break;
+        }
+        EXPECT_EQ(i, driver.pop(now));
+        ++interactive_served;
+        nap(10);
+    }
+    EXPECT_LT(0, interactive_served);
+}
+
+}  // namespace unittest
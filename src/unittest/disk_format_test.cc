@@ -69,11 +69,18 @@ TEST(DiskFormatTest, LbaEntryT) {
     ASSERT_TRUE(lba_entry_t::is_padding(&ent));
     flagged_off64_t real = flagged_off64_t::unused();
     real = flagged_off64_t::make(1);
-    ent = lba_entry_t::make(1, repli_timestamp_t::invalid, real, 1234);
+    ent = lba_entry_t::make(1, repli_timestamp_t::invalid, real, 1234, 1234);
     ASSERT_FALSE(lba_entry_t::is_padding(&ent));
+    // Uncompressed blocks are stored the way they always were.
+    EXPECT_EQ(1234u, ent.ser_block_size);
+    EXPECT_EQ(1234u, ent.get_ser_block_size());
+    EXPECT_EQ(1234u, ent.get_disk_block_size());
+    ent = lba_entry_t::make(1, repli_timestamp_t::invalid, real, 4096, 700);
+    EXPECT_EQ(4096u, ent.get_ser_block_size());
+    EXPECT_EQ(700u, ent.get_disk_block_size());
     flagged_off64_t deleteblock = flagged_off64_t::unused();
     deleteblock = flagged_off64_t::make(1);
-    ent = lba_entry_t::make(1, repli_timestamp_t::invalid, deleteblock, 1234);
+    ent = lba_entry_t::make(1, repli_timestamp_t::invalid, deleteblock, 1234, 1234);
     ASSERT_FALSE(lba_entry_t::is_padding(&ent));
 }
 
@@ -0,0 +1,183 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include "arch/io/disk/merging.hpp"
+#include "concurrency/queue/unlimited_fifo.hpp"
+#include "config/args.hpp"
+#include "containers/scoped.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+#if USE_WRITEV
+
+/* The merging disk manager only looks at the file descriptor, so it doesn't matter
+which one it is. */
+static const fd_t IRRELEVANT_DEFAULT_FD = 0;
+
+/* Stands in for both the accounting disk manager above the merging disk manager and
+the backend below it. The operations are never run, the test only looks at which of
+them get merged. */
+struct merging_test_driver_t {
+    typedef merging_diskmgr_t::action_t action_t;
+
+    merging_test_driver_t()
+        : buffer(4 * MEGABYTE), merger(&stats, "test", &source) {
+        merger.dispatch_fun = [this](action_t *a) { ++dispatch_counts[a]; };
+        merger.done_fun = [this](action_t *a) {
+            EXPECT_TRUE(a->get_succeeded());
+            ++done_counts[a];
+        };
+    }
+
+    ~merging_test_driver_t() {
+        complete_all();
+        for (const auto &action : actions) {
+            EXPECT_EQ(1, dispatch_counts[action.get()]);
+            EXPECT_EQ(1, done_counts[action.get()]);
+        }
+    }
+
+    action_t *push_read(int64_t offset, size_t count) {
+        action_t *a = make_action();
+        a->make_read(IRRELEVANT_DEFAULT_FD, buffer.data() + offset, count, offset);
+        source.push(a);
+        return a;
+    }
+
+    action_t *push_write(int64_t offset, size_t count,
+                         datasync_op ds_op = datasync_op::no_datasyncs) {
+        action_t *a = make_action();
+        a->make_write(IRRELEVANT_DEFAULT_FD, buffer.data() + offset, count, offset,
+                      ds_op);
+        source.push(a);
+        return a;
+    }
+
+    // Takes the next operation like the backend would, and returns the operations
+    // that went into it, by offset.
+    std::vector<action_t *> pop() {
+        EXPECT_TRUE(merger.producer->available->get());
+        action_t *a = merger.producer->pop();
+        running.push_back(a);
+        auto is_original = [&](const scoped_ptr_t<action_t> &original) {
+            return original.get() == a;
+        };
+        if (std::find_if(actions.begin(), actions.end(), is_original)
+                != actions.end()) {
+            return std::vector<action_t *>(1, a);
+        }
+        merging_diskmgr_action_t *merged = static_cast<merging_diskmgr_action_t *>(a);
+        const action_t *last = merged->parts.back();
+        EXPECT_EQ(merged->parts.front()->get_offset(), a->get_offset());
+        EXPECT_EQ(last->get_offset() + static_cast<int64_t>(last->get_count()),
+                  a->get_offset() + static_cast<int64_t>(a->get_count()));
+        return merged->parts;
+    }
+
+    void complete_all() {
+        for (action_t *a : running) {
+            a->set_successful_due_to_conflict();
+            merger.done(a);
+        }
+        running.clear();
+    }
+
+    perfmon_collection_t stats;
+    std::vector<char> buffer;
+    unlimited_fifo_queue_t<action_t *> source;
+    merging_diskmgr_t merger;
+
+    std::vector<scoped_ptr_t<action_t> > actions;
+    std::vector<action_t *> running;
+    std::map<action_t *, int> dispatch_counts;
+    std::map<action_t *, int> done_counts;
+
+private:
+    action_t *make_action() {
+        actions.push_back(make_scoped<action_t>());
+        return actions.back().get();
+    }
+};
+
+TPTEST(DiskMergingTest, MergesAdjacent) {
+    merging_test_driver_t driver;
+    auto r1 = driver.push_read(0, 4 * KILOBYTE);
+    auto r2 = driver.push_read(4 * KILOBYTE, 4 * KILOBYTE);
+    // Reads can have a small gap between them.
+    auto r3 = driver.push_read(12 * KILOBYTE, 4 * KILOBYTE);
+    auto w2 = driver.push_write(68 * KILOBYTE, 4 * KILOBYTE);
+    auto w1 = driver.push_write(64 * KILOBYTE, 4 * KILOBYTE);
+
+    typedef std::vector<merging_test_driver_t::action_t *> parts_t;
+    EXPECT_EQ((parts_t{r1, r2, r3}), driver.pop());
+    EXPECT_EQ((parts_t{w1, w2}), driver.pop());
+    EXPECT_FALSE(driver.merger.producer->available->get());
+
+    // Every operation completes once, whether it was merged or not.
+    driver.complete_all();
+    EXPECT_EQ(1, driver.done_counts[r3]);
+    EXPECT_EQ(1, driver.done_counts[w1]);
+}
+
+TPTEST(DiskMergingTest, DoesntMergeNonAdjacent) {
+    merging_test_driver_t driver;
+    // Writes have to be exactly adjacent.
+    auto w1 = driver.push_write(0, 4 * KILOBYTE);
+    auto w2 = driver.push_write(8 * KILOBYTE, 4 * KILOBYTE);
+    // The gap between reads is limited.
+    auto r1 = driver.push_read(64 * KILOBYTE, 4 * KILOBYTE);
+    auto r2 = driver.push_read(68 * KILOBYTE + DISK_MERGE_MAX_READ_GAP + 1,
+                               4 * KILOBYTE);
+    // A read doesn't merge with a write.
+    auto w3 = driver.push_write(68 * KILOBYTE + DISK_MERGE_MAX_READ_GAP + 1
+                                + 4 * KILOBYTE, 4 * KILOBYTE);
+    // Neither do writes with a datasync.
+    auto w4 = driver.push_write(1 * MEGABYTE, 4 * KILOBYTE);
+    auto w5 = driver.push_write(1 * MEGABYTE + 4 * KILOBYTE, 4 * KILOBYTE,
+                                datasync_op::wrap_in_datasyncs);
+
+    for (auto action : {w1, w2, r1, r2, w3, w4, w5}) {
+        EXPECT_EQ(std::vector<merging_test_driver_t::action_t *>(1, action),
+                  driver.pop());
+    }
+}
+
+TPTEST(DiskMergingTest, KeepsReleaseOrder) {
+    merging_test_driver_t driver;
+    // `w2` is adjacent to `w1`, but `w3` was released between them. `w1` can't wait
+    // for `w2`, so it goes to the backend on its own, and `w2` joins `w3`.
+    auto w1 = driver.push_write(0, 4 * KILOBYTE);
+    auto w3 = driver.push_write(8 * KILOBYTE, 4 * KILOBYTE);
+    auto w2 = driver.push_write(4 * KILOBYTE, 4 * KILOBYTE);
+
+    typedef std::vector<merging_test_driver_t::action_t *> parts_t;
+    EXPECT_EQ((parts_t{w1}), driver.pop());
+    EXPECT_EQ((parts_t{w2, w3}), driver.pop());
+}
+
+TPTEST(DiskMergingTest, Caps) {
+    merging_test_driver_t driver;
+    // At most DISK_MERGE_MAX_OPS operations go into a merged one...
+    const size_t num_small = DISK_MERGE_MAX_OPS + 4;
+    for (size_t i = 0; i < num_small; ++i) {
+        driver.push_write(i * 4 * KILOBYTE, 4 * KILOBYTE);
+    }
+    EXPECT_EQ(static_cast<size_t>(DISK_MERGE_MAX_OPS), driver.pop().size());
+    EXPECT_EQ(num_small - DISK_MERGE_MAX_OPS, driver.pop().size());
+
+    // ...and they can't cover more than DISK_MERGE_MAX_SIZE bytes.
+    const int64_t large = DISK_MERGE_MAX_SIZE / 2;
+    for (int64_t i = 0; i < 3; ++i) {
+        driver.push_write(MEGABYTE + i * large, large);
+    }
+    EXPECT_EQ(2u, driver.pop().size());
+    EXPECT_EQ(1u, driver.pop().size());
+}
+
+#endif  // USE_WRITEV
+
+}  // namespace unittest
@@ -0,0 +1,152 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <errno.h>
+
+#include <vector>
+
+#include "arch/timing.hpp"
+#include "config/args.hpp"
+#include "serializer/log/config.hpp"
+#include "serializer/log/extent_manager.hpp"
+#include "serializer/log/stats.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/mock_file.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+const int64_t TEST_EXTENT_SIZE = 16 * DEVICE_BLOCK_SIZE;
+
+// Waits until the extent manager's punch timer has started a punch.
+static void wait_for_held_punches(mock_file_t *file) {
+    for (int i = 0; i < 100 && file->num_held_punches() == 0; ++i) {
+        nap(HOLE_PUNCHING_INTERVAL_MS);
+    }
+    ASSERT_NE(0u, file->num_held_punches());
+}
+
+static bool extent_is_zeroed(const std::vector<char> &data, int64_t extent) {
+    for (int64_t i = extent; i < extent + TEST_EXTENT_SIZE; ++i) {
+        if (data[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+class punching_extent_manager_t {
+public:
+    punching_extent_manager_t()
+        : file(mock_file_t::mode_rw, &data), stats(&stats_collection) {
+        static_config.block_size_ = DEFAULT_BTREE_BLOCK_SIZE;
+        static_config.extent_size_ = TEST_EXTENT_SIZE;
+        // Fast enough to punch every free extent in one go.
+        set_hole_punching_rate(
+            100 * TEST_EXTENT_SIZE * 1000 / HOLE_PUNCHING_INTERVAL_MS);
+        manager.init(new extent_manager_t(&file, &static_config, &stats));
+        set_hole_punching_rate(0);
+        manager->start_existing();
+    }
+
+    ~punching_extent_manager_t() {
+        for (size_t i = 0; i < extents.size(); ++i) {
+            if (in_use[i]) {
+                release(i);
+            }
+        }
+        file.release_punches(0);
+        manager->stop_punching_holes();
+        manager->shutdown();
+    }
+
+    // Generates `count` extents and fills them with data.
+    void gen_extents(size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            extents.push_back(manager->gen_extent());
+            in_use.push_back(true);
+            memset(data.data() + extents.back().offset(), 1, TEST_EXTENT_SIZE);
+        }
+    }
+
+    void release(size_t i) {
+        guarantee(in_use[i]);
+        manager->release_extent(std::move(extents[i]));
+        in_use[i] = false;
+    }
+
+    int64_t regen(size_t i) {
+        guarantee(!in_use[i]);
+        extents[i] = manager->gen_extent();
+        in_use[i] = true;
+        return extents[i].offset();
+    }
+
+    std::vector<char> data;
+    mock_file_t file;
+    perfmon_collection_t stats_collection;
+    log_serializer_stats_t stats;
+    log_serializer_on_disk_static_config_t static_config;
+    scoped_ptr_t<extent_manager_t> manager;
+    std::vector<extent_reference_t> extents;
+    std::vector<bool> in_use;
+};
+
+TPTEST(ExtentManagerTest, PunchHoles) {
+    punching_extent_manager_t em;
+    em.gen_extents(10);
+    EXPECT_EQ(10 * TEST_EXTENT_SIZE, em.file.get_file_size());
+
+    em.file.hold_punches();
+    for (size_t i = 2; i < 6; ++i) {
+        em.release(i);
+    }
+    EXPECT_EQ(4u, em.manager->held_extents());
+    wait_for_held_punches(&em.file);
+    for (int64_t i = 2; i < 6; ++i) {
+        EXPECT_TRUE(extent_is_zeroed(em.data, i * TEST_EXTENT_SIZE));
+    }
+
+    // The extents that are being punched aren't handed out, so the file grows.
+    extent_reference_t extent = em.manager->gen_extent();
+    EXPECT_EQ(10 * TEST_EXTENT_SIZE, extent.offset());
+    EXPECT_EQ(0u, em.manager->held_extents());
+    EXPECT_EQ(11 * TEST_EXTENT_SIZE, em.file.get_file_size());
+
+    // Once the punch is done, they are free again.
+    em.file.release_punches(0);
+    for (int i = 0; i < 100 && em.manager->held_extents() == 0; ++i) {
+        nap(1);
+    }
+    EXPECT_EQ(4u, em.manager->held_extents());
+    EXPECT_EQ(2 * TEST_EXTENT_SIZE, em.regen(2));
+    EXPECT_EQ(3u, em.manager->held_extents());
+
+    // Freeing the last extent shrinks the file again.
+    em.manager->release_extent(std::move(extent));
+    EXPECT_EQ(10 * TEST_EXTENT_SIZE, em.file.get_file_size());
+    EXPECT_EQ(3u, em.manager->held_extents());
+}
+
+TPTEST(ExtentManagerTest, PunchHoleFailure) {
+    punching_extent_manager_t em;
+    em.gen_extents(10);
+
+    em.file.hold_punches();
+    em.release(3);
+    wait_for_held_punches(&em.file);
+
+    // A failed punch turns punching off, but the extent is free as usual.
+    em.file.release_punches(EIO);
+    nap(HOLE_PUNCHING_INTERVAL_MS);
+    EXPECT_EQ(1u, em.manager->held_extents());
+
+    em.file.hold_punches();
+    em.release(5);
+    nap(3 * HOLE_PUNCHING_INTERVAL_MS);
+    EXPECT_EQ(0u, em.file.num_held_punches());
+    EXPECT_FALSE(extent_is_zeroed(em.data, 5 * TEST_EXTENT_SIZE));
+    EXPECT_EQ(2u, em.manager->held_extents());
+
+    EXPECT_EQ(3 * TEST_EXTENT_SIZE, em.regen(3));
+}
+
+}  // namespace unittest
@@ -0,0 +1,83 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <vector>
+
+#include "arch/timing.hpp"
+#include "concurrency/new_mutex.hpp"
+#include "concurrency/pmap.hpp"
+#include "config/args.hpp"
+#include "perfmon/perfmon.hpp"
+#include "rdb_protocol/datum.hpp"
+#include "serializer/buf_ptr.hpp"
+#include "serializer/log/log_serializer.hpp"
+#include "serializer/merger.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/mock_file.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+static int64_t stat_of(perfmon_collection_t *collection,
+                       const char *group, const char *name, const char *field) {
+    void *ctx = collection->begin_stats();
+    collection->visit_stats(ctx);
+    ql::datum_t stats = collection->end_stats(ctx);
+    return static_cast<int64_t>(
+        stats.get_field(group).get_field(name).get_field(field).as_num());
+}
+
+TPTEST(MergerSerializerTest, GroupCommit) {
+    const int num_writes = 10;
+
+    mock_file_opener_t file_opener;
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+    perfmon_collection_t stats;
+    scoped_ptr_t<serializer_t> inner(
+        new log_serializer_t(log_serializer_t::dynamic_config_t(),
+                             &file_opener, &stats));
+    set_group_commit_window(20 * THOUSAND);
+    merger_serializer_t ser(std::move(inner), 1, &stats);
+    set_group_commit_window(0);
+
+    buf_ptr_t buf = buf_ptr_t::alloc_zeroed(ser.max_block_size());
+    std::vector<buf_write_info_t> infos;
+    for (block_id_t id = 0; id < num_writes; ++id) {
+        infos.push_back(buf_write_info_t(buf.ser_buffer(), buf.block_size(), id));
+    }
+    struct : public iocallback_t, public cond_t {
+        void on_io_complete() {
+            pulse();
+        }
+    } cb;
+    scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+    std::vector<counted_t<block_token_t>> tokens
+        = ser.block_writes(infos.data(), infos.size(), account.get(), &cb);
+    cb.wait();
+
+    const int64_t inner_index_writes =
+        stat_of(&stats, "serializer", "serializer_index_writes", "total");
+
+    // The index writes all come in within the window of the first one, so they
+    // share a single index write on the log serializer.
+    pmap(num_writes, [&](int i) {
+        std::vector<index_write_op_t> write_ops;
+        write_ops.push_back(index_write_op_t(i, make_optional(tokens[i]),
+                                             make_optional(repli_timestamp_t{1})));
+        new_mutex_in_line_t dummy_acq;
+        ser.index_write(&dummy_acq, []{ }, write_ops);
+    });
+    EXPECT_EQ(inner_index_writes + 1,
+              stat_of(&stats, "serializer", "serializer_index_writes", "total"));
+    for (block_id_t id = 0; id < num_writes; ++id) {
+        EXPECT_EQ(tokens[id].get(), ser.index_read(id).get());
+    }
+
+    // The histogram shows the last complete interval, so wait for this one to end.
+    const int64_t interval_nanos =
+        secs_to_ticks(DISK_LATENCY_HISTOGRAM_INTERVAL_SECS).nanos;
+    nap((interval_nanos - get_ticks().nanos % interval_nanos) / MILLION + 1);
+    EXPECT_EQ(1, stat_of(&stats, "group_commit", "group_commit_batch_size", "count"));
+    EXPECT_EQ(num_writes,
+              stat_of(&stats, "group_commit", "group_commit_batch_size", "max"));
+}
+
+}  // namespace unittest
@@ -0,0 +1,73 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/runtime.hpp"
+#include "arch/timing.hpp"
+#include "concurrency/auto_drainer.hpp"
+#include "config/args.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+#include "utils.hpp"
+
+namespace unittest {
+
+TEST(MessageHubTest, RingOverflowOrdering) {
+    // Sends enough messages to another thread in a single pass through the event
+    // loop to overflow its ring, and checks that they still arrive in order.
+    const int num_coros = 4 * MESSAGE_RING_SIZE;
+    run_in_thread_pool([&]() {
+        auto_drainer_t drainer;
+        int arrived = 0;
+        for (int i = 0; i < num_coros; ++i) {
+            auto_drainer_t::lock_t lock(&drainer);
+            coro_t::spawn_later_ordered([&arrived, i, lock]() {
+                on_thread_t t((threadnum_t(1)));
+                ASSERT_EQ(i, arrived);
+                ++arrived;
+            });
+        }
+        drainer.drain();
+        ASSERT_EQ(num_coros, arrived);
+    }, 2);
+}
+
+TEST(MessageHubTest, HopLatencyAndThroughput) {
+    run_in_thread_pool([&]() {
+        // Latency: a single coroutine going back and forth between two threads.
+        const int num_round_trips = 10000;
+        ticks_t start = get_ticks();
+        for (int i = 0; i < num_round_trips; ++i) {
+            on_thread_t t((threadnum_t(1)));
+        }
+        ticks_t end = get_ticks();
+        const double latency_us =
+            static_cast<double>(end.nanos - start.nanos) / num_round_trips / 2 / THOUSAND;
+
+        // Throughput: many coroutines hopping between all the threads at once, so
+        // that every wakeup has lots of messages to deliver.
+        const int num_threads = get_num_threads();
+        const int num_coros = 1000;
+        const int hops_per_coro = 100;
+        start = get_ticks();
+        {
+            auto_drainer_t drainer;
+            for (int i = 0; i < num_coros; ++i) {
+                auto_drainer_t::lock_t lock(&drainer);
+                coro_t::spawn_sometime([i, num_threads, lock]() {
+                    for (int j = 0; j < hops_per_coro; ++j) {
+                        on_thread_t t(threadnum_t((i + j) % num_threads));
+                    }
+                });
+            }
+            drainer.drain();
+        }
+        end = get_ticks();
+        // Each `on_thread_t` hops twice: there and back again.
+        const double hops_per_sec = 2.0 * num_coros * hops_per_coro
+            / (static_cast<double>(end.nanos - start.nanos) / BILLION);
+
+        printf("Cross-thread hop latency: %.2f us, throughput with %d threads: "
+               "%.0f hops/s\n", latency_us, num_threads, hops_per_sec);
+    }, 4);
+}
+
+}  // namespace unittest
@@ -0,0 +1,127 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "buffer_cache/cache_balancer.hpp"
+#include "buffer_cache/miss_ratio_curve.hpp"
+#include "config/args.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+TEST(MissRatioCurveTest, LoopFitsBetweenGridPoints) {
+    // A loop over 8 MB of blocks hits in any cache of at least 8 MB, and misses in
+    // smaller ones.
+    alt::miss_ratio_curve_t curve;
+    const block_id_t num_blocks = 2048;
+    const uint32_t block_size = 4096;
+    for (int round = 0; round < 100; ++round) {
+        for (block_id_t block_id = 0; block_id < num_blocks; ++block_id) {
+            curve.record_access(block_id, block_size);
+        }
+    }
+
+    ASSERT_GT(curve.accesses(), 0);
+    std::vector<double> hits = curve.hits_at_cache_sizes();
+    ASSERT_EQ(alt::miss_ratio_curve_t::NUM_CACHE_SIZES, hits.size());
+    for (size_t i = 0; i < hits.size(); ++i) {
+        const double hit_rate = hits[i] / curve.accesses();
+        if (alt::miss_ratio_curve_t::cache_size_at(i) < 6 * MEGABYTE) {
+            EXPECT_EQ(0, hit_rate);
+        } else if (alt::miss_ratio_curve_t::cache_size_at(i) >= 12 * MEGABYTE) {
+            EXPECT_GT(hit_rate, 0.9);
+        }
+    }
+
+    EXPECT_EQ(0, alt::miss_ratio_curve_t::hits_for_cache_size(hits, 0));
+    EXPECT_EQ(hits.back(), alt::miss_ratio_curve_t::hits_for_cache_size(
+        hits, UINT64_MAX));
+}
+
+TEST(MissRatioCurveTest, BoundedSample) {
+    // A working set much larger than the sample budget still gives a curve.
+    alt::miss_ratio_curve_t curve;
+    const block_id_t num_blocks = 1 << 18;
+    for (int round = 0; round < 3; ++round) {
+        for (block_id_t block_id = 0; block_id < num_blocks; ++block_id) {
+            curve.record_access(block_id, 4096);
+        }
+    }
+    std::vector<double> hits = curve.hits_at_cache_sizes();
+    const double hit_rate_at_2gb =
+        alt::miss_ratio_curve_t::hits_for_cache_size(hits, 2 * GIGABYTE)
+        / curve.accesses();
+    const double hit_rate_at_256mb =
+        alt::miss_ratio_curve_t::hits_for_cache_size(hits, 256 * MEGABYTE)
+        / curve.accesses();
+    EXPECT_GT(hit_rate_at_2gb, 0.5);
+    EXPECT_LT(hit_rate_at_256mb, 0.1);
+}
+
+TPTEST(MissRatioCurveTest, AgesOutStaleBlocks) {
+    alt::miss_ratio_curve_t curve;
+    const int initial_sampling_shift = curve.sampling_shift_;
+
+    // A scan over a large working set lowers the sampling rate...
+    for (block_id_t block_id = 0; block_id < (1 << 18); ++block_id) {
+        curve.record_access(block_id, 4096);
+    }
+    ASSERT_LT(initial_sampling_shift, curve.sampling_shift_);
+
+    // ...and once the accesses stay within 1 MB, its blocks age out of the stack and
+    // the sampling rate goes back up.
+    for (int round = 0; round < 20000; ++round) {
+        for (block_id_t block_id = 0; block_id < 256; ++block_id) {
+            curve.record_access(block_id, 4096);
+        }
+    }
+    EXPECT_EQ(initial_sampling_shift, curve.sampling_shift_);
+    // Only the sampled blocks of the loop are left.
+    EXPECT_GE(2 * (256u >> initial_sampling_shift), curve.stack_.size());
+    std::vector<double> hits = curve.hits_at_cache_sizes();
+    EXPECT_GT(alt::miss_ratio_curve_t::hits_for_cache_size(hits, 2 * MEGABYTE)
+              / curve.accesses(), 0.9);
+}
+
+TPTEST(MissRatioCurveTest, BalancerFollowsCurves) {
+    typedef alt_cache_balancer_t::cache_data_t cache_data_t;
+
+    // Loops over 8 MB, 32 MB and 1 GB of blocks.
+    const block_id_t loop_blocks[] = {2048, 8192, 1 << 18};
+    const uint64_t unevictable_size = MEGABYTE;
+    scoped_array_t<std::vector<cache_data_t> > cache_data(1);
+    for (block_id_t num_blocks : loop_blocks) {
+        alt::miss_ratio_curve_t curve;
+        for (int round = 0; round < 3; ++round) {
+            for (block_id_t block_id = 0; block_id < num_blocks; ++block_id) {
+                curve.record_access(block_id, 4096);
+            }
+        }
+        cache_data_t data;
+        data.unevictable_size = unevictable_size;
+        data.access_count = 10000;
+        data.curve_accesses = curve.accesses();
+        data.curve_hits = curve.hits_at_cache_sizes();
+        cache_data[0].push_back(data);
+    }
+
+    // The two smaller loops fit, but the memory that's left wouldn't get the third
+    // cache any hits, so it's left for the caller to spread evenly.
+    const uint64_t total_cache_size = 512 * MEGABYTE;
+    ASSERT_TRUE(alt_cache_balancer_t::size_from_miss_ratio_curves(
+        total_cache_size, &cache_data));
+    EXPECT_LE(unevictable_size + 8 * MEGABYTE, cache_data[0][0].curve_target_size);
+    EXPECT_LE(unevictable_size + 32 * MEGABYTE, cache_data[0][1].curve_target_size);
+    EXPECT_EQ(unevictable_size, cache_data[0][2].curve_target_size);
+    EXPECT_GT(total_cache_size,
+              cache_data[0][0].curve_target_size + cache_data[0][1].curve_target_size
+              + cache_data[0][2].curve_target_size);
+
+    // A cache with accesses whose curve hasn't seen enough of them yet means the
+    // curves can't be used.
+    cache_data[0].push_back(cache_data_t());
+    cache_data[0].back().access_count = 10000;
+    cache_data[0].back().curve_hits.resize(alt::miss_ratio_curve_t::NUM_CACHE_SIZES);
+    EXPECT_FALSE(alt_cache_balancer_t::size_from_miss_ratio_curves(
+        total_cache_size, &cache_data));
+}
+
+}  // namespace unittest
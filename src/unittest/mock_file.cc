@@ -10,11 +10,14 @@
 
 namespace unittest {
 
-mock_file_t::mock_file_t(mode_t mode, std::vector<char> *data) : mode_(mode), data_(data) {
+mock_file_t::mock_file_t(mode_t mode, std::vector<char> *data)
+    : mode_(mode), data_(data), hold_punches_(false) {
     guarantee(mode != 0);
     guarantee(data_ != nullptr);
 }
-mock_file_t::~mock_file_t() { }
+mock_file_t::~mock_file_t() {
+    guarantee(held_punches_.empty());
+}
 
 int64_t mock_file_t::get_file_size() { return data_->size(); }
 
@@ -71,6 +74,41 @@ void mock_file_t::writev_async(int64_t offset, size_t length, scoped_array_t<iov
     write_async(offset, length, buf.get(), account, cb, datasync_op::no_datasyncs);
 }
 
+void mock_file_t::punch_hole_async(int64_t offset, size_t length,
+                                   UNUSED file_account_t *account,
+                                   linux_iocallback_t *cb) {
+    guarantee(mode_ & mode_write);
+    guarantee(!(offset < 0
+                || static_cast<uint64_t>(offset) > SIZE_MAX - length
+                || offset + length > data_->size()));
+    memset(data_->data() + offset, 0, length);
+
+    if (hold_punches_) {
+        held_punches_.push_back(held_punch_t{offset, length, cb});
+        return;
+    }
+    coro_t::spawn_sometime(std::bind(&linux_iocallback_t::on_io_complete, cb));
+}
+
+void mock_file_t::hold_punches() {
+    hold_punches_ = true;
+}
+
+void mock_file_t::release_punches(int errsv) {
+    hold_punches_ = false;
+    for (const held_punch_t &punch : held_punches_) {
+        if (errsv == 0) {
+            coro_t::spawn_sometime(
+                std::bind(&linux_iocallback_t::on_io_complete, punch.cb));
+        } else {
+            coro_t::spawn_sometime(
+                std::bind(&linux_iocallback_t::on_io_failure, punch.cb, errsv,
+                          punch.offset, static_cast<int64_t>(punch.length)));
+        }
+    }
+    held_punches_.clear();
+}
+
 bool mock_file_t::coop_lock_and_check() {
     // We don't actually implement the locking behavior.
     return true;
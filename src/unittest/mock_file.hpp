@@ -31,8 +31,11 @@ public:
                      datasync_op ds_op);
     void writev_async(int64_t offset, size_t length, scoped_array_t<iovec> &&bufs,
                       file_account_t *account, linux_iocallback_t *cb);
+    void punch_hole_async(int64_t offset, size_t length,
+                          file_account_t *account, linux_iocallback_t *cb);
 
-    void *create_account(UNUSED int priority, UNUSED int outstanding_requests_limit) {
+    void *create_account(UNUSED int priority, UNUSED int outstanding_requests_limit,
+                         UNUSED file_io_class_t io_class) {
         // We don't care about accounts.  Return an arbitrary non-null pointer.
         return this;
     }
@@ -43,9 +46,24 @@ public:
 
     bool coop_lock_and_check();
 
+    // While punches are held, `punch_hole_async()` zeroes the range right away but
+    // doesn't complete until `release_punches()` is called, which fails them with
+    // `errsv` if it's not 0.
+    void hold_punches();
+    void release_punches(int errsv);
+    size_t num_held_punches() const { return held_punches_.size(); }
+
 private:
+    struct held_punch_t {
+        int64_t offset;
+        size_t length;
+        linux_iocallback_t *cb;
+    };
+
     mode_t mode_;
     std::vector<char> *data_;
+    bool hold_punches_;
+    std::vector<held_punch_t> held_punches_;
 
     DISABLE_COPYING(mock_file_t);
 };
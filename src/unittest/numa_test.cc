@@ -0,0 +1,54 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <vector>
+
+#include "arch/runtime/numa.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+TEST(NumaTest, ParseIdList) {
+    std::vector<int> ids;
+    ASSERT_TRUE(parse_numa_id_list("0-3,8,10-11\n", &ids));
+    ASSERT_EQ(std::vector<int>({0, 1, 2, 3, 8, 10, 11}), ids);
+    ASSERT_TRUE(parse_numa_id_list("", &ids));
+    ASSERT_TRUE(ids.empty());
+    ASSERT_FALSE(parse_numa_id_list("3-1", &ids));
+    ASSERT_FALSE(parse_numa_id_list("1,,2", &ids));
+    ASSERT_FALSE(parse_numa_id_list("x", &ids));
+}
+
+TEST(NumaTest, PlanThreadPlacement) {
+    // Two nodes with interleaved CPU numbers, like many dual-socket machines.
+    numa_topology_t topology({{0, 2, 4, 6}, {1, 3, 5, 7}});
+
+    std::vector<thread_placement_t> none =
+        plan_thread_placement(thread_affinity_t::none, 4, topology);
+    for (const thread_placement_t &p : none) {
+        ASSERT_EQ(-1, p.cpu);
+        ASSERT_EQ(-1, p.node);
+    }
+
+    std::vector<thread_placement_t> cores =
+        plan_thread_placement(thread_affinity_t::cores, 10, topology);
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_EQ(i % 8, cores[i].cpu);
+        ASSERT_EQ(i % 2, cores[i].node);
+    }
+
+    std::vector<thread_placement_t> numa =
+        plan_thread_placement(thread_affinity_t::numa, 6, topology);
+    const int expected_cpus[] = {0, 2, 4, 1, 3, 5};
+    for (int i = 0; i < 6; ++i) {
+        ASSERT_EQ(expected_cpus[i], numa[i].cpu);
+        ASSERT_EQ(i < 3 ? 0 : 1, numa[i].node);
+    }
+
+    // More threads than CPUs wrap around within their node.
+    numa = plan_thread_placement(thread_affinity_t::numa, 10, topology);
+    ASSERT_EQ(0, numa[4].cpu);
+    ASSERT_EQ(0, numa[4].node);
+    ASSERT_EQ(1, numa[9].cpu);
+    ASSERT_EQ(1, numa[9].node);
+}
+
+}  // namespace unittest
@@ -0,0 +1,206 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <stdint.h>
+#include <string.h>
+
+#include <fstream>
+#include <vector>
+
+#include "arch/page_arena.hpp"
+#include "arch/runtime/runtime.hpp"
+#include "config/args.hpp"
+#include "rdb_protocol/datum.hpp"
+#include "threading.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+#ifdef __linux__
+
+/* The arena can only be turned on once per process, so every test uses it in the
+`hugetlb` mode. That covers the fallback to regular slabs when the hugetlbfs pool
+is empty, which it is on most test machines. */
+static bool page_arena_enabled() {
+    static const bool enabled = set_page_arena_mode(page_arena_mode_t::hugetlb);
+    return enabled;
+}
+
+static int64_t page_arena_stat(const char *name) {
+    return static_cast<int64_t>(get_page_arena_stats().get_field(name).as_num());
+}
+
+static int64_t read_proc_number(const char *path) {
+    std::ifstream file(path);
+    int64_t value = 0;
+    file >> value;
+    return value;
+}
+
+// Every slab holds a single size class, so the tests use sizes that nothing else
+// allocates, to keep them from sharing slabs with leftovers of other tests.
+const size_t ALLOC_FREE_SIZE = 3 * DEVICE_BLOCK_SIZE;
+const size_t CROSS_THREAD_SIZE = 5 * DEVICE_BLOCK_SIZE;
+const size_t SLAB_RELEASE_SIZE = 15 * DEVICE_BLOCK_SIZE;
+
+TEST(PageArenaTest, AllocFree) {
+    run_in_thread_pool([&]() {
+        if (!page_arena_enabled()) {
+            printf("Skipping: the page arena could not be turned on.\n");
+            return;
+        }
+        const int64_t bytes_in_use = page_arena_stat("bytes_in_use");
+
+        std::vector<char *> buffers;
+        for (size_t size = 1; size <= ALLOC_FREE_SIZE; size += 1000) {
+            char *buffer = static_cast<char *>(page_arena_alloc(size));
+            ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(buffer) % DEVICE_BLOCK_SIZE);
+            memset(buffer, static_cast<int>(buffers.size()), size);
+            buffers.push_back(buffer);
+        }
+        // Every buffer takes up whole device blocks.
+        ASSERT_LT(bytes_in_use, page_arena_stat("bytes_in_use"));
+        for (size_t i = 0; i < buffers.size(); ++i) {
+            for (size_t j = i + 1; j < buffers.size(); ++j) {
+                ASSERT_NE(buffers[i], buffers[j]);
+            }
+            page_arena_free(buffers[i]);
+        }
+        ASSERT_EQ(bytes_in_use, page_arena_stat("bytes_in_use"));
+
+        // A freed buffer is handed out again.
+        char *first = static_cast<char *>(page_arena_alloc(ALLOC_FREE_SIZE));
+        page_arena_free(first);
+        char *second = static_cast<char *>(page_arena_alloc(ALLOC_FREE_SIZE));
+        ASSERT_EQ(first, second);
+        page_arena_free(second);
+    });
+}
+
+TEST(PageArenaTest, FreeOnOtherThread) {
+    run_in_thread_pool([&]() {
+        if (!page_arena_enabled()) {
+            printf("Skipping: the page arena could not be turned on.\n");
+            return;
+        }
+        const int64_t bytes_in_use = page_arena_stat("bytes_in_use");
+
+        // More than a thread cache holds, so that the buffers go back to the arena.
+        const size_t count = 3 * PAGE_ARENA_THREAD_CACHE_SIZE;
+        std::vector<char *> buffers;
+        for (size_t i = 0; i < count; ++i) {
+            char *buffer = static_cast<char *>(page_arena_alloc(CROSS_THREAD_SIZE));
+            memset(buffer, i % 256, CROSS_THREAD_SIZE);
+            buffers.push_back(buffer);
+        }
+        {
+            on_thread_t thread_switcher(threadnum_t(1));
+            for (size_t i = 0; i < count; ++i) {
+                ASSERT_EQ(static_cast<char>(i % 256), buffers[i][CROSS_THREAD_SIZE - 1]);
+                page_arena_free(buffers[i]);
+            }
+        }
+        ASSERT_EQ(bytes_in_use, page_arena_stat("bytes_in_use"));
+
+        // The buffers that thread 1 gave back can be allocated here again.
+        for (size_t i = 0; i < count; ++i) {
+            buffers[i] = static_cast<char *>(page_arena_alloc(CROSS_THREAD_SIZE));
+            memset(buffers[i], 0, CROSS_THREAD_SIZE);
+        }
+        for (char *buffer : buffers) {
+            page_arena_free(buffer);
+        }
+        ASSERT_EQ(bytes_in_use, page_arena_stat("bytes_in_use"));
+    }, 2);
+}
+
+TEST(PageArenaTest, SlabRelease) {
+    run_in_thread_pool([&]() {
+        if (!page_arena_enabled()) {
+            printf("Skipping: the page arena could not be turned on.\n");
+            return;
+        }
+        const int64_t slabs = page_arena_stat("slabs");
+
+        const size_t buffers_per_slab = PAGE_ARENA_SLAB_SIZE / SLAB_RELEASE_SIZE;
+        const size_t num_slabs = 3 * PAGE_ARENA_EMPTY_SLABS_KEPT;
+        const int64_t slabs_kept = PAGE_ARENA_EMPTY_SLABS_KEPT;
+        std::vector<void *> buffers;
+        for (size_t i = 0; i < num_slabs * buffers_per_slab; ++i) {
+            buffers.push_back(page_arena_alloc(SLAB_RELEASE_SIZE));
+        }
+        // Some of the slabs might have been empty ones that were still mapped.
+        ASSERT_LE(slabs + static_cast<int64_t>(num_slabs) - slabs_kept,
+                  page_arena_stat("slabs"));
+
+        for (void *buffer : buffers) {
+            page_arena_free(buffer);
+        }
+        // Only PAGE_ARENA_EMPTY_SLABS_KEPT empty slabs stay mapped, and the buffers
+        // in this thread's cache pin at most two more.
+        ASSERT_GE(slabs + slabs_kept + 2, page_arena_stat("slabs"));
+        ASSERT_GE(slabs_kept, page_arena_stat("empty_slabs"));
+
+        // Released slabs get mapped again.
+        for (size_t i = 0; i < buffers.size(); ++i) {
+            buffers[i] = page_arena_alloc(SLAB_RELEASE_SIZE);
+            memset(buffers[i], 1, SLAB_RELEASE_SIZE);
+        }
+        for (void *buffer : buffers) {
+            page_arena_free(buffer);
+        }
+    });
+}
+
+TEST(PageArenaTest, Fallbacks) {
+    run_in_thread_pool([&]() {
+        if (!page_arena_enabled()) {
+            printf("Skipping: the page arena could not be turned on.\n");
+            return;
+        }
+        const int64_t fallback_allocations = page_arena_stat("fallback_allocations");
+        const int64_t bytes_in_use = page_arena_stat("bytes_in_use");
+
+        // Buffers that are too large for the arena come from `raw_malloc_aligned()`.
+        void *large = page_arena_alloc(PAGE_ARENA_MAX_BUFFER_SIZE + DEVICE_BLOCK_SIZE);
+        ASSERT_EQ(0u, reinterpret_cast<uintptr_t>(large) % DEVICE_BLOCK_SIZE);
+        memset(large, 1, PAGE_ARENA_MAX_BUFFER_SIZE + DEVICE_BLOCK_SIZE);
+        ASSERT_EQ(bytes_in_use, page_arena_stat("bytes_in_use"));
+        page_arena_free(large);
+
+        // Map more slabs than there can be empty ones, so that at least one of them
+        // is new.
+        const int64_t hugetlb_slabs = page_arena_stat("hugetlb_slabs");
+        const int64_t hugetlb_fallbacks = page_arena_stat("hugetlb_fallbacks");
+        const size_t buffers_per_slab =
+            PAGE_ARENA_SLAB_SIZE / PAGE_ARENA_MAX_BUFFER_SIZE;
+        std::vector<void *> buffers;
+        for (size_t i = 0; i < (PAGE_ARENA_EMPTY_SLABS_KEPT + 1) * buffers_per_slab;
+             ++i) {
+            void *buffer = page_arena_alloc(PAGE_ARENA_MAX_BUFFER_SIZE);
+            memset(buffer, 1, PAGE_ARENA_MAX_BUFFER_SIZE);
+            buffers.push_back(buffer);
+        }
+        const bool hugetlb_pool_empty =
+            read_proc_number("/proc/sys/vm/nr_hugepages") == 0
+            && read_proc_number("/proc/sys/vm/nr_overcommit_hugepages") == 0;
+        if (hugetlb_pool_empty) {
+            // Without huge pages, the slabs fell back to regular memory.
+            ASSERT_EQ(hugetlb_slabs, page_arena_stat("hugetlb_slabs"));
+            ASSERT_LT(hugetlb_fallbacks, page_arena_stat("hugetlb_fallbacks"));
+        } else {
+            ASSERT_LT(hugetlb_slabs + hugetlb_fallbacks,
+                      page_arena_stat("hugetlb_slabs")
+                      + page_arena_stat("hugetlb_fallbacks"));
+        }
+        for (void *buffer : buffers) {
+            page_arena_free(buffer);
+        }
+
+        // None of this ran out of address space.
+        ASSERT_EQ(fallback_allocations, page_arena_stat("fallback_allocations"));
+    });
+}
+
+#endif  // __linux__
+
+}  // namespace unittest
@@ -103,7 +103,8 @@ class test_acq_t : public page_acq_t {
 public:
     test_acq_t() : page_acq_t() { }
     void init(page_t *page, page_cache_t *_page_cache) {
-        page_acq_t::init(page, _page_cache, _page_cache->default_reads_account());
+        page_acq_t::init(page, _page_cache, _page_cache->default_reads_account(),
+                         page_access_hint_t::normal);
     }
 
     void *get_buf_write() {
@@ -310,6 +311,128 @@ TPTEST(PageTest, WriteWaitForFlush, 4) {
     pmap(2, std::bind(&WriteWaitForFlush_cases, &s, &page_cache, ph::_1));
 }
 
+// Creates `count` pages and flushes them to the serializer, so that a new cache has
+// to load them.
+static std::vector<block_id_t> create_pages(mock_ser_t *mock, size_t count) {
+    std::vector<block_id_t> block_ids;
+    dummy_cache_balancer_t balancer(GIGABYTE);
+    test_cache_t page_cache(mock->ser.get(), &balancer, mock->throttler.get());
+    auto txn = make_scoped<test_txn_t>(&page_cache);
+    for (size_t i = 0; i < count; ++i) {
+        current_test_acq_t acq(txn.get(), alt_create_t::create);
+        test_acq_t page_acq;
+        page_acq.init(acq.current_page_for_write(), &page_cache);
+        memset(page_acq.get_buf_write(), 'a' + i % 26,
+               page_cache.max_block_size().value());
+        block_ids.push_back(acq.block_id());
+    }
+    page_cache.flush(std::move(txn));
+    return block_ids;
+}
+
+static void read_page(page_cache_t *page_cache, block_id_t block_id,
+                      page_access_hint_t hint) {
+    current_test_acq_t acq(page_cache, block_id, read_access_t::read);
+    page_acq_t page_acq;
+    page_acq.init(acq.current_page_for_read(), page_cache,
+                  page_cache->default_reads_account(), hint);
+    page_acq.buf_ready_signal()->wait();
+}
+
+// Room for about 40 pages.
+const uint64_t SEGMENT_TEST_MEMORY_LIMIT = 40 * DEFAULT_BTREE_BLOCK_SIZE;
+
+TPTEST(PageTest, SecondAccessPromotes) {
+    mock_ser_t mock;
+    std::vector<block_id_t> block_ids = create_pages(&mock, 1);
+    dummy_cache_balancer_t balancer(SEGMENT_TEST_MEMORY_LIMIT);
+    test_cache_t page_cache(mock.ser.get(), &balancer, mock.throttler.get());
+    alt::evicter_t *evicter = &page_cache.evicter();
+
+    // The first access loads the page into the probationary segment.
+    read_page(&page_cache, block_ids[0], page_access_hint_t::normal);
+    EXPECT_EQ(1u, evicter->misses());
+    const uint64_t page_size = evicter->evictable_probationary_size();
+    ASSERT_LT(0u, page_size);
+    EXPECT_EQ(0u, evicter->evictable_protected_size());
+
+    // A scan that comes across it again doesn't count as a second use.
+    read_page(&page_cache, block_ids[0], page_access_hint_t::use_once);
+    EXPECT_EQ(1u, evicter->probationary_hits());
+    EXPECT_EQ(page_size, evicter->evictable_probationary_size());
+    EXPECT_EQ(0u, evicter->evictable_protected_size());
+
+    // The second normal access does.
+    read_page(&page_cache, block_ids[0], page_access_hint_t::normal);
+    EXPECT_EQ(2u, evicter->probationary_hits());
+    EXPECT_EQ(0u, evicter->evictable_probationary_size());
+    EXPECT_EQ(page_size, evicter->evictable_protected_size());
+
+    read_page(&page_cache, block_ids[0], page_access_hint_t::normal);
+    EXPECT_EQ(1u, evicter->protected_hits());
+    EXPECT_EQ(1u, evicter->misses());
+}
+
+TPTEST(PageTest, ScanLeavesProtectedPages) {
+    const size_t num_hot = 10;
+    const size_t num_scanned = 200;
+    mock_ser_t mock;
+    std::vector<block_id_t> block_ids = create_pages(&mock, num_hot + num_scanned);
+    dummy_cache_balancer_t balancer(SEGMENT_TEST_MEMORY_LIMIT);
+    test_cache_t page_cache(mock.ser.get(), &balancer, mock.throttler.get());
+    alt::evicter_t *evicter = &page_cache.evicter();
+
+    for (int pass = 0; pass < 2; ++pass) {
+        for (size_t i = 0; i < num_hot; ++i) {
+            read_page(&page_cache, block_ids[i], page_access_hint_t::normal);
+        }
+    }
+    const uint64_t protected_size = evicter->evictable_protected_size();
+    ASSERT_LT(0u, protected_size);
+    EXPECT_EQ(0u, evicter->evictable_probationary_size());
+
+    // The scan is five times the memory limit, so it has to evict its own pages.
+    for (size_t i = num_hot; i < num_hot + num_scanned; ++i) {
+        read_page(&page_cache, block_ids[i], page_access_hint_t::use_once);
+    }
+    EXPECT_GE(SEGMENT_TEST_MEMORY_LIMIT, evicter->in_memory_size());
+    EXPECT_EQ(protected_size, evicter->evictable_protected_size());
+
+    // The hot pages are all still loaded.
+    const uint64_t misses = evicter->misses();
+    const uint64_t protected_hits = evicter->protected_hits();
+    for (size_t i = 0; i < num_hot; ++i) {
+        read_page(&page_cache, block_ids[i], page_access_hint_t::normal);
+    }
+    EXPECT_EQ(misses, evicter->misses());
+    EXPECT_EQ(protected_hits + num_hot, evicter->protected_hits());
+}
+
+TPTEST(PageTest, ProtectedSegmentDemotes) {
+    // These fit into the memory limit, but not into the protected segment.
+    const size_t num_pages = 32;
+    mock_ser_t mock;
+    std::vector<block_id_t> block_ids = create_pages(&mock, num_pages);
+    dummy_cache_balancer_t balancer(SEGMENT_TEST_MEMORY_LIMIT);
+    test_cache_t page_cache(mock.ser.get(), &balancer, mock.throttler.get());
+    alt::evicter_t *evicter = &page_cache.evicter();
+
+    for (int pass = 0; pass < 2; ++pass) {
+        for (block_id_t block_id : block_ids) {
+            read_page(&page_cache, block_id, page_access_hint_t::normal);
+        }
+    }
+    EXPECT_EQ(num_pages, evicter->misses());
+    EXPECT_GE(SEGMENT_TEST_MEMORY_LIMIT / 100
+              * alt::evicter_t::PROTECTED_SEGMENT_PERCENT,
+              evicter->evictable_protected_size());
+    // The pages that didn't fit were demoted rather than evicted.
+    EXPECT_LT(0u, evicter->evictable_probationary_size());
+    EXPECT_EQ(evicter->in_memory_size(),
+              evicter->evictable_protected_size()
+              + evicter->evictable_probationary_size());
+}
+
 class bigger_test_t {
 public:
     explicit bigger_test_t(uint64_t _memory_limit)
@@ -7,6 +7,7 @@
 
 #include "perfmon/perfmon.hpp"
 #include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
 
 namespace unittest {
 
@@ -57,4 +58,62 @@ TEST(PerfmonTest, StddevComputation) {
     }
 }
 
+TEST(PerfmonTest, HistogramBuckets) {
+    using namespace perfmon_histogram;  // NOLINT(build/namespaces)
+
+    // Buckets must cover all values without gaps, in order.
+    int last_bucket = 0;
+    for (int64_t v = 0; v < 100000; ++v) {
+        int bucket = bucket_for_value(v);
+        ASSERT_TRUE(bucket == last_bucket || bucket == last_bucket + 1);
+        ASSERT_LE(bucket_lower_bound(bucket), v);
+        if (bucket + 1 < num_buckets) {
+            ASSERT_LT(v, bucket_lower_bound(bucket + 1));
+        }
+        last_bucket = bucket;
+    }
+    EXPECT_EQ(num_buckets - 1, bucket_for_value(std::numeric_limits<int64_t>::max()));
+}
+
+TEST(PerfmonTest, HistogramPercentiles) {
+    perfmon_histogram::stats_t stats;
+    for (int64_t v = 1; v <= 10000; ++v) {
+        stats.record(v);
+    }
+    EXPECT_EQ(10000u, stats.count);
+    EXPECT_EQ(10000, stats.max);
+
+    // Percentiles are rounded up to the end of their bucket.
+    const std::pair<double, int64_t> expected[] = {
+        {0.5, 5000}, {0.99, 9900}, {0.999, 9990} };
+    for (const auto &pair : expected) {
+        int64_t p = stats.percentile(pair.first);
+        EXPECT_LE(pair.second, p);
+        EXPECT_GE(pair.second * 1.25, p);
+    }
+    EXPECT_EQ(10000, stats.percentile(1.0));
+
+    perfmon_histogram::stats_t other;
+    other.record(20000);
+    stats.aggregate(other);
+    EXPECT_EQ(10001u, stats.count);
+    EXPECT_EQ(20000, stats.percentile(1.0));
+}
+
+TPTEST(PerfmonTest, CounterRatio) {
+    perfmon_counter_t numerator;
+    perfmon_counter_t denominator;
+    perfmon_counter_ratio_t ratio(&numerator, &denominator);
+    auto get_ratio = [&]() {
+        void *ctx = ratio.begin_stats();
+        ratio.visit_stats(ctx);
+        return ratio.end_stats(ctx).as_num();
+    };
+
+    numerator += 3;
+    EXPECT_EQ(0.0, get_ratio());
+    denominator += 4;
+    EXPECT_EQ(0.75, get_ratio());
+}
+
 }  // namespace unittest
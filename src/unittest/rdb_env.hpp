@@ -287,6 +287,20 @@ public:
                 ql::datum_t *result_out,
                 admin_err_t *error_out);
 
+        bool table_compact(
+                auth::user_context_t const &user_context,
+                counted_t<const ql::db_t> db,
+                const name_string_t &name,
+                signal_t *interruptor,
+                ql::datum_t *result_out,
+                admin_err_t *error_out);
+        bool db_compact(
+                auth::user_context_t const &user_context,
+                counted_t<const ql::db_t> db,
+                signal_t *interruptor,
+                ql::datum_t *result_out,
+                admin_err_t *error_out);
+
         bool grant_global(
                 auth::user_context_t const &user_context,
                 auth::username_t username,
@@ -0,0 +1,115 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <stdlib.h>
+#include <string.h>
+
+#include <functional>
+#include <vector>
+
+#include "arch/timing.hpp"
+#include "concurrency/new_mutex.hpp"
+#include "serializer/buf_ptr.hpp"
+#include "serializer/log/log_serializer.hpp"
+#include "serializer/translator.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/mock_file.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+// Like the CPU shards of a table.
+const int NUM_PROXIES = 8;
+
+// Opens a log serializer for each of `files`, like a striped table does, and calls
+// `fn` with the multiplexer on top of them.
+static void with_multiplexer(
+        const std::vector<mock_file_opener_t *> &files,
+        bool create,
+        const std::function<void(serializer_multiplexer_t *,
+                                 const std::vector<serializer_t *> &)> &fn) {
+    std::vector<scoped_ptr_t<log_serializer_t> > serializers;
+    std::vector<serializer_t *> ptrs;
+    for (mock_file_opener_t *file : files) {
+        if (create) {
+            log_serializer_t::create(file, log_serializer_t::static_config_t());
+        }
+        serializers.push_back(make_scoped<log_serializer_t>(
+            log_serializer_t::dynamic_config_t(), file,
+            &get_global_perfmon_collection()));
+        ptrs.push_back(serializers.back().get());
+    }
+    if (create) {
+        serializer_multiplexer_t::create(ptrs, NUM_PROXIES);
+    }
+    serializer_multiplexer_t multiplexer(ptrs);
+    fn(&multiplexer, ptrs);
+}
+
+static void write_proxy_block(serializer_t *proxy, char value) {
+    buf_ptr_t buf = buf_ptr_t::alloc_zeroed(proxy->max_block_size());
+    memset(buf.cache_data(), value, buf.block_size().value());
+    buf_write_info_t info(buf.ser_buffer(), buf.block_size(), 0);
+    struct : public iocallback_t, public cond_t {
+        void on_io_complete() {
+            pulse();
+        }
+    } cb;
+    std::vector<counted_t<block_token_t> > tokens
+        = proxy->block_writes(&info, 1, DEFAULT_DISK_ACCOUNT, &cb);
+    cb.wait();
+
+    std::vector<index_write_op_t> write_ops;
+    write_ops.push_back(index_write_op_t(0, make_optional(tokens[0]),
+                                         make_optional(repli_timestamp_t{1})));
+    new_mutex_in_line_t dummy_acq;
+    proxy->index_write(&dummy_acq, []{ }, write_ops);
+}
+
+static char read_proxy_block(serializer_t *proxy) {
+    buf_ptr_t buf = proxy->block_read(proxy->index_read(0), DEFAULT_DISK_ACCOUNT);
+    return static_cast<char *>(buf.cache_data())[buf.block_size().value() - 1];
+}
+
+TEST(SerializerMultiplexerTest, Stripes) {
+    mock_file_opener_t first;
+    mock_file_opener_t second;
+
+    run_in_thread_pool([&]() {
+        with_multiplexer({&first, &second}, true,
+            [](serializer_multiplexer_t *multiplexer,
+               const std::vector<serializer_t *> &serializers) {
+                ASSERT_EQ(static_cast<size_t>(NUM_PROXIES),
+                          multiplexer->proxies.size());
+                for (int i = 0; i < NUM_PROXIES; ++i) {
+                    write_proxy_block(multiplexer->proxies[i], 'a' + i);
+                }
+                // Each file holds the blocks of half of the proxies, next to its
+                // config block.
+                for (serializer_t *serializer : serializers) {
+                    EXPECT_EQ(static_cast<block_id_t>(1 + NUM_PROXIES / 2),
+                              serializer->end_block_id());
+                }
+            });
+    });
+
+    // The files can be given in any order.
+    run_in_thread_pool([&]() {
+        with_multiplexer({&second, &first}, false,
+            [](serializer_multiplexer_t *multiplexer,
+               const std::vector<serializer_t *> &) {
+                for (int i = 0; i < NUM_PROXIES; ++i) {
+                    EXPECT_EQ('a' + i, read_proxy_block(multiplexer->proxies[i]));
+                }
+            });
+    });
+
+    // A missing stripe is reported to the user, rather than failing a guarantee.
+    EXPECT_EXIT(run_in_thread_pool([&]() {
+                    with_multiplexer({&first}, false,
+                        [](serializer_multiplexer_t *,
+                           const std::vector<serializer_t *> &) { });
+                }),
+                ::testing::ExitedWithCode(EXIT_FAILURE),
+                "spread over 2 files, but the server only found 1");
+}
+
+}  // namespace unittest
@@ -1,9 +1,21 @@
+#include <algorithm>
 #include <functional>
+#include <map>
 
+#include "arch/arch.hpp"
+#include "arch/io/disk.hpp"
 #include "arch/runtime/starter.hpp"
+#include "arch/timing.hpp"
 #include "concurrency/new_mutex.hpp"
+#include "math.hpp"
 #include "serializer/buf_ptr.hpp"
+#include "serializer/log/compaction.hpp"
+#include "serializer/log/lba/in_memory_index.hpp"
+#include "serializer/log/lba/lba_list.hpp"
 #include "serializer/log/log_serializer.hpp"
+#include "serializer/log/metablock_manager.hpp"
+#include "serializer/log/stats.hpp"
+#include "version.hpp"
 #include "unittest/mock_file.hpp"
 #include "unittest/gtest.hpp"
 #include "unittest/unittest_utils.hpp"
@@ -90,5 +102,464 @@ TEST(SerializerTest, AddDeleteRepeatedlyWithIndex) {
     run_in_thread_pool(std::bind(run_AddDeleteRepeatedly, true), 4);
 }
 
+// Checks that the in-memory index gives back what it was given, both for entries that
+// fit into its compact encoding and for the ones that make a chunk fall back to
+// storing them as they are.
+TPTEST(SerializerTest, InMemoryIndex) {
+    log_serializer_stats_t stats(&get_global_perfmon_collection());
+    std::map<block_id_t, index_block_info_t> expected;
+    {
+        in_memory_index_t index(&stats);
+        auto set = [&](block_id_t id, index_block_info_t info) {
+            index.set_block_info(id, info.recency, info.offset,
+                                 info.ser_block_size, info.disk_block_size);
+            expected[id] = info;
+        };
+
+        const block_id_t chunk = IN_MEMORY_INDEX_CHUNK_SIZE;
+        for (block_id_t id = 0; id < 3 * chunk; id += 7) {
+            set(id, index_block_info_t(flagged_off64_t::make(id * DEVICE_BLOCK_SIZE),
+                                       repli_timestamp_t{1000000 + id}, 4096, 4096));
+        }
+        // The compact encoding fits these in the first chunk...
+        set(1, index_block_info_t(flagged_off64_t::make(0), repli_timestamp_t{0},
+                                  4096, 700));
+        set(2, index_block_info_t(flagged_off64_t::unused(),
+                                  repli_timestamp_t::invalid, 0, 0));
+        // ...but not these, which turn the second and third chunk into plain ones.
+        set(chunk + 1, index_block_info_t(flagged_off64_t::make(123),
+                                          repli_timestamp_t{5}, 4096, 4096));
+        set(2 * chunk + 1,
+            index_block_info_t(flagged_off64_t::make(DEVICE_BLOCK_SIZE),
+                               repli_timestamp_t{uint64_t(1) << 40}, 4096, 4096));
+        // Aux blocks don't have a recency.
+        set(FIRST_AUX_BLOCK_ID + 5,
+            index_block_info_t(flagged_off64_t::make(10 * DEVICE_BLOCK_SIZE),
+                               repli_timestamp_t::invalid, 4096, 2000));
+
+        for (const auto &pair : expected) {
+            ASSERT_EQ(pair.second, index.get_block_info(pair.first));
+        }
+        EXPECT_EQ(index_block_info_t(), index.get_block_info(3));
+        EXPECT_EQ((3 * chunk - 1) / 7 * 7 + 1, index.end_block_id());
+        EXPECT_EQ(FIRST_AUX_BLOCK_ID + 6, index.end_aux_block_id());
+
+        // Compact chunks take 12 bytes per block id (8 for aux blocks), and plain
+        // ones 20.
+        EXPECT_LT(index.memory_usage(),
+                  (chunk * 12 + 2 * chunk * 20 + chunk * 8) * 1.01);
+        EXPECT_GT(index.memory_usage(), chunk * 12 + 2 * chunk * 20 + chunk * 8);
+    }
+}
+
+// Writes small blocks with the ids [begin, end).
+static void write_small_blocks(log_serializer_t *ser, block_id_t begin, block_id_t end) {
+    scoped_ptr_t<file_account_t> account(ser->make_io_account(1));
+    std::vector<buf_ptr_t> bufs;
+    std::vector<buf_write_info_t> infos;
+    for (block_id_t id = begin; id < end; ++id) {
+        bufs.push_back(buf_ptr_t::alloc_zeroed(block_size_t::make_from_cache(64)));
+    }
+    for (block_id_t id = begin; id < end; ++id) {
+        buf_ptr_t *buf = &bufs[id - begin];
+        infos.push_back(buf_write_info_t(buf->ser_buffer(), buf->block_size(), id));
+    }
+    struct : public iocallback_t, public cond_t {
+        void on_io_complete() {
+            pulse();
+        }
+    } cb;
+    std::vector<counted_t<block_token_t> > tokens
+        = ser->block_writes(infos.data(), infos.size(), account.get(), &cb);
+    cb.wait();
+
+    std::vector<index_write_op_t> write_ops;
+    for (block_id_t id = begin; id < end; ++id) {
+        write_ops.push_back(index_write_op_t(id, make_optional(tokens[id - begin]),
+                                             make_optional(repli_timestamp_t{1})));
+    }
+    new_mutex_in_line_t dummy_acq;
+    ser->index_write(&dummy_acq, []{ }, write_ops);
+}
+
+// The LBA GC rewrites a shard once no more than LBA_MIN_UNGARBAGE_FRACTION of its
+// entries are live.  This piles up garbage in the first shard by updating the
+// recencies of its blocks, and checks that the GC takes the shard on exactly when its
+// entries cross that fraction.
+TPTEST(SerializerTest, LbaGcThreshold) {
+    mock_file_opener_t file_opener;
+    log_serializer_t::static_config_t static_config;
+    // Small extents, so that the shards reach the minimum size for the GC soon.
+    static_config.extent_size_ = 64 * KILOBYTE;
+    log_serializer_t::create(&file_opener, static_config);
+    log_serializer_t ser(log_serializer_t::dynamic_config_t(), &file_opener,
+                         &get_global_perfmon_collection());
+    lba_list_t *lba = ser.lba_index;
+    auto shard_extents = [&]() {
+        return static_cast<int64_t>(
+            lba->disk_structures[0]->extents_in_superblock.size());
+    };
+
+    const int64_t entries_per_extent =
+        lba->disk_structures[0]->num_entries_that_can_fit_in_an_extent();
+    const int64_t min_extents = ceil_divide(LBA_MIN_SIZE_FOR_GC / LBA_SHARD_FACTOR,
+                                            static_config.extent_size());
+
+    // Enough live blocks that a shard with the minimum size for the GC isn't garbage
+    // enough yet, but one with an extent more is.
+    const int64_t live_per_shard =
+        (min_extents + 1) * entries_per_extent * LBA_MIN_UNGARBAGE_FRACTION;
+    ASSERT_FALSE(lba_list_t::garbage_warrants_gc(
+        live_per_shard, min_extents * entries_per_extent));
+    ASSERT_TRUE(lba_list_t::garbage_warrants_gc(
+        live_per_shard, (min_extents + 1) * entries_per_extent));
+
+    // Block `id` goes into shard `id % LBA_SHARD_FACTOR`.
+    const block_id_t num_blocks = live_per_shard * LBA_SHARD_FACTOR;
+    for (block_id_t id = 0; id < num_blocks; id += 1024) {
+        write_small_blocks(&ser, id, std::min<block_id_t>(id + 1024, num_blocks));
+    }
+    ASSERT_EQ(num_blocks, lba->num_blocks());
+    ASSERT_LT(shard_extents(), min_extents);
+
+    // Every update adds an entry to the first shard, and the number of live blocks
+    // stays the same.
+    block_id_t next_id = 0;
+    auto update_recency = [&]() {
+        std::vector<index_write_op_t> write_ops;
+        write_ops.push_back(index_write_op_t(next_id, r_nullopt,
+                                             make_optional(repli_timestamp_t{2})));
+        new_mutex_in_line_t dummy_acq;
+        ser.index_write(&dummy_acq, []{ }, write_ops);
+        next_id = (next_id + LBA_SHARD_FACTOR) % num_blocks;
+    };
+    int64_t num_extents = shard_extents();
+    while (!lba->we_want_to_gc(0)) {
+        ASSERT_FALSE(lba->gc_active[0]);
+        ASSERT_LE(num_extents, min_extents);
+        update_recency();
+        num_extents = shard_extents();
+    }
+    EXPECT_EQ(min_extents + 1, num_extents);
+
+    // The next index write starts the GC, which rewrites the live entries of the
+    // shard and drops its old extents.
+    update_recency();
+    for (int i = 0; i < 10000 && lba->gc_active[0]; ++i) {
+        nap(1);
+    }
+    ASSERT_FALSE(lba->gc_active[0]);
+    EXPECT_LE(shard_extents(), min_extents);
+    EXPECT_FALSE(lba->we_want_to_gc(0));
+    EXPECT_EQ(num_blocks, lba->num_blocks());
+}
+
+// Fills `buf` with data that compresses well, but differs for every block id.
+static void fill_compressible_block(block_id_t block_id, buf_ptr_t *buf) {
+    char *data = static_cast<char *>(buf->cache_data());
+    for (uint32_t i = 0; i < buf->block_size().value(); ++i) {
+        data[i] = static_cast<char>('a' + (i * i + block_id) % 7);
+    }
+    memcpy(data, &block_id, sizeof(block_id));
+}
+
+// Returns the `disk_format_version` of the newest metablock in the file.
+static uint32_t latest_disk_format_version(serializer_file_opener_t *file_opener) {
+    scoped_ptr_t<file_t> file;
+    file_opener->open_serializer_file_existing(&file);
+    scoped_device_block_aligned_ptr_t<crc_metablock_t> mb(METABLOCK_SIZE);
+    metablock_version_t latest_version = MB_BAD_VERSION;
+    uint32_t disk_format_version = 0;
+    for (int64_t offset : initial_metablock_offsets(DEFAULT_EXTENT_SIZE)) {
+        co_read(file.get(), offset, METABLOCK_SIZE, mb.get(), DEFAULT_DISK_ACCOUNT);
+        if (memcmp(mb->magic_marker, MB_MARKER_MAGIC, sizeof(MB_MARKER_MAGIC)) == 0
+            && mb->version > latest_version) {
+            latest_version = mb->version;
+            disk_format_version = mb->disk_format_version;
+        }
+    }
+    return disk_format_version;
+}
+
+TPTEST(SerializerTest, CompressedBlocksSurviveGcAndRestart) {
+    mock_file_opener_t file_opener;
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+
+    // Enough blocks to fill a few extents, even compressed.
+    const block_id_t num_blocks = 20000;
+    std::map<block_id_t, int64_t> offsets_before_gc;
+    {
+        log_serializer_t::dynamic_config_t config;
+        config.compression = block_compression_t::zlib;
+        log_serializer_t ser(config, &file_opener, &get_global_perfmon_collection());
+        scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+
+        buf_ptr_t buf = buf_ptr_t::alloc_zeroed(ser.max_block_size());
+        for (block_id_t id = 0; id < num_blocks; ++id) {
+            fill_compressible_block(id, &buf);
+            buf_write_info_t info(buf.ser_buffer(), buf.block_size(), id);
+            struct : public iocallback_t, public cond_t {
+                void on_io_complete() {
+                    pulse();
+                }
+            } cb;
+            std::vector<counted_t<block_token_t> > tokens
+                = ser.block_writes(&info, 1, account.get(), &cb);
+            cb.wait();
+            ASSERT_LT(tokens[0]->disk_block_size().ser_value(),
+                      tokens[0]->block_size().ser_value());
+
+            std::vector<index_write_op_t> write_ops;
+            write_ops.push_back(index_write_op_t(id, make_optional(tokens[0]),
+                                                 make_optional(repli_timestamp_t{id})));
+            new_mutex_in_line_t dummy_acq;
+            ser.index_write(&dummy_acq, []{ }, write_ops);
+        }
+
+        // Deleting every other block leaves garbage in every extent.
+        std::vector<index_write_op_t> delete_ops;
+        for (block_id_t id = 0; id < num_blocks; id += 2) {
+            delete_ops.push_back(
+                index_write_op_t(id, make_optional(counted_t<block_token_t>())));
+        }
+        {
+            new_mutex_in_line_t dummy_acq;
+            ser.index_write(&dummy_acq, []{ }, delete_ops);
+        }
+        for (block_id_t id = 1; id < num_blocks; id += 2) {
+            offsets_before_gc[id] = ser.index_read(id)->offset();
+        }
+
+        ser.start_compaction();
+        for (int i = 0; i < 10000 && ser.is_gc_active(); ++i) {
+            nap(1);
+        }
+        ASSERT_FALSE(ser.is_gc_active());
+    }
+
+    // Versions that can't read compressed blocks refuse to open the file.
+    const uint32_t disk_format_version = latest_disk_format_version(&file_opener);
+    EXPECT_EQ(static_cast<uint32_t>(cluster_version_t::LATEST_DISK)
+              | MB_FEATURE_COMPRESSED_BLOCKS, disk_format_version);
+    EXPECT_TRUE(disk_format_version_is_recognized(disk_format_version));
+    EXPECT_FALSE(disk_format_version_is_recognized(
+        disk_format_version | (MB_FEATURE_COMPRESSED_BLOCKS << 1)));
+
+    {
+        // The blocks can be read back without compression turned on.
+        log_serializer_t ser(log_serializer_t::dynamic_config_t(), &file_opener,
+                             &get_global_perfmon_collection());
+        scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+        const segmented_vector_t<repli_timestamp_t> recencies =
+            ser.get_all_recencies(0, 1);
+
+        buf_ptr_t expected = buf_ptr_t::alloc_zeroed(ser.max_block_size());
+        size_t moved = 0;
+        for (block_id_t id = 0; id < num_blocks; ++id) {
+            counted_t<block_token_t> token = ser.index_read(id);
+            if (id % 2 == 0) {
+                ASSERT_FALSE(token.has());
+                continue;
+            }
+            ASSERT_TRUE(token.has());
+            if (token->offset() != offsets_before_gc[id]) {
+                ++moved;
+            }
+            EXPECT_EQ(repli_timestamp_t{id}, recencies[id]);
+            buf_ptr_t buf = ser.block_read(token, account.get());
+            fill_compressible_block(id, &expected);
+            ASSERT_EQ(expected.block_size().ser_value(), buf.block_size().ser_value());
+            ASSERT_EQ(0, memcmp(expected.cache_data(), buf.cache_data(),
+                                expected.block_size().value()));
+        }
+        // The GC moved the blocks out of the extents with garbage.
+        EXPECT_LT(0u, moved);
+
+        // New metablocks keep the flag.
+        std::vector<index_write_op_t> write_ops;
+        write_ops.push_back(index_write_op_t(0, make_optional(counted_t<block_token_t>())));
+        new_mutex_in_line_t dummy_acq;
+        ser.index_write(&dummy_acq, []{ }, write_ops);
+    }
+    EXPECT_EQ(disk_format_version, latest_disk_format_version(&file_opener));
+}
+
+// Writes the blocks `block_ids` with `fill_compressible_block()`, and gives the ones
+// that aren't aux blocks their block id as the recency.
+static void write_blocks(log_serializer_t *ser,
+                         const std::vector<block_id_t> &block_ids) {
+    scoped_ptr_t<file_account_t> account(ser->make_io_account(1));
+    std::vector<buf_ptr_t> bufs;
+    std::vector<buf_write_info_t> infos;
+    for (block_id_t id : block_ids) {
+        bufs.push_back(buf_ptr_t::alloc_zeroed(ser->max_block_size()));
+        fill_compressible_block(id, &bufs.back());
+    }
+    for (size_t i = 0; i < block_ids.size(); ++i) {
+        infos.push_back(buf_write_info_t(
+            bufs[i].ser_buffer(), bufs[i].block_size(), block_ids[i]));
+    }
+    struct : public iocallback_t, public cond_t {
+        void on_io_complete() {
+            pulse();
+        }
+    } cb;
+    std::vector<counted_t<block_token_t> > tokens
+        = ser->block_writes(infos.data(), infos.size(), account.get(), &cb);
+    cb.wait();
+
+    std::vector<index_write_op_t> write_ops;
+    for (size_t i = 0; i < block_ids.size(); ++i) {
+        optional<repli_timestamp_t> recency;
+        if (!is_aux_block_id(block_ids[i])) {
+            recency.set(repli_timestamp_t{block_ids[i]});
+        }
+        write_ops.push_back(
+            index_write_op_t(block_ids[i], make_optional(tokens[i]), recency));
+    }
+    new_mutex_in_line_t dummy_acq;
+    ser->index_write(&dummy_acq, []{ }, write_ops);
+}
+
+static void delete_blocks(log_serializer_t *ser,
+                          const std::vector<block_id_t> &block_ids) {
+    std::vector<index_write_op_t> write_ops;
+    for (block_id_t id : block_ids) {
+        write_ops.push_back(
+            index_write_op_t(id, make_optional(counted_t<block_token_t>())));
+    }
+    new_mutex_in_line_t dummy_acq;
+    ser->index_write(&dummy_acq, []{ }, write_ops);
+}
+
+static int64_t serializer_file_size(serializer_file_opener_t *file_opener) {
+    scoped_ptr_t<file_t> file;
+    file_opener->open_serializer_file_existing(&file);
+    return file->get_file_size();
+}
+
+// The compaction tests delete the first half of the blocks, which frees the extents
+// at the start of the file, and keep every tenth block of the second half and every
+// other aux block.
+const block_id_t COMPACTION_TEST_NUM_BLOCKS = 5000;
+const block_id_t COMPACTION_TEST_NUM_AUX_BLOCKS = 20;
+
+static bool compaction_test_keeps(block_id_t id) {
+    return id >= COMPACTION_TEST_NUM_BLOCKS / 2 && id % 10 == 9;
+}
+
+// Fills a new serializer file with blocks and deletes most of them again.
+static void write_and_delete_blocks(log_serializer_t *ser) {
+    std::vector<block_id_t> block_ids;
+    for (block_id_t id = 0; id < COMPACTION_TEST_NUM_BLOCKS; ++id) {
+        block_ids.push_back(id);
+    }
+    for (block_id_t i = 0; i < COMPACTION_TEST_NUM_AUX_BLOCKS; ++i) {
+        block_ids.push_back(FIRST_AUX_BLOCK_ID + i);
+    }
+    write_blocks(ser, block_ids);
+
+    std::vector<block_id_t> deleted;
+    for (block_id_t id = 0; id < COMPACTION_TEST_NUM_BLOCKS; ++id) {
+        if (!compaction_test_keeps(id)) {
+            deleted.push_back(id);
+        }
+    }
+    for (block_id_t i = 0; i < COMPACTION_TEST_NUM_AUX_BLOCKS; i += 2) {
+        deleted.push_back(FIRST_AUX_BLOCK_ID + i);
+    }
+    delete_blocks(ser, deleted);
+}
+
+// Checks that every block that `write_and_delete_blocks()` kept has its data and its
+// recency, and that the deleted ones stay deleted.
+static void check_kept_blocks(log_serializer_t *ser) {
+    scoped_ptr_t<file_account_t> account(ser->make_io_account(1));
+    const segmented_vector_t<repli_timestamp_t> recencies =
+        ser->get_all_recencies(0, 1);
+    EXPECT_EQ(COMPACTION_TEST_NUM_BLOCKS, ser->end_block_id());
+    EXPECT_EQ(FIRST_AUX_BLOCK_ID + COMPACTION_TEST_NUM_AUX_BLOCKS,
+              ser->end_aux_block_id());
+
+    buf_ptr_t expected = buf_ptr_t::alloc_zeroed(ser->max_block_size());
+    auto check_block = [&](block_id_t id, bool kept) {
+        counted_t<block_token_t> token = ser->index_read(id);
+        if (!kept) {
+            ASSERT_FALSE(token.has());
+            return;
+        }
+        ASSERT_TRUE(token.has());
+        buf_ptr_t buf = ser->block_read(token, account.get());
+        fill_compressible_block(id, &expected);
+        ASSERT_EQ(expected.block_size().ser_value(), buf.block_size().ser_value());
+        ASSERT_EQ(0, memcmp(expected.cache_data(), buf.cache_data(),
+                            expected.block_size().value()));
+    };
+    for (block_id_t id = 0; id < COMPACTION_TEST_NUM_BLOCKS; ++id) {
+        check_block(id, compaction_test_keeps(id));
+        if (compaction_test_keeps(id)) {
+            EXPECT_EQ(repli_timestamp_t{id}, recencies[id]);
+        }
+    }
+    for (block_id_t i = 0; i < COMPACTION_TEST_NUM_AUX_BLOCKS; ++i) {
+        check_block(FIRST_AUX_BLOCK_ID + i, i % 2 == 1);
+    }
+}
+
+TPTEST(SerializerTest, CompactFile) {
+    temp_file_t temp_file;
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    {
+        filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+        log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+        log_serializer_t ser(log_serializer_t::dynamic_config_t(), &file_opener,
+                             &get_global_perfmon_collection());
+        write_and_delete_blocks(&ser);
+    }
+
+    int64_t old_size;
+    int64_t new_size;
+    compact_serializer_file(&io_backender, temp_file.name(), &old_size, &new_size);
+    EXPECT_LT(new_size, old_size);
+
+    // The compacted file took the place of the old one.
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    EXPECT_EQ(new_size, serializer_file_size(&file_opener));
+    log_serializer_t ser(log_serializer_t::dynamic_config_t(), &file_opener,
+                         &get_global_perfmon_collection());
+    check_kept_blocks(&ser);
+}
+
+TPTEST(SerializerTest, StartCompaction) {
+    mock_file_opener_t file_opener;
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+    {
+        log_serializer_t ser(log_serializer_t::dynamic_config_t(), &file_opener,
+                             &get_global_perfmon_collection());
+        write_and_delete_blocks(&ser);
+    }
+
+    // After a restart, none of the extents is still being written to.
+    const int64_t old_size = serializer_file_size(&file_opener);
+    {
+        log_serializer_t ser(log_serializer_t::dynamic_config_t(), &file_opener,
+                             &get_global_perfmon_collection());
+        ser.start_compaction();
+        for (int i = 0; i < 10000 && ser.is_gc_active(); ++i) {
+            nap(1);
+        }
+        ASSERT_FALSE(ser.is_gc_active());
+
+        // The kept blocks moved into the free extents at the start of the file, so
+        // the extents at its end are gone.
+        EXPECT_LT(serializer_file_size(&file_opener), old_size);
+        check_kept_blocks(&ser);
+    }
+
+    log_serializer_t ser(log_serializer_t::dynamic_config_t(), &file_opener,
+                         &get_global_perfmon_collection());
+    EXPECT_LT(serializer_file_size(&file_opener), old_size);
+    check_kept_blocks(&ser);
+}
 
 }  // namespace unittest
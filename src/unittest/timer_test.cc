@@ -1,8 +1,13 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include <algorithm>
 
+#include <vector>
+
 #include "arch/timing.hpp"
 #include "concurrency/pmap.hpp"
+#include "containers/intrusive_priority_queue.hpp"
+#include "containers/timer_wheel.hpp"
+#include "random.hpp"
 #include "unittest/gtest.hpp"
 #include "unittest/unittest_utils.hpp"
 #include "utils.hpp"
@@ -93,5 +98,159 @@ TPTEST(TimerTest, TestChangeInterval) {
     nap(70);
 }
 
+struct test_wheel_node_t : public timer_wheel_node_t {
+    int64_t deadline;
+};
+
+TEST(TimerWheelTest, NeverEarlyNeverLate) {
+    rng_t rng(1234);
+    const int64_t start = 123456789;
+    timer_wheel_t wheel(start);
+    std::vector<test_wheel_node_t> nodes(1000);
+    int64_t now = start;
+    for (int step = 0; step < 100000; ++step) {
+        test_wheel_node_t *node = &nodes[rng.randint(nodes.size())];
+        switch (rng.randint(4)) {
+        case 0:
+            if (!node->in_wheel()) {
+                // Mix deadlines for every level of the wheel, and some that have
+                // already passed.
+                const int64_t ranges[] = { 10, 300, 70000, 20000000, 1LL << 33 };
+                node->deadline = now - 2 + rng.randuint64(ranges[rng.randint(5)]);
+                wheel.add(node, node->deadline);
+            }
+            break;
+        case 1:
+            if (node->in_wheel()) {
+                wheel.remove(node);
+            }
+            break;
+        default: {
+            int64_t earliest = INT64_MAX;
+            for (const test_wheel_node_t &n : nodes) {
+                if (n.in_wheel()) {
+                    earliest = std::min(earliest, n.deadline);
+                }
+            }
+            int64_t event_tick;
+            if (wheel.next_event_tick(&event_tick)) {
+                ASSERT_LE(event_tick, std::max(earliest, now));
+            } else {
+                ASSERT_EQ(INT64_MAX, earliest);
+            }
+
+            now += rng.randint(3) == 0 ? rng.randint(100000) : rng.randint(10);
+            wheel.advance(now);
+            while (timer_wheel_node_t *due = wheel.pop_due()) {
+                ASSERT_LE(static_cast<test_wheel_node_t *>(due)->deadline, now);
+            }
+            for (const test_wheel_node_t &n : nodes) {
+                ASSERT_TRUE(!n.in_wheel() || n.deadline > now);
+            }
+        } break;
+        }
+    }
+    for (test_wheel_node_t &n : nodes) {
+        if (n.in_wheel()) {
+            wheel.remove(&n);
+        }
+    }
+}
+
+// This is not really a unit test, but a micro benchmark that compares the timer
+// wheel to the priority queue that `timer_handler_t` used to keep its timers in. No
+// need to run this in debug mode.
+#ifdef NDEBUG
+struct test_queue_node_t : public intrusive_priority_queue_node_t<test_queue_node_t> {
+    int64_t deadline;
+};
+
+bool left_is_higher_priority(const test_queue_node_t *left,
+                             const test_queue_node_t *right) {
+    return left->deadline < right->deadline;
+}
+
+TEST(TimerWheelTest, ChurnBenchmark) {
+    // Like a busy server: lots of live timers, most of which get canceled and
+    // replaced before they ring, while the clock moves forward one tick at a time.
+    const int NUM_TIMERS = 200000;
+    const int NUM_OPERATIONS = 5000000;
+    const int OPERATIONS_PER_TICK = 1000;
+    const int MAX_DELAY_TICKS = 30000;
+
+    std::vector<int> victims(NUM_OPERATIONS);
+    std::vector<int64_t> delays(NUM_OPERATIONS);
+    {
+        rng_t rng(5678);
+        for (int i = 0; i < NUM_OPERATIONS; ++i) {
+            victims[i] = rng.randint(NUM_TIMERS);
+            delays[i] = 1 + rng.randint(MAX_DELAY_TICKS);
+        }
+    }
+
+    int64_t wheel_rings = 0;
+    double wheel_secs;
+    {
+        timer_wheel_t wheel(0);
+        std::vector<test_wheel_node_t> nodes(NUM_TIMERS);
+        ticks_t start_ticks = get_ticks();
+        int64_t now = 0;
+        for (int i = 0; i < NUM_OPERATIONS; ++i) {
+            test_wheel_node_t *node = &nodes[victims[i]];
+            if (node->in_wheel()) {
+                wheel.remove(node);
+            }
+            wheel.add(node, now + delays[i]);
+            if ((i + 1) % OPERATIONS_PER_TICK == 0) {
+                wheel.advance(++now);
+                while (wheel.pop_due() != nullptr) {
+                    ++wheel_rings;
+                }
+            }
+        }
+        wheel_secs = ticks_to_secs(ticks_t{get_ticks().nanos - start_ticks.nanos});
+        for (test_wheel_node_t &n : nodes) {
+            if (n.in_wheel()) {
+                wheel.remove(&n);
+            }
+        }
+    }
+
+    int64_t queue_rings = 0;
+    double queue_secs;
+    {
+        intrusive_priority_queue_t<test_queue_node_t> queue;
+        std::vector<test_queue_node_t> nodes(NUM_TIMERS);
+        std::vector<bool> queued(NUM_TIMERS, false);
+        ticks_t start_ticks = get_ticks();
+        int64_t now = 0;
+        for (int i = 0; i < NUM_OPERATIONS; ++i) {
+            test_queue_node_t *node = &nodes[victims[i]];
+            if (queued[victims[i]]) {
+                queue.remove(node);
+            }
+            node->deadline = now + delays[i];
+            queue.push(node);
+            queued[victims[i]] = true;
+            if ((i + 1) % OPERATIONS_PER_TICK == 0) {
+                ++now;
+                while (!queue.empty() && queue.peek()->deadline <= now) {
+                    queued[queue.pop() - nodes.data()] = false;
+                    ++queue_rings;
+                }
+            }
+        }
+        queue_secs = ticks_to_secs(ticks_t{get_ticks().nanos - start_ticks.nanos});
+        while (!queue.empty()) {
+            queue.pop();
+        }
+    }
+
+    EXPECT_EQ(queue_rings, wheel_rings);
+    printf("%d add/cancel operations on %d timers: timer wheel %f s, "
+           "priority queue %f s\n",
+           NUM_OPERATIONS, NUM_TIMERS, wheel_secs, queue_secs);
+}
+#endif  // NDEBUG
 
 }  // namespace unittest
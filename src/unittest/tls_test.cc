@@ -0,0 +1,156 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifdef ENABLE_TLS
+
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+
+#include <vector>
+
+#include "arch/io/network.hpp"
+#include "arch/timing.hpp"
+#include "concurrency/cond_var.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+/* A throwaway self-signed certificate for the loopback connections. */
+class test_tls_identity_t {
+public:
+    test_tls_identity_t() : key(nullptr), cert(nullptr) {
+        EVP_PKEY_CTX *key_ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
+        guarantee(key_ctx != nullptr);
+        guarantee(EVP_PKEY_keygen_init(key_ctx) == 1);
+        guarantee(EVP_PKEY_CTX_set_ec_paramgen_curve_nid(
+            key_ctx, NID_X9_62_prime256v1) == 1);
+        guarantee(EVP_PKEY_keygen(key_ctx, &key) == 1);
+        EVP_PKEY_CTX_free(key_ctx);
+
+        cert = X509_new();
+        guarantee(cert != nullptr);
+        X509_set_version(cert, 2);
+        ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+        X509_gmtime_adj(X509_get_notBefore(cert), 0);
+        X509_gmtime_adj(X509_get_notAfter(cert), 24 * 60 * 60);
+        X509_set_pubkey(cert, key);
+        X509_NAME *name = X509_get_subject_name(cert);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC,
+            reinterpret_cast<const unsigned char *>("localhost"), -1, -1, 0);
+        X509_set_issuer_name(cert, name);
+        guarantee(X509_sign(cert, key, EVP_sha256()) != 0);
+    }
+    ~test_tls_identity_t() {
+        X509_free(cert);
+        EVP_PKEY_free(key);
+    }
+
+    EVP_PKEY *key;
+    X509 *cert;
+
+private:
+    DISABLE_COPYING(test_tls_identity_t);
+};
+
+SSL_CTX *make_test_tls_ctx(const test_tls_identity_t *identity, bool kernel_offload) {
+    SSL_CTX *ctx = SSL_CTX_new(SSLv23_method());
+    guarantee(ctx != nullptr);
+    SSL_CTX_set_options(ctx, SSL_OP_NO_SSLv2|SSL_OP_NO_SSLv3|SSL_OP_NO_TLSv1|SSL_OP_NO_TLSv1_1);
+    if (identity != nullptr) {
+        guarantee(SSL_CTX_use_certificate(ctx, identity->cert) == 1);
+        guarantee(SSL_CTX_use_PrivateKey(ctx, identity->key) == 1);
+    }
+    if (kernel_offload) {
+#ifdef SSL_OP_ENABLE_KTLS
+        SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+#endif
+    }
+    return ctx;
+}
+
+/* Sends `num_chunks` chunks of `chunk_size` bytes over a TLS connection on the
+loopback interface. Returns the throughput in MB/s. Sets `*kernel_tls_send_out` to
+whether the client's writes were encrypted by the kernel. */
+double tls_loopback_throughput(bool kernel_offload, size_t chunk_size, int num_chunks,
+                               bool *kernel_tls_send_out) {
+    test_tls_identity_t identity;
+    SSL_CTX *server_ctx = make_test_tls_ctx(&identity, kernel_offload);
+    SSL_CTX *client_ctx = make_test_tls_ctx(nullptr, kernel_offload);
+
+    const uint64_t total_size = static_cast<uint64_t>(chunk_size) * num_chunks;
+    std::vector<char> chunk(chunk_size);
+    uint64_t expected_sum = 0;
+    for (size_t i = 0; i < chunk_size; ++i) {
+        chunk[i] = static_cast<char>(i * 7 + 3);
+        expected_sum += static_cast<unsigned char>(chunk[i]);
+    }
+    expected_sum *= num_chunks;
+
+    uint64_t received_size = 0;
+    uint64_t received_sum = 0;
+    cond_t received_all;
+    std::set<ip_address_t> addresses;
+    addresses.insert(ip_address_t("127.0.0.1"));
+    non_throwing_tcp_listener_t listener(addresses, 0,
+        [&](scoped_ptr_t<tcp_conn_descriptor_t> &nconn) {
+            cond_t non_closer;
+            scoped_ptr_t<tcp_conn_t> conn;
+            nconn->make_server_connection(server_ctx, &conn, &non_closer);
+            std::vector<char> buf(64 * KILOBYTE);
+            try {
+                while (received_size < total_size) {
+                    size_t n = conn->read_some(buf.data(), buf.size(), &non_closer);
+                    for (size_t i = 0; i < n; ++i) {
+                        received_sum += static_cast<unsigned char>(buf[i]);
+                    }
+                    received_size += n;
+                }
+            } catch (const tcp_conn_read_closed_exc_t &) {
+            }
+            received_all.pulse();
+        });
+    guarantee(listener.begin_listening());
+
+    ticks_t start = get_ticks();
+    {
+        cond_t non_interruptor;
+        secure_tcp_conn_t client(client_ctx, ip_address_t("127.0.0.1"),
+                                 listener.get_port(), &non_interruptor);
+        *kernel_tls_send_out = client.is_kernel_tls_send();
+        for (int i = 0; i < num_chunks; ++i) {
+            client.write(chunk.data(), chunk.size(), &non_interruptor);
+        }
+        received_all.wait();
+    }
+    ticks_t end = get_ticks();
+
+    EXPECT_EQ(total_size, received_size);
+    EXPECT_EQ(expected_sum, received_sum);
+
+    SSL_CTX_free(client_ctx);
+    SSL_CTX_free(server_ctx);
+
+    double secs = static_cast<double>(end.nanos - start.nanos) / BILLION;
+    return static_cast<double>(total_size) / MEGABYTE / secs;
+}
+
+TPTEST(TLSTest, KernelOffloadLoopbackThroughput) {
+    bool userspace_ktls;
+    const double userspace = tls_loopback_throughput(false, MEGABYTE, 64,
+                                                     &userspace_ktls);
+    EXPECT_FALSE(userspace_ktls);
+    bool kernel_ktls;
+    const double kernel = tls_loopback_throughput(true, MEGABYTE, 64, &kernel_ktls);
+    if (!kernel_ktls) {
+        // Kernel TLS only kicks in with OpenSSL 3 and if the kernel has the `tls`
+        // module.
+        printf("Skipping the kernel TLS check: this OpenSSL or kernel doesn't "
+               "support kernel TLS.\n");
+        return;
+    }
+    printf("TLS loopback throughput: %.1f MB/s with OpenSSL encryption, "
+           "%.1f MB/s with kernel TLS\n", userspace, kernel);
+}
+
+}  // namespace unittest
+
+#endif  // ENABLE_TLS
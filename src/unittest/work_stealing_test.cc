@@ -0,0 +1,78 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <atomic>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+#include "arch/runtime/runtime.hpp"
+#include "concurrency/work_stealing.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+TEST(WorkStealingTest, EveryIndexOnce) {
+    run_in_thread_pool([&]() {
+        const size_t count = 10000;
+        std::vector<std::atomic<int> > visits(count);
+        for (auto &v : visits) {
+            v.store(0);
+        }
+        std::atomic<uint64_t> thread_mask(0);
+        run_stealable_batch(count, 7, [&](size_t begin, size_t end) {
+            ASSERT_LT(begin, end);
+            ASSERT_LE(end, count);
+            thread_mask.fetch_or(uint64_t(1) << get_thread_id().threadnum);
+            for (size_t i = begin; i < end; ++i) {
+                visits[i].fetch_add(1);
+            }
+        });
+        for (size_t i = 0; i < count; ++i) {
+            ASSERT_EQ(1, visits[i].load());
+        }
+        // The calling thread always helps out.
+        ASSERT_NE(0u, thread_mask.load() & 1);
+    }, 4);
+}
+
+TEST(WorkStealingTest, RethrowsFirstException) {
+    run_in_thread_pool([&]() {
+        std::atomic<size_t> processed(0);
+        try {
+            run_stealable_batch(1000, 10, [&](size_t begin, size_t end) {
+                processed.fetch_add(end - begin);
+                if (begin == 500 || begin == 700) {
+                    throw std::runtime_error(std::to_string(begin));
+                }
+            });
+            FAIL() << "run_stealable_batch() should have thrown";
+        } catch (const std::runtime_error &e) {
+            ASSERT_EQ("500", std::string(e.what()));
+        }
+        // All chunks still run, even after one of them failed.
+        ASSERT_EQ(1000u, processed.load());
+    }, 4);
+}
+
+TEST(WorkStealingTest, PreparesThievesFirst) {
+    run_in_thread_pool([&]() {
+        const threadnum_t home = get_thread_id();
+        std::vector<std::atomic<bool> > prepared(get_num_threads());
+        for (auto &p : prepared) {
+            p.store(false);
+        }
+        run_stealable_batch(10000, 7,
+            [&](size_t, size_t) {
+                if (get_thread_id() != home) {
+                    ASSERT_TRUE(prepared[get_thread_id().threadnum].load());
+                }
+            },
+            [&](threadnum_t thread) {
+                ASSERT_EQ(home, get_thread_id());
+                ASSERT_NE(home, thread);
+                prepared[thread.threadnum].store(true);
+            });
+    }, 4);
+}
+
+}  // namespace unittest